@@ -99,11 +99,19 @@ boot_device_t* g3_app_boot_add_connected_device(const uint8_t* ext_addr, const u
 
 bool 		   g3_app_boot_remove_connected_device(const uint8_t* ext_addr);
 
+#if ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+uint16_t	   g3_app_boot_restore_devices(void);
+void		   g3_app_boot_compact_device_log(void);
+void		   g3_app_boot_check_frame_counters(void);
+void		   g3_app_boot_counter_timeoutCallback(void *argument);
+#endif
+
 #endif /* IS_COORD */
 
 /* Device Management */
 #if IS_COORD
 void 		   g3_app_boot_kick_device(boot_device_t *device);
+bool		   g3_app_boot_erase_sflash(void);
 #else
 char* 		   g3_app_pansort_translate_media_type(uint8_t media);
 void 		   g3_app_boot_leave();
@@ -139,6 +139,7 @@ typedef struct boot_client_str
     ADP_PanDescriptor_t 	pan_descriptor[ADP_MAX_NUM_PANDESCR];
     uint8_t					pan_index;
     uint8_t 				join_tries;
+    uint32_t				join_start_time;			/**< @brief Time stamp of the first join attempt of the bootstrap */
 
     /* Connection info */
     uint16_t 				pan_id;
@@ -36,6 +36,10 @@
   * @{
   */
 
+/* Inclusions */
+#include <sflash_info.h>
+#include <image_management.h>
+
 /* Boot Attributes definitions */
 
 #if IS_COORD
@@ -57,6 +61,43 @@
 
 #define BOOT_SERVER_BOOTSTRAP_TIMEOUT_CHECK_PERIOD	(1000U)	/* Period of the bootstrap timeout check, in ms */
 
+/* Re-keying */
+#define BOOT_SERVER_REKEYING_WINDOW					4		/* Maximum number of devices re-keyed at the same time (bounded by the joining table) */
+#define BOOT_SERVER_REKEYING_MAX_RETRIES			2		/* Number of retries of a re-keying phase for each device before the procedure fails */
+
+#define BOOT_SERVER_REKEYING_RECORD_ADDR			BOOT_SERVER_SFLASH_ALIGN(SFLASH_LOAD_RECORD + IMAGE_LOAD_RECORD_SIZE)	/* SFLASH address of the re-keying progress record (after the image load record) */
+#define BOOT_SERVER_REKEYING_RECORD_SIZE			(65536)		/* in bytes (one SFLASH sector) */
+#define BOOT_SERVER_REKEYING_RECORD_MAGIC			0x524B4559
+
+/* Connected device log */
+#define BOOT_SERVER_DEVICE_LOG_ADDR					BOOT_SERVER_SFLASH_ALIGN(BOOT_SERVER_REKEYING_RECORD_ADDR + BOOT_SERVER_REKEYING_RECORD_SIZE)	/* SFLASH address of the connected device log (after the re-keying progress record) */
+#define BOOT_SERVER_DEVICE_LOG_SECTOR_SIZE			(65536)		/* in bytes (one SFLASH sector) */
+#define BOOT_SERVER_DEVICE_LOG_SECTORS				2			/* The log is compacted alternating between the sectors */
+#define BOOT_SERVER_DEVICE_LOG_MAGIC				0x44564C47
+#define BOOT_SERVER_FRAME_COUNTER_MARGIN			0x10000		/* Frame counter values reserved in the log at each update, the counters restart from the reserved value after a reset */
+#define BOOT_SERVER_FRAME_COUNTER_CHECK_PERIOD		60000		/* Period of the check of the MAC frame counters against the reserved value, in ms */
+
+/* Access list */
+#define BOOT_SERVER_ACCESS_LIST_ADDR				BOOT_SERVER_SFLASH_ALIGN(BOOT_SERVER_DEVICE_LOG_ADDR + (BOOT_SERVER_DEVICE_LOG_SECTORS * BOOT_SERVER_DEVICE_LOG_SECTOR_SIZE))	/* SFLASH address of the access list (after the connected device log) */
+#define BOOT_SERVER_ACCESS_LIST_AREA_SIZE			(131072)	/* in bytes (two SFLASH sectors) */
+#define BOOT_SERVER_ACCESS_LIST_AREAS				2			/* The list is compacted alternating between the areas */
+#define BOOT_SERVER_ACCESS_LIST_MAGIC				0x41434C53
+#define BOOT_SERVER_ACCESS_LIST_MAX_ENTRIES			2048		/* Maximum number of entries stored in the SFLASH */
+#define BOOT_SERVER_ACCESS_LIST_HASH_SIZE			4096		/* Number of buckets of the RAM index, power of 2 (3 bytes each) */
+
+/* SFLASH area of the persistent Boot Server data, from the re-keying progress record to the end of the access list */
+#define BOOT_SERVER_SFLASH_ALIGN(address)			((((address) + SPI_FLASH_SECTOR_SIZE - 1) / SPI_FLASH_SECTOR_SIZE) * SPI_FLASH_SECTOR_SIZE)	/* Rounds up to the next SFLASH sector */
+#define BOOT_SERVER_SFLASH_START					BOOT_SERVER_REKEYING_RECORD_ADDR
+#define BOOT_SERVER_SFLASH_END						(BOOT_SERVER_ACCESS_LIST_ADDR + (BOOT_SERVER_ACCESS_LIST_AREAS * BOOT_SERVER_ACCESS_LIST_AREA_SIZE))
+
+#if ((BOOT_SERVER_REKEYING_RECORD_SIZE % SPI_FLASH_SECTOR_SIZE) != 0) || ((BOOT_SERVER_DEVICE_LOG_SECTOR_SIZE % SPI_FLASH_SECTOR_SIZE) != 0) || ((BOOT_SERVER_ACCESS_LIST_AREA_SIZE % SPI_FLASH_SECTOR_SIZE) != 0)
+#error "The SFLASH areas of the Boot Server must be multiples of the SFLASH sector size, they are erased by sectors"
+#endif
+
+#if BOOT_SERVER_SFLASH_END > SPI_FLASH_SIZE
+#error "The SFLASH areas of the Boot Server do not fit in the SFLASH after the image management areas"
+#endif
+
 #else
 
 /* Client/Device attributes */
@@ -67,6 +108,12 @@
 #define BOOT_CLIENT_ASSOCIATION_MAX_RETRIES   		10		/**< @brief bootDeviceAssociationMaxRetries: the number of time a device tries to associate with the same LBA */
 #define BOOT_CLIENT_ASSOCIATION_RAND_WAIT_TIME 		30		/**< @brief bootDeviceAssociationRandWaitTime: the maximum of the random time (in seconds) window before trying to attempt to the same LBA */
 
+/* Join backoff */
+#define BOOT_CLIENT_START_JITTER_TIME				5000	/* Maximum random time (in ms) added to the start wait time, to spread the devices rejoining at the same time */
+#define BOOT_CLIENT_BACKOFF_MIN_TIME				1000	/* Minimum wait time (in ms) before a join retry, the random window doubles at each retry */
+#define BOOT_CLIENT_BACKOFF_DECLINE_SHIFT			2		/* A declined join (e.g. coordinator joining table full) waits a window 2^shift times larger than a timed out one */
+#define BOOT_CLIENT_BACKOFF_LQI_MARGIN				20		/* Below BOOT_CLIENT_LQI_THRESHOLD + margin, the next PAN agent is tried after half of the retries */
+
 #define BOOT_CLIENT_DEFAULT_MAX_HOPS        		14  	/**< @brief The default MaxHops value used in LBP messages sent from the Device */
 
 #define BOOT_CLIENT_DISCOVER_ROUTE					1  		/**< @brief If enabled, discovers the route to the coordinator during the bootstrap */
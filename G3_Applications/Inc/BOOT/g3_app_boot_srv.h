@@ -118,6 +118,30 @@ typedef enum boot_srv_rk_err_enum
 	rekeying_error_abort
 } boot_srv_rk_err_t;
 
+typedef enum boot_srv_rk_dev_state_enum
+{
+	rekeying_device_idle,			/* Not part of the re-keying (not connected or already aligned by its bootstrap) */
+	rekeying_device_pending,		/* Waiting for the new GMK */
+	rekeying_device_distributing,	/* EAP handshake with the new GMK in progress */
+	rekeying_device_distributed,	/* Holds the new GMK */
+	rekeying_device_activating,		/* GMK-Activation sent */
+	rekeying_device_activated,		/* Uses the new GMK */
+	rekeying_device_deactivating,	/* GMK-Deactivation sent (roll-back) */
+	rekeying_device_failed			/* Could not be rolled-back */
+} boot_srv_rk_dev_state_t;
+
+/**
+  * @brief Statistics of the last re-keying procedure
+  */
+typedef struct boot_srv_rk_stats_str
+{
+	uint32_t	duration;			/**< @brief Duration of the procedure, in ms */
+	uint32_t	devices;			/**< @brief Number of devices that received the new GMK */
+	uint32_t	resumed;			/**< @brief Number of devices skipped because they received the new GMK during an interrupted procedure */
+	uint32_t	retries;			/**< @brief Number of per-device retries */
+	uint32_t	devices_per_min;	/**< @brief Throughput of the procedure, in devices per minute */
+} boot_srv_rk_stats_t;
+
 #endif /* ENABLE_BOOT_SERVER_ON_HOST */
 
 typedef enum boot_conn_status_enum
@@ -173,10 +197,16 @@ typedef struct boot_server_str
 	uint8_t 				gmk_index;							/**< @brief The index of the active GMK*/
 	uint8_t 				gmk_index_new;						/**< @brief The index of the future active GMK*/
 
-	uint32_t 				rekeying_index;
+	uint32_t 				rekeying_index;						/**< @brief Cursor of the next connected device to add to the re-keying window */
 	uint32_t 				rekeying_count;
 	uint32_t 				rekeyed_count;
 	uint32_t 				activated_count;
+	uint32_t				rekeying_start_ts;					/**< @brief Start time of the re-keying, in ms */
+
+	uint8_t					rekeying_state[BOOT_MAX_NUM_JOINING_NODES];		/**< @brief Re-keying progress of each connected device (boot_srv_rk_dev_state_t) */
+	uint8_t					rekeying_retries[BOOT_MAX_NUM_JOINING_NODES];	/**< @brief Retries of the current re-keying phase of each connected device */
+
+	boot_srv_rk_stats_t		rekeying_stats;						/**< @brief Statistics of the last re-keying */
 #endif /* ENABLE_BOOT_SERVER_ON_HOST */
 } boot_server_t;
 
@@ -69,7 +69,12 @@ extern "C" {
 
 #if IS_COORD
 void 			g3_boot_access_table_init(void);
-g3_boot_data_t*	g3_boot_access_table_find(const uint8_t *extended_address);
+bool			g3_boot_access_table_find(const uint8_t *extended_address, g3_boot_data_t *entry);
+#if ENABLE_ACCESS_LIST_STORAGE
+bool			g3_boot_access_table_add(const g3_boot_data_t *entry);
+bool			g3_boot_access_table_remove(const uint8_t *extended_address);
+uint16_t		g3_boot_access_table_count(void);
+#endif /* ENABLE_ACCESS_LIST_STORAGE */
 #endif /* IS_COORD */
 
 /**
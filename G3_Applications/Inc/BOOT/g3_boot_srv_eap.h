@@ -24,6 +24,7 @@ extern "C" {
 #include <stdint.h>
 #include <settings.h>
 #include <hi_adp_lbp.h>
+#include <g3_app_boot_srv.h>
 
 /** @addtogroup G3_ADP
   * @{
@@ -53,9 +54,11 @@ extern "C" {
 #define REKEYING_SEND_GMK_PHASE_DELAY		1000
 #define REKEYING_ACTIVATE_GMK_PHASE_DELAY	1000
 #define REKEYING_SET_GMK_INDEX_PHASE_DELAY	1000
+#define REKEYING_WINDOW_RETRY_DELAY			1000	/* Delay before retrying to fill the re-keying window when the joining table is full, in ms */
 
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST
 void g3_boot_srv_eap_rekeying_fsm();
+void g3_boot_srv_eap_rekeying_failed(boot_join_entry_t* join_entry, boot_srv_rk_err_t error);
 void g3_boot_srv_eap_fsm_manager(const lbp_ind_t* lbp_eap_msg, boot_join_entry_t* join_entry);
 void g3_boot_srv_eap_timeoutCallback(void *argument);
 #endif
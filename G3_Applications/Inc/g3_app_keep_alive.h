@@ -47,6 +47,18 @@ extern "C" {
 
 #if ENABLE_ICMP_KEEP_ALIVE
 
+#if IS_COORD
+/**
+  * @brief Keep-Alive counters of the coordinator
+  */
+typedef struct ka_stats_str
+{
+	uint32_t	pings_sent;			/**< @brief Number of pings sent */
+	uint32_t	pings_avoided;		/**< @brief Number of pings skipped because the device sent traffic during the check period */
+	uint32_t	traffic_refreshes;	/**< @brief Number of inbound messages that refreshed the liveness of a device */
+} ka_stats_t;
+#endif
+
 /* Public functions */
 bool	 g3_app_ka_msg_needed( const g3_msg_t *g3_msg);
 void	 g3_app_ka_msg_handler(const g3_msg_t *g3_msg);
@@ -56,6 +68,7 @@ bool 	 g3_app_ka_stop(void);
 #if IS_COORD
 void	 g3_app_ka_wait(void);
 bool 	 g3_app_ka_in_progress(void);
+void	 g3_app_ka_get_stats(ka_stats_t *stats);
 void 	 g3_app_ka(void);
 #else
 uint32_t g3_app_ka_time_to_leave(void);
@@ -44,6 +44,7 @@ extern "C" {
   */
 
 /* Definitions */
+#define LAST_GASP_UDP_HANDLE	0xFF	/* Handle of the pre-built Last Gasp G3UDP-DATA.Request, skipped by the other UDP handle allocators */
 
 #if ENABLE_LAST_GASP
 
@@ -52,7 +53,10 @@ bool	 g3_app_last_gasp_msg_needed( const g3_msg_t *g3_msg);
 void	 g3_app_last_gasp_msg_handler(const g3_msg_t *g3_msg);
 void	 g3_app_last_gasp_init(void);
 
-#if !IS_COORD
+#if IS_COORD
+void	 g3_app_last_gasp_report(void);
+void	 g3_app_last_gasp_timer_callback(void *argument);
+#else
 void 	 g3_app_last_gasp_start(void);
 void 	 g3_app_last_gasp_activate(void);
 uint8_t	 g3_app_last_gasp_is_active(void);
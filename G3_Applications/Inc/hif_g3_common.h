@@ -44,6 +44,15 @@
 #define TRANSFER_LOCAL_PORT    		2000		/*!< Local port for the connection used for transfers */
 #define TRANSFER_REMOTE_PORT   		2000		/*!< Remote port for the connection used for transfers */
 
+#define POLL_LOCAL_PORT    			3000		/*!< Local port for the connection used for the polling of the devices */
+#define POLL_REMOTE_PORT   			3000		/*!< Remote port for the connection used for the polling of the devices */
+
+#define BENCH_LOCAL_PORT    		4000		/*!< Local port for the connection used for benchmarks */
+#define BENCH_REMOTE_PORT   		4000		/*!< Remote port for the connection used for benchmarks */
+
+#define MODBUS_GW_LOCAL_PORT   		5000		/*!< Local port for the connection used for the Modbus gateway */
+#define MODBUS_GW_REMOTE_PORT  		5000		/*!< Remote port for the connection used for the Modbus gateway */
+
 /* UDP ports used in connections for G3 */
 #define LAST_GASP_LOCAL_PORT		50		/*!< Local port for the connection used for Last Gasp */
 #define LAST_GASP_REMOTE_PORT		50		/*!< Remote port for the connection used for Last Gasp */
@@ -58,6 +67,15 @@ typedef enum connection_id_enum
 {
 	TEST_CONN_ID		= 0U,	/*!< ID for the connection used for tests */
 	TRANSFER_CONN_ID,			/*!< ID for the connection used for transfers */
+#if ENABLE_METER_POLLING
+	POLL_CONN_ID,				/*!< ID for the connection used for the polling of the devices */
+#endif
+#if ENABLE_BENCHMARK
+	BENCH_CONN_ID,				/*!< ID for the connection used for benchmarks */
+#endif
+#if ENABLE_MODBUS_GATEWAY
+	MODBUS_GW_CONN_ID,			/*!< ID for the connection used for the Modbus gateway */
+#endif
 #if ENABLE_LAST_GASP
 	LAST_GASP_CONN_ID,			/*!< ID for the connection used for Last Gasp (cannot be used in User G3) */
 #endif
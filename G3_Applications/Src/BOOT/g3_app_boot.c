@@ -13,12 +13,16 @@
 *******************************************************************************/
 
 /* Inclusions */
+#include <stddef.h>
 #include <debug_print.h>
 #include <mem_pool.h>
 #include <utils.h>
+#include <crc.h>
+#include <sflash.h>
 #include <g3_boot_access_tbl.h>
 #include <g3_app_config.h>
 #include <g3_app_attrib_tbl.h>
+#include <g3_app_boot_constants.h>
 #include <g3_app_boot.h>
 #include <hi_msgs_impl.h>
 #include <main.h>
@@ -47,10 +51,73 @@
 
 #if IS_COORD
 extern boot_server_t boot_server;
+#if ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+extern osTimerId_t counterTimerHandle;
+extern osMessageQueueId_t g3_queueHandle;
+#endif
 #else
 extern osTimerId_t bootTimerHandle;
 #endif /* IS_COORD */
 
+#if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+/* Connected device log: each sector starts with a header, followed by the records appended at each connection/disconnection */
+typedef enum boot_log_type_enum
+{
+	boot_log_add		= 0x01,
+	boot_log_remove		= 0x02,
+	boot_log_counters	= 0x03,
+	boot_log_erased		= 0xFF,
+} boot_log_type_t;
+
+#pragma pack(push, 1)
+typedef struct boot_log_header_str
+{
+	uint32_t	magic;			/* BOOT_SERVER_DEVICE_LOG_MAGIC if valid, 0 once compacted into the other sector */
+	uint32_t	sequence;		/* Incremented at each compaction */
+	crc16_t		gmk_crc;		/* CRC16 of the active GMK when the log was written (the key itself is not stored) */
+	uint8_t		reserved[6];
+} boot_log_header_t;
+
+typedef struct boot_log_record_str
+{
+	uint8_t		type;			/* boot_log_type_t */
+	uint8_t		media_type;
+	uint8_t		disable_bkp;
+	uint8_t		gmk_index;		/* Index of the active GMK */
+	uint16_t	short_addr;
+	uint8_t		ext_addr[MAC_ADDR64_SIZE];
+	crc16_t		crc;			/* CRC16 of the previous fields, detects partially written records */
+} boot_log_record_t;
+
+typedef struct boot_log_counters_str
+{
+	uint8_t		type;			/* boot_log_counters */
+	uint8_t		reserved[5];
+	uint32_t	frame_counter;	/* Reserved value of macFrameCounter */
+	uint32_t	frame_counter_rf; /* Reserved value of macFrameCounter_RF (0 if not read) */
+	crc16_t		crc;			/* CRC16 of the previous fields, at the same offset as in boot_log_record_t */
+} boot_log_counters_t;
+#pragma pack(pop)
+
+typedef struct boot_log_str
+{
+	bool		valid;			/* The log can be appended */
+	uint8_t		sector;			/* Sector in use */
+	uint32_t	sequence;		/* Sequence number of the sector in use */
+	uint32_t	records;		/* Number of records in the sector in use */
+	uint32_t	frame_counter;	/* Reserved value of macFrameCounter (0 if none) */
+	uint32_t	frame_counter_rf; /* Reserved value of macFrameCounter_RF (0 if none) */
+} boot_log_t;
+
+#define BOOT_LOG_SECTOR_ADDR(sector)			(BOOT_SERVER_DEVICE_LOG_ADDR + ((sector) * BOOT_SERVER_DEVICE_LOG_SECTOR_SIZE))
+#define BOOT_LOG_RECORD_ADDR(sector, index)		(BOOT_LOG_SECTOR_ADDR(sector) + sizeof(boot_log_header_t) + ((index) * sizeof(boot_log_record_t)))
+#define BOOT_LOG_RECORDS_PER_SECTOR				((BOOT_SERVER_DEVICE_LOG_SECTOR_SIZE - sizeof(boot_log_header_t)) / sizeof(boot_log_record_t))
+#define BOOT_LOG_COMPACT_CHUNK					8	/* Records written at once by the compaction (each write takes a place in the SFLASH queue) */
+
+/* Private variables */
+static boot_log_t boot_log;
+#endif /* IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE */
+
 #if !IS_COORD
 
 /* Global variables */
@@ -234,6 +301,7 @@ static void g3_boot_handle_server_getpsk_ind(const void *payload)
 
 	uint8_t* psk = empty_psk;
 	uint16_t short_address = MAC_BROADCAST_SHORT_ADDR;
+	g3_boot_data_t access_table_entry;
 
 #if (DEBUG_G3_BOOT >= DEBUG_LEVEL_FULL)
     ALLOC_STATIC_HEX_STRING(idp_str, getpsk_ind->idp, getpsk_ind->idp_len);
@@ -242,12 +310,12 @@ static void g3_boot_handle_server_getpsk_ind(const void *payload)
 #endif
 
     /* Looks for the device with the given extended address in the table */
-	g3_boot_data_t *access_table_entry = g3_boot_access_table_find(getpsk_ind->ext_addr);
+	bool found = g3_boot_access_table_find(getpsk_ind->ext_addr, &access_table_entry);
 
 #if (SELECTED_LIST_MODE == BLACK_LIST_MODE)
-	if (access_table_entry == NULL)
+	if (!found)
 #else
-	if (access_table_entry != NULL)
+	if (found)
 #endif
 	{
 #if (SELECTED_LIST_MODE == BLACK_LIST_MODE)
@@ -255,8 +323,8 @@ static void g3_boot_handle_server_getpsk_ind(const void *payload)
 		psk_to_assign = default_psk;
 #else
 		/* Uses short address and PSK values associated to the device, inside the table */
-		psk_to_assign = access_table_entry->psk;
-		short_address = access_table_entry->short_addr;
+		psk_to_assign = access_table_entry.psk;
+		short_address = access_table_entry.short_addr;
 #endif
 
 		/* Looks for the device in the connected entries of the connected device table, using the extended address */
@@ -431,6 +499,202 @@ static void g3_boot_handle_nvm_cnf(const void *payload)
 
 #endif /* IS_COORD */
 
+#if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+/**
+  * @brief Fills a record of the connected device log.
+  * @param record Pointer to the record to fill.
+  * @param type Type of the record (boot_log_add or boot_log_remove).
+  * @param device Pointer to the device to log.
+  * @retval None
+  */
+static void g3_boot_log_fill(boot_log_record_t *record, const boot_log_type_t type, const boot_device_t *device)
+{
+	record->type		= type;
+	record->media_type	= device->media_type;
+	record->disable_bkp	= device->disable_bkp;
+	record->gmk_index	= boot_server.gmk_index;
+	record->short_addr	= device->short_addr;
+	memcpy(record->ext_addr, device->ext_addr, MAC_ADDR64_SIZE);
+	record->crc			= CRC16_CCITT(record, offsetof(boot_log_record_t, crc));
+}
+
+/**
+  * @brief Fills the record of the reserved frame counters.
+  * @param counters Pointer to the record to fill.
+  * @retval None
+  */
+static void g3_boot_log_fill_counters(boot_log_counters_t *counters)
+{
+	counters->type				= boot_log_counters;
+	memset(counters->reserved, 0xFF, sizeof(counters->reserved));
+	counters->frame_counter		= boot_log.frame_counter;
+	counters->frame_counter_rf	= boot_log.frame_counter_rf;
+	counters->crc				= CRC16_CCITT(counters, offsetof(boot_log_counters_t, crc));
+}
+
+/**
+  * @brief Appends a record to the connected device log.
+  * @param record Pointer to the record to append (boot_log_record_t or boot_log_counters_t).
+  * @retval None
+  */
+static void g3_boot_log_append(const void *record)
+{
+	if (!boot_log.valid)
+	{
+		return;
+	}
+
+	if (boot_log.records >= BOOT_LOG_RECORDS_PER_SECTOR)
+	{
+		/* The sector is full, the compacted log already reflects the change */
+		g3_app_boot_compact_device_log();
+		return;
+	}
+
+	if (SFLASH_WRITE(BOOT_LOG_RECORD_ADDR(boot_log.sector, boot_log.records), (uint8_t*) record, sizeof(boot_log_record_t)))
+	{
+		boot_log.records++;
+	}
+	else
+	{
+		PRINT_G3_BOOT_WARNING("Could not write the connected device log\n");
+	}
+}
+
+/**
+  * @brief Writes a record in the connected device log.
+  * @param type Type of the record (boot_log_add or boot_log_remove).
+  * @param device Pointer to the device to log.
+  * @retval None
+  */
+static void g3_boot_log_write(const boot_log_type_t type, const boot_device_t *device)
+{
+	boot_log_record_t record;
+
+	g3_boot_log_fill(&record, type, device);
+	g3_boot_log_append(&record);
+}
+
+/**
+  * @brief Writes the reserved frame counters in the connected device log.
+  * @param None
+  * @retval None
+  */
+static void g3_boot_log_write_counters(void)
+{
+	boot_log_counters_t counters;
+
+	g3_boot_log_fill_counters(&counters);
+	g3_boot_log_append(&counters);
+}
+
+/**
+  * @brief Sets a MAC frame counter of the ST8500 (after a reset, to the value reserved before it).
+  * @param id Attribute ID of the counter (MAC_FRAMECOUNTER_ID or MAC_FRAMECOUNTER_RF_ID).
+  * @param value Value of the counter.
+  * @retval None
+  */
+static void g3_boot_set_frame_counter(const uint32_t id, uint32_t value)
+{
+	G3_LIB_SetAttributeRequest_t *set_attr_req = MEMPOOL_MALLOC(G3_LIB_PIB_SIZE(sizeof(value)));
+
+	uint16_t len = hi_g3lib_setreq_fill(set_attr_req, id, 0, (uint8_t*) &value, sizeof(value));
+	g3_send_message(HIF_TX_MSG, HIF_G3LIB_SET_REQ, set_attr_req, len);
+}
+
+/**
+  * @brief Handles the reception of a G3LIB-GET Confirm (MAC frame counters only).
+  * 	   The reservation in the log is renewed when the counter gets close to the reserved value.
+  * @param payload Pointer to the payload of the received message.
+  * @retval None
+  */
+static void g3_boot_handle_get_cnf(const void *payload)
+{
+	const G3_LIB_GetAttributeConfirm_t *get_cnf = payload;
+	uint32_t *reserved;
+	uint32_t counter;
+
+	if (get_cnf->attribute.attribute_id.id == MAC_FRAMECOUNTER_ID)
+	{
+		reserved = &boot_log.frame_counter;
+	}
+	else if (get_cnf->attribute.attribute_id.id == MAC_FRAMECOUNTER_RF_ID)
+	{
+		reserved = &boot_log.frame_counter_rf;
+	}
+	else
+	{
+		return;
+	}
+
+	/* The RF counter cannot be read without the RF module, its reservation stays 0 */
+	if (get_cnf->status == G3_SUCCESS)
+	{
+		memcpy(&counter, get_cnf->attribute.value, sizeof(counter));
+
+		if ((counter + (BOOT_SERVER_FRAME_COUNTER_MARGIN / 2)) > *reserved)
+		{
+			*reserved = counter + BOOT_SERVER_FRAME_COUNTER_MARGIN;
+
+			PRINT_G3_BOOT_INFO("Frame counter %s reserved up to %u\n", (reserved == &boot_log.frame_counter) ? "PLC" : "RF", *reserved);
+
+			g3_boot_log_write_counters();
+		}
+	}
+}
+
+/**
+  * @brief Applies a record of the connected device log to the connected device list.
+  * @param record Pointer to the record to apply.
+  * @retval None
+  */
+static void g3_boot_log_apply(const boot_log_record_t *record)
+{
+	boot_device_t *device = g3_app_boot_find_device(record->ext_addr, MAC_BROADCAST_SHORT_ADDR, boot_state_connected);
+
+	if (record->type == boot_log_add)
+	{
+		if (device == NULL)
+		{
+			/* Uses the slot matching the short address if possible (short addresses can be assigned by position) */
+			if (	(record->short_addr > 0							) &&
+					(record->short_addr <= BOOT_MAX_NUM_JOINING_NODES	) &&
+					(boot_server.connected_devices[record->short_addr - 1].conn_state == boot_state_disconnected) )
+			{
+				device = &boot_server.connected_devices[record->short_addr - 1];
+			}
+			else
+			{
+				device = g3_app_boot_find_first_device(boot_state_disconnected);
+			}
+
+			if (device == NULL)
+			{
+				return;
+			}
+
+			boot_server.connected_devices_number++;
+		}
+
+		device->conn_state	= boot_state_connected;
+		device->short_addr	= record->short_addr;
+		device->media_type	= record->media_type;
+		device->disable_bkp	= record->disable_bkp;
+		memcpy(device->ext_addr, record->ext_addr, MAC_ADDR64_SIZE);
+#if ENABLE_ICMP_KEEP_ALIVE
+		device->lives		= KEEP_ALIVE_LIVES_N;
+		device->last_ka_ts	= HAL_GetTick();
+#endif /* ENABLE_ICMP_KEEP_ALIVE */
+	}
+	else if ((record->type == boot_log_remove) && (device != NULL))
+	{
+		device->conn_state = boot_state_disconnected;
+
+		boot_server.connected_devices_number--;
+	}
+}
+#endif /* IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE */
+
 /**
   * @}
   */
@@ -630,6 +894,9 @@ boot_device_t* g3_app_boot_add_connected_device(const uint8_t* ext_addr, const u
 		boot_device->media_type = media_type;
 		boot_device->disable_bkp = disable_bkp;
 #endif /* ENABLE_BOOT_SERVER_ON_HOST */
+#if ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+		g3_boot_log_write(boot_log_add, boot_device);
+#endif
 	}
 
 	return boot_device;
@@ -649,9 +916,18 @@ bool g3_app_boot_remove_connected_device(const uint8_t* ext_addr)
 	{
 #if (DEBUG_G3_BOOT >= DEBUG_LEVEL_FULL)
 		PRINT_G3_BOOT_INFO("Disconnected device %u\n", device->short_addr);
+#endif
+#if ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+		bool logged = (device->conn_state == boot_state_connected); /* Only connected devices are in the log */
 #endif
 		/* Sets the found entry to disconnected state */
 		device->conn_state = boot_state_disconnected;
+#if ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+		if (logged)
+		{
+			g3_boot_log_write(boot_log_remove, device);
+		}
+#endif
 
 		/* Decrements the number of connected devices */
 		boot_server.connected_devices_number--;
@@ -662,6 +938,235 @@ bool g3_app_boot_remove_connected_device(const uint8_t* ext_addr)
 	return removed;
 }
 
+#if ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+/**
+  * @brief Compacts the connected device log: the connected devices are written in the other sector of the log,
+  * 	   which becomes the valid one, then the previous sector is invalidated.
+  * @param None
+  * @retval None
+  * @note The new sector is committed by its header magic, written last: if the power fails before, the previous
+  * 	   sector stays the valid one. If it fails after, the new sector has the highest sequence number.
+  */
+void g3_app_boot_compact_device_log(void)
+{
+	boot_log_header_t header;
+	boot_log_counters_t counters;
+	boot_log_record_t record[BOOT_LOG_COMPACT_CHUNK];
+	uint8_t  sector  = (boot_log.sector + 1) % BOOT_SERVER_DEVICE_LOG_SECTORS;
+	uint32_t records = 0;
+	uint32_t chunk	 = 0;
+	uint32_t magic   = BOOT_SERVER_DEVICE_LOG_MAGIC;
+	bool	 success = SFLASH_ERASE(BOOT_LOG_SECTOR_ADDR(sector), BOOT_SERVER_DEVICE_LOG_SECTOR_SIZE);
+
+	/* Copies the reserved frame counters and the connected devices first */
+	if ((boot_log.frame_counter != 0) || (boot_log.frame_counter_rf != 0))
+	{
+		g3_boot_log_fill_counters(&counters);
+		memcpy(&record[chunk++], &counters, sizeof(boot_log_record_t));
+	}
+
+	for (uint16_t i = 0; (i < BOOT_MAX_NUM_JOINING_NODES) && (success); i++)
+	{
+		if (boot_server.connected_devices[i].conn_state == boot_state_connected)
+		{
+			g3_boot_log_fill(&record[chunk++], boot_log_add, &boot_server.connected_devices[i]);
+		}
+
+		if ((chunk == BOOT_LOG_COMPACT_CHUNK) || ((i == (BOOT_MAX_NUM_JOINING_NODES - 1)) && (chunk > 0)))
+		{
+			success = SFLASH_WRITE(BOOT_LOG_RECORD_ADDR(sector, records), (uint8_t*) record, chunk * sizeof(boot_log_record_t));
+
+			records += chunk;
+			chunk	 = 0;
+		}
+	}
+
+	/* Then the header, with the magic left erased */
+	header.magic	= UINT32_MAX;
+	header.sequence	= boot_log.sequence + 1;
+	header.gmk_crc	= CRC16_CCITT(boot_server.gmk[boot_server.gmk_index], MAC_KEY_SIZE);
+	memset(header.reserved, 0xFF, sizeof(header.reserved));
+
+	if (	(success) &&
+			SFLASH_WRITE(BOOT_LOG_SECTOR_ADDR(sector), (uint8_t*) &header, sizeof(header)) &&
+			SFLASH_WRITE(BOOT_LOG_SECTOR_ADDR(sector) + offsetof(boot_log_header_t, magic), (uint8_t*) &magic, sizeof(magic)) )
+	{
+		/* The new sector is valid, the previous one can be invalidated */
+		if (boot_log.valid)
+		{
+			magic = 0;
+			SFLASH_WRITE(BOOT_LOG_SECTOR_ADDR(boot_log.sector) + offsetof(boot_log_header_t, magic), (uint8_t*) &magic, sizeof(magic));
+		}
+
+		boot_log.valid	  = true;
+		boot_log.sector	  = sector;
+		boot_log.sequence = header.sequence;
+		boot_log.records  = records;
+	}
+	else
+	{
+		PRINT_G3_BOOT_WARNING("Could not compact the connected device log\n");
+
+		boot_log.valid = false;
+	}
+}
+
+/**
+  * @brief Restores the connected device list from the connected device log in the SFLASH (at the start of the PAN).
+  * 	   The devices are discarded if the log was written with a different GMK (the devices have to bootstrap again).
+  * 	   The MAC frame counters of the ST8500 are restored from the values reserved in the log, then reserved again.
+  * @param None
+  * @return Number of devices restored.
+  * @note The frame counters never reach the reserved values, set after a reset they are always above the
+  * 	   values used before it: the restored devices do not discard the frames of the coordinator as replayed.
+  */
+uint16_t g3_app_boot_restore_devices(void)
+{
+	boot_log_header_t header;
+	boot_log_record_t record;
+	boot_log_counters_t counters;
+	bool found	  = false;
+	bool gmk_valid = false;
+	bool torn	  = false;
+	bool restored = false;
+	crc16_t gmk_crc = CRC16_CCITT(boot_server.gmk[boot_server.gmk_index], MAC_KEY_SIZE);
+
+	boot_log.valid			  = false;
+	boot_log.sector			  = 0;
+	boot_log.sequence		  = 0;
+	boot_log.records		  = 0;
+	boot_log.frame_counter	  = 0;
+	boot_log.frame_counter_rf = 0;
+
+	/* Looks for the valid sector with the highest sequence number */
+	for (uint8_t sector = 0; sector < BOOT_SERVER_DEVICE_LOG_SECTORS; sector++)
+	{
+		if (	SFLASH_READ((uint8_t*) &header, BOOT_LOG_SECTOR_ADDR(sector), sizeof(header)) &&
+				(header.magic == BOOT_SERVER_DEVICE_LOG_MAGIC) &&
+				((!found) || ((int32_t) (header.sequence - boot_log.sequence) > 0)) )
+		{
+			found			  = true;
+			boot_log.sector	  = sector;
+			boot_log.sequence = header.sequence;
+			gmk_valid		  = (header.gmk_crc == gmk_crc);
+		}
+	}
+
+	if (found)
+	{
+		/* Replays the log until the first erased (or partially written) record, the frame counters are kept with any GMK */
+		while (boot_log.records < BOOT_LOG_RECORDS_PER_SECTOR)
+		{
+			if (!SFLASH_READ((uint8_t*) &record, BOOT_LOG_RECORD_ADDR(boot_log.sector, boot_log.records), sizeof(record)))
+			{
+				break;
+			}
+
+			if (record.type == boot_log_erased)
+			{
+				break;
+			}
+
+			if (record.crc != CRC16_CCITT(&record, offsetof(boot_log_record_t, crc)))
+			{
+				torn = true;
+				break;
+			}
+
+			if (record.type == boot_log_counters)
+			{
+				memcpy(&counters, &record, sizeof(counters));
+
+				boot_log.frame_counter	  = counters.frame_counter;
+				boot_log.frame_counter_rf = counters.frame_counter_rf;
+				restored				  = true;
+			}
+			else if ((gmk_valid) && (record.gmk_index == boot_server.gmk_index))
+			{
+				g3_boot_log_apply(&record);
+			}
+
+			boot_log.records++;
+		}
+
+		boot_log.valid = gmk_valid;
+
+		if (gmk_valid)
+		{
+			PRINT_G3_BOOT_INFO("Restored %u connected devices (%u log records)\n", boot_server.connected_devices_number, boot_log.records);
+		}
+		else
+		{
+			PRINT_G3_BOOT_WARNING("Connected device log discarded (different GMK)\n");
+		}
+	}
+
+	if (restored)
+	{
+		PRINT_G3_BOOT_INFO("Restored frame counters PLC %u, RF %u\n", boot_log.frame_counter, boot_log.frame_counter_rf);
+
+		/* Restarts the counters from the reserved values, then reserves the next ones */
+		g3_boot_set_frame_counter(MAC_FRAMECOUNTER_ID, boot_log.frame_counter);
+		boot_log.frame_counter += BOOT_SERVER_FRAME_COUNTER_MARGIN;
+
+		if (boot_log.frame_counter_rf != 0)
+		{
+			g3_boot_set_frame_counter(MAC_FRAMECOUNTER_RF_ID, boot_log.frame_counter_rf);
+			boot_log.frame_counter_rf += BOOT_SERVER_FRAME_COUNTER_MARGIN;
+		}
+	}
+
+	/* Compacts the log if it cannot be appended or if most of its records are obsolete */
+	if (	(!boot_log.valid) || (torn) ||
+			(boot_log.records > (BOOT_LOG_RECORDS_PER_SECTOR / 2)) )
+	{
+		g3_app_boot_compact_device_log();
+	}
+	else if (restored)
+	{
+		g3_boot_log_write_counters();
+	}
+
+	/* Reserves the counters periodically (the first check reserves them if the log had none) */
+	g3_app_boot_check_frame_counters();
+	osTimerStart(counterTimerHandle, BOOT_SERVER_FRAME_COUNTER_CHECK_PERIOD);
+
+	return boot_server.connected_devices_number;
+}
+
+/**
+  * @brief Reads the MAC frame counters of the ST8500, their reservation in the connected device log is renewed
+  * 	   at the reception of the confirms, when they get close to the reserved values.
+  * @param None
+  * @retval None
+  */
+void g3_app_boot_check_frame_counters(void)
+{
+	G3_LIB_GetAttributeRequest_t *get_req = MEMPOOL_MALLOC(sizeof(G3_LIB_GetAttributeRequest_t));
+
+	uint16_t len = hi_g3lib_getreq_fill(get_req, MAC_FRAMECOUNTER_ID, 0);
+	g3_send_message(HIF_TX_MSG, HIF_G3LIB_GET_REQ, get_req, len);
+
+	get_req = MEMPOOL_MALLOC(sizeof(G3_LIB_GetAttributeRequest_t));
+
+	len = hi_g3lib_getreq_fill(get_req, MAC_FRAMECOUNTER_RF_ID, 0);
+	g3_send_message(HIF_TX_MSG, HIF_G3LIB_GET_REQ, get_req, len);
+}
+
+/**
+  * @brief Callback function of the counterTimer FreeRTOS timer. Triggers the check of the MAC frame counters.
+  * @param argument Unused argument.
+  * @retval None
+  */
+void g3_app_boot_counter_timeoutCallback(void *argument)
+{
+	UNUSED(argument);
+
+	/* The counters are read by the G3 task, that owns the connected device log */
+	RTOS_PUT_MSG(g3_queueHandle, BOOT_LOG_MSG, NULL);
+}
+#endif /* ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE */
+
 /**
   * @brief Sends a kick request to the Boot Server to kick out a device.
   * @param device_data Pointer to the device to remove.
@@ -683,6 +1188,31 @@ void g3_app_boot_kick_device(boot_device_t *device)
 #endif
 }
 
+/**
+  * @brief Erases the persistent Boot Server data in the SFLASH: the re-keying progress record,
+  * 	   the connected device log and the access list (the image management areas are preserved).
+  * @param None
+  * @return True if the SFLASH erase operation is successful, false otherwise.
+  * @note The connected device log restarts from the devices currently connected, the access list restarts empty.
+  */
+bool g3_app_boot_erase_sflash(void)
+{
+	bool result = SFLASH_ERASE(BOOT_SERVER_SFLASH_START, BOOT_SERVER_SFLASH_END - BOOT_SERVER_SFLASH_START);
+
+	PRINT_G3_BOOT_INFO("Boot Server SFLASH data erased (%s)\n", (result) ? "success" : "failure");
+
+#if ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+	/* The erased sectors hold no valid log, a new one is written with the connected devices */
+	boot_log.valid = false;
+	g3_app_boot_compact_device_log();
+#endif
+
+	/* Reloads the (now empty) access list */
+	g3_boot_access_table_init();
+
+	return result;
+}
+
 #else
 
 /**
@@ -779,6 +1309,9 @@ bool g3_app_boot_msg_needed(const g3_msg_t *g3_msg)
 #endif
 	case HIF_BOOT_SRV_GETPSK_IND:
 	case HIF_BOOT_SRV_SETPSK_CNF:
+#if ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+	case HIF_G3LIB_GET_CNF:
+#endif
 #else
 	case HIF_HI_NVM_CNF:
 	case HIF_BOOT_DEV_START_CNF:
@@ -830,6 +1363,11 @@ void g3_app_boot_msg_handler(const g3_msg_t *g3_msg)
     case HIF_BOOT_SRV_SETPSK_CNF:
         g3_boot_handle_server_setpsk_cnf(g3_msg->payload);
         break;
+#if ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+	case HIF_G3LIB_GET_CNF:
+		g3_boot_handle_get_cnf(g3_msg->payload);
+		break;
+#endif
 #else
 	case HIF_HI_NVM_CNF:
 		g3_boot_handle_nvm_cnf(g3_msg->payload);
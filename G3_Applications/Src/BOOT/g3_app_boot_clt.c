@@ -344,6 +344,56 @@ static void g3_boot_clt_send_pansort_cnf(uint8_t status)
 	g3_send_message(G3_RX_MSG, HIF_BOOT_DEV_PANSORT_CNF, pansort_cnf, sizeof(BOOT_DevicePANSortConfirm_t));
 }
 
+/**
+  * @brief G3 Boot Client function that gets the number of join attempts to the chosen PAN LBA before trying the next one.
+  * @param None
+  * @return The maximum number of join attempts
+  */
+static uint8_t g3_boot_clt_max_join_tries(void)
+{
+	uint8_t max_tries = BOOT_CLIENT_ASSOCIATION_MAX_RETRIES;
+
+	/* A PAN LBA with a weak link is abandoned earlier, if there are other ones in the list */
+	if (	((boot_client.pan_index + 1) < boot_client.pan_count) &&
+			(boot_client.pan_descriptor[boot_client.pan_index].lq < (BOOT_CLIENT_LQI_THRESHOLD + BOOT_CLIENT_BACKOFF_LQI_MARGIN)) )
+	{
+		max_tries /= 2;
+	}
+
+	return max_tries;
+}
+
+/**
+  * @brief G3 Boot Client function that calculates the wait time before the next join attempt,
+  * 	   with an exponential backoff and a random jitter over the whole window.
+  * @param status The status of the failed join attempt
+  * @return The wait time, in ms
+  */
+static uint32_t g3_boot_clt_join_backoff(uint8_t status)
+{
+	uint32_t window = BOOT_CLIENT_BACKOFF_MIN_TIME;
+	uint32_t shift  = (boot_client.join_tries > 0) ? (boot_client.join_tries - 1) : 0;
+
+	if (status == G3_JOINING_DECLINE)
+	{
+		/* The coordinator is reachable but cannot accept the device now (e.g. its joining table is full) */
+		shift += BOOT_CLIENT_BACKOFF_DECLINE_SHIFT;
+	}
+
+	while ((shift > 0) && (window < (BOOT_CLIENT_ASSOCIATION_RAND_WAIT_TIME*configTICK_RATE_HZ)))
+	{
+		window <<= 1;
+		shift--;
+	}
+
+	if (window > (BOOT_CLIENT_ASSOCIATION_RAND_WAIT_TIME*configTICK_RATE_HZ))
+	{
+		window = BOOT_CLIENT_ASSOCIATION_RAND_WAIT_TIME*configTICK_RATE_HZ;
+	}
+
+	return BOOT_CLIENT_BACKOFF_MIN_TIME + (rand() % window);
+}
+
 /**
   * @brief G3 Boot Client function that tries to join the current/next chosen PAN LBA in the list, depending on the retries/LQI.
   * @param None
@@ -353,7 +403,7 @@ static boot_clt_state_t g3_boot_clt_join_chosen_pan(void)
 {
 	boot_clt_state_t next_state;
 
-	if (boot_client.join_tries >= BOOT_CLIENT_ASSOCIATION_MAX_RETRIES)
+	if (boot_client.join_tries >= g3_boot_clt_max_join_tries())
 	{
 		uint16_t pan_id 	= boot_client.pan_descriptor[boot_client.pan_index].pan_id;
 		uint16_t lba_addr 	= boot_client.pan_descriptor[boot_client.pan_index].lba_addr;
@@ -477,7 +527,8 @@ static boot_clt_state_t g3_boot_clt_fsm_start(const void *payload)
 		/* Normal start */
 		srand(HAL_GetTick()); /* Needed to randomize the random wait time between join retries */
 
-		osTimerStart(bootTimerHandle, BOOT_CLIENT_START_WAIT_TIME*configTICK_RATE_HZ); /* Starts the device connection procedure after this time */
+		/* Starts the device connection procedure after this time, with a random jitter to spread the devices restarting together */
+		osTimerStart(bootTimerHandle, BOOT_CLIENT_START_WAIT_TIME*configTICK_RATE_HZ + (rand() % BOOT_CLIENT_START_JITTER_TIME));
 
 		PRINT_G3_BOOT_CLT_INFO("Normal start\n");
 
@@ -727,6 +778,8 @@ static boot_clt_state_t g3_boot_clt_fsm_join_start(const void *payload)
 	PRINT_G3_BOOT_CLT_INFO("Starting from PAN %X, address %u, media %s\n", pan_id, lba_addr, g3_app_pansort_translate_media_type(media_type));
 #endif
 
+	boot_client.join_start_time = HAL_GetTick();
+
 	next_state = g3_boot_clt_join_chosen_pan();
 
 	boot_client.curr_event = BOOT_CLT_EV_NONE;
@@ -786,14 +839,17 @@ static boot_clt_state_t g3_boot_clt_fsm_join_result(const void *payload)
 		g3_send_message(HIF_TX_MSG, HIF_HI_NVM_REQ, hif_nvm_req, len);
 
 		PRINT_G3_BOOT_CLT_INFO("PAN ID and short address saved\n");
+		PRINT_G3_BOOT_CLT_INFO("Joined after %u attempts in %u ms\n", boot_client.join_tries, HAL_GetTick() - boot_client.join_start_time);
+
+		boot_client.join_tries = 0;
 
 		next_state = boot_clt_finish_join();
 	}
 	else
 	{
-		uint32_t retry_time = rand() % (BOOT_CLIENT_ASSOCIATION_RAND_WAIT_TIME*configTICK_RATE_HZ);
+		uint32_t retry_time = g3_boot_clt_join_backoff(network_join_cnf->status);
 
-		PRINT_G3_BOOT_CLT_WARNING("Network join failed. Retrying in %u ms\n", retry_time);
+		PRINT_G3_BOOT_CLT_WARNING("Network join failed (%u=%s). Retrying in %u ms\n", network_join_cnf->status, g3_app_translate_g3_result(network_join_cnf->status), retry_time);
 
 		osTimerStart(bootTimerHandle, retry_time);
 	}
@@ -1195,6 +1251,7 @@ void g3_app_boot_clt_init(void)
 	memset(&boot_client.pan_descriptor, 0, sizeof(boot_client.pan_descriptor));
 	boot_client.pan_index			= 0;
 	boot_client.join_tries			= 0;
+	boot_client.join_start_time		= 0;
 
 	boot_client.pan_id				= 0;
 	boot_client.short_address		= 0;
@@ -25,6 +25,7 @@
 #include <g3_app_boot_srv.h>
 #include <g3_app_boot.h>
 #include <g3_boot_srv_eap.h>
+#include <g3_app_keep_alive.h>
 #include <main.h>
 
 
@@ -413,6 +414,20 @@ static boot_srv_state_t g3_boot_srv_fsm_net_start_cnf(const void *payload)
 	{
 		PRINT_G3_BOOT_SRV_INFO("PAN %X started\n", boot_server.pan_id);
 
+#if ENABLE_DEVICE_TABLE_RESTORE
+		/* Restores the devices connected before the reset of the host, they do not need to bootstrap again */
+		if (g3_app_boot_restore_devices() > 0)
+		{
+#if ENABLE_ICMP_KEEP_ALIVE
+			/* Starts the keep-alive, if not already running, or adds the restored devices to the schedule */
+			if (!g3_app_ka_start())
+			{
+				RTOS_PUT_MSG(g3_queueHandle, KA_MSG, NULL);
+			}
+#endif /* ENABLE_ICMP_KEEP_ALIVE */
+		}
+#endif /* ENABLE_DEVICE_TABLE_RESTORE */
+
 		next_state = BOOT_SRV_ST_ACTIVE;
 	}
 	else
@@ -466,6 +481,11 @@ static boot_srv_state_t g3_boot_srv_fsm_lbp_cnf(const void *payload)
 
 				g3_boot_srv_eap_fsm_manager(NULL, join_entry);
 			}
+			else if (join_entry->rekeying)
+			{
+				/* The accept could not be sent, the re-keying of the device is retried */
+				g3_boot_srv_eap_rekeying_failed(join_entry, rekeying_error_msg_4);
+			}
 		}
 	}
 
@@ -593,7 +613,18 @@ static boot_srv_state_t g3_boot_srv_fsm_lbp_ind(const void *payload)
 					}
 					else
 					{
-						Error_Handler(); /* Joining Entry Table full */
+						/* Joining Entry Table full: declines the join, the device retries with a longer backoff */
+						boot_join_entry_t busy_entry;
+
+						memset(&busy_entry, 0, sizeof(busy_entry));
+						memcpy(busy_entry.ext_addr, lbp_eap_msg.lbp_msg->header.lbd_addr, sizeof(busy_entry.ext_addr));
+						busy_entry.lba_addr	   = lbp_eap_msg.lba_addr;
+						busy_entry.media_type  = media_type;
+						busy_entry.disable_bkp = lbp_eap_msg.lbp_msg->header.disable_bkp;
+
+						PRINT_G3_BOOT_SRV_WARNING("Joining table full, declining the join\n");
+
+						g3_adp_lbp_send_decline(&busy_entry, boot_server.pan_id, boot_server.nsdu_handle++);
 					}
 				}
 				break;
@@ -682,18 +713,16 @@ static boot_srv_state_t g3_boot_srv_fsm_timeout(const void *payload)
 					{
 						if (join_entry->curr_state == BOOT_SRV_EAP_ST_WAIT_SECOND)
 						{
-							boot_server.rekeying_error = rekeying_error_msg_2;
+							g3_boot_srv_eap_rekeying_failed(join_entry, rekeying_error_msg_2);
 						}
 						else if (join_entry->curr_state == BOOT_SRV_EAP_ST_WAIT_FOURTH)
 						{
-							boot_server.rekeying_error = rekeying_error_msg_4;
+							g3_boot_srv_eap_rekeying_failed(join_entry, rekeying_error_msg_4);
 						}
-						else if (join_entry->curr_state == BOOT_SRV_EAP_ST_WAIT_PARAM)
+						else
 						{
-							boot_server.rekeying_error = rekeying_error_param;
+							g3_boot_srv_eap_rekeying_failed(join_entry, rekeying_error_param);
 						}
-
-						g3_boot_srv_eap_rekeying_fsm();
 					}
 					else
 					{
@@ -1248,6 +1277,8 @@ void g3_app_boot_srv_init(void)
 	boot_server.rekeying_count	= 0;
 	boot_server.rekeyed_count	= 0;
 	boot_server.activated_count = 0;
+	memset(boot_server.rekeying_state,	 rekeying_device_idle, sizeof(boot_server.rekeying_state));
+	memset(boot_server.rekeying_retries, 0,					sizeof(boot_server.rekeying_retries));
 
 	/* The connected device list is initialized in 'g3_app_boot_init' */
 }
@@ -14,11 +14,16 @@
 
 /* Inclusions */
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
+#include <cmsis_os.h>
 #include <debug_print.h>
 #include <utils.h>
+#include <crc.h>
+#include <sflash.h>
 #include <g3_app_config.h>
 #include <g3_app_attrib_tbl.h>
+#include <g3_app_boot_constants.h>
 #include <g3_boot_access_tbl.h>
 #include <main.h>
 
@@ -43,6 +48,66 @@
 #define DEVICE_1_EXT_ADDR	{0x00, 0x80, 0xE1, 0xFF, 0xFE, 0x00, 0x00, 0x00}
 #define DEVICE_2_EXT_ADDR	{0x00, 0x80, 0xE1, 0xFF, 0xFE, 0x00, 0x00, 0x00}
 
+#if ENABLE_ACCESS_LIST_STORAGE
+/* Access list in the SFLASH: each area starts with a header, followed by the slots appended at each addition/update */
+typedef enum g3_boot_access_slot_type_enum
+{
+	access_slot_deleted	= 0x00,
+	access_slot_valid	= 0x01,
+	access_slot_erased	= 0xFF,
+} g3_boot_access_slot_type_t;
+
+#pragma pack(push, 1)
+typedef struct g3_boot_access_header_str
+{
+	uint32_t	magic;			/* BOOT_SERVER_ACCESS_LIST_MAGIC if valid, 0 once compacted into the other area */
+	uint32_t	sequence;		/* Incremented at each compaction */
+	uint8_t		reserved[24];
+} g3_boot_access_header_t;
+
+typedef struct g3_boot_access_slot_str
+{
+	uint8_t		type;			/* g3_boot_access_slot_type_t, cleared to delete the slot */
+	uint8_t		reserved;
+	uint16_t	short_addr;
+	uint8_t		ext_addr[MAC_ADDR64_SIZE];
+	uint8_t		psk[ADP_EAP_PSK_KEY_LEN];
+	uint8_t		reserved_2[2];
+	crc16_t		crc;			/* CRC16 of the previous fields, detects partially written slots */
+} g3_boot_access_slot_t;
+#pragma pack(pop)
+
+/* RAM index of the access list: open addressing hash table of slot indexes, with a tag (8 bits of the hash)
+ * for each bucket, so that a lookup reads from the SFLASH only the slots that are likely to match */
+typedef struct g3_boot_access_list_str
+{
+	bool		valid;			/* The list can be appended */
+	uint8_t		area;			/* Area in use */
+	uint32_t	sequence;		/* Sequence number of the area in use */
+	uint16_t	slots;			/* Number of slots written in the area in use */
+	uint16_t	entries;		/* Number of valid entries */
+	uint16_t	index[BOOT_SERVER_ACCESS_LIST_HASH_SIZE];
+	uint8_t		tag[BOOT_SERVER_ACCESS_LIST_HASH_SIZE];
+} g3_boot_access_list_t;
+
+#define ACCESS_LIST_AREA_ADDR(area)			(BOOT_SERVER_ACCESS_LIST_ADDR + ((area) * BOOT_SERVER_ACCESS_LIST_AREA_SIZE))
+#define ACCESS_LIST_SLOT_ADDR(area, slot)	(ACCESS_LIST_AREA_ADDR(area) + sizeof(g3_boot_access_header_t) + ((slot) * sizeof(g3_boot_access_slot_t)))
+#define ACCESS_LIST_SLOTS_PER_AREA			((BOOT_SERVER_ACCESS_LIST_AREA_SIZE - sizeof(g3_boot_access_header_t)) / sizeof(g3_boot_access_slot_t))
+
+#define ACCESS_LIST_HASH_MASK				(BOOT_SERVER_ACCESS_LIST_HASH_SIZE - 1)
+#define ACCESS_LIST_BUCKET_EMPTY			0xFFFF
+#define ACCESS_LIST_BUCKET_DELETED			0xFFFE
+#define ACCESS_LIST_NO_BUCKET				0xFFFFFFFF
+
+#if (BOOT_SERVER_ACCESS_LIST_HASH_SIZE & ACCESS_LIST_HASH_MASK) != 0
+#error "The size of the access list index must be a power of 2"
+#endif
+
+#if (BOOT_SERVER_ACCESS_LIST_HASH_SIZE < (2 * BOOT_SERVER_ACCESS_LIST_MAX_ENTRIES))
+#error "The access list index must have at least twice the buckets of the maximum number of entries"
+#endif
+#endif /* ENABLE_ACCESS_LIST_STORAGE */
+
 /* Private variables */
 
 /* G3 Boot access table  */
@@ -70,6 +135,13 @@ static g3_boot_data_t g3_boot_access_table[] = {
      */
 };
 
+#if ENABLE_ACCESS_LIST_STORAGE
+static g3_boot_access_list_t	g3_boot_access_list;
+
+/* External variables */
+extern osMutexId_t mutexAccessListHandle;
+#endif /* ENABLE_ACCESS_LIST_STORAGE */
+
 /* Private Functions */
 
 /**
@@ -104,6 +176,257 @@ static int g3_boot_data_tbl_compare_ext_addr(const void *first, const void *seco
     return 0;
 }
 
+#if ENABLE_ACCESS_LIST_STORAGE
+/**
+  * @brief Calculates the hash (FNV-1a) of an extended address.
+  * @param ext_addr Pointer to the extended address.
+  * @return Hash of the extended address.
+  */
+static uint32_t g3_boot_access_list_hash(const uint8_t *ext_addr)
+{
+	uint32_t hash = 2166136261U;
+
+	for (uint32_t i = 0; i < MAC_ADDR64_SIZE; i++)
+	{
+		hash ^= ext_addr[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/**
+  * @brief Looks for an extended address in the index of the access list.
+  * @param ext_addr Pointer to the extended address to look for.
+  * @param slot Pointer to the slot where the entry read from the SFLASH is copied.
+  * @return Bucket of the entry in the index, if found, ACCESS_LIST_NO_BUCKET otherwise.
+  */
+static uint32_t g3_boot_access_list_lookup(const uint8_t *ext_addr, g3_boot_access_slot_t *slot)
+{
+	uint32_t hash	= g3_boot_access_list_hash(ext_addr);
+	uint32_t bucket	= hash & ACCESS_LIST_HASH_MASK;
+	uint8_t  tag	= (uint8_t) (hash >> 24);
+
+	for (uint32_t probes = 0; probes < BOOT_SERVER_ACCESS_LIST_HASH_SIZE; probes++)
+	{
+		uint16_t index = g3_boot_access_list.index[bucket];
+
+		if (index == ACCESS_LIST_BUCKET_EMPTY)
+		{
+			break;
+		}
+
+		/* Reads the slot only if the tag matches */
+		if (	(index != ACCESS_LIST_BUCKET_DELETED			) &&
+				(g3_boot_access_list.tag[bucket] == tag			) &&
+				SFLASH_READ((uint8_t*) slot, ACCESS_LIST_SLOT_ADDR(g3_boot_access_list.area, index), sizeof(*slot)) &&
+				(slot->type == access_slot_valid				) &&
+				(memcmp(slot->ext_addr, ext_addr, MAC_ADDR64_SIZE) == 0) )
+		{
+			return bucket;
+		}
+
+		bucket = (bucket + 1) & ACCESS_LIST_HASH_MASK;
+	}
+
+	return ACCESS_LIST_NO_BUCKET;
+}
+
+/**
+  * @brief Adds a slot to the index of the access list.
+  * @param ext_addr Pointer to the extended address of the slot.
+  * @param index Index of the slot in the area in use.
+  * @return True if the slot was added, false if the index is full.
+  */
+static bool g3_boot_access_list_index_add(const uint8_t *ext_addr, uint16_t index)
+{
+	uint32_t hash	= g3_boot_access_list_hash(ext_addr);
+	uint32_t bucket	= hash & ACCESS_LIST_HASH_MASK;
+
+	for (uint32_t probes = 0; probes < BOOT_SERVER_ACCESS_LIST_HASH_SIZE; probes++)
+	{
+		if (	(g3_boot_access_list.index[bucket] == ACCESS_LIST_BUCKET_EMPTY	) ||
+				(g3_boot_access_list.index[bucket] == ACCESS_LIST_BUCKET_DELETED) )
+		{
+			g3_boot_access_list.index[bucket] = index;
+			g3_boot_access_list.tag[bucket]   = (uint8_t) (hash >> 24);
+			return true;
+		}
+
+		bucket = (bucket + 1) & ACCESS_LIST_HASH_MASK;
+	}
+
+	return false;
+}
+
+/**
+  * @brief Loads the area in use of the access list, building its index.
+  * @param None
+  * @return True if a partially written slot was found (the area must be compacted), false otherwise.
+  */
+static bool g3_boot_access_list_load(void)
+{
+	g3_boot_access_slot_t slot;
+	g3_boot_access_slot_t old_slot;
+	bool torn = false;
+
+	memset(g3_boot_access_list.index, 0xFF, sizeof(g3_boot_access_list.index));
+	g3_boot_access_list.slots	= 0;
+	g3_boot_access_list.entries	= 0;
+
+	/* Reads the slots until the first erased (or partially written) one */
+	while (g3_boot_access_list.slots < ACCESS_LIST_SLOTS_PER_AREA)
+	{
+		if (!SFLASH_READ((uint8_t*) &slot, ACCESS_LIST_SLOT_ADDR(g3_boot_access_list.area, g3_boot_access_list.slots), sizeof(slot)))
+		{
+			break;
+		}
+
+		if (slot.type == access_slot_erased)
+		{
+			break;
+		}
+
+		if (slot.type == access_slot_valid)
+		{
+			if (slot.crc != CRC16_CCITT(&slot, offsetof(g3_boot_access_slot_t, crc)))
+			{
+				torn = true;
+				break;
+			}
+
+			/* An update appends the new slot before deleting the old one, the newest slot is kept if both are valid */
+			uint32_t bucket = g3_boot_access_list_lookup(slot.ext_addr, &old_slot);
+
+			if (bucket != ACCESS_LIST_NO_BUCKET)
+			{
+				g3_boot_access_list.index[bucket] = g3_boot_access_list.slots;
+			}
+			else if (g3_boot_access_list_index_add(slot.ext_addr, g3_boot_access_list.slots))
+			{
+				g3_boot_access_list.entries++;
+			}
+		}
+
+		g3_boot_access_list.slots++;
+	}
+
+	return torn;
+}
+
+/**
+  * @brief Compacts the access list: the valid entries are copied in the other area of the list,
+  * 	   which becomes the valid one, then the previous area is invalidated.
+  * @param None
+  * @return True if the list was compacted, false otherwise.
+  * @note The new area is committed by its header magic, written after the entries: if the power fails before,
+  * 	   the previous area stays the valid one. If it fails after, the new area has the highest sequence number.
+  */
+static bool g3_boot_access_list_compact(void)
+{
+	g3_boot_access_header_t header;
+	g3_boot_access_slot_t slot;
+	uint8_t  area	= (g3_boot_access_list.area + 1) % BOOT_SERVER_ACCESS_LIST_AREAS;
+	uint16_t copied	= 0;
+	uint32_t magic	= BOOT_SERVER_ACCESS_LIST_MAGIC;
+	bool	 success = SFLASH_ERASE(ACCESS_LIST_AREA_ADDR(area), BOOT_SERVER_ACCESS_LIST_AREA_SIZE);
+
+	if (g3_boot_access_list.valid)
+	{
+		/* Copies the entries of the index first, in the order they were written */
+		for (uint16_t i = 0; (i < g3_boot_access_list.slots) && (success); i++)
+		{
+			if (	SFLASH_READ((uint8_t*) &slot, ACCESS_LIST_SLOT_ADDR(g3_boot_access_list.area, i), sizeof(slot)) &&
+					(slot.type == access_slot_valid) &&
+					(slot.crc == CRC16_CCITT(&slot, offsetof(g3_boot_access_slot_t, crc))) )
+			{
+				success = SFLASH_WRITE(ACCESS_LIST_SLOT_ADDR(area, copied), (uint8_t*) &slot, sizeof(slot));
+				copied++;
+			}
+		}
+	}
+
+	/* Then the header, with the magic left erased */
+	header.magic	= UINT32_MAX;
+	header.sequence	= g3_boot_access_list.sequence + 1;
+	memset(header.reserved, 0xFF, sizeof(header.reserved));
+
+	if (	(success) &&
+			SFLASH_WRITE(ACCESS_LIST_AREA_ADDR(area), (uint8_t*) &header, sizeof(header)) &&
+			SFLASH_WRITE(ACCESS_LIST_AREA_ADDR(area) + offsetof(g3_boot_access_header_t, magic), (uint8_t*) &magic, sizeof(magic)) )
+	{
+		/* The new area is valid, the previous one can be invalidated */
+		if (g3_boot_access_list.valid)
+		{
+			magic = 0;
+			SFLASH_WRITE(ACCESS_LIST_AREA_ADDR(g3_boot_access_list.area) + offsetof(g3_boot_access_header_t, magic), (uint8_t*) &magic, sizeof(magic));
+		}
+
+		g3_boot_access_list.valid	 = true;
+		g3_boot_access_list.area	 = area;
+		g3_boot_access_list.sequence = header.sequence;
+
+		g3_boot_access_list_load();
+
+		PRINT_G3_BOOT_INFO("Access list compacted (%u entries)\n", g3_boot_access_list.entries);
+	}
+	else
+	{
+		/* The previous area was not invalidated, it stays in use */
+		PRINT_G3_BOOT_WARNING("Could not compact the access list\n");
+
+		success = false;
+	}
+
+	return success;
+}
+
+/**
+  * @brief Opens the access list stored in the SFLASH, loading the area with the highest sequence number.
+  * @param None
+  * @retval None
+  */
+static void g3_boot_access_list_open(void)
+{
+	g3_boot_access_header_t header;
+	bool torn = false;
+
+	memset(g3_boot_access_list.index, 0xFF, sizeof(g3_boot_access_list.index));
+	g3_boot_access_list.valid		= false;
+	g3_boot_access_list.area		= 0;
+	g3_boot_access_list.sequence	= 0;
+	g3_boot_access_list.slots		= 0;
+	g3_boot_access_list.entries		= 0;
+
+	for (uint8_t area = 0; area < BOOT_SERVER_ACCESS_LIST_AREAS; area++)
+	{
+		if (	SFLASH_READ((uint8_t*) &header, ACCESS_LIST_AREA_ADDR(area), sizeof(header)) &&
+				(header.magic == BOOT_SERVER_ACCESS_LIST_MAGIC) &&
+				((!g3_boot_access_list.valid) || ((int32_t) (header.sequence - g3_boot_access_list.sequence) > 0)) )
+		{
+			g3_boot_access_list.valid	 = true;
+			g3_boot_access_list.area	 = area;
+			g3_boot_access_list.sequence = header.sequence;
+		}
+	}
+
+	/* The list is created at the first addition */
+	if (g3_boot_access_list.valid)
+	{
+		torn = g3_boot_access_list_load();
+
+		PRINT_G3_BOOT_INFO("Access list loaded (%u entries)\n", g3_boot_access_list.entries);
+
+		/* Compacts the list if it cannot be appended or if most of its slots are obsolete */
+		if (	(torn) ||
+				((g3_boot_access_list.slots - g3_boot_access_list.entries) > (ACCESS_LIST_SLOTS_PER_AREA / 2)) )
+		{
+			g3_boot_access_list_compact();
+		}
+	}
+}
+#endif /* ENABLE_ACCESS_LIST_STORAGE */
+
 /**
   * @}
   */
@@ -123,24 +446,168 @@ void g3_boot_access_table_init(void)
 {
 	/* Sorts by extended address */
 	qsort(g3_boot_access_table, NUM_OF_ELEM(g3_boot_access_table), sizeof(g3_boot_access_table[0]), g3_boot_data_tbl_compare_ext_addr);
+
+#if ENABLE_ACCESS_LIST_STORAGE
+	osMutexAcquire(mutexAccessListHandle, osWaitForever);
+	g3_boot_access_list_open();
+	osMutexRelease(mutexAccessListHandle);
+#endif
 }
 
 /**
-  * @brief Looks for a device with a specific extended address inside the G3 Boot access table (which is read only).
+  * @brief Looks for a device with a specific extended address inside the G3 Boot access table (which is read only),
+  * 	   then inside the access list stored in the SFLASH.
   * @param extended_address Pointer to the extended address of the desired device.
-  * @return Pointer to the desired device, if found, NULL otherwise.
+  * @param entry Pointer to the buffer where the entry of the device is copied, if found.
+  * @return True if the device was found, false otherwise.
+  * @note The entry is copied while the access list is locked, it stays consistent if the list is updated later.
   */
-g3_boot_data_t *g3_boot_access_table_find(const uint8_t *extended_address)
+bool g3_boot_access_table_find(const uint8_t *extended_address, g3_boot_data_t *entry)
 {
-	g3_boot_data_t *data_entry;
+	const g3_boot_data_t *data_entry;
     g3_boot_data_t key = { 0 };
+    bool found = false;
 
     memcpy(key.ext_addr, extended_address, sizeof(key.ext_addr));
 
     data_entry = bsearch(&key, g3_boot_access_table, NUM_OF_ELEM(g3_boot_access_table), sizeof(g3_boot_access_table[0]), g3_boot_data_tbl_compare_ext_addr);
 
-    return data_entry;
+    if (data_entry != NULL)
+    {
+    	memcpy(entry, data_entry, sizeof(*entry));
+    	found = true;
+    }
+#if ENABLE_ACCESS_LIST_STORAGE
+    else
+    {
+    	g3_boot_access_slot_t slot;
+
+    	osMutexAcquire(mutexAccessListHandle, osWaitForever);
+
+    	if (	(g3_boot_access_list.entries > 0) &&
+    			(g3_boot_access_list_lookup(extended_address, &slot) != ACCESS_LIST_NO_BUCKET) )
+    	{
+    		entry->short_addr = slot.short_addr;
+    		memcpy(entry->ext_addr, slot.ext_addr, sizeof(entry->ext_addr));
+    		memcpy(entry->psk,		slot.psk,	   sizeof(entry->psk));
+
+    		found = true;
+    	}
+
+    	osMutexRelease(mutexAccessListHandle);
+    }
+#endif /* ENABLE_ACCESS_LIST_STORAGE */
+
+    return found;
+}
+
+#if ENABLE_ACCESS_LIST_STORAGE
+/**
+  * @brief Adds an entry to the access list stored in the SFLASH, or updates it if its extended address is already in the list.
+  * @param entry Pointer to the entry to add.
+  * @return True if the entry was added or updated, false otherwise.
+  */
+bool g3_boot_access_table_add(const g3_boot_data_t *entry)
+{
+	g3_boot_access_slot_t slot;
+	g3_boot_access_slot_t old_slot;
+	uint32_t bucket;
+	uint8_t deleted = access_slot_deleted;
+	bool added = false;
+
+	osMutexAcquire(mutexAccessListHandle, osWaitForever);
+
+	/* Creates the list, or frees the obsolete slots when the area is full */
+	if (	(!g3_boot_access_list.valid) ||
+			(g3_boot_access_list.slots >= ACCESS_LIST_SLOTS_PER_AREA) )
+	{
+		g3_boot_access_list_compact();
+	}
+
+	bucket = g3_boot_access_list_lookup(entry->ext_addr, &old_slot);
+
+	if (	(g3_boot_access_list.valid) &&
+			(g3_boot_access_list.slots < ACCESS_LIST_SLOTS_PER_AREA) &&
+			((bucket != ACCESS_LIST_NO_BUCKET) || (g3_boot_access_list.entries < BOOT_SERVER_ACCESS_LIST_MAX_ENTRIES)) )
+	{
+		slot.type		= access_slot_valid;
+		slot.reserved	= 0xFF;
+		slot.short_addr	= entry->short_addr;
+		memcpy(slot.ext_addr, entry->ext_addr, sizeof(slot.ext_addr));
+		memcpy(slot.psk,	  entry->psk,	   sizeof(slot.psk));
+		memset(slot.reserved_2, 0xFF, sizeof(slot.reserved_2));
+		slot.crc		= CRC16_CCITT(&slot, offsetof(g3_boot_access_slot_t, crc));
+
+		if (SFLASH_WRITE(ACCESS_LIST_SLOT_ADDR(g3_boot_access_list.area, g3_boot_access_list.slots), (uint8_t*) &slot, sizeof(slot)))
+		{
+			if (bucket != ACCESS_LIST_NO_BUCKET)
+			{
+				/* Deletes the previous slot of the entry, after writing the new one */
+				SFLASH_WRITE(ACCESS_LIST_SLOT_ADDR(g3_boot_access_list.area, g3_boot_access_list.index[bucket]), &deleted, sizeof(deleted));
+
+				g3_boot_access_list.index[bucket] = g3_boot_access_list.slots;
+				added = true;
+			}
+			else if (g3_boot_access_list_index_add(slot.ext_addr, g3_boot_access_list.slots))
+			{
+				g3_boot_access_list.entries++;
+				added = true;
+			}
+
+			g3_boot_access_list.slots++;
+		}
+	}
+
+	osMutexRelease(mutexAccessListHandle);
+
+	if (!added)
+	{
+		PRINT_G3_BOOT_WARNING("Could not add the entry to the access list\n");
+	}
+
+	return added;
+}
+
+/**
+  * @brief Removes an entry from the access list stored in the SFLASH.
+  * @param extended_address Pointer to the extended address of the entry to remove.
+  * @return True if the entry was removed, false if it was not found.
+  * @note The entries of the built-in table cannot be removed.
+  */
+bool g3_boot_access_table_remove(const uint8_t *extended_address)
+{
+	g3_boot_access_slot_t slot;
+	uint8_t deleted = access_slot_deleted;
+	bool removed = false;
+
+	osMutexAcquire(mutexAccessListHandle, osWaitForever);
+
+	uint32_t bucket = g3_boot_access_list_lookup(extended_address, &slot);
+
+	if (bucket != ACCESS_LIST_NO_BUCKET)
+	{
+		SFLASH_WRITE(ACCESS_LIST_SLOT_ADDR(g3_boot_access_list.area, g3_boot_access_list.index[bucket]), &deleted, sizeof(deleted));
+
+		g3_boot_access_list.index[bucket] = ACCESS_LIST_BUCKET_DELETED;
+		g3_boot_access_list.entries--;
+		removed = true;
+	}
+
+	osMutexRelease(mutexAccessListHandle);
+
+	return removed;
+}
+
+/**
+  * @brief Gets the number of entries of the access list stored in the SFLASH.
+  * @param None
+  * @return Number of entries.
+  */
+uint16_t g3_boot_access_table_count(void)
+{
+	return g3_boot_access_list.entries;
 }
+#endif /* ENABLE_ACCESS_LIST_STORAGE */
 
 #endif /* IS_COORD */
 
@@ -24,6 +24,8 @@
 #include <g3_app_boot_constants.h>
 #include <g3_app_boot.h>
 #include <g3_boot_srv_eap.h>
+#include <crc.h>
+#include <sflash.h>
 #include <main.h>
 
 
@@ -63,6 +65,19 @@ typedef enum boot_srv_err_enum
 	srv_err_entry_table_full_no_rollback,
 } boot_srv_err_t;
 
+#if ENABLE_REKEYING_RECORD
+/* Re-keying progress record, followed in the SFLASH by the extended addresses of the devices that received the new GMK */
+typedef struct boot_srv_rk_record_str
+{
+	uint32_t	magic;		/* BOOT_SERVER_REKEYING_RECORD_MAGIC if valid */
+	crc16_t		gmk_crc;	/* CRC16 of the GMK being distributed (the key itself is not stored) */
+	uint8_t		gmk_index;	/* Index of the GMK being distributed */
+	uint8_t		reserved;
+} boot_srv_rk_record_t;
+
+#define BOOT_SERVER_REKEYING_RECORD_SLOTS	((BOOT_SERVER_REKEYING_RECORD_SIZE - sizeof(boot_srv_rk_record_t)) / MAC_ADDR64_SIZE)
+#endif
+
 /* External variables */
 extern boot_server_t 		boot_server;
 
@@ -72,6 +87,11 @@ extern osTimerId_t			bootTimerHandle;
 
 extern osTimerId_t			serverTimerHandle;
 
+#if ENABLE_REKEYING_RECORD
+/* Private variables */
+static uint32_t				rekeying_record_slots; /* Number of addresses written in the re-keying progress record */
+#endif
+
 /* State Functions */
 static void g3_boot_srv_eap_fsm_default(          const lbp_ind_t *lbp_eap_msg, boot_join_entry_t *join_entry);
 static void g3_boot_srv_eap_fsm_send_1(           const lbp_ind_t *lbp_eap_msg, boot_join_entry_t *join_entry);
@@ -81,6 +101,8 @@ static void g3_boot_srv_eap_fsm_recv_4(           const lbp_ind_t *lbp_eap_msg,
 static void g3_boot_srv_eap_fsm_accepted(         const lbp_ind_t *lbp_eap_msg, boot_join_entry_t *join_entry);
 static void g3_boot_srv_eap_fsm_recv_param_result(const lbp_ind_t* lbp_eap_msg, boot_join_entry_t* join_entry);
 
+static void g3_boot_srv_eap_rk_succeeded(boot_join_entry_t *join_entry);
+
 /**
   * @brief State function for Bootstrap Procedure Handling
   */
@@ -124,7 +146,13 @@ static void g3_boot_complete_bootstrap(boot_join_entry_t* join_entry)
 	g3_send_message(G3_RX_MSG, HIF_BOOT_SRV_JOIN_IND, srvjoin_ind, len);
 
 	/* Sets the device to the connected state */
-	g3_app_boot_add_connected_device(join_entry->ext_addr, join_entry->short_addr, join_entry->media_type, join_entry->disable_bkp);
+	boot_device_t *boot_device = g3_app_boot_add_connected_device(join_entry->ext_addr, join_entry->short_addr, join_entry->media_type, join_entry->disable_bkp);
+
+	if (boot_device != NULL)
+	{
+		/* The bootstrap aligns the GMK of the device, it is taken into account by the re-keying only if needed (see g3_boot_srv_eap_rk_start_phase) */
+		boot_server.rekeying_state[boot_device - boot_server.connected_devices] = rekeying_device_idle;
+	}
 
 	/* Remove entry when done */
 	g3_boot_srv_join_entry_remove(join_entry);
@@ -226,9 +254,7 @@ static void g3_boot_srv_eap_fsm_recv_2(const lbp_ind_t *lbp_eap_msg, boot_join_e
 
 		if (join_entry->rekeying)
 		{
-			boot_server.rekeying_error = rekeying_error_msg_2;
-
-			g3_boot_srv_eap_rekeying_fsm();
+			g3_boot_srv_eap_rekeying_failed(join_entry, rekeying_error_msg_2);
 		}
 		else
 		{
@@ -366,10 +392,12 @@ static void g3_boot_srv_eap_fsm_send_3(const lbp_ind_t *lbp_eap_msg, boot_join_e
 
 		if (join_entry->rekeying)
 		{
-			boot_server.rekeying_error = rekeying_error_msg_2;
+			g3_boot_srv_eap_rekeying_failed(join_entry, rekeying_error_msg_2);
+		}
+		else
+		{
+			join_entry->curr_state = BOOT_SRV_EAP_ST_WAIT_JOIN;
 		}
-
-		join_entry->curr_state = BOOT_SRV_EAP_ST_WAIT_JOIN;
 	}
 }
 
@@ -470,9 +498,7 @@ static void g3_boot_srv_eap_fsm_recv_4(const lbp_ind_t *lbp_eap_msg, boot_join_e
 
 		if (join_entry->rekeying)
 		{
-			boot_server.rekeying_error = rekeying_error_msg_4;
-
-			g3_boot_srv_eap_rekeying_fsm();
+			g3_boot_srv_eap_rekeying_failed(join_entry, rekeying_error_msg_4);
 		}
 		else
 		{
@@ -493,24 +519,8 @@ static void g3_boot_srv_eap_fsm_accepted(const lbp_ind_t *lbp_eap_msg, boot_join
 
 	if (join_entry->rekeying)
 	{
-		/* Set device to the next re-keying step */
-		join_entry->curr_state = BOOT_SRV_EAP_ST_WAIT_PARAM;
-
-#if ENABLE_REKEYING_DELAYS
-		if (boot_server.rekeyed_count < boot_server.rekeying_count)
-		{
-			/* Continues the "Send GMK" phase */
-			g3_boot_srv_eap_rekeying_fsm();
-		}
-		else
-		{
-			/* Proceeds to the "Activate GMK" phase */
-			osTimerStart(serverTimerHandle, REKEYING_ACTIVATE_GMK_PHASE_DELAY);
-		}
-#else
-		/* Continues the "Send GMK" phase or proceeds to the "Activate GMK" phase */
-		g3_boot_srv_eap_rekeying_fsm();
-#endif
+		/* The device holds the new GMK, continues the "Send GMK" phase */
+		g3_boot_srv_eap_rk_succeeded(join_entry);
 	}
 	else
 	{
@@ -552,22 +562,8 @@ static void g3_boot_srv_eap_fsm_recv_param_result(const lbp_ind_t* lbp_eap_msg,
 	{
 		if (join_entry->rekeying)
 		{
-			join_entry->curr_state = BOOT_SRV_EAP_ST_WAIT_JOIN;
-#if ENABLE_REKEYING_DELAYS
-			if (boot_server.activated_count < boot_server.rekeying_count)
-			{
-				/* Continues the "Activate GMK" phase */
-				g3_boot_srv_eap_rekeying_fsm();
-			}
-			else
-			{
-				/* Proceeds to the "Set GMK index" phase */
-				osTimerStart(serverTimerHandle, REKEYING_SET_GMK_INDEX_PHASE_DELAY);
-			}
-#else
-			/* Continues the "Activate GMK" phase or proceeds to the "Set GMK index" phase */
-			g3_boot_srv_eap_rekeying_fsm();
-#endif
+			/* The device switched its active GMK, continues the "Activate GMK" (or "Deactivate GMK") phase */
+			g3_boot_srv_eap_rk_succeeded(join_entry);
 		}
 		else
 		{
@@ -579,13 +575,186 @@ static void g3_boot_srv_eap_fsm_recv_param_result(const lbp_ind_t* lbp_eap_msg,
 		if (join_entry->rekeying)
 		{
 			/* Handles the error of the parameter configuration */
-			boot_server.rekeying_error = rekeying_error_param;
+			g3_boot_srv_eap_rekeying_failed(join_entry, rekeying_error_param);
+		}
+	}
+}
+
+/**
+ * @brief   G3 Boot EAP function that returns the index of the connected device related to a re-keying entry
+ * @param   [in] join_entry The re-keying entry
+ * @return  The index of the device in the connected device list, BOOT_MAX_NUM_JOINING_NODES if the device is not connected
+ */
+static uint32_t g3_boot_srv_eap_rk_device_index(const boot_join_entry_t *join_entry)
+{
+	boot_device_t *boot_device = g3_app_boot_find_device(join_entry->ext_addr, MAC_BROADCAST_SHORT_ADDR, boot_state_connected);
 
-			g3_boot_srv_eap_rekeying_fsm();
+	return (boot_device != NULL) ? (uint32_t) (boot_device - boot_server.connected_devices) : BOOT_MAX_NUM_JOINING_NODES;
+}
+
+/**
+ * @brief   G3 Boot EAP function that gives the device states handled by the current re-keying phase
+ * @param   [out] from The state of the devices to process
+ * @param   [out] busy The state of the devices being processed
+ * @param   [out] done The state of the devices processed
+ * @return  'true' if the current re-keying phase is performed device by device, 'false' otherwise
+ */
+static bool g3_boot_srv_eap_rk_phase_states(boot_srv_rk_dev_state_t *from, boot_srv_rk_dev_state_t *busy, boot_srv_rk_dev_state_t *done)
+{
+	bool per_device = true;
+
+	switch (boot_server.curr_substate)
+	{
+	case boot_srv_rekeying_step_send_gmk:
+		*from = rekeying_device_pending;
+		*busy = rekeying_device_distributing;
+		*done = rekeying_device_distributed;
+		break;
+	case boot_srv_rekeying_step_activate_gmk:
+		*from = rekeying_device_distributed;
+		*busy = rekeying_device_activating;
+		*done = rekeying_device_activated;
+		break;
+	case boot_srv_rekeying_step_deactivate_gmk:
+		*from = rekeying_device_activated;
+		*busy = rekeying_device_deactivating;
+		*done = rekeying_device_distributed;
+		break;
+	default:
+		per_device = false;
+		break;
+	}
+
+	return per_device;
+}
+
+/**
+ * @brief   G3 Boot EAP function that counts the devices in a given re-keying state
+ * @param   [in] state The re-keying state to look for
+ * @param   [in] connected_only If 'true', counts only the devices that are still connected
+ * @return  The number of devices found
+ */
+static uint32_t g3_boot_srv_eap_rk_count(const boot_srv_rk_dev_state_t state, const bool connected_only)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < BOOT_MAX_NUM_JOINING_NODES; i++)
+	{
+		if (	(boot_server.rekeying_state[i] == state) &&
+				((!connected_only) || (boot_server.connected_devices[i].conn_state == boot_state_connected)) )
+		{
+			count++;
 		}
 	}
+
+	return count;
 }
 
+#if ENABLE_REKEYING_RECORD
+/**
+ * @brief   G3 Boot EAP function that opens the re-keying progress record in the SFLASH.
+ * 			If the record belongs to an interrupted re-keying with the same GMK, the devices that already received it are skipped.
+ * 			Otherwise, a new record is written.
+ * @param   None
+ * @return  None
+ */
+static void g3_boot_srv_eap_rk_record_open(void)
+{
+	boot_srv_rk_record_t record;
+	boot_device_t *boot_device;
+	uint8_t ext_addr[MAC_ADDR64_SIZE];
+	uint8_t erased_addr[MAC_ADDR64_SIZE];
+	uint32_t device_index;
+	crc16_t gmk_crc = CRC16_CCITT(boot_server.gmk[boot_server.gmk_index_new], MAC_KEY_SIZE);
+
+	memset(erased_addr, 0xFF, sizeof(erased_addr));
+
+	rekeying_record_slots = 0;
+
+	if (	SFLASH_READ((uint8_t*) &record, BOOT_SERVER_REKEYING_RECORD_ADDR, sizeof(record)) &&
+			(record.magic	  == BOOT_SERVER_REKEYING_RECORD_MAGIC	) &&
+			(record.gmk_crc	  == gmk_crc							) &&
+			(record.gmk_index == boot_server.gmk_index_new			) )
+	{
+		/* Reads the addresses until the first erased slot */
+		while (rekeying_record_slots < BOOT_SERVER_REKEYING_RECORD_SLOTS)
+		{
+			if (!SFLASH_READ(ext_addr, BOOT_SERVER_REKEYING_RECORD_ADDR + sizeof(record) + (rekeying_record_slots * MAC_ADDR64_SIZE), MAC_ADDR64_SIZE))
+			{
+				break;
+			}
+
+			if (memcmp(ext_addr, erased_addr, MAC_ADDR64_SIZE) == 0)
+			{
+				break;
+			}
+
+			rekeying_record_slots++;
+
+			boot_device = g3_app_boot_find_device(ext_addr, MAC_BROADCAST_SHORT_ADDR, boot_state_connected);
+
+			if (boot_device != NULL)
+			{
+				device_index = boot_device - boot_server.connected_devices;
+
+				if (boot_server.rekeying_state[device_index] == rekeying_device_pending)
+				{
+					boot_server.rekeying_state[device_index] = rekeying_device_distributed;
+					boot_server.rekeyed_count++;
+					boot_server.rekeying_stats.resumed++;
+				}
+			}
+		}
+
+		PRINT_G3_BOOT_SRV_INFO("Resuming re-keying, %u devices already received the new GMK\n", boot_server.rekeying_stats.resumed);
+	}
+	else
+	{
+		record.magic	 = BOOT_SERVER_REKEYING_RECORD_MAGIC;
+		record.gmk_crc	 = gmk_crc;
+		record.gmk_index = boot_server.gmk_index_new;
+		record.reserved	 = 0xFF;
+
+		if (!(	SFLASH_ERASE(BOOT_SERVER_REKEYING_RECORD_ADDR, BOOT_SERVER_REKEYING_RECORD_SIZE) &&
+				SFLASH_WRITE(BOOT_SERVER_REKEYING_RECORD_ADDR, (uint8_t*) &record, sizeof(record)) ) )
+		{
+			PRINT_G3_BOOT_SRV_WARNING("Could not write the re-keying progress record\n");
+
+			/* The progress is not recorded */
+			rekeying_record_slots = BOOT_SERVER_REKEYING_RECORD_SLOTS;
+		}
+	}
+}
+
+/**
+ * @brief   G3 Boot EAP function that adds a device that received the new GMK to the re-keying progress record.
+ * 			The address is written in the next erased slot, no erase is needed.
+ * @param   [in] device_index Index of the device in the connected device list
+ * @return  None
+ */
+static void g3_boot_srv_eap_rk_record_add(const uint32_t device_index)
+{
+	if (rekeying_record_slots < BOOT_SERVER_REKEYING_RECORD_SLOTS)
+	{
+		SFLASH_WRITE(BOOT_SERVER_REKEYING_RECORD_ADDR + sizeof(boot_srv_rk_record_t) + (rekeying_record_slots * MAC_ADDR64_SIZE), boot_server.connected_devices[device_index].ext_addr, MAC_ADDR64_SIZE);
+
+		rekeying_record_slots++;
+	}
+}
+
+/**
+ * @brief   G3 Boot EAP function that invalidates the re-keying progress record (the re-keying cannot be resumed).
+ * @param   None
+ * @return  None
+ */
+static void g3_boot_srv_eap_rk_record_invalidate(void)
+{
+	uint32_t magic = 0;
+
+	SFLASH_WRITE(BOOT_SERVER_REKEYING_RECORD_ADDR, (uint8_t*) &magic, sizeof(magic));
+}
+#endif /* ENABLE_REKEYING_RECORD */
+
 /**
  * @brief   G3 Boot EAP function that handles the completion of the re-keying procedure, in case of success or failure
  * @param   None
@@ -594,6 +763,7 @@ static void g3_boot_srv_eap_fsm_recv_param_result(const lbp_ind_t* lbp_eap_msg,
 static void g3_boot_srv_eap_complete_rekeying(void)
 {
 	g3_result_t result;
+	boot_srv_rk_stats_t *stats = &boot_server.rekeying_stats;
 
 	if (boot_server.rekeying_error == rekeying_error_none)
 	{
@@ -601,6 +771,15 @@ static void g3_boot_srv_eap_complete_rekeying(void)
 		boot_server.gmk_index = boot_server.gmk_index_new;
 
 		result = G3_SUCCESS;
+
+#if ENABLE_REKEYING_RECORD
+		/* The record is kept in case of failure, to resume the distribution of the same GMK */
+		g3_boot_srv_eap_rk_record_invalidate();
+#endif
+#if ENABLE_DEVICE_TABLE_RESTORE
+		/* The connected device log is rewritten with the new GMK */
+		g3_app_boot_compact_device_log();
+#endif
 	}
 	else
 	{
@@ -618,8 +797,18 @@ static void g3_boot_srv_eap_complete_rekeying(void)
 		{
 			g3_boot_srv_join_entry_remove(join_entry);
 		}
+
+		boot_server.rekeying_state[i] = rekeying_device_idle;
 	}
 
+	/* Throughput statistics */
+	stats->duration			= HAL_GetTick() - boot_server.rekeying_start_ts;
+	stats->devices			= boot_server.rekeyed_count;
+	stats->devices_per_min	= (stats->duration > 0) ? ((stats->devices * 60000U) / stats->duration) : stats->devices;
+
+	PRINT_G3_BOOT_SRV_INFO("Re-keying %s: %u devices in %u ms (%u devices/min, %u resumed, %u retries)\n", (result == G3_SUCCESS) ? "completed" : "failed",
+			stats->devices, stats->duration, stats->devices_per_min, stats->resumed, stats->retries);
+
 	/* Prepare and send SRV-REKEYING-Confirm */
 	BOOT_ServerRekeyingConfirm_t *rekeying_cnf = MEMPOOL_MALLOC(sizeof(BOOT_ServerRekeyingConfirm_t));
 
@@ -631,63 +820,241 @@ static void g3_boot_srv_eap_complete_rekeying(void)
 }
 
 /**
- * @brief   G3 Boot EAP function that creates/updates the list of re-keying entries
- * @param   None
+ * @brief   G3 Boot EAP function that starts the current re-keying phase for a connected device
+ * @param   [in] device_index Index of the device in the connected device list
+ * @return  'false' if the joining table is full, 'true' otherwise
+ */
+static bool g3_boot_srv_eap_rk_start_device(const uint32_t device_index)
+{
+	boot_device_t *boot_device = &boot_server.connected_devices[device_index];
+	boot_join_entry_t *rekeying_entry = g3_boot_srv_join_entry_find(boot_device->ext_addr);
+
+	if (rekeying_entry == NULL)
+	{
+		/* Initialize the new entry, with short address (needed to cipher messages), LBA = LBD in this case */
+		rekeying_entry = g3_boot_srv_join_entry_add(boot_device->ext_addr, boot_device->short_addr, boot_device->media_type, boot_device->disable_bkp, true);
+
+		if (rekeying_entry == NULL)
+		{
+			return false;
+		}
+
+		rekeying_entry->short_addr = boot_device->short_addr;
+	}
+	else if (!rekeying_entry->rekeying)
+	{
+		/* The device is bootstrapping again, its GMK is aligned by the bootstrap */
+		boot_server.rekeying_state[device_index] = rekeying_device_idle;
+		return true;
+	}
+
+	/* Restarts the timeout of the entry */
+	rekeying_entry->join_time = HAL_GetTick();
+
+	switch (boot_server.curr_substate)
+	{
+	case boot_srv_rekeying_step_send_gmk:
+		PRINT_G3_BOOT_SRV_INFO("Re-keying device %u/%u, short address: %u\n", boot_server.rekeyed_count+1, boot_server.rekeying_count, rekeying_entry->short_addr);
+
+		/* Send Message 1 */
+		g3_adp_lbp_eap_send_1(rekeying_entry, boot_server.pan_id, boot_server.nsdu_handle++, boot_server.ids, sizeof(boot_server.ids));
+
+		boot_server.rekeying_state[device_index] = rekeying_device_distributing;
+		break;
+	case boot_srv_rekeying_step_activate_gmk:
+		PRINT_G3_BOOT_SRV_INFO("GMK Activation for device %u/%u, short addr: %u\n", boot_server.activated_count+1, boot_server.rekeying_count, rekeying_entry->short_addr);
+
+		/* Send Message GMK-Activation */
+		rekeying_entry->curr_state = BOOT_SRV_EAP_ST_WAIT_PARAM;
+		g3_adp_lbp_send_gmk_activation(rekeying_entry, boot_server.pan_id, boot_server.nsdu_handle++, boot_server.gmk_index_new);
+
+		boot_server.rekeying_state[device_index] = rekeying_device_activating;
+		break;
+	case boot_srv_rekeying_step_deactivate_gmk:
+		PRINT_G3_BOOT_SRV_INFO("GMK-Deactivation for device %u/%u, short address: %u\n", boot_server.activated_count, boot_server.rekeying_count, rekeying_entry->short_addr);
+
+		/* Send Message GMK-Activation, with the previous index */
+		rekeying_entry->curr_state = BOOT_SRV_EAP_ST_WAIT_PARAM;
+		g3_adp_lbp_send_gmk_activation(rekeying_entry, boot_server.pan_id, boot_server.nsdu_handle++, boot_server.gmk_index);
+
+		boot_server.rekeying_state[device_index] = rekeying_device_deactivating;
+		break;
+	default:
+		break;
+	}
+
+	/* Starts the timer to handle timeouts */
+	if (!osTimerIsRunning(bootTimerHandle))
+	{
+		osTimerStart(bootTimerHandle, BOOT_SERVER_BOOTSTRAP_TIMEOUT_CHECK_PERIOD);
+	}
+
+	return true;
+}
+
+/**
+ * @brief   G3 Boot EAP function that prepares the devices for a new re-keying phase
+ * @param   [in] substate The sub-state of the new phase
  * @return  None
  */
-static boot_srv_rk_err_t g3_boot_srv_eap_update_rekeying_list(void)
+static void g3_boot_srv_eap_rk_start_phase(const boot_srv_substate_t substate)
 {
-	boot_srv_rk_err_t result = rekeying_error_none;
+	boot_server.curr_substate  = substate;
+	boot_server.rekeying_index = 0;
 
-	boot_join_entry_t *rekeying_entry;
-	uint8_t *ext_addr;
-	uint16_t short_addr;
-	uint8_t media_type;
-	uint8_t disable_bkp;
+	memset(boot_server.rekeying_retries, 0, sizeof(boot_server.rekeying_retries));
 
 	for (uint32_t i = 0; i < BOOT_MAX_NUM_JOINING_NODES; i++)
 	{
-		if (boot_server.connected_devices[i].conn_state == boot_state_connected)
+		if (	(substate == boot_srv_rekeying_step_activate_gmk						) &&
+				(boot_server.rekeying_state[i]				== rekeying_device_idle		) &&
+				(boot_server.connected_devices[i].conn_state == boot_state_connected	) )
 		{
-			rekeying_entry = g3_boot_srv_join_entry_find(boot_server.connected_devices[i].ext_addr);
+			/* Devices that bootstrapped during the distribution received both GMK, but still use the previous one */
+			boot_server.rekeying_state[i] = rekeying_device_distributed;
+			boot_server.rekeying_count++;
+		}
+		else if (	(substate == boot_srv_rekeying_step_deactivate_gmk				) &&
+					(boot_server.rekeying_state[i] == rekeying_device_activating	) )
+		{
+			/* Devices with a pending GMK-Activation might have switched, they are rolled-back too */
+			boot_server.rekeying_state[i] = rekeying_device_activated;
+			boot_server.activated_count++;
+		}
+	}
+}
 
-			/* If not found in the joining entries */
-			if (rekeying_entry == NULL)
-			{
-				ext_addr    = boot_server.connected_devices[i].ext_addr;
-				short_addr  = boot_server.connected_devices[i].short_addr;
-				media_type  = boot_server.connected_devices[i].media_type;
-				disable_bkp = boot_server.connected_devices[i].disable_bkp;
+/**
+ * @brief   G3 Boot EAP function that moves the re-keying to the next phase, after the configured delay
+ * @param   [in] substate The sub-state of the next phase
+ * @param   [in] delay The delay before the next phase, in ms (if ENABLE_REKEYING_DELAYS is set)
+ * @return  None
+ */
+static void g3_boot_srv_eap_rk_next_phase(const boot_srv_substate_t substate, const uint32_t delay)
+{
+	g3_boot_srv_eap_rk_start_phase(substate);
 
-				/* Initialize the new entry, with short address (needed to cipher messages), LBA = LBD in this case */
-				rekeying_entry = g3_boot_srv_join_entry_add(ext_addr, short_addr, media_type, disable_bkp, true);
+#if ENABLE_REKEYING_DELAYS
+	osTimerStart(serverTimerHandle, delay);
+#else
+	UNUSED(delay);
 
-				if (rekeying_entry != NULL)
-				{
-					rekeying_entry->short_addr = short_addr;
+	g3_boot_srv_eap_rekeying_fsm();
+#endif
+}
+
+/**
+ * @brief   G3 Boot EAP function that runs a per-device re-keying phase: the window of devices being processed is
+ * 			filled up to BOOT_SERVER_REKEYING_WINDOW devices and the next phase starts when all devices have been processed.
+ * @param   None
+ * @return  None
+ */
+static void g3_boot_srv_eap_rk_run_phase(void)
+{
+	boot_srv_rk_dev_state_t from, busy, done;
+	uint32_t in_progress;
+	uint32_t device_index;
 
-					boot_server.rekeying_count++;
+	if (!g3_boot_srv_eap_rk_phase_states(&from, &busy, &done))
+	{
+		return;
+	}
 
-					/* If the current step is the (de)activation of the GMK, the entry is set in the status where it waits for the config. parameter */
-					if (	(boot_server.curr_substate == boot_srv_rekeying_step_activate_gmk	) ||
-							(boot_server.curr_substate == boot_srv_rekeying_step_deactivate_gmk	) )
-					{
-						rekeying_entry->curr_state = BOOT_SRV_EAP_ST_WAIT_PARAM;
-					}
-				}
-				else
-				{
-					result = rekeying_error_table_full;
-				}
+	in_progress = g3_boot_srv_eap_rk_count(busy, false);
+
+	/* Fills the window, starting from the cursor */
+	for (uint32_t scanned = 0; (scanned < BOOT_MAX_NUM_JOINING_NODES) && (in_progress < BOOT_SERVER_REKEYING_WINDOW); scanned++)
+	{
+		device_index = boot_server.rekeying_index;
+
+		if (	(boot_server.rekeying_state[device_index]				 == from				) &&
+				(boot_server.connected_devices[device_index].conn_state == boot_state_connected	) )
+		{
+			if (!g3_boot_srv_eap_rk_start_device(device_index))
+			{
+				/* The joining table is full, the device will be processed when an entry is freed */
+				break;
 			}
-			else
+
+			if (boot_server.rekeying_state[device_index] == busy)
 			{
-				/* If it is found, then it is bootstrapping or already in list, and it won't be added to the list */
+				in_progress++;
 			}
 		}
+
+		boot_server.rekeying_index = (boot_server.rekeying_index + 1) % BOOT_MAX_NUM_JOINING_NODES;
 	}
 
-	return result;
+	if (in_progress == 0)
+	{
+		if (g3_boot_srv_eap_rk_count(from, true) > 0)
+		{
+			/* Nothing in progress but the joining table is full (bootstrapping devices), retries later */
+			osTimerStart(serverTimerHandle, REKEYING_WINDOW_RETRY_DELAY);
+		}
+		else if (boot_server.curr_substate == boot_srv_rekeying_step_send_gmk)
+		{
+			/* Proceeds to the "Activate GMK" phase */
+			g3_boot_srv_eap_rk_next_phase(boot_srv_rekeying_step_activate_gmk, REKEYING_ACTIVATE_GMK_PHASE_DELAY);
+		}
+		else if (boot_server.curr_substate == boot_srv_rekeying_step_activate_gmk)
+		{
+			/* Proceeds to the "Set GMK index" phase */
+			g3_boot_srv_eap_rk_next_phase(boot_srv_rekeying_step_set_gmk_index, REKEYING_SET_GMK_INDEX_PHASE_DELAY);
+		}
+		else
+		{
+			/* All devices have been deactivated  */
+			g3_boot_srv_eap_complete_rekeying();
+		}
+	}
+}
+
+/**
+ * @brief   G3 Boot EAP function that handles the completion of the current re-keying phase for a device
+ * @param   [in/out] join_entry The re-keying entry of the device, removed to free a place in the window
+ * @return  None
+ */
+static void g3_boot_srv_eap_rk_succeeded(boot_join_entry_t *join_entry)
+{
+	boot_srv_rk_dev_state_t from, busy, done;
+	uint32_t device_index = g3_boot_srv_eap_rk_device_index(join_entry);
+	bool per_device = g3_boot_srv_eap_rk_phase_states(&from, &busy, &done);
+
+	if (	(per_device									   	) &&
+			(device_index < BOOT_MAX_NUM_JOINING_NODES	   	) &&
+			(boot_server.rekeying_state[device_index] == busy	) )
+	{
+		boot_server.rekeying_state[device_index] = done;
+
+		switch (boot_server.curr_substate)
+		{
+		case boot_srv_rekeying_step_send_gmk:
+			boot_server.rekeyed_count++;
+#if ENABLE_REKEYING_RECORD
+			g3_boot_srv_eap_rk_record_add(device_index);
+#endif
+			break;
+		case boot_srv_rekeying_step_activate_gmk:
+			boot_server.activated_count++;
+			break;
+		default:
+			boot_server.activated_count--;
+			break;
+		}
+	}
+	else if ((per_device) && (device_index >= BOOT_MAX_NUM_JOINING_NODES))
+	{
+		HANDLE_SRV_ERROR(srv_err_disconnected);
+	}
+
+	g3_boot_srv_join_entry_remove(join_entry);
+
+	if (per_device)
+	{
+		/* Refills the window or proceeds to the next phase */
+		g3_boot_srv_eap_rekeying_fsm();
+	}
 }
 
 /**
@@ -698,16 +1065,64 @@ static boot_srv_rk_err_t g3_boot_srv_eap_update_rekeying_list(void)
   * @{
   */
 
+/**
+ * @brief   G3 Boot EAP function that handles the failure of the current re-keying phase for a device.
+ * 			The phase is retried up to BOOT_SERVER_REKEYING_MAX_RETRIES times, then the re-keying fails (and is rolled-back if needed).
+ * @param   [in/out] join_entry The re-keying entry of the device, removed to free a place in the window
+ * @param   [in] error The error that occurred
+ * @return  None
+ */
+void g3_boot_srv_eap_rekeying_failed(boot_join_entry_t* join_entry, boot_srv_rk_err_t error)
+{
+	boot_srv_rk_dev_state_t from, busy, done;
+	uint32_t device_index = g3_boot_srv_eap_rk_device_index(join_entry);
+	bool per_device = g3_boot_srv_eap_rk_phase_states(&from, &busy, &done);
+
+	if (	(per_device									   	) &&
+			(device_index < BOOT_MAX_NUM_JOINING_NODES	   	) &&
+			(boot_server.rekeying_state[device_index] == busy	) )
+	{
+		if (boot_server.rekeying_retries[device_index] < BOOT_SERVER_REKEYING_MAX_RETRIES)
+		{
+			boot_server.rekeying_retries[device_index]++;
+			boot_server.rekeying_stats.retries++;
+
+			PRINT_G3_BOOT_SRV_WARNING("Re-keying error %u for short address %u, retry %u/%u\n", error, join_entry->short_addr, boot_server.rekeying_retries[device_index], BOOT_SERVER_REKEYING_MAX_RETRIES);
+
+			/* The device is processed again */
+			boot_server.rekeying_state[device_index] = from;
+		}
+		else if (boot_server.curr_substate == boot_srv_rekeying_step_deactivate_gmk)
+		{
+			PRINT_G3_BOOT_SRV_WARNING("GMK-Deactivation failed for short address %u\n", join_entry->short_addr);
+
+			/* The roll-back continues with the other devices */
+			boot_server.rekeying_state[device_index] = rekeying_device_failed;
+			boot_server.activated_count--;
+		}
+		else
+		{
+			boot_server.rekeying_error = error;
+		}
+	}
+
+	g3_boot_srv_join_entry_remove(join_entry);
+
+	if (per_device)
+	{
+		g3_boot_srv_eap_rekeying_fsm();
+	}
+}
+
 /**
  * @brief   G3 Boot EAP FSM function that handles the full re-keying procedure and, in case of error, its roll-back.
  * @param   None
  * @return  None
  * @details This function is called:
  * 				- At the reception of the BOOT-SRV-REKEYING.request.
- * 				- At the reception of the EAP-PSK message #2 and #4 (in case of error).
- * 				- At the reception of the EAP accept message.
- * 				- At the reception of the configuration parameter result message.
+ * 				- At the completion or failure of a re-keying phase for a device (EAP-PSK messages, accept, configuration parameter result, timeout).
  * 				- At the reception of the G3LIB-SET.confirm.
+ * 				- At the expiration of the serverTimer (phase delays and window retries).
  * 			The steps of the re-keying procedure are the following:
  * 				1. Write the new GMK in the not active index of the internal GMK array of the coordinator, by setting the relative attribute.
  * 				2. Perform the bootstrap procedure with each connected device, to distribute the new GMK.
@@ -718,6 +1133,9 @@ static boot_srv_rk_err_t g3_boot_srv_eap_update_rekeying_list(void)
  *				1. Switch the index of the active GMK of the coordinator to its original value, by setting the relative attribute.
  *				2. Send a configuration parameter message to each connected device, to switch their index of the active GMK to its original value.
  *				3. Send back a negative BOOT-SERVER-REKEYING.confirm.
+ *			The per-device steps are performed for up to BOOT_SERVER_REKEYING_WINDOW devices at the same time, each device is retried up to
+ *			BOOT_SERVER_REKEYING_MAX_RETRIES times. With ENABLE_REKEYING_RECORD, the devices that received the new GMK are recorded in the SFLASH,
+ *			so that a new request with the same GMK skips them.
  * @note	For the re-keying procedure, additional steps (after step 4.) to remove the previous GMK on the connected devices and the coordinator could be added.
  * 			For the roll-back procedure, additional steps (after step 2.) to remove the new GMK on the connected devices and the coordinator could be added.
  */
@@ -725,7 +1143,6 @@ void g3_boot_srv_eap_rekeying_fsm(void)
 {
 	uint16_t len;
 	G3_LIB_SetAttributeRequest_t *set_attr_req;
-	boot_join_entry_t *rekeying_entry;
 
 	/* Changes state in case of exceptions */
 	if (		(boot_server.curr_substate == boot_srv_rekeying_step_send_gmk) &&
@@ -739,7 +1156,7 @@ void g3_boot_srv_eap_rekeying_fsm(void)
 	{
 		/* In case of error, goes from activation to de-activation */
 		PRINT_G3_BOOT_SRV_WARNING("Rolling-back...\n");
-		boot_server.curr_substate = boot_srv_rekeying_step_deactivate_gmk;
+		g3_boot_srv_eap_rk_start_phase(boot_srv_rekeying_step_deactivate_gmk);
 	}
 
 	/* Re-keying FSM */
@@ -752,166 +1169,53 @@ void g3_boot_srv_eap_rekeying_fsm(void)
 		boot_server.rekeying_count  = 0;
 		boot_server.rekeyed_count	= 0;
 		boot_server.activated_count = 0;
-		set_attr_req = MEMPOOL_MALLOC(sizeof(G3_LIB_SetAttributeRequest_t));
-
-		/* Sets the new GMK key in the free slot */
-		len = hi_g3lib_setreq_fill(set_attr_req, MAC_KEYTABLE_ID, boot_server.gmk_index_new, boot_server.gmk[boot_server.gmk_index_new], MAC_KEY_SIZE);
-		g3_send_message(HIF_TX_MSG, HIF_G3LIB_SET_REQ, set_attr_req, len);
-
-		boot_server.curr_substate = boot_srv_rekeying_step_send_gmk;
+		boot_server.rekeying_start_ts = HAL_GetTick();
+		memset(&boot_server.rekeying_stats,	  0, sizeof(boot_server.rekeying_stats));
+		memset(boot_server.rekeying_retries, 0, sizeof(boot_server.rekeying_retries));
 
 		/* Creates the list of devices to re-key */
-		boot_server.rekeying_error = g3_boot_srv_eap_update_rekeying_list();
-
-		/* Terminate Re-keying in case of error */
-		if (boot_server.rekeying_error != rekeying_error_none)
+		for (uint32_t i = 0; i < BOOT_MAX_NUM_JOINING_NODES; i++)
 		{
-			g3_boot_srv_eap_complete_rekeying();
-		}
-		break;
-	case boot_srv_rekeying_step_send_gmk:
-		if (boot_server.rekeying_error == rekeying_error_none)
-		{
-			while (boot_server.rekeying_index < BOOT_MAX_NUM_JOINING_NODES)
+			if (boot_server.connected_devices[i].conn_state == boot_state_connected)
 			{
-				rekeying_entry = g3_boot_srv_join_entry_get(boot_server.rekeying_index);
-
-				if (rekeying_entry->rekeying)
-				{
-					PRINT_G3_BOOT_SRV_INFO("Re-keying device %u/%u, short address: %u\n", boot_server.rekeyed_count+1, boot_server.connected_devices_number, rekeying_entry->short_addr);
-
-					/* Send Message 1 */
-					g3_adp_lbp_eap_send_1(rekeying_entry, boot_server.pan_id, boot_server.nsdu_handle++, boot_server.ids, sizeof(boot_server.ids));
-
-					boot_server.rekeyed_count++;
-
-					if (boot_server.rekeyed_count == boot_server.rekeying_count)
-					{
-						boot_server.rekeying_index = 0;
-
-						boot_server.curr_substate  = boot_srv_rekeying_step_activate_gmk;
-
-						/* Updates the list to keep into account the devices that bootstrapped in the meanwhile */
-						boot_server.rekeying_error = g3_boot_srv_eap_update_rekeying_list();
-					}
-					else
-					{
-						boot_server.rekeying_index++;
-					}
-					break;
-				}
-				else
-				{
-					boot_server.rekeying_index++;
-				}
+				boot_server.rekeying_state[i] = rekeying_device_pending;
+				boot_server.rekeying_count++;
 			}
-
-			if (boot_server.rekeying_index >= BOOT_MAX_NUM_JOINING_NODES)
+			else
 			{
-				/* If the code gets here, it means that the list was fully scanned without finding the expected number of devices */
-				boot_server.rekeying_error = rekeying_error_procedure;
-				g3_boot_srv_eap_error(srv_err_rekeying_index_oor_no_proceed);
-				g3_boot_srv_eap_complete_rekeying();
+				boot_server.rekeying_state[i] = rekeying_device_idle;
 			}
 		}
 
-		/* Terminate Re-keying in case of error */
-		if (boot_server.rekeying_error != rekeying_error_none)
-		{
-			g3_boot_srv_eap_complete_rekeying();
-		}
-		break;
-	case boot_srv_rekeying_step_activate_gmk:
-		if (boot_server.rekeying_error == rekeying_error_none)
-		{
-			while (boot_server.rekeying_index < BOOT_MAX_NUM_JOINING_NODES)
-			{
-				rekeying_entry = g3_boot_srv_join_entry_get(boot_server.rekeying_index);
-
-				if (rekeying_entry->rekeying)
-				{
-					/* Print before increment, requires +1 */
-					PRINT_G3_BOOT_SRV_INFO("GMK Activation for device %u/%u, short addr: %u\n", boot_server.activated_count+1, boot_server.rekeying_count, rekeying_entry->short_addr);
-
-					/* Send Message GMK-Activation */
-					g3_adp_lbp_send_gmk_activation(rekeying_entry, boot_server.pan_id, boot_server.nsdu_handle++, boot_server.gmk_index_new);
-
-					boot_server.activated_count++;
-					boot_server.rekeying_index++;
+#if ENABLE_REKEYING_RECORD
+		/* Skips the devices that received the same GMK during an interrupted re-keying */
+		g3_boot_srv_eap_rk_record_open();
+#endif
 
-					if (boot_server.activated_count == boot_server.rekeying_count)
-					{
-						/* All devices received the GMK-Activation */
-						boot_server.curr_substate = boot_srv_rekeying_step_set_gmk_index;
-					}
-					break;
-				}
-				else
-				{
-					boot_server.rekeying_index++;
-				}
-			}
+		set_attr_req = MEMPOOL_MALLOC(sizeof(G3_LIB_SetAttributeRequest_t));
 
-			if (boot_server.rekeying_index >= BOOT_MAX_NUM_JOINING_NODES)
-			{
-				/* If the code gets here, it means that the list was fully scanned without finding the expected number of devices */
-				boot_server.rekeying_error = rekeying_error_procedure;
-				g3_boot_srv_eap_error(srv_err_rekeying_index_oor_no_proceed);
-				g3_boot_srv_eap_complete_rekeying();
-			}
-		}
+		/* Sets the new GMK key in the free slot */
+		len = hi_g3lib_setreq_fill(set_attr_req, MAC_KEYTABLE_ID, boot_server.gmk_index_new, boot_server.gmk[boot_server.gmk_index_new], MAC_KEY_SIZE);
+		g3_send_message(HIF_TX_MSG, HIF_G3LIB_SET_REQ, set_attr_req, len);
 
-		/* Do NOT terminate re-keying in case of error */
+		boot_server.curr_substate = boot_srv_rekeying_step_send_gmk;
 		break;
-	case boot_srv_rekeying_step_deactivate_gmk:
-		if (boot_server.activated_count == 0)
+	case boot_srv_rekeying_step_send_gmk:
+		if (boot_server.rekeying_error == rekeying_error_none)
 		{
-			/* All devices have been deactivated  */
-			g3_boot_srv_eap_complete_rekeying();
+			g3_boot_srv_eap_rk_run_phase();
 		}
 		else
 		{
-			/* Looks for the next device to deactivate */
-			while (boot_server.rekeying_index > 0)
-			{
-				/* Index value is in the range 1 : BOOT_MAX_NUM_JOINING_NODES. Its value is the last used index + 1 */
-				rekeying_entry = g3_boot_srv_join_entry_get(boot_server.rekeying_index - 1);
-
-				if (rekeying_entry->rekeying)
-				{
-					/* Rolls-back the state of the entry */
-					rekeying_entry->curr_state = BOOT_SRV_EAP_ST_WAIT_PARAM;
-
-					/* Print before decrement, does not require +1 */
-					PRINT_G3_BOOT_SRV_INFO("GMK-Deactivation for device %u/%u, short address: %u\n", boot_server.activated_count, boot_server.rekeying_count, rekeying_entry->short_addr);
-
-					/* Send Message GMK-Activation */
-					g3_adp_lbp_send_gmk_activation(rekeying_entry, boot_server.pan_id, boot_server.nsdu_handle++, boot_server.gmk_index);
-
-					/* Decreases the active count (one device has been deactivated) */
-					boot_server.activated_count--;
-
-					/* Decreases the index if necessary */
-					if (boot_server.activated_count > 0)
-					{
-						boot_server.rekeying_index--;
-					}
-					break;
-				}
-				else
-				{
-					boot_server.rekeying_index--;
-				}
-			}
-
-			if (boot_server.rekeying_index == 0)
-			{
-				/* Should not reach here. If so, returns an error */
-				g3_boot_srv_eap_error(srv_err_rekeying_index_oor_no_rollback);
-				g3_boot_srv_eap_complete_rekeying();
-			}
+			/* Terminate Re-keying in case of error (no device uses the new GMK yet) */
+			g3_boot_srv_eap_complete_rekeying();
 		}
 		break;
+	case boot_srv_rekeying_step_activate_gmk:
+	case boot_srv_rekeying_step_deactivate_gmk:
+		/* Do NOT terminate re-keying in case of error */
+		g3_boot_srv_eap_rk_run_phase();
+		break;
 	case boot_srv_rekeying_step_set_gmk_index:
 		/* Sets the attribute about the index of the active GMK to the new value */
 		set_attr_req = MEMPOOL_MALLOC(sizeof(G3_LIB_SetAttributeRequest_t));
@@ -935,9 +1239,8 @@ void g3_boot_srv_eap_rekeying_fsm(void)
 			g3_send_message(HIF_TX_MSG, HIF_G3LIB_SET_REQ, set_attr_req, len);
 
 			PRINT_G3_BOOT_SRV_WARNING("Rolling-back...\n");
-			boot_server.curr_substate = boot_srv_rekeying_step_deactivate_gmk;
-
-			g3_boot_srv_eap_update_rekeying_list();
+			g3_boot_srv_eap_rk_start_phase(boot_srv_rekeying_step_deactivate_gmk);
+			g3_boot_srv_eap_rk_run_phase();
 		}
 		break;
 	default:
@@ -26,6 +26,7 @@
 #include <g3_app_config_rf_params.h>
 #include <g3_app_boot.h>
 #include <user_modbus.h>
+#include <image_download.h>
 #include <settings.h>
 #include <version.h>
 
@@ -48,6 +49,9 @@
 #define HANDLE_CNF_ERROR(cnf_id, status)
 #endif
 
+/* Definitions */
+#define G3_CONF_MAX_PENDING		2	/* Maximum number of configuration requests waiting for confirm (the ST8500 handles 2 requests at the same time) */
+
 /* Private types */
 typedef enum conf_event_enum
 {
@@ -64,8 +68,7 @@ typedef enum conf_event_enum
 typedef enum conf_state_enum
 {
     CONF_ST_WAIT_SWRESET_CNF,
-    CONF_ST_WAIT_SET_CNF,
-	CONF_ST_WAIT_DBGTOOL_CNF,
+    CONF_ST_WAIT_SET_CNF,			/* Attributes and DBGTOOL requests pipelined */
 	CONF_ST_WAIT_RFCONFIGSET_CNF,
 #if IS_COORD
     CONF_ST_WAIT_SRV_STOP_CNF,
@@ -81,6 +84,11 @@ typedef struct g3_conf_fsm_info_str
     uint32_t		peVersion;
     bool			rf_connected;
     bool			g3_ready;
+    bool			attributes_sent;						/* All the attributes of the table have been sent */
+    bool			dbgtool_pending;						/* DBGTOOL request waiting for confirm */
+    uint8_t			pending_attr_num;						/* Number of G3LIB-SET requests waiting for confirm */
+    G3_LIB_PIB_ID_t	pending_attr[G3_CONF_MAX_PENDING];		/* Attributes of the G3LIB-SET requests waiting for confirm */
+    G3_LIB_PIB_ID_t	cnf_attr;								/* Attribute of the last G3LIB-SET confirm received */
 } g3_conf_fsm_info_t;
 
 /* Private variables */
@@ -116,7 +124,8 @@ typedef g3_conf_state_t g3_conf_fsm_func(void);
 
 /* Private FSM function prototypes */
 static g3_conf_state_t g3_conf_fsm_default(void);
-static g3_conf_state_t g3_conf_fsm_set_attribute(void);
+static g3_conf_state_t g3_conf_fsm_start(void);
+static g3_conf_state_t g3_conf_fsm_received_set_cnf(void);
 static g3_conf_state_t g3_conf_fsm_received_dbgtool_cnf(void);
 static g3_conf_state_t g3_conf_fsm_received_rfconfigset_cnf(void);
 #if IS_COORD
@@ -131,9 +140,8 @@ static g3_conf_state_t g3_conf_fsm_received_srvstart_cnf(void);
   */
 static g3_conf_fsm_func *g3_conf_fsm_func_tbl[CONF_ST_CNT][CONF_EV_CNT] = {
 /*                               NONE,                RECEIVED_SWRESET_CNF,         RECEIVED_G3LIBSET_CNF,          RECEIVED_DBGTOOL_CNF,			    RECEIVED_RFCONFIGSET_CNF,               RECEIVED_SRVSTOP_CNF,			  RECEIVED_SRVSTART_CNF,             */
-/* WAIT_SWRESET_CNF          */ {g3_conf_fsm_default, g3_conf_fsm_set_attribute, 	g3_conf_fsm_default,			g3_conf_fsm_default,            	g3_conf_fsm_default,        			g3_conf_fsm_default,        	  g3_conf_fsm_default				 },
-/* WAIT_G3LIBSET_CNF         */ {g3_conf_fsm_default, g3_conf_fsm_default,        	g3_conf_fsm_set_attribute,		g3_conf_fsm_default,				g3_conf_fsm_default,            		g3_conf_fsm_default,        	  g3_conf_fsm_default        		 },
-/* WAIT_DBGTOOL_CNF          */ {g3_conf_fsm_default, g3_conf_fsm_default,        	g3_conf_fsm_default,			g3_conf_fsm_received_dbgtool_cnf,	g3_conf_fsm_default, 					g3_conf_fsm_default,        	  g3_conf_fsm_default        		 },
+/* WAIT_SWRESET_CNF          */ {g3_conf_fsm_default, g3_conf_fsm_start,         	g3_conf_fsm_default,			g3_conf_fsm_default,            	g3_conf_fsm_default,        			g3_conf_fsm_default,        	  g3_conf_fsm_default				 },
+/* WAIT_G3LIBSET_CNF         */ {g3_conf_fsm_default, g3_conf_fsm_default,        	g3_conf_fsm_received_set_cnf,	g3_conf_fsm_received_dbgtool_cnf,	g3_conf_fsm_default,            		g3_conf_fsm_default,        	  g3_conf_fsm_default        		 },
 /* WAIT_RFCONFIGSET_CNF      */ {g3_conf_fsm_default, g3_conf_fsm_default,        	g3_conf_fsm_default,			g3_conf_fsm_default,				g3_conf_fsm_received_rfconfigset_cnf,	g3_conf_fsm_default,        	  g3_conf_fsm_default        		 },
 #if IS_COORD
 /* WAIT_SRVSTOP_CNF          */ {g3_conf_fsm_default, g3_conf_fsm_default,        	g3_conf_fsm_default,			g3_conf_fsm_default,				g3_conf_fsm_default,            		g3_conf_fsm_received_srvstop_cnf, g3_conf_fsm_default      		     },
@@ -176,6 +184,8 @@ static g3_conf_state_t g3_conf_complete(void)
 {
 	g3_conf_fsm_info.g3_ready = true;
 
+	setBootPhaseEnd(BOOT_PHASE_CONFIG);
+
 	if (working_plc_mode == PLC_MODE_MAC)
 	{
 #if defined(DEBUG)
@@ -243,71 +253,14 @@ static g3_conf_state_t g3_conf_fsm_default(void)
 }
 
 /**
-  * @brief G3 Configuration FSM function that sets another attribute of the list.
-  * @param None
-  * @return The next state of the G3 Configuration FSM.
-  */
-static g3_conf_state_t g3_conf_fsm_set_attribute(void)
-{
-    g3_conf_state_t next_state;
-
-    g3_conf_fsm_info.curr_event = CONF_EV_NONE;
-
-	G3_LIB_SetAttributeRequest_t *set_attr_req = MEMPOOL_MALLOC(sizeof(G3_LIB_SetAttributeRequest_t));
-
-	/* Extracts next attribute from table  */
-	bool found_attribute = g3_app_attrib_tbl_extract(&set_attr_req->attribute);
-
-	/* Sets the extracted attribute */
-	if (found_attribute)
-	{
-#if (DEBUG_G3_CONF >= DEBUG_LEVEL_FULL)
-		/* uint16 attributes shall be displayed swapped (MAC_PANID_ID, MAC_SHORTADDRESS_ID...)*/
-		ALLOC_DYNAMIC_HEX_STRING(attribute_value_str, set_attr_req->attribute.value, set_attr_req->attribute.len);
-		PRINT_G3_CONF_INFO("Setting attribute %s = 0x%s\n", g3_conf_translate_attribute(set_attr_req->attribute.attribute_id), attribute_value_str);
-		FREE_DYNAMIC_HEX_STRING(attribute_value_str)
-#endif
-		/* Calculates message length, then sends it to the ST8500 */
-		uint16_t len = sizeof(set_attr_req->attribute) - sizeof(set_attr_req->attribute.value) + set_attr_req->attribute.len;
-		g3_send_message(HIF_TX_MSG, HIF_G3LIB_SET_REQ, set_attr_req, len);
-	}
-	else
-	{
-		MEMPOOL_FREE(set_attr_req);
-	}
-
-
-    if (found_attribute)
-    {
-        /* Need to wait for the setup of the next attribute, remains in the same state */
-        next_state = CONF_ST_WAIT_SET_CNF;
-    }
-    else
-    {
-    	/* If there are no more attributes left to set */
-    	hi_dbgtool_req_t *dbgtool_req = MEMPOOL_MALLOC(sizeof(hi_dbgtool_req_t));
-
-    	uint16_t len = hi_hostif_dbgtoolreq_fill(dbgtool_req, HI_TOOL_INFO, HI_TOOL_NO_CONF);
-    	g3_send_message(HIF_TX_MSG, HIF_HI_DBGTOOL_REQ, dbgtool_req, len);
-
-    	next_state = CONF_ST_WAIT_DBGTOOL_CNF;
-	}
-
-    return next_state;
-}
-
-
-/**
-  * @brief G3 Configuration FSM function that executes after the reception of a DBGTOOL confirmation.
+  * @brief Configures the RF module (if connected) and the Boot Server (Coordinator), after the attributes and the DBGTOOL confirm.
   * @note The behaviour of this function depends on the device type, the version of the ST8500 FW
   * and the presence of the RF module.
   * @param None
   * @return The next state of the G3 Configuration FSM.
   */
-static g3_conf_state_t g3_conf_fsm_received_dbgtool_cnf(void)
+static g3_conf_state_t g3_conf_attributes_complete(void)
 {
-	g3_conf_fsm_info.curr_event = CONF_EV_NONE;
-
 	g3_conf_state_t next_state;
 
 	if (g3_conf_fsm_info.rf_connected)
@@ -360,6 +313,124 @@ static g3_conf_state_t g3_conf_fsm_received_dbgtool_cnf(void)
 	return next_state;
 }
 
+/**
+  * @brief Sends the next attributes of the table, up to G3_CONF_MAX_PENDING requests waiting for confirm.
+  *        The attribute writes are independent, they are not serialized.
+  * @param None
+  * @return The next state of the G3 Configuration FSM.
+  */
+static g3_conf_state_t g3_conf_send_attributes(void)
+{
+	g3_conf_state_t next_state = CONF_ST_WAIT_SET_CNF;
+
+	while ((!g3_conf_fsm_info.attributes_sent) &&
+		   ((g3_conf_fsm_info.pending_attr_num + (g3_conf_fsm_info.dbgtool_pending ? 1 : 0)) < G3_CONF_MAX_PENDING))
+	{
+		G3_LIB_SetAttributeRequest_t *set_attr_req = MEMPOOL_MALLOC(sizeof(G3_LIB_SetAttributeRequest_t));
+
+		/* Extracts next attribute from table  */
+		if (g3_app_attrib_tbl_extract(&set_attr_req->attribute))
+		{
+#if (DEBUG_G3_CONF >= DEBUG_LEVEL_FULL)
+			/* uint16 attributes shall be displayed swapped (MAC_PANID_ID, MAC_SHORTADDRESS_ID...)*/
+			ALLOC_DYNAMIC_HEX_STRING(attribute_value_str, set_attr_req->attribute.value, set_attr_req->attribute.len);
+			PRINT_G3_CONF_INFO("Setting attribute %s = 0x%s\n", g3_conf_translate_attribute(set_attr_req->attribute.attribute_id), attribute_value_str);
+			FREE_DYNAMIC_HEX_STRING(attribute_value_str)
+#endif
+			g3_conf_fsm_info.pending_attr[g3_conf_fsm_info.pending_attr_num++] = set_attr_req->attribute.attribute_id;
+
+			/* Calculates message length, then sends it to the ST8500 */
+			uint16_t len = sizeof(set_attr_req->attribute) - sizeof(set_attr_req->attribute.value) + set_attr_req->attribute.len;
+			g3_send_message(HIF_TX_MSG, HIF_G3LIB_SET_REQ, set_attr_req, len);
+		}
+		else
+		{
+			MEMPOOL_FREE(set_attr_req);
+
+			/* There are no more attributes left to set */
+			g3_conf_fsm_info.attributes_sent = true;
+		}
+	}
+
+	/* The RF and Boot Server configurations need all the attributes set and the DBGTOOL confirm */
+	if ((g3_conf_fsm_info.attributes_sent) && (g3_conf_fsm_info.pending_attr_num == 0) && (!g3_conf_fsm_info.dbgtool_pending))
+	{
+		next_state = g3_conf_attributes_complete();
+	}
+
+	return next_state;
+}
+
+/**
+  * @brief G3 Configuration FSM function that starts the configuration after the SWRESET confirmation.
+  *        The DBGTOOL request (information on the platform) is sent together with the first attributes.
+  * @param None
+  * @return The next state of the G3 Configuration FSM.
+  */
+static g3_conf_state_t g3_conf_fsm_start(void)
+{
+	g3_conf_fsm_info.curr_event = CONF_EV_NONE;
+
+	g3_conf_fsm_info.attributes_sent  = false;
+	g3_conf_fsm_info.pending_attr_num = 0;
+	g3_conf_fsm_info.dbgtool_pending  = true;
+
+	hi_dbgtool_req_t *dbgtool_req = MEMPOOL_MALLOC(sizeof(hi_dbgtool_req_t));
+
+	uint16_t len = hi_hostif_dbgtoolreq_fill(dbgtool_req, HI_TOOL_INFO, HI_TOOL_NO_CONF);
+	g3_send_message(HIF_TX_MSG, HIF_HI_DBGTOOL_REQ, dbgtool_req, len);
+
+	return g3_conf_send_attributes();
+}
+
+/**
+  * @brief G3 Configuration FSM function that executes after the reception of a G3LIB-SET confirmation.
+  *        The confirm is matched with the pending request by attribute ID and index.
+  * @param None
+  * @return The next state of the G3 Configuration FSM.
+  */
+static g3_conf_state_t g3_conf_fsm_received_set_cnf(void)
+{
+	g3_conf_fsm_info.curr_event = CONF_EV_NONE;
+
+	uint8_t i;
+
+	for (i = 0; i < g3_conf_fsm_info.pending_attr_num; i++)
+	{
+		if ((g3_conf_fsm_info.pending_attr[i].id    == g3_conf_fsm_info.cnf_attr.id   ) &&
+			(g3_conf_fsm_info.pending_attr[i].index == g3_conf_fsm_info.cnf_attr.index)	)
+		{
+			break;
+		}
+	}
+
+	if (i < g3_conf_fsm_info.pending_attr_num)
+	{
+		/* Removes the attribute from the pending ones */
+		g3_conf_fsm_info.pending_attr[i] = g3_conf_fsm_info.pending_attr[--g3_conf_fsm_info.pending_attr_num];
+	}
+	else
+	{
+		PRINT_G3_CONF_WARNING("Unexpected %s for attribute 0x%X[%u]\n", translateG3cmd(HIF_G3LIB_SET_CNF), g3_conf_fsm_info.cnf_attr.id, g3_conf_fsm_info.cnf_attr.index);
+	}
+
+	return g3_conf_send_attributes();
+}
+
+/**
+  * @brief G3 Configuration FSM function that executes after the reception of a DBGTOOL confirmation.
+  * @param None
+  * @return The next state of the G3 Configuration FSM.
+  */
+static g3_conf_state_t g3_conf_fsm_received_dbgtool_cnf(void)
+{
+	g3_conf_fsm_info.curr_event = CONF_EV_NONE;
+
+	g3_conf_fsm_info.dbgtool_pending = false;
+
+	return g3_conf_send_attributes();
+}
+
 /**
   * @brief G3 Configuration FSM function that executes after the reception of a RFCONFIGSET confirmation.
   * @note The behavior of this function depends on the device type.
@@ -449,12 +520,10 @@ static void g3_conf_handle_swreset_cnf(const void *payload)
   */
 static void g3_conf_handle_set_cnf(const void *payload)
 {
-#if (DEBUG_G3_CONF >= DEBUG_LEVEL_CRITICAL)
 	const G3_LIB_SetAttributeConfirm_t *set_attr_cnf = payload;
 	HANDLE_CNF_ERROR(HIF_G3LIB_SET_CNF, set_attr_cnf->status);
-#else
-	UNUSED(payload);
-#endif
+
+	g3_conf_fsm_info.cnf_attr = set_attr_cnf->attribute_id;
 
     g3_conf_fsm_info.curr_event = CONF_EV_RECEIVED_SET_CNF;
 }
@@ -670,6 +739,10 @@ void g3_app_conf_init(void)
 	g3_conf_fsm_info.peVersion = 0x00000000;
 	g3_conf_fsm_info.rf_connected = false;
 	g3_conf_fsm_info.g3_ready = false;
+
+	g3_conf_fsm_info.attributes_sent  = false;
+	g3_conf_fsm_info.dbgtool_pending  = false;
+	g3_conf_fsm_info.pending_attr_num = 0;
 }
 
 /**
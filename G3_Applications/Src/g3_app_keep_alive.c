@@ -62,7 +62,7 @@
 /* Time between Keep-Alive checks */
 #define KEEP_ALIVE_CHECK_PERIOD             (600000U)	/* In ms, using a too short period can clog up the communication */
 
-/* For 2 or more devices, time between each device Keep-Alive check (ping/kick) */
+/* For a device that did not answer, time before the next Keep-Alive check (ping/kick) */
 #define KEEP_ALIVE_CHECK_NEXT_DELAY         (10000U)		/* In ms */
 
 /* Time between Keep-Alive check retries */
@@ -75,37 +75,48 @@
 /* Timeouts for kick (coord) / leave (device) request */
 #define KA_DEVICE_LEAVE_TIME                (3 * KEEP_ALIVE_CHECK_PERIOD) /* In ms */
 
+/* KEEP-ALIVE SCHEDULING (coordinator only) */
+
+/* Maximum number of pings waiting for their echo reply at the same time */
+#define KEEP_ALIVE_MAX_PENDING_PINGS        (4U)
+
+/* Minimum time between two consecutive pings, to leave room for the user traffic */
+#define KEEP_ALIVE_PING_INTERVAL            (1000U)		/* In ms */
+
+/* Position value of a device that is not in the Keep-Alive schedule */
+#define KA_NOT_SCHEDULED                    (0xFFFFU)
+
+/* Wrap-safe comparison of two HAL_GetTick() timestamps */
+#define KA_TS_REACHED(ts, now)              (((int32_t) ((now) - (ts))) >= 0)
+
 /* KA message ID */
 #define KA_MSG_ID		0x10		/* ID value of the Keep-Alive message */
 
 /* Custom types */
-typedef enum ka_panc_event_enum
-{
-    KA_EV_PANC_NONE = 0,
-    KA_EV_PANC_PING_DEVICE,
-    KA_EV_PANC_RECEIVED_ECHO_CNF,
-    KA_EV_PANC_RECEIVED_ECHO_IND,
-    KA_EV_PANC_TIMEOUT_ON_ECHO_IND,
-    KA_EV_PANC_CNT
-} ka_event_t;
-
-typedef enum ka_panc_state_enum
+#if IS_COORD
+typedef struct ka_ping_str
 {
-    KA_ST_PANC_READY_TO_SEND_ECHO = 0,
-    KA_ST_PANC_WAIT_FOR_ECHO_ANSWER,
-    KA_ST_PANC_WAIT_FOR_ECHO_IND,
-    KA_ST_PANC_CNT
-} ka_state_t;
+	uint16_t		device_index;	/* Index of the pinged device in the connected device table */
+	uint8_t			handle;			/* Handle of the ICMP echo request */
+	bool			cnf_received;	/* True if the ICMP echo CNF was received */
+	uint32_t		deadline;		/* Time limit for the ICMP echo CNF (or IND, after the CNF) */
+} ka_ping_t;
+#endif
 
 typedef struct ka_info_str
 {
     uint16_t    	ka_pan_id;
 #if IS_COORD
-    ka_state_t		curr_state;
-	ka_event_t		curr_event;
-	uint16_t        ping_index;
-	uint8_t         ping_handle;
-	g3_result_t     ping_status;
+    bool			active;
+    uint16_t		heap_size;
+    uint16_t		heap[BOOT_MAX_NUM_JOINING_NODES];		/* Min-heap of device indexes, ordered by due time */
+    uint16_t		heap_pos[BOOT_MAX_NUM_JOINING_NODES];	/* Position of each device in the heap, or KA_NOT_SCHEDULED */
+    uint32_t		due_ts[BOOT_MAX_NUM_JOINING_NODES];		/* Time of the next ping of each device */
+    ka_ping_t		ping[KEEP_ALIVE_MAX_PENDING_PINGS];		/* Pings waiting for their answer */
+    uint8_t			ping_num;
+    uint32_t		last_ping_ts;
+    bool			traffic_seen[BOOT_MAX_NUM_JOINING_NODES];	/* True if the device sent traffic since its last ping */
+    ka_stats_t		stats;
 #else
     uint16_t    	ka_short_addr;
     uint32_t		last_ka_ts;
@@ -120,6 +131,7 @@ typedef struct ka_msg_str
     uint8_t     	id;
     uint16_t    	pan_id;
     uint16_t    	short_addr;
+    uint8_t			handle;
 } ka_msg_t;
 
 #pragma pack(pop)
@@ -135,334 +147,505 @@ extern osTimerId_t			kaTimerHandle;
 
 /* Private variables */
 static ka_info_t	ka_info;
-static uint8_t u8_keep_alive_in_process;
 
 #if IS_COORD
 
-/* Private function pointer type */
-typedef ka_state_t g3_ka_coord_fsm_func(ka_event_t);
+/* Private functions */
 
-/* Private FSM function prototypes */
-static ka_state_t g3_ka_fsm_default(          	ka_event_t event);
-static ka_state_t g3_ka_fsm_ping_device(	    ka_event_t event);
-static ka_state_t g3_ka_fsm_received_echo_cnf(	ka_event_t event);
-static ka_state_t g3_ka_fsm_received_echo_ind(	ka_event_t event);
-static ka_state_t g3_ka_fsm_timeout_on_echo_ind(ka_event_t event);
+/**
+  * @brief Swaps two entries of the Keep-Alive schedule heap (coordinator only).
+  * @param pos_a Position of the first entry.
+  * @param pos_b Position of the second entry.
+  * @retval None
+  */
+static void g3_ka_heap_swap(uint16_t pos_a, uint16_t pos_b)
+{
+	uint16_t index = ka_info.heap[pos_a];
 
-/* Private FSM function pointer array */
-static g3_ka_coord_fsm_func *g3_ka_coord_fsm_func_tbl[KA_ST_PANC_CNT][KA_EV_PANC_CNT] = {
-/*                         NONE,              PING_DEVICE,           RECEIVED_ECHO_CNF,           RECEIVED_ECHO_IND,           TIMEOUT_ON_ECHO_IND*/
-/* READY_TO_SEND_ECHO   */{g3_ka_fsm_default, g3_ka_fsm_ping_device, g3_ka_fsm_default,           g3_ka_fsm_default,           g3_ka_fsm_default            },
-/* WAIT_FOR_ECHO_ANSWER */{g3_ka_fsm_default, g3_ka_fsm_default,     g3_ka_fsm_received_echo_cnf, g3_ka_fsm_received_echo_ind, g3_ka_fsm_timeout_on_echo_ind},
-/* WAIT_FOR_ECHO_IND    */{g3_ka_fsm_default, g3_ka_fsm_default,     g3_ka_fsm_default,           g3_ka_fsm_received_echo_ind, g3_ka_fsm_timeout_on_echo_ind}
-};
+	ka_info.heap[pos_a] = ka_info.heap[pos_b];
+	ka_info.heap[pos_b] = index;
 
-/* Private functions */
+	ka_info.heap_pos[ka_info.heap[pos_a]] = pos_a;
+	ka_info.heap_pos[ka_info.heap[pos_b]] = pos_b;
+}
+
+/**
+  * @brief Checks if the entry at a position of the heap is due before the entry at another one (coordinator only).
+  * @param pos_a Position of the first entry.
+  * @param pos_b Position of the second entry.
+  * @return 'true' if the first entry is due before the second one, 'false' otherwise.
+  */
+static bool g3_ka_heap_before(uint16_t pos_a, uint16_t pos_b)
+{
+	return ((int32_t) (ka_info.due_ts[ka_info.heap[pos_a]] - ka_info.due_ts[ka_info.heap[pos_b]])) < 0;
+}
 
 /**
-  * @brief Prepares to ping the next device, if there are still more to ping, or sets the next K.A. event (coordinator only).
+  * @brief Restores the heap order, moving an entry towards the top or the bottom of the heap (coordinator only).
+  * @param pos Position of the entry to move.
   * @retval None
   */
-static void g3_ka_coord_load_next_device()
+static void g3_ka_heap_fix(uint16_t pos)
 {
-	uint32_t time_to_next_check;
-	bool roundtable_completed = false;
+	uint16_t smallest;
 
-	uint16_t initial_index = ka_info.ping_index;
-	boot_device_t  *device = NULL;
+	/* Moves up */
+	while ((pos > 0) && g3_ka_heap_before(pos, (pos - 1) / 2))
+	{
+		g3_ka_heap_swap(pos, (pos - 1) / 2);
+		pos = (pos - 1) / 2;
+	}
 
-	do
+	/* Moves down */
+	while (true)
 	{
-		ka_info.ping_index++;
+		smallest = pos;
 
-		if (ka_info.ping_index >= BOOT_MAX_NUM_JOINING_NODES)
+		if (((2 * pos + 1) < ka_info.heap_size) && g3_ka_heap_before(2 * pos + 1, smallest))
+		{
+			smallest = 2 * pos + 1;
+		}
+		if (((2 * pos + 2) < ka_info.heap_size) && g3_ka_heap_before(2 * pos + 2, smallest))
 		{
-			/* When the index restarts from 0, more time is waited to trigger the next keep-alive event */
-			ka_info.ping_index = 0;
-			roundtable_completed = true;
+			smallest = 2 * pos + 2;
 		}
 
-		if (boot_server.connected_devices[ka_info.ping_index].conn_state == boot_state_connected)
+		if (smallest == pos)
 		{
-			device = &boot_server.connected_devices[ka_info.ping_index];
 			break;
 		}
+
+		g3_ka_heap_swap(pos, smallest);
+		pos = smallest;
 	}
-	while (ka_info.ping_index != initial_index);
+}
 
-	if (device != NULL)
+/**
+  * @brief Schedules the next ping of a device, or moves it if the device is already scheduled (coordinator only).
+  * @param index Index of the device in the connected device table.
+  * @param due_ts Time of the next ping.
+  * @retval None
+  */
+static void g3_ka_schedule_device(uint16_t index, uint32_t due_ts)
+{
+	ka_info.due_ts[index] = due_ts;
+
+	if (ka_info.heap_pos[index] == KA_NOT_SCHEDULED)
 	{
-		/* Checks if all connected devices have been pinged */
-		if (roundtable_completed)
-		{
-			u8_keep_alive_in_process = 0;
+		ka_info.heap[ka_info.heap_size] = index;
+		ka_info.heap_pos[index] = ka_info.heap_size;
+		ka_info.heap_size++;
+	}
 
-			/* No more devices, sets standard amount of time, if not urgent */
-			if ((HAL_GetTick() - device->last_ka_ts + KEEP_ALIVE_CHECK_PERIOD) < KA_DEVICE_LEAVE_TIME)
-			{
-				time_to_next_check =  KEEP_ALIVE_CHECK_PERIOD;
-			}
-			else
-			{
-				time_to_next_check = KEEP_ALIVE_CHECK_NEXT_DELAY;
-			}
+	g3_ka_heap_fix(ka_info.heap_pos[index]);
+}
+
+/**
+  * @brief Removes a device from the Keep-Alive schedule (coordinator only).
+  * @param index Index of the device in the connected device table.
+  * @retval None
+  */
+static void g3_ka_unschedule_device(uint16_t index)
+{
+	uint16_t pos = ka_info.heap_pos[index];
+
+	if (pos != KA_NOT_SCHEDULED)
+	{
+		ka_info.heap_size--;
+
+		if (pos != ka_info.heap_size)
+		{
+			g3_ka_heap_swap(pos, ka_info.heap_size);
+			ka_info.heap_pos[index] = KA_NOT_SCHEDULED;
+			g3_ka_heap_fix(pos);
 		}
 		else
 		{
-			/* If there are more devices to ping, sets a small amount of time before the next Keep-Alive ping event */
-			time_to_next_check = KEEP_ALIVE_CHECK_NEXT_DELAY;
+			ka_info.heap_pos[index] = KA_NOT_SCHEDULED;
 		}
+	}
+}
 
-#if (DEBUG_G3_KA >= DEBUG_LEVEL_FULL)
-		PRINT_G3_KA_INFO("Will ping device %u in %u seconds.\n", device->short_addr, time_to_next_check/configTICK_RATE_HZ);
-#endif
-		osTimerStart(kaTimerHandle, time_to_next_check);
+/**
+  * @brief Finds the pending ping with the given handle (coordinator only).
+  * @param handle Handle of the ICMP echo request.
+  * @return Position of the ping in the pending ping table, or KEEP_ALIVE_MAX_PENDING_PINGS if not found.
+  */
+static uint8_t g3_ka_find_ping(uint8_t handle)
+{
+	uint8_t i;
+
+	for (i = 0; i < ka_info.ping_num; i++)
+	{
+		if (ka_info.ping[i].handle == handle)
+		{
+			break;
+		}
 	}
-	else
+
+	return (i < ka_info.ping_num) ? i : KEEP_ALIVE_MAX_PENDING_PINGS;
+}
+
+/**
+  * @brief Removes a ping from the pending ping table (coordinator only).
+  * @param ping_pos Position of the ping in the pending ping table.
+  * @retval None
+  */
+static void g3_ka_remove_ping(uint8_t ping_pos)
+{
+	ka_info.ping_num--;
+	ka_info.ping[ping_pos] = ka_info.ping[ka_info.ping_num];
+}
+
+/**
+  * @brief Checks if a ping is still waiting for its ICMP echo CNF (coordinator only).
+  * @return 'true' if a ping is waiting for its CNF, 'false' otherwise.
+  */
+static bool g3_ka_cnf_pending(void)
+{
+	bool pending = false;
+
+	for (uint8_t i = 0; i < ka_info.ping_num; i++)
 	{
-		u8_keep_alive_in_process = 0;
+		if (!ka_info.ping[i].cnf_received)
+		{
+			pending = true;
+			break;
+		}
+	}
+
+	return pending;
+}
+
+/**
+  * @brief Adds the connected devices that are not scheduled yet, spreading their first ping across the check period (coordinator only).
+  * @retval None
+  */
+static void g3_ka_coord_sync_devices(void)
+{
+	uint32_t now = HAL_GetTick();
 
-		PRINT_G3_KA_WARNING("No device to ping\n");
+	for (uint16_t i = 0; i < BOOT_MAX_NUM_JOINING_NODES; i++)
+	{
+		if ((boot_server.connected_devices[i].conn_state == boot_state_connected) && (ka_info.heap_pos[i] == KA_NOT_SCHEDULED))
+		{
+			/* Devices being pinged are rescheduled when the ping ends */
+			bool pinging = false;
+
+			for (uint8_t j = 0; j < ka_info.ping_num; j++)
+			{
+				if (ka_info.ping[j].device_index == i)
+				{
+					pinging = true;
+					break;
+				}
+			}
+
+			if (!pinging)
+			{
+				g3_ka_schedule_device(i, now + (KEEP_ALIVE_CHECK_PERIOD / BOOT_MAX_NUM_JOINING_NODES) * (i + 1));
+			}
+		}
 	}
 }
 
 /**
-  * @brief Starts the check for the next device in the K.A. device table, by triggering the KA_EV_PANC_CHECK_DEVICES event (coordinator only).
-  * @param unused Unused parameter (can be set as NULL).
+  * @brief Handles the end of a successful ping, scheduling the next one after a full check period (coordinator only).
+  * @param index Index of the device in the connected device table.
   * @retval None
   */
-static void g3_ka_coord_timer_event(void *unused)
+static void g3_ka_coord_ping_succeeded(uint16_t index)
 {
-	UNUSED(unused);
+	boot_device_t *device = &boot_server.connected_devices[index];
 
-	if (ka_info.curr_state == KA_ST_PANC_READY_TO_SEND_ECHO)
+	if (device->conn_state == boot_state_connected)
 	{
-		/* Triggers ping */
-		ka_info.curr_event = KA_EV_PANC_PING_DEVICE;
+		if (device->lives != KEEP_ALIVE_LIVES_N)
+		{
+			PRINT_G3_KA_WARNING("Device with short address %u restored (lives: %u->%u)\n", device->short_addr, device->lives, KEEP_ALIVE_LIVES_N);
+			device->lives = KEEP_ALIVE_LIVES_N;
+		}
+#if (DEBUG_G3_KA >= DEBUG_LEVEL_FULL)
+		else
+		{
+			PRINT_G3_KA_INFO("Device with short address %u is alive\n", device->short_addr);
+		}
+#endif
+		device->last_ka_ts = HAL_GetTick();
+
+		g3_ka_schedule_device(index, device->last_ka_ts + KEEP_ALIVE_CHECK_PERIOD);
 	}
-	else if (ka_info.curr_state == KA_ST_PANC_WAIT_FOR_ECHO_IND)
+	else
 	{
-		/* Triggers timeout */
-		ka_info.curr_event = KA_EV_PANC_TIMEOUT_ON_ECHO_IND;
+		PRINT_G3_KA_WARNING("Echo IND from disconnected device\n");
 	}
-
-	RTOS_PUT_MSG(g3_queueHandle, KA_MSG, NULL);
 }
 
 /**
-  * @brief G3 Keep-Alive FSM function that maintains the current state, with no further action.
-  * @param event Current G3 Keep-Alive event.
-  * @return The next state of the G3 Keep-Alive FSM (equal to the current one).
+  * @brief Handles the end of a failed ping, kicking the device if it has no lives left (coordinator only).
+  * @param index Index of the device in the connected device table.
+  * @retval None
   */
-static ka_state_t g3_ka_fsm_default(ka_event_t event)
+static void g3_ka_coord_ping_failed(uint16_t index)
 {
-	UNUSED(event);
+	boot_device_t *device = &boot_server.connected_devices[index];
 
-	/* Resets event */
-    ka_info.curr_event = KA_EV_PANC_NONE;
+	if (device->conn_state == boot_state_connected)
+	{
+		device->lives--;
 
-    return ka_info.curr_state;
+		if (device->lives == 0)
+		{
+			/* If the ping failed and the device has no lives left, kicks out the device */
+			g3_app_boot_kick_device(device);
+		}
+		else
+		{
+			/* Checks the device again sooner than usual */
+			g3_ka_schedule_device(index, HAL_GetTick() + KEEP_ALIVE_CHECK_NEXT_DELAY);
+		}
+	}
 }
 
 /**
-  * @brief G3 Keep-Alive FSM function that pings the current device, depending on how many times it was pinged unsuccessfully before.
-  * @param event Current G3 Keep-Alive event.
-  * @return The next state of the G3 Keep-Alive FSM.
+  * @brief Sends a ping to a device, adding it to the pending ping table (coordinator only).
+  * @param index Index of the device in the connected device table.
+  * @retval None
   */
-static ka_state_t g3_ka_fsm_ping_device(ka_event_t event)
+static void g3_ka_coord_ping_device(uint16_t index)
 {
-	UNUSED(event);
-
-	ka_state_t next_state;
 	ip6_addr_t ip_dst_addr;
 	uint16_t len;
 	ka_msg_t ka_payload;
 	IP_G3IcmpDataRequest_t	*icmp_data_req = MEMPOOL_MALLOC(sizeof(IP_G3IcmpDataRequest_t));
-    
-    boot_device_t * device = &boot_server.connected_devices[ka_info.ping_index];
+	boot_device_t *device = &boot_server.connected_devices[index];
+	ka_ping_t *ping = &ka_info.ping[ka_info.ping_num++];
 
-    if (device->conn_state == boot_state_connected)
-	{
-    	u8_keep_alive_in_process = 1;
+	ping->device_index = index;
+	ping->handle = ++ka_info.icmp_handle;
+	ping->cnf_received = false;
+	ping->deadline = HAL_GetTick() + KEEP_ALIVE_CNF_TIMEOUT;
+
+	ka_info.last_ping_ts = HAL_GetTick();
+	ka_info.traffic_seen[index] = false;
+	ka_info.stats.pings_sent++;
 
-		/* Sends new ping to the device */
-		ka_payload.id = KA_MSG_ID;
-		ka_payload.pan_id = ka_info.ka_pan_id;
-		ka_payload.short_addr = device->short_addr;
+	/* Sends new ping to the device */
+	ka_payload.id = KA_MSG_ID;
+	ka_payload.pan_id = ka_info.ka_pan_id;
+	ka_payload.short_addr = device->short_addr;
+	ka_payload.handle = ping->handle;
 
 #if (DEBUG_G3_KA >= DEBUG_LEVEL_FULL)
-		PRINT_G3_KA_INFO("Pinging device %u (PAN: %X).\n", device->short_addr, ka_info.ka_pan_id);
+	PRINT_G3_KA_INFO("Pinging device %u (PAN: %X).\n", device->short_addr, ka_info.ka_pan_id);
 #endif
-		/* Compute the IPv6 remote address, from the short address */
-		hi_ipv6_set_ipaddr(&ip_dst_addr, ka_info.ka_pan_id, device->short_addr);
-
-		ka_info.ping_handle = ++ka_info.icmp_handle;
+	/* Compute the IPv6 remote address, from the short address */
+	hi_ipv6_set_ipaddr(&ip_dst_addr, ka_info.ka_pan_id, device->short_addr);
 
-		device->last_ka_ts = HAL_GetTick();
+	/* Prepare and send request ST8500 */
+	len = hi_ipv6_echoreq_fill(icmp_data_req, ip_dst_addr, ping->handle, sizeof(ka_payload), (uint8_t*) &ka_payload);
+	g3_send_message(HIF_TX_MSG, HIF_ICMP_ECHO_REQ, icmp_data_req, len);
+}
 
-		/* Prepare and send request ST8500 */
-		len = hi_ipv6_echoreq_fill(icmp_data_req, ip_dst_addr, ka_info.ping_handle, sizeof(ka_payload), (uint8_t*) &ka_payload);
-		g3_send_message(HIF_TX_MSG, HIF_ICMP_ECHO_REQ, icmp_data_req, len);
+/**
+  * @brief Starts the K.A. timer for the earliest of the pending ping deadlines and of the next scheduled ping (coordinator only).
+  * @param now Current time, in ms.
+  * @retval None
+  */
+static void g3_ka_coord_arm_timer(uint32_t now)
+{
+	uint32_t next_ts = now + KEEP_ALIVE_CHECK_PERIOD;
+	int32_t  time_to_next_event;
 
-		/* Now both IND and CNF can be received in any order so we go to a state that can receive both */
-		next_state = KA_ST_PANC_WAIT_FOR_ECHO_ANSWER;
+	for (uint8_t i = 0; i < ka_info.ping_num; i++)
+	{
+		if ((int32_t) (ka_info.ping[i].deadline - next_ts) < 0)
+		{
+			next_ts = ka_info.ping[i].deadline;
+		}
 	}
-    else
-    {
-    	/* If the device is missing at the given index, silently loads the next one */
-		g3_ka_coord_load_next_device();
 
-		next_state = KA_ST_PANC_READY_TO_SEND_ECHO;
-    }
+	/* The next ping is sent when its device is due, if there is room for it (CNFs trigger the scheduler too) */
+	if ((ka_info.heap_size > 0) && (ka_info.ping_num < KEEP_ALIVE_MAX_PENDING_PINGS))
+	{
+		uint32_t ping_ts = ka_info.due_ts[ka_info.heap[0]];
+
+		if ((int32_t) (ka_info.last_ping_ts + KEEP_ALIVE_PING_INTERVAL - ping_ts) > 0)
+		{
+			ping_ts = ka_info.last_ping_ts + KEEP_ALIVE_PING_INTERVAL;
+		}
 
-	/* Resets event */
-	ka_info.curr_event = KA_EV_PANC_NONE;
+		if ((int32_t) (ping_ts - next_ts) < 0)
+		{
+			next_ts = ping_ts;
+		}
+	}
 
-    return next_state;
+	time_to_next_event = (int32_t) (next_ts - now);
+
+	osTimerStart(kaTimerHandle, (time_to_next_event > 0) ? (uint32_t) time_to_next_event : 1);
 }
 
 /**
-  * @brief G3 Keep-Alive FSM function that acknowledges the reception of the ICMP echo confirmation.
-  * @param event Current G3 Keep-Alive event.
-  * @return The next state of the G3 Keep-Alive FSM.
+  * @brief Runs the K.A. scheduler: expires the late pings, sends the next due ping and re-arms the K.A. timer (coordinator only).
+  * @retval None
   */
-static ka_state_t g3_ka_fsm_received_echo_cnf(ka_event_t event)
+static void g3_ka_coord_run(void)
 {
-	UNUSED(event);
+	uint32_t now = HAL_GetTick();
 
-	ka_state_t next_state;
-    
-    boot_device_t *device = &boot_server.connected_devices[ka_info.ping_index];
+	if (!ka_info.active)
+	{
+		return;
+	}
 
-	if (device->conn_state == boot_state_connected)
+	g3_ka_coord_sync_devices();
+
+	/* Expires the pings with no answer */
+	for (uint8_t i = ka_info.ping_num; i > 0; i--)
 	{
-		if (ka_info.ping_status == G3_SUCCESS)
-		{
-			next_state = KA_ST_PANC_WAIT_FOR_ECHO_IND;
+		ka_ping_t *ping = &ka_info.ping[i - 1];
 
-			/* If the ping was successful and it received only the ECHO CNF, waits for the ECHO IND */
-			osTimerStart(kaTimerHandle, KEEP_ALIVE_IND_TIMEOUT);
-		}
-		else
+		if (KA_TS_REACHED(ping->deadline, now))
 		{
-			next_state = KA_ST_PANC_READY_TO_SEND_ECHO;
+			uint16_t index = ping->device_index;
 
-			if (ka_info.ping_status == G3_BUSY)
+			/* Necessary but not sufficient for determinate death */
+			if (ping->cnf_received)
 			{
-				PRINT_G3_KA_WARNING("Platform busy while pinging device %u, retrying in %u ms\n", device->short_addr, KEEP_ALIVE_CHECK_RETRY_DELAY);
-				osTimerStart(kaTimerHandle, KEEP_ALIVE_CHECK_RETRY_DELAY);
+				PRINT_G3_KA_WARNING("Did not receive echo IND for device %u\n", boot_server.connected_devices[index].short_addr);
 			}
 			else
 			{
-				/* Necessary but not sufficient for determinate death */
-				PRINT_G3_KA_WARNING("Error on echo CNF for device %u\n", device->short_addr);
+				PRINT_G3_KA_WARNING("Did not receive echo CNF for device %u\n", boot_server.connected_devices[index].short_addr);
+			}
+
+			g3_ka_remove_ping(i - 1);
+			g3_ka_coord_ping_failed(index);
+		}
+	}
+
+	/* The ST8500 handles one echo request at a time: the next ping waits for the CNF of the previous one */
+	if ((ka_info.ping_num < KEEP_ALIVE_MAX_PENDING_PINGS) && !g3_ka_cnf_pending() &&
+		KA_TS_REACHED(ka_info.last_ping_ts + KEEP_ALIVE_PING_INTERVAL, now))
+	{
+		while ((ka_info.heap_size > 0) && KA_TS_REACHED(ka_info.due_ts[ka_info.heap[0]], now))
+		{
+			uint16_t index = ka_info.heap[0];
+
+			g3_ka_unschedule_device(index);
 
-				device->lives--;
+			/* Devices that left the PAN are silently dropped from the schedule */
+			if (boot_server.connected_devices[index].conn_state == boot_state_connected)
+			{
+				uint32_t last_ka_ts = boot_server.connected_devices[index].last_ka_ts;
 
-				if (device->lives == 0)
+				if (ka_info.traffic_seen[index] && ((now - last_ka_ts) < KEEP_ALIVE_CHECK_PERIOD))
 				{
-					/* If the ping failed and the device has no lives left, kicks out the device */
-					g3_app_boot_kick_device(device);
+					/* The device sent traffic during the check period: postpones its ping */
+					ka_info.traffic_seen[index] = false;
+					ka_info.stats.pings_avoided++;
+					g3_ka_schedule_device(index, last_ka_ts + KEEP_ALIVE_CHECK_PERIOD);
+				}
+				else
+				{
+					g3_ka_coord_ping_device(index);
+					break;
 				}
-
-				g3_ka_coord_load_next_device();
 			}
 		}
 	}
-	else
-	{
-		next_state = KA_ST_PANC_READY_TO_SEND_ECHO;
-
-		g3_ka_coord_load_next_device();
-	}
 
-	/* Resets the event */
-	ka_info.curr_event = KA_EV_PANC_NONE;
-
-    return next_state;
+	g3_ka_coord_arm_timer(now);
 }
 
 /**
-  * @brief G3 Keep-Alive FSM function that acknowledges the reception of the ICMP echo indication.
-  * @param event Current G3 Keep-Alive event.
-  * @return The next state of the G3 Keep-Alive FSM.
+  * @brief Refreshes the liveness of the device that sent an inbound message, postponing its next ping (coordinator only).
+  * @param pan_id PAN ID of the sender.
+  * @param short_addr Short address of the sender.
+  * @retval None
   */
-static ka_state_t g3_ka_fsm_received_echo_ind(ka_event_t event)
+static void g3_ka_coord_traffic_received(uint16_t pan_id, uint16_t short_addr)
 {
-	UNUSED(event);
-    
-    boot_device_t *device = &boot_server.connected_devices[ka_info.ping_index];
+	boot_device_t *device;
 
-	if (device->conn_state == boot_state_connected)
+	if (ka_info.active && (pan_id == ka_info.ka_pan_id))
 	{
-		if (device->lives != KEEP_ALIVE_LIVES_N)
-		{
-			PRINT_G3_KA_WARNING("Device with short address %u restored (lives: %u->%u)\n", device->short_addr, device->lives, KEEP_ALIVE_LIVES_N);
-			device->lives = KEEP_ALIVE_LIVES_N;
-		}
-#if (DEBUG_G3_KA >= DEBUG_LEVEL_FULL)
-		else
+		device = g3_app_boot_find_device(NULL, short_addr, boot_state_connected);
+
+		if (device != NULL)
 		{
-			PRINT_G3_KA_INFO("Device with short address %u is alive\n", device->short_addr);
+			if (device->lives != KEEP_ALIVE_LIVES_N)
+			{
+				PRINT_G3_KA_WARNING("Device with short address %u restored by traffic (lives: %u->%u)\n", device->short_addr, device->lives, KEEP_ALIVE_LIVES_N);
+				device->lives = KEEP_ALIVE_LIVES_N;
+			}
+
+			/* The ping is postponed when the device is due, to leave the schedule untouched here */
+			device->last_ka_ts = HAL_GetTick();
+			ka_info.traffic_seen[device - boot_server.connected_devices] = true;
+			ka_info.stats.traffic_refreshes++;
 		}
-#endif
 	}
-	else
+}
+
+/**
+  * @brief Function that handles the reception of a UDP data indication (coordinator only).
+  * @param payload Pointer to the payload of the received message.
+  * @retval None
+  */
+static void g3_ka_handle_udp_data_ind(const void *payload)
+{
+	const IP_UdpDataIndication_t *udp_data_ind = hi_ipv6_extract_udp_from_ip(payload);
+	uint16_t src_pan_id, src_short_addr;
+
+	if (udp_data_ind != NULL)
 	{
-		PRINT_G3_KA_WARNING("Echo IND from disconnected device\n");
+		hi_ipv6_get_saddr_panid(udp_data_ind->source_address, &src_pan_id, &src_short_addr);
+		g3_ka_coord_traffic_received(src_pan_id, src_short_addr);
 	}
+}
 
-	g3_ka_coord_load_next_device();
+/**
+  * @brief Function that handles the reception of a ICMP echo request indication (coordinator only).
+  * @param payload Pointer to the payload of the received message.
+  * @retval None
+  */
+static void g3_ka_handle_echoreq_ind(const void *payload)
+{
+	const IP_IcmpDataIndication_t *data_ind = hi_ipv6_extract_icmp_from_ip(payload);
+	uint16_t src_pan_id, src_short_addr;
 
-    /* Resets event */
-    ka_info.curr_event = KA_EV_PANC_NONE;
-    
-    return KA_ST_PANC_READY_TO_SEND_ECHO;
+	hi_ipv6_get_saddr_panid(data_ind->source_address, &src_pan_id, &src_short_addr);
+	g3_ka_coord_traffic_received(src_pan_id, src_short_addr);
 }
 
 /**
- * @brief G3 Keep-Alive FSM function that acknowledges the timeout of the ICMP echo indication.
- * @param event Current G3 Keep-Alive event.
- * @return The next state of the G3 Keep-Alive FSM.
- */
-static ka_state_t g3_ka_fsm_timeout_on_echo_ind(ka_event_t event)
+  * @brief Function that handles the reception of a LBP indication (coordinator only).
+  * @param payload Pointer to the payload of the received message.
+  * @retval None
+  */
+static void g3_ka_handle_lbp_ind(const void *payload)
 {
-	UNUSED(event);
+	const ADP_AdpmLbpIndication_t *lbp_ind = payload;
 
-	boot_device_t * device = &boot_server.connected_devices[ka_info.ping_index];
-
-	if (device->conn_state == boot_state_connected)
+	/* LBP messages relayed for a joining device come from its agent, that is alive as well */
+	if (lbp_ind->src_addr.addr_mode == MAC_ADDR_MODE_16)
 	{
-		/* Necessary but not sufficient for determinate death */
-		PRINT_G3_KA_WARNING("Did not receive echo IND for device %u\n", device->short_addr);
-
-		device->lives--;
-
-		if (device->lives == 0)
-		{
-			/* If the ping failed and the device has no lives left, kicks out the device */
-			g3_app_boot_kick_device(device);
-		}
+		g3_ka_coord_traffic_received(ka_info.ka_pan_id, lbp_ind->src_addr.short_addr);
 	}
-
-	/* Proceeds to the next device in list */
-	g3_ka_coord_load_next_device();
-
-	/* Resets event */
-	ka_info.curr_event = KA_EV_PANC_NONE;
-
-	return KA_ST_PANC_READY_TO_SEND_ECHO;
 }
 
-
 /**
-  * @brief Function that handles the FSM of the keep-alive activity.
-  * @param None
+  * @brief Triggers the K.A. scheduler from the G3 task (coordinator only).
+  * @param unused Unused parameter (can be set as NULL).
   * @retval None
   */
-static void g3_ka_fsm_manager(void)
+static void g3_ka_coord_timer_event(void *unused)
 {
-    ka_info.curr_state = g3_ka_coord_fsm_func_tbl[ka_info.curr_state][ka_info.curr_event](ka_info.curr_event);
+	UNUSED(unused);
+
+	RTOS_PUT_MSG(g3_queueHandle, KA_MSG, NULL);
 }
 
 /**
@@ -506,8 +689,11 @@ static void g3_ka_handle_server_join_ind(const void *payload)
 {
 	UNUSED(payload);
 
-    /* Starts timer for keep-alive, if not already running */
-    g3_app_ka_start();
+    /* Starts the keep-alive, if not already running, or adds the new device to the schedule */
+    if (!g3_app_ka_start())
+    {
+    	RTOS_PUT_MSG(g3_queueHandle, KA_MSG, NULL);
+    }
 }
 
 /**
@@ -518,13 +704,39 @@ static void g3_ka_handle_server_join_ind(const void *payload)
 static void g3_ka_handle_echo_cnf(const void *payload)
 {
     const IP_G3IcmpDataConfirm_t *echo_cnf = payload;
+    uint8_t ping_pos = g3_ka_find_ping(echo_cnf->handle);
 
-    if (echo_cnf->handle == ka_info.ping_handle)
+    /* The echo IND may have been received before the CNF, in that case the ping is already closed */
+    if (ping_pos < KEEP_ALIVE_MAX_PENDING_PINGS)
     {
+    	ka_ping_t *ping = &ka_info.ping[ping_pos];
+    	uint16_t index = ping->device_index;
+
     	HANDLE_CNF_ERROR(HIF_ICMP_ECHO_CNF, echo_cnf->status);
 
-		ka_info.ping_status = echo_cnf->status;
-        ka_info.curr_event = KA_EV_PANC_RECEIVED_ECHO_CNF;
+		if (echo_cnf->status == G3_SUCCESS)
+		{
+			/* Waits for the echo IND */
+			ping->cnf_received = true;
+			ping->deadline = HAL_GetTick() + KEEP_ALIVE_IND_TIMEOUT;
+		}
+		else
+		{
+			g3_ka_remove_ping(ping_pos);
+
+			if (echo_cnf->status == G3_BUSY)
+			{
+				PRINT_G3_KA_WARNING("Platform busy while pinging device %u, retrying in %u ms\n", boot_server.connected_devices[index].short_addr, KEEP_ALIVE_CHECK_RETRY_DELAY);
+				g3_ka_schedule_device(index, HAL_GetTick() + KEEP_ALIVE_CHECK_RETRY_DELAY);
+			}
+			else
+			{
+				/* Necessary but not sufficient for determinate death */
+				PRINT_G3_KA_WARNING("Error on echo CNF for device %u\n", boot_server.connected_devices[index].short_addr);
+				g3_ka_coord_ping_failed(index);
+			}
+		}
+
         RTOS_PUT_MSG(g3_queueHandle, KA_MSG, NULL);
     }
 }
@@ -539,31 +751,38 @@ static void g3_ka_handle_echorep_ind(const void *payload)
     const IP_DataIndication_t *echo_ind = payload;
     const IP_IcmpDataIndication_t *data_ind = hi_ipv6_extract_icmp_from_ip(echo_ind);
     uint16_t src_pan_id, src_short_addr;
-    
-    boot_device_t * device = &boot_server.connected_devices[ka_info.ping_index];
 
-	if (device->conn_state == boot_state_connected)
+	ka_msg_t* ka_msg = (ka_msg_t*) data_ind->data;
+
+	 /* If for the Keep-Alive */
+	if (ka_msg->id == KA_MSG_ID)
 	{
-		ka_msg_t* ka_msg = (ka_msg_t*) data_ind->data;
+		uint8_t ping_pos = g3_ka_find_ping(ka_msg->handle);
 
-		 /* If for the Keep-Alive */
-		if (ka_msg->id == KA_MSG_ID)
+		hi_ipv6_get_saddr_panid(data_ind->source_address, &src_pan_id, &src_short_addr);
+
+		/* Checks the PAN ID and short address */
+		if ((ping_pos < KEEP_ALIVE_MAX_PENDING_PINGS) && (src_pan_id == ka_info.ka_pan_id) &&
+			(src_short_addr == boot_server.connected_devices[ka_info.ping[ping_pos].device_index].short_addr))
 		{
-			hi_ipv6_get_saddr_panid(data_ind->source_address, &src_pan_id, &src_short_addr);
+			uint16_t index = ka_info.ping[ping_pos].device_index;
 
-			/* Checks the PAN ID and short address */
-			if ((src_pan_id == ka_info.ka_pan_id) && (src_short_addr == device->short_addr))
-			{
-				ka_info.curr_event = KA_EV_PANC_RECEIVED_ECHO_IND;
-				RTOS_PUT_MSG(g3_queueHandle, KA_MSG, NULL);
-			}
-			else
-			{
-				PRINT_G3_KA_WARNING("Ping from unknown device (PAN %X, address %d).\n", src_pan_id, src_short_addr);
-			}
+			g3_ka_remove_ping(ping_pos);
+			g3_ka_coord_ping_succeeded(index);
+
+			RTOS_PUT_MSG(g3_queueHandle, KA_MSG, NULL);
+		}
+		else
+		{
+			PRINT_G3_KA_WARNING("Ping from unknown device (PAN %X, address %d).\n", src_pan_id, src_short_addr);
 		}
 	}
-
+	else
+	{
+		/* Echo reply to a user ping */
+		hi_ipv6_get_saddr_panid(data_ind->source_address, &src_pan_id, &src_short_addr);
+		g3_ka_coord_traffic_received(src_pan_id, src_short_addr);
+	}
 }
 
 #else
@@ -692,6 +911,9 @@ bool g3_app_ka_msg_needed(const g3_msg_t *g3_msg)
     case HIF_BOOT_SRV_JOIN_IND:
     case HIF_ICMP_ECHO_CNF:
     case HIF_ICMP_ECHO_REP_IND:
+    case HIF_ICMP_ECHO_REQ_IND:
+    case HIF_UDP_DATA_IND:
+    case HIF_ADPM_LBP_IND:
 #else
     case HIF_BOOT_DEV_LEAVE_CNF:
     case HIF_BOOT_DEV_LEAVE_IND:
@@ -730,6 +952,15 @@ void g3_app_ka_msg_handler(const g3_msg_t *g3_msg)
 	case HIF_ICMP_ECHO_REP_IND:
 		g3_ka_handle_echorep_ind(g3_msg->payload);
 		break;
+	case HIF_ICMP_ECHO_REQ_IND:
+		g3_ka_handle_echoreq_ind(g3_msg->payload);
+		break;
+	case HIF_UDP_DATA_IND:
+		g3_ka_handle_udp_data_ind(g3_msg->payload);
+		break;
+	case HIF_ADPM_LBP_IND:
+		g3_ka_handle_lbp_ind(g3_msg->payload);
+		break;
 #else
 	case HIF_BOOT_DEV_START_CNF:
 		g3_ka_handle_device_start_cnf(g3_msg->payload);
@@ -759,8 +990,7 @@ void g3_app_ka_init(void)
 	memset(&ka_info, 0, sizeof(ka_info));
 
 #if IS_COORD
-	ka_info.curr_state = KA_ST_PANC_READY_TO_SEND_ECHO;
-	ka_info.curr_event = KA_EV_PANC_NONE;
+	memset(ka_info.heap_pos, 0xFF, sizeof(ka_info.heap_pos));
 
 	ka_info.ka_pan_id = PAN_ID;
 #endif /* IS_COORD */
@@ -775,19 +1005,25 @@ bool g3_app_ka_start(void)
 {
 	bool started = false;
 
-	if (!osTimerIsRunning(kaTimerHandle))
-	{
 #if IS_COORD
+	if (!ka_info.active)
+	{
 		started = true;
 		PRINT_G3_KA_INFO("Starting Keep-Alive (PAN ID: %X)\n", ka_info.ka_pan_id);
-		ka_info.ping_index = 0;
-		osTimerStart(kaTimerHandle, KEEP_ALIVE_CHECK_PERIOD);
+		ka_info.active = true;
+		ka_info.last_ping_ts = HAL_GetTick() - KEEP_ALIVE_PING_INTERVAL;
+
+		/* The scheduler adds the connected devices at its first run */
+		osTimerStart(kaTimerHandle, KEEP_ALIVE_CHECK_RETRY_DELAY);
+	}
 #else
+	if (!osTimerIsRunning(kaTimerHandle))
+	{
 		PRINT_G3_KA_INFO("Starting Keep-Alive (PAN ID: %X, short address: %u)\n", ka_info.ka_pan_id, ka_info.ka_short_addr);
 		ka_info.last_ka_ts = HAL_GetTick();
 		osTimerStart(kaTimerHandle, KA_DEVICE_LEAVE_TIME);
-#endif
 	}
+#endif
 
 	return started;
 }
@@ -801,13 +1037,28 @@ bool g3_app_ka_stop(void)
 {
 	bool stopped = false;
 
+#if IS_COORD
+	if (ka_info.active)
+	{
+		stopped = true;
+		ka_info.active = false;
+
+		/* Empties the schedule, answers to the pending pings are ignored */
+		ka_info.heap_size = 0;
+		ka_info.ping_num  = 0;
+		memset(ka_info.heap_pos, 0xFF, sizeof(ka_info.heap_pos));
+
+		PRINT_G3_KA_INFO("Stopped Keep-Alive\n");
+		osTimerStop(kaTimerHandle);
+	}
+#else
 	if (osTimerIsRunning(kaTimerHandle))
 	{
 		stopped = true;
-		u8_keep_alive_in_process = 0;
 		PRINT_G3_KA_INFO("Stopped Keep-Alive\n");
 		osTimerStop(kaTimerHandle);
 	}
+#endif
 
 	return stopped;
 }
@@ -816,7 +1067,7 @@ bool g3_app_ka_stop(void)
 #if IS_COORD
 
 /**
-  * @brief Waits until the G3 keep-alive has finished the round-table ping.
+  * @brief Waits until the G3 keep-alive has no ping waiting for its answer.
   * @param None
   * @retval None
   */
@@ -831,11 +1082,21 @@ void g3_app_ka_wait(void)
 /**
   * @brief Returns the status of the G3 keep-alive current activity.
   * @param None
-  * @retval Returns true if the G3 keep-alive is executing the round-table ping (status of the Keep-Alive LED).
+  * @retval Returns true if the G3 keep-alive has pings waiting for their answer (status of the Keep-Alive LED).
   */
 bool g3_app_ka_in_progress(void)
 {
-	return u8_keep_alive_in_process;
+	return (ka_info.ping_num > 0);
+}
+
+/**
+  * @brief Gets the counters of the G3 keep-alive.
+  * @param stats Pointer to the structure where the counters are copied.
+  * @retval None
+  */
+void g3_app_ka_get_stats(ka_stats_t *stats)
+{
+	*stats = ka_info.stats;
 }
 
 /**
@@ -847,9 +1108,8 @@ void g3_app_ka(void)
 {
     /* For coordinator only */
 
-	/* Manages the current event, depending on the current state */
-	g3_ka_fsm_manager();
-
+	/* Expires the late pings and sends the next due ones */
+	g3_ka_coord_run();
 }
 #else
 
@@ -27,6 +27,7 @@
 #include <g3_app_config.h>
 #include <g3_app_boot.h>
 #include <g3_app_last_gasp.h>
+#include <host_if.h>
 #include <main.h>
 
 /** @addtogroup G3_App
@@ -69,6 +70,20 @@
 
 #define LAST_GASP_MAXHOPS		15	/* Maximum number of hops for broadcast messages */
 
+/* Last Gasp aggregation (coordinator) and forwarding de-duplication (device) */
+#define LAST_GASP_SET_SIZE		64			/* Number of entries of a gasp set, must be a power of 2 */
+#define LAST_GASP_WINDOW		(5000U)		/* In ms, an outage ends when no new device gasped for this time */
+#define LAST_GASP_OVERFLOW_BITS	4096		/* Number of bits of the bitmap of the devices not fitting in the outage set, must be a power of 2 */
+
+/* Size of the buffer of the pre-built Last Gasp frames (G3LIB-SET and G3UDP-DATA requests) */
+#define LAST_GASP_FRAMES_SIZE	256
+
+#if ENABLE_LAST_GASP_PVD
+#define LAST_GASP_PVD_LEVEL		PWR_PVDLEVEL_6	/* Around 2.8 V */
+#endif
+
+#define LAST_GASP_TIMESTAMP_US()	((HAL_GetTick() * 1000) + htimSys.Instance->CNT)	/* Time base counts microseconds within each tick */
+
 /* Custom types */
 typedef enum last_gasp_dest_mode_enum
 {
@@ -102,12 +117,45 @@ typedef struct last_gasp_info_str
 	last_gasp_event_t	curr_event;
 
 	/* This device info */
-	uint8_t				last_gasp_activated;
+	volatile uint8_t	last_gasp_activated;
     uint16_t    		pan_id;
     uint16_t    		short_address;
     uint8_t				handle;
+
+    /* Pre-built frames, sent from the power failure interrupt */
+    volatile bool		frames_ready;
+    volatile bool		frames_sent;
+    uint16_t			frames_len;
+    uint16_t			set_frame_len;	/* Length of the first frame (G3LIB-SET request), the G3UDP-DATA request follows */
+    uint8_t				frames_handle;
+    uint32_t			detection_ts;
 } last_gasp_fsm_t;
 
+/* Entry of a gasp set (hash set of gasped short addresses) */
+typedef struct last_gasp_entry_str
+{
+	uint16_t			short_addr;
+	uint16_t			copies;		/* Number of received copies, 0 for an empty entry */
+	uint32_t			ts;			/* Time of the first copy */
+} last_gasp_entry_t;
+
+typedef struct last_gasp_set_str
+{
+	last_gasp_entry_t	entry[LAST_GASP_SET_SIZE];
+	uint16_t			num;		/* Number of used entries */
+	uint32_t			last_ts;	/* Time of the last new entry */
+} last_gasp_set_t;
+
+#if IS_COORD
+typedef struct last_gasp_outage_str
+{
+	last_gasp_set_t		set;
+	uint32_t			duplicates;	/* Copies of gasps already received */
+	uint32_t			overflows;	/* Devices not fitting in the set */
+	uint32_t			overflow_map[LAST_GASP_OVERFLOW_BITS / 32];	/* Hashed short addresses of the devices not fitting in the set */
+} last_gasp_outage_t;
+#endif
+
 #pragma pack(push, 1)
 
 typedef struct last_gasp_msg_str
@@ -126,11 +174,25 @@ extern osMessageQueueId_t g3_queueHandle;
 
 extern uint8_t udp_handle;         /*!<  Number of sent messages */
 
-#if !IS_COORD
+#if IS_COORD
+
+extern osTimerId_t lastGaspTimerHandle;
+
+/* Private variables */
+static last_gasp_outage_t last_gasp_outage;
+
+#else
+
+extern UART_HandleTypeDef huartHostIf;
+extern TIM_HandleTypeDef  htimSys; /* Systick Timer */
 
 /* Private variables */
 static last_gasp_fsm_t	last_gasp_fsm;
 
+static last_gasp_set_t last_gasp_relayed;	/* Gasps recently forwarded by this device */
+
+static uint8_t last_gasp_frames[LAST_GASP_FRAMES_SIZE]; /* G3LIB-SET (Last Gasp mode) and G3UDP-DATA (Last Gasp message) requests, ready to be sent */
+
 /* Private function pointer type */
 typedef last_gasp_state_t g3_last_gasp_fsm_func(void);
 
@@ -153,6 +215,121 @@ static g3_last_gasp_fsm_func *g3_last_gasp_fsm_func_tbl[LAST_GASP_ST_CNT][LAST_G
 
 /* Private functions */
 
+/**
+  * @brief Fills a Last Gasp message.
+  * @param last_gasp_msg Pointer to the message to fill.
+  * @param gasped_short_addr Short address of the device that detected the power supply shortage
+  * @param hop_count Number of hops of the request
+  * @param device_list The array with the list of short addresses the message has already passed through, NULL for the device starting the Last Gasp.
+  * @return None
+  */
+static void g3_last_gasp_fill_msg(last_gasp_msg_t *last_gasp_msg, uint16_t gasped_short_addr, uint16_t hop_count, uint16_t* device_list)
+{
+	last_gasp_msg->id = LAST_GASP_MSG_ID;
+	last_gasp_msg->gasped_short_addr = gasped_short_addr;
+	last_gasp_msg->hop_count = hop_count;
+
+	if (device_list != NULL)
+	{
+		/* Forwarded message case, copies the given list */
+		memcpy(last_gasp_msg->visited_device, device_list, sizeof(last_gasp_msg->visited_device));
+	}
+	else
+	{
+		/* Starting message case */
+		last_gasp_msg->visited_device[0] = gasped_short_addr; /* The gasped short address is equal to the device short address, in this case */
+
+		for (uint32_t i = 1; i < LAST_GASP_MAXHOPS; i++)
+		{
+			last_gasp_msg->visited_device[i] = 0xFF; /* Empty */
+		}
+	}
+}
+
+/**
+  * @brief Gets a new handle for a G3UDP-DATA.Request.
+  * @param None
+  * @return The new handle (never 0 or LAST_GASP_UDP_HANDLE).
+  */
+static uint8_t g3_last_gasp_new_handle(void)
+{
+	uint8_t handle = 0;
+
+	if (osKernelLock() == osOK)
+	{
+		/* Same reserved handles of the UDP allocator of the user task */
+		do
+		{
+			udp_handle++;
+		} while ((udp_handle == 0) || (udp_handle == LAST_GASP_UDP_HANDLE));
+
+		handle = udp_handle;
+
+		osKernelUnlock();
+	}
+	else
+	{
+		Error_Handler();
+	}
+
+	return handle;
+}
+
+/**
+  * @brief Builds the G3LIB-SET.Request that activates the Last Gasp mode and the first Last Gasp message (broadcast),
+  *        as complete Host Interface frames, so that they can be sent from the power failure interrupt.
+  * @param None
+  * @return None
+  */
+static void g3_last_gasp_build_frames(void)
+{
+	uint16_t 				len;
+	uint16_t				set_frame_len;
+	uint16_t				data_frame_len = 0;
+	uint8_t					last_gasp_on = 1;
+	ip6_addr_t          	ip_dst_addr;
+	last_gasp_msg_t 		last_gasp_msg;
+	uint8_t 				broadcast_arr[IP_IPV6_ADDR128_UINT8_LEN] = IPV6_MULTICAST_ADDR;
+
+	G3_LIB_SetAttributeRequest_t *set_attr_req = MEMPOOL_MALLOC(sizeof(G3_LIB_SetAttributeRequest_t));
+	IP_G3UdpDataRequest_t		 *udpdata_req  = MEMPOOL_MALLOC(sizeof(IP_G3UdpDataRequest_t)); /* Uses memory pool due to big structure size */
+
+	last_gasp_fsm.frames_ready = false;
+
+	/* First frame: activation of the Last Gasp mode */
+	len = hi_g3lib_setreq_fill(set_attr_req, ADP_LASTGASP_ID, 0, &last_gasp_on, sizeof(last_gasp_on));
+	set_frame_len = host_if_build_frame(last_gasp_frames, sizeof(last_gasp_frames), HIF_G3LIB_SET_REQ, set_attr_req, len);
+
+	if (set_frame_len > 0)
+	{
+		/* Second frame: Last Gasp message, in broadcast */
+		memcpy(ip_dst_addr.u8, broadcast_arr, IP_IPV6_ADDR128_UINT8_LEN);
+		g3_last_gasp_fill_msg(&last_gasp_msg, last_gasp_fsm.short_address, 0, NULL);
+
+		/* Fixed handle, the frames can be sent long after being built, while other requests are in flight */
+		last_gasp_fsm.frames_handle = LAST_GASP_UDP_HANDLE;
+
+		len = hi_ipv6_udpdatareq_fill(udpdata_req, LAST_GASP_CONN_ID, ip_dst_addr, last_gasp_fsm.frames_handle, LAST_GASP_REMOTE_PORT, sizeof(last_gasp_msg), (uint8_t*) &last_gasp_msg);
+		data_frame_len = host_if_build_frame(&last_gasp_frames[set_frame_len], sizeof(last_gasp_frames) - set_frame_len, HIF_UDP_DATA_REQ, udpdata_req, len);
+	}
+
+	if (data_frame_len > 0)
+	{
+		last_gasp_fsm.frames_len    = set_frame_len + data_frame_len;
+		last_gasp_fsm.set_frame_len = set_frame_len;
+		last_gasp_fsm.frames_ready  = true;
+
+		PRINT_G3_LAST_GASP_INFO("Last Gasp frames ready (%u bytes)\n", last_gasp_fsm.frames_len);
+	}
+	else
+	{
+		PRINT_G3_LAST_GASP_WARNING("Last Gasp frames do not fit in %u bytes, the G3 task will send them\n", sizeof(last_gasp_frames));
+	}
+
+	MEMPOOL_FREE(set_attr_req);
+	MEMPOOL_FREE(udpdata_req);
+}
+
 /**
   * @brief Sends a G3UDP-DATA.Request in broadcast or to the LBA in unicast
   * @param dest_mode Determines the transmission mode (broadcast or unicast)
@@ -186,36 +363,9 @@ static void g3_last_gasp_send_data_req(last_gasp_dest_mode_t dest_mode, uint16_t
 		PRINT_G3_LAST_GASP_INFO("Sending Last Gasp to device %u in unicast\n", dest_short_addr);
 	}
 
-	last_gasp_msg.id = LAST_GASP_MSG_ID;
-	last_gasp_msg.gasped_short_addr = gasped_short_addr;
-	last_gasp_msg.hop_count = hop_count;
-
-	if (device_list != NULL)
-	{
-		/* Forwarded message case, copies the given list */
-		memcpy(last_gasp_msg.visited_device, device_list, sizeof(last_gasp_msg.visited_device));
-	}
-	else
-	{
-		/* Starting message case */
-		last_gasp_msg.visited_device[0] = gasped_short_addr; /* The gasped short address is equal to the device short address, in this case */
-
-		for (uint32_t i = 1; i < LAST_GASP_MAXHOPS; i++)
-		{
-			last_gasp_msg.visited_device[i] = 0xFF; /* Empty */
-		}
-	}
+	g3_last_gasp_fill_msg(&last_gasp_msg, gasped_short_addr, hop_count, device_list);
 
-	if (osKernelLock() == osOK)
-	{
-		last_gasp_fsm.handle = ++udp_handle;
-
-		osKernelUnlock();
-	}
-	else
-	{
-		Error_Handler();
-	}
+	last_gasp_fsm.handle = g3_last_gasp_new_handle();
 
 	/* Send the message to ST8500 */
 	len = hi_ipv6_udpdatareq_fill(udpdata_req, LAST_GASP_CONN_ID, ip_dst_addr, last_gasp_fsm.handle, LAST_GASP_REMOTE_PORT, sizeof(last_gasp_msg), (uint8_t*) &last_gasp_msg);
@@ -241,6 +391,9 @@ static last_gasp_state_t g3_last_gasp_fsm_default(void)
   */
 static last_gasp_state_t g3_last_gasp_fsm_connect(void)
 {
+	/* Prepares the frames to send in case of power failure */
+	g3_last_gasp_build_frames();
+
 	last_gasp_fsm.curr_event = LAST_GASP_EV_NONE;
 
 	return LAST_GASP_ST_NORMAL;
@@ -253,7 +406,11 @@ static last_gasp_state_t g3_last_gasp_fsm_connect(void)
   */
 static last_gasp_state_t g3_last_gasp_fsm_send_gasp(void)
 {
-	g3_last_gasp_send_data_req(last_gasp_broadcast, 0, last_gasp_fsm.short_address, 0, NULL);
+	/* The pre-built frames already contain the first Last Gasp message */
+	if (!last_gasp_fsm.frames_sent)
+	{
+		g3_last_gasp_send_data_req(last_gasp_broadcast, 0, last_gasp_fsm.short_address, 0, NULL);
+	}
 
 	last_gasp_fsm.curr_event = LAST_GASP_EV_NONE;
 
@@ -269,6 +426,14 @@ static last_gasp_state_t g3_last_gasp_fsm_depart(void)
 {
 	PRINT_G3_LAST_GASP_WARNING("Last Gasp activated\n");
 
+	if (last_gasp_fsm.frames_sent)
+	{
+		/* The first byte leaves the UART one character time (10 bits) after the start of the DMA transfer of the last urgent frame (G3UDP-DATA request) */
+		uint32_t first_byte_us = host_if_get_urgent_frame_start_time() - last_gasp_fsm.detection_ts + (10 * 1000000U) / huartHostIf.Init.BaudRate;
+
+		PRINT_G3_LAST_GASP_INFO("Power failure detection to first byte of the Last Gasp message on the wire: %u us\n", first_byte_us);
+	}
+
 	last_gasp_fsm.curr_event = LAST_GASP_EV_NONE;
 
 	return LAST_GASP_ST_DEAD;
@@ -281,6 +446,8 @@ static last_gasp_state_t g3_last_gasp_fsm_depart(void)
   */
 static last_gasp_state_t g3_last_gasp_fsm_disconnect(void)
 {
+	last_gasp_fsm.frames_ready = false;
+
 	last_gasp_fsm.curr_event = LAST_GASP_EV_NONE;
 
 	return LAST_GASP_ST_DISCONNECTED;
@@ -395,6 +562,56 @@ static void g3_last_gasp_handle_data_cnf(const void *payload)
 
 #endif /* !IS_COORD */
 
+/**
+  * @brief Adds a copy of the gasp of a device to a gasp set. The set is emptied first if its last new entry is older than LAST_GASP_WINDOW.
+  * @param set Pointer to the gasp set.
+  * @param short_addr Short address of the gasped device.
+  * @param expire Set to true to empty the set after LAST_GASP_WINDOW, false to keep the entries.
+  * @return Number of copies received for the device, including this one (0 if the set is full).
+  */
+static uint16_t g3_last_gasp_set_add(last_gasp_set_t *set, uint16_t short_addr, bool expire)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t pos = ((uint32_t) short_addr * 2654435761U) >> 16; /* Multiplicative hashing */
+	uint16_t copies = 0;
+
+	if (expire && (set->num > 0) && ((now - set->last_ts) >= LAST_GASP_WINDOW))
+	{
+		memset(set, 0, sizeof(*set));
+	}
+
+	/* Open addressing with linear probing */
+	for (uint32_t i = 0; i < LAST_GASP_SET_SIZE; i++)
+	{
+		last_gasp_entry_t *entry = &set->entry[(pos + i) & (LAST_GASP_SET_SIZE - 1)];
+
+		if (entry->copies == 0)
+		{
+			entry->short_addr = short_addr;
+			entry->copies     = 1;
+			entry->ts         = now;
+
+			set->num++;
+			set->last_ts = now;
+
+			copies = 1;
+			break;
+		}
+		else if (entry->short_addr == short_addr)
+		{
+			if (entry->copies < UINT16_MAX)
+			{
+				entry->copies++;
+			}
+
+			copies = entry->copies;
+			break;
+		}
+	}
+
+	return copies;
+}
+
 /**
   * @brief Function that handles the G3UDP-DATA.Indication. Handles Last Gasp forwarding.
   * @param payload Pointer to the payload of the received G3 message.
@@ -418,8 +635,40 @@ static void g3_last_gasp_handle_data_ind(const void *payload)
 
 			hi_ipv6_get_saddr_panid(udp_data_ind->source_address, &udp_src_pan_id, &udp_src_addr);
 
+#if IS_COORD
+			/* Aggregates the gasps of the same outage, the report is printed at the end of the outage */
+			uint16_t copies = g3_last_gasp_set_add(&last_gasp_outage.set, last_gasp_msg->gasped_short_addr, false);
+
+			if (copies == 1)
+			{
+#if (DEBUG_G3_LAST_GASP >= DEBUG_LEVEL_FULL)
+				PRINT_G3_LAST_GASP_INFO("Received Last Gasp of device %u from device %u, hop count: %u\n", last_gasp_msg->gasped_short_addr, udp_src_addr, last_gasp_msg->hop_count);
+#endif
+				osTimerStart(lastGaspTimerHandle, LAST_GASP_WINDOW);
+			}
+			else if (copies == 0)
+			{
+				/* The set is full: each device is counted once through its bit, devices sharing a bit are counted as one */
+				uint32_t bit  = (((uint32_t) last_gasp_msg->gasped_short_addr * 2654435761U) >> 16) & (LAST_GASP_OVERFLOW_BITS - 1); /* Multiplicative hashing */
+				uint32_t mask = 1UL << (bit & 31U);
+
+				if ((last_gasp_outage.overflow_map[bit >> 5] & mask) == 0)
+				{
+					last_gasp_outage.overflow_map[bit >> 5] |= mask;
+					last_gasp_outage.overflows++;
+					osTimerStart(lastGaspTimerHandle, LAST_GASP_WINDOW);
+				}
+				else
+				{
+					last_gasp_outage.duplicates++;
+				}
+			}
+			else
+			{
+				last_gasp_outage.duplicates++;
+			}
+#else
 			PRINT_G3_LAST_GASP_WARNING("Received Last Gasp of device %u from device %u, hop count: %u\n", last_gasp_msg->gasped_short_addr, udp_src_addr, last_gasp_msg->hop_count);
-#if !IS_COORD
 
 			/* In order to avoid bounces, each message carries the list of visited short addresses */
 			bool not_visited_yet = true;
@@ -434,7 +683,12 @@ static void g3_last_gasp_handle_data_ind(const void *payload)
 				}
 			}
 
-			if (not_visited_yet)
+			/* Copies of a gasp reach the device through several neighbours: only the first one is forwarded */
+			if (not_visited_yet && (g3_last_gasp_set_add(&last_gasp_relayed, last_gasp_msg->gasped_short_addr, true) > 1))
+			{
+				PRINT_G3_LAST_GASP_WARNING("Already forwarded for device %u\n", last_gasp_msg->gasped_short_addr);
+			}
+			else if (not_visited_yet)
 			{
 				for (uint32_t i = 0; i < LAST_GASP_MAXHOPS; i++)
 				{
@@ -542,7 +796,58 @@ void g3_app_last_gasp_msg_handler(const g3_msg_t *g3_msg)
 	}
 }
 
-#if !IS_COORD
+#if IS_COORD
+
+/**
+  * @brief Prints the report of the current outage (all the devices that gasped) and starts a new one.
+  * @param None
+  * @retval None
+  */
+void g3_app_last_gasp_report(void)
+{
+	last_gasp_set_t *set = &last_gasp_outage.set;
+
+	if ((set->num > 0) || (last_gasp_outage.overflows > 0))
+	{
+		uint32_t first_ts = set->last_ts;
+
+		for (uint32_t i = 0; i < LAST_GASP_SET_SIZE; i++)
+		{
+			if ((set->entry[i].copies > 0) && ((int32_t) (set->entry[i].ts - first_ts) < 0))
+			{
+				first_ts = set->entry[i].ts;
+			}
+		}
+
+		PRINT_G3_LAST_GASP_WARNING("Outage: %u devices lost power in %u ms (%u duplicate gasps, %u devices not listed)\n",
+				set->num + last_gasp_outage.overflows, set->last_ts - first_ts, last_gasp_outage.duplicates, last_gasp_outage.overflows);
+
+		for (uint32_t i = 0; i < LAST_GASP_SET_SIZE; i++)
+		{
+			if (set->entry[i].copies > 0)
+			{
+				PRINT_G3_LAST_GASP_WARNING("\tDevice %u (+%u ms, %u copies)\n", set->entry[i].short_addr, set->entry[i].ts - first_ts, set->entry[i].copies);
+			}
+		}
+	}
+
+	memset(&last_gasp_outage, 0, sizeof(last_gasp_outage));
+}
+
+/**
+  * @brief Callback function of the lastGaspTimer FreeRTOS timer. Ends the current outage.
+  * @param argument Unused argument.
+  * @retval None
+  */
+void g3_app_last_gasp_timer_callback(void *argument)
+{
+	UNUSED(argument);
+
+	/* The report is printed by the G3 task, that owns the outage data */
+	RTOS_PUT_MSG(g3_queueHandle, LAST_GASP_MSG, NULL);
+}
+
+#else
 
 /**
   * @brief Initializes the G3 Last Gasp application.
@@ -558,15 +863,46 @@ void g3_app_last_gasp_init(void)
 	last_gasp_fsm.pan_id 				= MAC_BROADCAST_PAN_ID;
 	last_gasp_fsm.short_address 		= MAC_BROADCAST_SHORT_ADDR;
 	last_gasp_fsm.handle				= 0;
+	last_gasp_fsm.frames_ready			= false;
+	last_gasp_fsm.frames_sent			= false;
+
+	memset(&last_gasp_relayed, 0, sizeof(last_gasp_relayed));
+
+#if ENABLE_LAST_GASP_PVD
+	/* The PVD interrupt signals the supply voltage drop (power failure) */
+	PWR_PVDTypeDef pvd_config = {.PVDLevel = LAST_GASP_PVD_LEVEL, .Mode = PWR_PVD_MODE_IT_RISING};
+
+	HAL_PWR_ConfigPVD(&pvd_config);
+	HAL_PWR_EnablePVD();
+
+	HAL_NVIC_SetPriority(PVD_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(PVD_IRQn);
+#endif
 }
 
 /**
   * @brief Starts the G3 Last Gasp sequence. Kept light since executed inside an ISR.
+  *        If the frames are ready, sends them directly on the Host Interface.
   * @param None
   * @retval None
   */
 void g3_app_last_gasp_start(void)
 {
+	last_gasp_fsm.detection_ts = LAST_GASP_TIMESTAMP_US();
+
+	if (last_gasp_fsm.frames_ready && !last_gasp_fsm.frames_sent && !last_gasp_fsm.last_gasp_activated)
+	{
+		/* Each request is sent as soon as it gets its place among the ones handled by the ST8500, released by its confirm.
+		 * If they cannot be queued, the G3 task sends the Last Gasp through the memory pool instead. */
+		if (	host_if_queue_urgent_frame(last_gasp_frames, last_gasp_fsm.set_frame_len) &&
+				host_if_queue_urgent_frame(&last_gasp_frames[last_gasp_fsm.set_frame_len], last_gasp_fsm.frames_len - last_gasp_fsm.set_frame_len) )
+		{
+			last_gasp_fsm.last_gasp_activated = 1;
+			last_gasp_fsm.frames_sent = true;
+			last_gasp_fsm.handle = last_gasp_fsm.frames_handle;
+		}
+	}
+
 	/* Unblocks the G3 task to execute Last Gasp Activation */
 	RTOS_PUT_MSG(g3_queueHandle, LAST_GASP_MSG, NULL);
 }
@@ -578,15 +914,21 @@ void g3_app_last_gasp_start(void)
   */
 void g3_app_last_gasp_activate(void)
 {
-	if (last_gasp_fsm.curr_state == LAST_GASP_ST_NORMAL)
+	if ((last_gasp_fsm.curr_state == LAST_GASP_ST_NORMAL) && last_gasp_fsm.frames_sent)
+	{
+		/* Both requests have already been sent from the interrupt, waits for the G3UDP-DATA.Confirm */
+		last_gasp_fsm.curr_state = LAST_GASP_ST_WAIT_DATA_CNF;
+	}
+	else if (last_gasp_fsm.curr_state == LAST_GASP_ST_NORMAL)
 	{
 		/* Activates Last Gasp mode */
 		last_gasp_fsm.last_gasp_activated = 1;
 
 		/* Sets the attribute to set the platform in Last Gasp mode */
 		G3_LIB_SetAttributeRequest_t *set_attr_req = MEMPOOL_MALLOC(sizeof(G3_LIB_SetAttributeRequest_t));
+		uint8_t last_gasp_on = last_gasp_fsm.last_gasp_activated;
 
-		uint16_t len = hi_g3lib_setreq_fill(set_attr_req, ADP_LASTGASP_ID, 0, &last_gasp_fsm.last_gasp_activated, sizeof(last_gasp_fsm.last_gasp_activated));
+		uint16_t len = hi_g3lib_setreq_fill(set_attr_req, ADP_LASTGASP_ID, 0, &last_gasp_on, sizeof(last_gasp_on));
 		g3_send_message(HIF_TX_MSG, HIF_G3LIB_SET_REQ, set_attr_req, len);
 
 #if (DEBUG_G3_LAST_GASP >= DEBUG_LEVEL_FULL)
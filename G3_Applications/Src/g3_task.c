@@ -24,6 +24,7 @@
 #include <hi_msgs_impl.h>
 #include <g3_comm.h>
 #include <sflash.h>
+#include <image_download.h>
 #include <g3_app_config.h>
 #include <g3_app_boot.h>
 #include <g3_app_keep_alive.h>
@@ -243,6 +244,67 @@ static void g3_change_hif_baudrate(const uint32_t baudrate)
 }
 #endif
 
+#if ENABLE_DOWNLOAD && ENABLE_DOWNLOAD_SKIP
+/**
+ * @brief This functions checks that the ST8500 still runs its images, when it was not reset at startup.
+ *        The HIF baudrate set before the reset of the host is restored and confirmed with a HI-BAUDRATE-SET request.
+ *        If the ST8500 does not answer, the record of the loaded images is invalidated and the host is reset,
+ *        to download the images again.
+ * @param None
+ * @return None.
+ */
+static void g3_check_running_st8500(void)
+{
+	task_msg_t	task_msg;
+	bool		st8500_answered = false;
+	uint32_t	start_tick = HAL_GetTick();
+
+	host_if_rx_stop();
+
+	USART_changeBaudrate(&huartHostIf, HIF_BAUDRATE);
+
+	host_if_rx_start();
+
+	/* Send HI-BAUDRATE-SET.request, with the current baudrate */
+	hif_baudrateset_req_t baudrateset_req;
+
+	baudrateset_req.baudrate = HIF_BAUDRATE;
+	host_if_send_message(HIF_HI_BAUDRATE_SET_REQ, &baudrateset_req, sizeof(baudrateset_req));
+
+	PRINT_G3_MSG_INFO("Waiting for %s...\n", translateG3cmd(HIF_HI_BAUDRATE_SET_CNF));
+
+	/* Indications of the running ST8500 may be received before the confirm, they are discarded */
+	while ((st8500_answered == false) && ((HAL_GetTick() - start_tick) < TIMEOUT_BAUDRATE_SET))
+	{
+		if (RTOS_GET_MSG_TIMEOUT(g3_queueHandle, &task_msg, TIMEOUT_BAUDRATE_SET))
+		{
+			g3_msg_t *g3_msg = task_msg.data;
+
+			st8500_answered = (g3_msg->command_id == HIF_HI_BAUDRATE_SET_CNF);
+
+			g3_discard_message(g3_msg); /* Message discarded (memory has to be freed) */
+		}
+	}
+
+	if (st8500_answered == true)
+	{
+		PRINT_G3_MSG_INFO("Received %s\n", translateG3cmd(HIF_HI_BAUDRATE_SET_CNF));
+	}
+	else
+	{
+		PRINT_G3_MSG_CRITICAL("No %s, the ST8500 does not run its images anymore, restarting...\n", translateG3cmd(HIF_HI_BAUDRATE_SET_CNF));
+
+		invalidateImageLoadRecord();
+
+		while (print_app_is_busy())
+		{
+			utils_delay_ms(1);
+		}
+		HAL_NVIC_SystemReset();
+	}
+}
+#endif /* ENABLE_DOWNLOAD && ENABLE_DOWNLOAD_SKIP */
+
 #if SET_TRACES_FILTER
 /**
  * @brief This functions sets the filter for debug traces
@@ -363,7 +425,7 @@ static bool g3_msg_forward(g3_msg_t *g3_msg)
 	/* Checks if the user task needs to process the message as well */
 	if ((working_plc_mode == PLC_MODE_IPV6_BOOT) || (working_plc_mode == PLC_MODE_IPV6_ADP))
 	{
-		if (UserG3_MsgNeeded(g3_msg) || UserImgTransfer_MsgNeeded(g3_msg))
+		if (UserG3_MsgNeeded(g3_msg) || UserImgTransfer_MsgNeeded(g3_msg) || UserG3_AppsMsgNeeded(g3_msg))
 		{
 			forward_needed = true;
 		}
@@ -482,8 +544,23 @@ void g3_task_exec(void)
 	task_msg_t task_msg;
 
 	osStatus_t	os_status;
+
+	bool st8500_running = false; /* The ST8500 was not reset at startup and still runs its images */
+
+#if ENABLE_DOWNLOAD && ENABLE_DOWNLOAD_SKIP
+	st8500_running = isImageDownloadSkipped();
+
+	if (st8500_running == true)
+	{
+		g3_check_running_st8500(); /* Restores the HIF baudrate, no HW reset confirm is received */
+	}
+#endif /* ENABLE_DOWNLOAD && ENABLE_DOWNLOAD_SKIP */
+
 #if RESET_AT_START
-	g3_wait_for_hw_reset_cnf(); /* HW reset confirm must always be received */
+	if (st8500_running == false)
+	{
+		g3_wait_for_hw_reset_cnf(); /* HW reset confirm must always be received */
+	}
 #endif /* RESET_AT_START */
 
 #if !IS_COORD && !ENABLE_BOOT_CLIENT_ON_HOST
@@ -492,7 +569,10 @@ void g3_task_exec(void)
 #endif
 
 #if CHANGE_BAUDRATE
-	g3_change_hif_baudrate(HIF_BAUDRATE);
+	if (st8500_running == false)
+	{
+		g3_change_hif_baudrate(HIF_BAUDRATE);
+	}
 #endif /* CHANGE_BAUDRATE */
 
 #if SET_TRACES_FILTER
@@ -588,15 +668,25 @@ void g3_task_exec(void)
 				g3_app_boot_srv_rekeying(g3_msg);		/* Triggers execution of the Re-keying procedure inside Boot Server module */
 				g3_discard_message(g3_msg); 			/* No forward */
 				break;
+#if ENABLE_DEVICE_TABLE_RESTORE
+			case BOOT_LOG_MSG:
+				g3_app_boot_check_frame_counters();		/* Reads the MAC frame counters, to renew their reservation in the log */
+				g3_discard_message(g3_msg); 			/* No forward */
+				break;
+#endif
 #elif !IS_COORD && ENABLE_BOOT_CLIENT_ON_HOST
 			case BOOT_CLT_MSG:	 						/* Internal messages for Boot Client module */
 				g3_app_boot_clt_req_handler(g3_msg);	/* Boot Client request handler (Boot Client module) */
 				g3_discard_message(g3_msg); 			/* No forward */
 				break;
 #endif
-#if !IS_COORD && ENABLE_LAST_GASP
+#if ENABLE_LAST_GASP
 			case LAST_GASP_MSG:
+#if IS_COORD
+				g3_app_last_gasp_report();				/* End of the outage aggregation window */
+#else
 				g3_app_last_gasp_activate();
+#endif
 				g3_discard_message(g3_msg); 			/* No forward */
 				break;
 #endif
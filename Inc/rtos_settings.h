@@ -26,6 +26,8 @@ extern "C" {
 #define PRINT_TASK_STACK_SIZE			80
 #define HOST_IF_TASK_STACK_SIZE			96
 #define SFLASH_TASK_STACK_SIZE			192
+#define HIF_CAPTURE_TASK_STACK_SIZE		256
+#define MODBUS_GW_TASK_STACK_SIZE		128
 
 /* Maximum number of elements in each queue */
 #define G3_QUEUE_LENGTH					8
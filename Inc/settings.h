@@ -76,6 +76,7 @@ extern "C" {
 #define USE_POOL_IN_USER_TERMINAL 	1	/*!< Define to 1 to use memory pools for the User Interface buffers (instead of the stack of the calling task) */
 #define USE_BIGGER_POOL_IF_NEEDED	1	/*!< Define to 1 to enable the use of a bigger pool if all pools of the best-fit type are occupied */
 #define ENABLE_REKEYING_DELAYS		1	/*!< Define to 1 to separate each re-keying phase with a delay > */
+#define ENABLE_REKEYING_RECORD		1	/*!< Define to 1 to record the re-keying progress in the SPI FLASH, to resume an interrupted re-keying with the same GMK */
 
 /* RF options */
 #define USE_STANDARD_ETSI_RF		1	/* Selects the frequency and power gain values to be compliant with ETSI standard */
@@ -88,21 +89,28 @@ extern "C" {
 /* Enable/disable features */
 #define ENABLE_ICMP_KEEP_ALIVE		1	/* Enable the keep alive feature */
 #define ENABLE_DOWNLOAD				1	/* Enable the image download feature */
+#define ENABLE_DOWNLOAD_SKIP		1	/* Skip the image download at startup if the ST8500 still runs the selected images (after a reset of the host only), requires ENABLE_DOWNLOAD */
 #define ENABLE_IMAGE_TRANSFER		1	/* Enable the image transfer feature */
 #define ENABLE_SFLASH_MANAGEMENT	1	/* Enable the SPI FLASH management feature */
 #define ENABLE_DEVICE_MANAGEMENT	1	/* Enable the device management feature */
 #define ENABLE_REKEYING				1	/* Enable the GMK Re-keying feature */
 #define ENABLE_LAST_GASP			1 	/* Enable the Last Gasp feature */
+#define ENABLE_LAST_GASP_PVD		0 	/* Start the Last Gasp from the PVD interrupt (supply voltage below LAST_GASP_PVD_LEVEL), requires ENABLE_LAST_GASP */
 #define ENABLE_FAST_RESTORE			1 	/* Enable the Fast Restore feature */
+#define ENABLE_METER_POLLING		0	/* Enable the polling of the connected devices by the coordinator (data concentrator), answered by the devices */
+#define ENABLE_BENCHMARK			0	/* Enable the scripted benchmark of the User Terminal (UDP loopback, ICMP echo, MAC), answered by all nodes */
+#define ENABLE_MODBUS_GATEWAY		0	/* Enable the gateway between the coordinator (UDP) and the Modbus slaves of the devices (RTU), requires ENABLE_MODBUS on the devices */
 
 #if IS_COORD
 #define ENABLE_BOOT_SERVER_ON_HOST	1	/* If set to 1, the Boot Server of the coordinator is embedded in the host application (this FW) */
+#define ENABLE_DEVICE_TABLE_RESTORE	1	/* If set to 1, the connected device table is logged in the SPI FLASH and restored at the start of the PAN with the reserved MAC frame counters, requires ENABLE_BOOT_SERVER_ON_HOST */
 #else
 #define ENABLE_BOOT_CLIENT_ON_HOST	1	/* If set to 1, the Boot Client of the device is embedded in the host application (this FW) */
 #endif
 
 /* Other settings */
 #define ENABLE_LPMODE				0	/* Set to 1 to set the LPMODE as external input, 0 to force its de-assertion (recommended at 0) */
+#define ENABLE_HIF_CAPTURE			0	/* Set to 1 to capture the Host Interface traffic to the uSD card (pcap file, decoded by Tools/hif_capture_tool) */
 
 /* Enable/disable tests */
 #define ENABLE_MODBUS				0 	/* Enable the Modbus feature */
@@ -122,6 +130,17 @@ extern "C" {
 #define ENABLE_SFLASH_TEST			0
 #endif
 
+/* The uSD card driver signals the end of its DMA transfers from the SPI callbacks, set for each of its users */
+#define USE_SD_SPI_DMA				(ENABLE_FATFS_TEST || ENABLE_HIF_CAPTURE)
+
+#if !IS_COORD && ENABLE_MODBUS_GATEWAY && !ENABLE_MODBUS
+#error "The Modbus gateway of the devices requires ENABLE_MODBUS"
+#endif
+
+#if ENABLE_HIF_CAPTURE && ENABLE_FATFS_TEST
+#error "The HIF capture keeps the uSD card mounted, it cannot be used with ENABLE_FATFS_TEST"
+#endif
+
 #if IS_COORD
 
 /* Access mode */
@@ -131,6 +150,8 @@ extern "C" {
 #error "Black list mode or White list mode must be selected"
 #endif
 
+#define ENABLE_ACCESS_LIST_STORAGE	1	/* If set to 1, the access list is also stored in the SPI FLASH and can be updated at runtime (in addition to the built-in table) */
+
 #else
 
 /* PAN sorting criteria */
@@ -18,6 +18,8 @@
 
 /* Inclusions */
 #include <stdint.h>
+#include <settings.h>
+#include <host_if_capture.h>
 
 /* Definitions */
 #define HIF_PREAMBLE_BYTE_VALUE			0x16U
@@ -56,6 +58,9 @@ typedef struct host_if_msg_rx_str
 	uint8_t 	preamble[HIF_PREAMBLE_AND_EC_LEN]; 	/* Used to store the preamble */
 	uint8_t 	*payload_crc;						/* Points to the memory pool where payload + CRC are allocated */
 	uint16_t 	payload_len;						/* Payload length, Error code (EC) is excluded */
+#if ENABLE_HIF_CAPTURE
+	hif_capture_time_t	rx_time;					/* Reception time of the first byte */
+#endif
 } host_if_msg_rx_t;
 
 /* Public Functions */
@@ -65,6 +70,11 @@ void	 host_if_rx_stop(void);
 void	 host_if_rx_handler(void);
 void	 host_if_tx_handler(void);
 uint32_t host_if_send_message(uint8_t cmd_id, void *payload, uint16_t payload_len);
+uint16_t host_if_build_frame(uint8_t *frame, uint16_t frame_size, uint8_t cmd_id, const void *payload, uint16_t payload_len);
+void	 host_if_send_urgent_frame(const uint8_t *frame, uint16_t frame_len);
+bool	 host_if_queue_urgent_frame(const uint8_t *frame, uint16_t frame_len);
+void	 host_if_send_queued_urgent_frame(void);
+uint32_t host_if_get_urgent_frame_start_time(void);
 
 #endif /* HOST_IF_H_ */
 
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    host_if_capture.h
+  * @author  AMG/IPC Application Team
+  * @brief   Header file for the capture of the Host Interface traffic to the
+  *          uSD card.
+  *
+  * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+  * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+  * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+  * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+  * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  *******************************************************************************/
+
+#ifndef HOST_IF_CAPTURE_H_
+#define HOST_IF_CAPTURE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Inclusions */
+#include <stdint.h>
+#include <stdbool.h>
+#include <settings.h>
+
+#if ENABLE_HIF_CAPTURE
+
+/*
+ * Format of the capture file (pcap, little-endian, microsecond timestamps, link type LINKTYPE_USER0):
+ *
+ * File header:		standard pcap global header (24 bytes)
+ * Record header:	TS_SEC (4 bytes) | TS_USEC (4 bytes) | INCL_LEN (4 bytes) | ORIG_LEN (4 bytes)
+ * Record data:		DIRECTION (1 byte, see hif_capture_dir_t) | HIF frame (preamble, payload and CRC16, as on the UART)
+ *
+ * Timestamps are relative to the start of the firmware. The file can be decoded with Tools/hif_capture_tool.
+ */
+
+/* Definitions */
+#define HIF_CAPTURE_BUFFER_SIZE			(4096)	/* Size of each of the two RAM buffers, in bytes (written to the uSD card at once) */
+#define HIF_CAPTURE_SNAP_LEN			(1600)	/* Maximum number of bytes of a frame stored in the capture, longer frames are truncated */
+#define HIF_CAPTURE_FLUSH_PERIOD		(1000)	/* In ms, maximum time a frame stays in RAM before being written to the uSD card */
+#define HIF_CAPTURE_FILE_MAX			(1000)	/* Maximum number of capture files on the uSD card (one for each start) */
+#define HIF_CAPTURE_LINKTYPE			(147)	/* pcap link type (LINKTYPE_USER0) */
+
+/* Custom types */
+
+/* Direction of a captured frame */
+typedef enum hif_capture_dir_enum
+{
+	hif_capture_dir_tx = 0,	/* From the host (this FW) to the ST8500 modem */
+	hif_capture_dir_rx = 1,	/* From the ST8500 modem to the host */
+} hif_capture_dir_t;
+
+/* Timestamp of a captured frame */
+typedef struct hif_capture_time_str
+{
+	uint32_t	sec;	/* Seconds since the start */
+	uint32_t	usec;	/* Microseconds within the second */
+} hif_capture_time_t;
+
+/* Public Functions */
+void	hif_capture_init(void);
+void	hif_capture_exec(void);
+void	hif_capture_get_time(hif_capture_time_t *time);
+void	hif_capture_frame(hif_capture_dir_t dir, const hif_capture_time_t *time, const uint8_t *head, uint16_t head_len, const uint8_t *tail, uint16_t tail_len);
+
+#endif /* ENABLE_HIF_CAPTURE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_IF_CAPTURE_H_ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
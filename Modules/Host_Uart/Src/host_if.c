@@ -20,6 +20,7 @@
 #include <utils.h>
 #include <debug_print.h>
 #include <mem_pool.h>
+#include <rtos_settings.h>
 #include <task_comm.h>
 #include <main.h>
 #include <host_if.h>
@@ -28,6 +29,11 @@
   * @{
   */
 
+/* Definitions */
+#define HOST_IF_TIMESTAMP_US()		((HAL_GetTick() * 1000) + htimSys.Instance->CNT)	/* Time base counts microseconds within each tick */
+
+#define HOST_IF_URGENT_QUEUE_SIZE	2	/* Maximum number of urgent frames waiting for a free place among the requests handled by the ST8500 */
+
 /* Custom types */
 typedef enum host_if_rx_state_enum
 {
@@ -70,15 +76,42 @@ typedef struct host_if_rx_handler_str
     host_if_msg_rx_t 	*hif_msg_rx;	/* Contains the three parts of a G3 message (preamble, payload, crc16) */
 } host_if_rx_handler_t;
 
+typedef enum host_if_urgent_state_enum
+{
+	host_if_urgent_st_none = 0,
+	host_if_urgent_st_pending,		/* Waits for the end of the current transmission */
+	host_if_urgent_st_sending,
+} host_if_urgent_state_t;
+
+typedef struct host_if_urgent_frame_str
+{
+	const uint8_t			*frame;
+	uint16_t				len;
+} host_if_urgent_frame_t;
+
 typedef struct host_if_tx_handler_str
 {
 	host_if_g3_tx_msg_t		*hif_msg_tx;
+
+	/* Urgent frame, sent from an ISR bypassing the G3 task */
+	volatile host_if_urgent_state_t	urgent_state;
+	const uint8_t			*urgent_frame;
+	uint16_t				urgent_len;
+	uint32_t				urgent_start_ts;
+
+	/* Urgent request frames waiting for a free place among the requests handled by the ST8500 */
+	host_if_urgent_frame_t	urgent_queue[HOST_IF_URGENT_QUEUE_SIZE];
+	uint8_t					urgent_queue_head;
+	volatile uint8_t		urgent_queue_count;
 } host_if_tx_handler_t;
 
 /* External Variables */
 extern osMessageQueueId_t	host_if_queueHandle;
 
+extern TIM_HandleTypeDef	htimSys; /* Systick Timer */
+
 extern osSemaphoreId_t 		semHostIfTxCompleteHandle;
+extern osSemaphoreId_t 		semConfirmationHandle;
 
 /* Private variables */
 static host_if_rx_handler_t rx_handler;
@@ -101,6 +134,64 @@ static inline void host_if_init_rx_buffer(void)
 	rx_handler.hif_msg_rx = MEMPOOL_MALLOC(sizeof(host_if_msg_rx_t));
 }
 
+/**
+  * @brief This functions starts the DMA transmission of the urgent frame.
+  * @param None
+  * @retval None
+  */
+static void host_if_start_urgent_frame(void)
+{
+	tx_handler.urgent_state    = host_if_urgent_st_sending;
+	tx_handler.urgent_start_ts = HOST_IF_TIMESTAMP_US();
+
+#if ENABLE_HIF_CAPTURE
+	hif_capture_time_t tx_time;
+
+	hif_capture_get_time(&tx_time);
+	hif_capture_frame(hif_capture_dir_tx, &tx_time, tx_handler.urgent_frame, tx_handler.urgent_len, NULL, 0);
+#endif
+
+	if (HAL_UART_Transmit_DMA(&huartHostIf, (uint8_t*) tx_handler.urgent_frame, tx_handler.urgent_len) != HAL_OK)
+	{
+		Error_Handler();
+	}
+}
+
+/**
+  * @brief This functions takes the first queued urgent frame, if a place among the requests handled by the ST8500 is free.
+  *        As in the G3 task, a G3UDP-DATA or G3ICMP-ECHO request needs the ST8500 to have no other request pending.
+  * @param None
+  * @retval 'true' if the frame was taken (as the current urgent frame), 'false' otherwise.
+  * @note The place taken is released by the HIF task at the reception of the confirm, as for the requests sent by the G3 task.
+  */
+static bool host_if_take_queued_urgent_frame(void)
+{
+	bool taken = false;
+
+	if (tx_handler.urgent_queue_count > 0)
+	{
+		host_if_urgent_frame_t *entry = &tx_handler.urgent_queue[tx_handler.urgent_queue_head];
+		uint8_t cmd_id = ((const host_if_g3_tx_msg_t*) entry->frame)->cmd_id;
+		uint32_t free_places = ((cmd_id == HIF_UDP_DATA_REQ) || (cmd_id == HIF_ICMP_ECHO_REQ)) ? CONFIRMATION_SEMAPHORE_COUNT : 1;
+
+		/* Called from an ISR or inside a critical section, the count cannot change before the acquisition */
+		taken = (osSemaphoreGetCount(semConfirmationHandle) >= free_places) && (osSemaphoreAcquire(semConfirmationHandle, 0) == osOK);
+	}
+
+	if (taken)
+	{
+		host_if_urgent_frame_t *entry = &tx_handler.urgent_queue[tx_handler.urgent_queue_head];
+
+		tx_handler.urgent_frame = entry->frame;
+		tx_handler.urgent_len   = entry->len;
+
+		tx_handler.urgent_queue_head = (tx_handler.urgent_queue_head + 1) % HOST_IF_URGENT_QUEUE_SIZE;
+		tx_handler.urgent_queue_count--;
+	}
+
+	return taken;
+}
+
 /* Public functions */
 
 /**
@@ -112,6 +203,9 @@ void host_if_init(void)
 {
 	/* Initialize TX buffer */
 	tx_handler.hif_msg_tx = NULL;
+	tx_handler.urgent_state = host_if_urgent_st_none;
+	tx_handler.urgent_queue_head  = 0;
+	tx_handler.urgent_queue_count = 0;
 
 	/* Initialize RX buffer */
 	host_if_init_rx_buffer();
@@ -156,6 +250,10 @@ void host_if_rx_handler(void)
 			/* Sets the first receive byte */
 			rx_handler.hif_msg_rx->preamble[0] = huartHostIf_data;
 
+#if ENABLE_HIF_CAPTURE
+			hif_capture_get_time(&rx_handler.hif_msg_rx->rx_time);
+#endif
+
 			/* Starts the reception of the rest of the preamble + the EC */
 			HAL_UART_Receive_DMA(&huartHostIf, &rx_handler.hif_msg_rx->preamble[1], HIF_REM_PREAMBLE_AND_EC_LEN);
 
@@ -206,12 +304,153 @@ void host_if_rx_handler(void)
   */
 void host_if_tx_handler(void)
 {
-	MEMPOOL_FREE(tx_handler.hif_msg_tx);
+	if (tx_handler.urgent_state == host_if_urgent_st_sending)
+	{
+		/* The urgent frame is static, nothing to free */
+		tx_handler.urgent_state = host_if_urgent_st_none;
+
+		if (host_if_take_queued_urgent_frame())
+		{
+			/* Sends the next queued urgent frame, keeping the Host Interface */
+			host_if_start_urgent_frame();
+			return;
+		}
+	}
+	else
+	{
+		MEMPOOL_FREE(tx_handler.hif_msg_tx);
+
+		if (tx_handler.urgent_state == host_if_urgent_st_pending)
+		{
+			/* Sends the urgent frame before any other queued message */
+			host_if_start_urgent_frame();
+			return;
+		}
+	}
 
 	/* Unblocks the Print task after the data has been sent on User Interface UART */
 	osSemaphoreRelease(semHostIfTxCompleteHandle);
 }
 
+/**
+  * @brief This functions builds a complete G3 request frame (preamble, payload and CRC16) in the given buffer.
+  * @param frame Pointer to the buffer where the frame is built.
+  * @param frame_size Size of the buffer.
+  * @param cmd_id Command ID of the message.
+  * @param payload Pointer to the payload of the message.
+  * @param payload_len Length of the payload.
+  * @return Length of the frame (0 if the buffer is too small).
+  */
+uint16_t host_if_build_frame(uint8_t *frame, uint16_t frame_size, uint8_t cmd_id, const void *payload, uint16_t payload_len)
+{
+	host_if_g3_tx_msg_t *hif_msg = (host_if_g3_tx_msg_t*) frame;
+	uint16_t msg_len = sizeof(host_if_g3_tx_msg_t) + payload_len + sizeof(crc16_t);
+	crc16_t crc;
+
+	if (msg_len > frame_size)
+	{
+		return 0;
+	}
+
+	hif_msg->sync   = HIF_PREAMBLE_FIELD_VALUE;
+	hif_msg->cmd_id = cmd_id;
+	hif_msg->len    = payload_len;
+	hif_msg->mode   = 0U;
+	hif_msg->cnt    = 0U;
+
+	if ((payload != NULL) && (payload_len > 0))
+	{
+		memcpy(hif_msg->data, payload, payload_len);
+	}
+
+	/* Calculates CRC16 on preamble+payload, inserted in little endian after the payload */
+	crc = CRC16_XMODEM(hif_msg, sizeof(*hif_msg) + payload_len);
+
+	hif_msg->data[payload_len]     = LOW_BYTE(crc);
+	hif_msg->data[payload_len + 1] = HIGH_BYTE(crc);
+
+	return msg_len;
+}
+
+/**
+  * @brief This functions sends pre-built frames through the Host Interface, bypassing the G3 task and the memory pool.
+  *        Can be called from an ISR. If a message is being transmitted, the frames are sent right after it.
+  * @param frame Pointer to the frames to send (must remain valid until the end of the transmission).
+  * @param frame_len Total length of the frames.
+  * @retval None
+  */
+void host_if_send_urgent_frame(const uint8_t *frame, uint16_t frame_len)
+{
+	if (tx_handler.urgent_state == host_if_urgent_st_none)
+	{
+		tx_handler.urgent_frame = frame;
+		tx_handler.urgent_len   = frame_len;
+
+		if (osSemaphoreAcquire(semHostIfTxCompleteHandle, 0) == osOK)
+		{
+			/* No transmission in progress, takes the Host Interface for good */
+			host_if_start_urgent_frame();
+		}
+		else
+		{
+			tx_handler.urgent_state = host_if_urgent_st_pending;
+		}
+	}
+}
+
+/**
+  * @brief This functions queues a pre-built request frame, sent bypassing the G3 task as soon as the ST8500 can handle one more request.
+  *        Can be called from an ISR. The frames are sent in the order they were queued.
+  * @param frame Pointer to the request frame to send (must remain valid until the end of the transmission).
+  * @param frame_len Length of the request frame.
+  * @retval 'true' if the frame was queued, 'false' if the queue is full.
+  */
+bool host_if_queue_urgent_frame(const uint8_t *frame, uint16_t frame_len)
+{
+	bool queued = false;
+
+	if (tx_handler.urgent_queue_count < HOST_IF_URGENT_QUEUE_SIZE)
+	{
+		host_if_urgent_frame_t *entry = &tx_handler.urgent_queue[(tx_handler.urgent_queue_head + tx_handler.urgent_queue_count) % HOST_IF_URGENT_QUEUE_SIZE];
+
+		entry->frame = frame;
+		entry->len   = frame_len;
+
+		tx_handler.urgent_queue_count++;
+
+		host_if_send_queued_urgent_frame();
+
+		queued = true;
+	}
+
+	return queued;
+}
+
+/**
+  * @brief This functions sends the first queued urgent frame, if no urgent frame is in progress and the ST8500 can handle one more request.
+  *        Called when a place is released (reception of a confirm), the next queued frames are sent at the end of each transmission.
+  * @param None
+  * @retval None
+  * @note Must be called from an ISR, or inside a critical section.
+  */
+void host_if_send_queued_urgent_frame(void)
+{
+	if ((tx_handler.urgent_state == host_if_urgent_st_none) && host_if_take_queued_urgent_frame())
+	{
+		host_if_send_urgent_frame(tx_handler.urgent_frame, tx_handler.urgent_len);
+	}
+}
+
+/**
+  * @brief This functions returns the time the last urgent frame transmission started at.
+  * @param None
+  * @return Start time of the urgent frame transmission, in microseconds.
+  */
+uint32_t host_if_get_urgent_frame_start_time(void)
+{
+	return tx_handler.urgent_start_ts;
+}
+
 /**
   * @brief This functions handles the transmission of a G3 message through the Host Interface.
   * @param cmd_id Command ID of the message to send.
@@ -221,7 +460,6 @@ void host_if_tx_handler(void)
   */
 uint32_t host_if_send_message(uint8_t cmd_id, void *payload, uint16_t payload_len)
 {
-    crc16_t crc;
     uint16_t msg_len = 0;
     
     /* Waits for the previous message to be sent */
@@ -230,29 +468,14 @@ uint32_t host_if_send_message(uint8_t cmd_id, void *payload, uint16_t payload_le
     assert(tx_handler.hif_msg_tx == NULL);
 
 	/* Total message length */
-	msg_len = sizeof(host_if_g3_tx_msg_t) + payload_len + sizeof(crc);
+	msg_len = sizeof(host_if_g3_tx_msg_t) + payload_len + sizeof(crc16_t);
 
 	tx_handler.hif_msg_tx = MEMPOOL_MALLOC(msg_len);
 
 	assert(tx_handler.hif_msg_tx != NULL);
 
-	tx_handler.hif_msg_tx->sync   = HIF_PREAMBLE_FIELD_VALUE;
-	tx_handler.hif_msg_tx->cmd_id = cmd_id;
-	tx_handler.hif_msg_tx->len    = payload_len;
-	tx_handler.hif_msg_tx->mode   = 0U;
-	tx_handler.hif_msg_tx->cnt    = 0U;
-
-	if ((payload != NULL) && (payload_len > 0))
-	{
-		memcpy(tx_handler.hif_msg_tx->data, payload, payload_len);
-	}
-
-	/* Calculates CRC16 on preamble+payload */
-	crc = CRC16_XMODEM(tx_handler.hif_msg_tx, sizeof(*tx_handler.hif_msg_tx) + payload_len);
-
-	/* Inserts the CRC16 in little endian after the payload */
-	tx_handler.hif_msg_tx->data[payload_len]     = LOW_BYTE(crc);
-	tx_handler.hif_msg_tx->data[payload_len + 1] = HIGH_BYTE(crc);
+	/* Fills preamble, payload and CRC16 */
+	host_if_build_frame((uint8_t*) tx_handler.hif_msg_tx, msg_len, cmd_id, payload, payload_len);
 
 #if (DEBUG_G3_MSG >= DEBUG_LEVEL_FULL)
 
@@ -291,6 +514,13 @@ uint32_t host_if_send_message(uint8_t cmd_id, void *payload, uint16_t payload_le
 	}
 #endif
 
+#if ENABLE_HIF_CAPTURE
+	hif_capture_time_t tx_time;
+
+	hif_capture_get_time(&tx_time);
+	hif_capture_frame(hif_capture_dir_tx, &tx_time, (uint8_t*) tx_handler.hif_msg_tx, msg_len, NULL, 0);
+#endif
+
 	if (HAL_UART_Transmit_DMA(&huartHostIf, (uint8_t*) tx_handler.hif_msg_tx, msg_len) != HAL_OK)
 	{
 		Error_Handler();
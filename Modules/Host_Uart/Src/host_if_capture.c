@@ -0,0 +1,401 @@
+/**
+  ******************************************************************************
+  * @file    host_if_capture.c
+  * @author  AMG/IPC Application Team
+  * @brief   This file contains code that captures the Host Interface traffic
+  *          to the uSD card.
+  *
+  *          Frames are copied with their timestamp in one of two RAM buffers.
+  *          When a buffer is full (or after HIF_CAPTURE_FLUSH_PERIOD), the
+  *          buffers are swapped and the full one is written to the uSD card
+  *          by the capture task, at low priority. The Host Interface never
+  *          waits for the uSD card: if both buffers are in use, the frame is
+  *          dropped and counted.
+  *
+  * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+  * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+  * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+  * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+  * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  *******************************************************************************/
+
+/* Inclusions */
+#include <stdio.h>
+#include <string.h>
+#include <cmsis_os.h>
+#include <debug_print.h>
+#include <main.h>
+#include <host_if_capture.h>
+
+#if ENABLE_HIF_CAPTURE
+
+#include <ff.h>
+
+/** @defgroup g3_hif_capture G3 Host Interface capture
+  * @{
+  */
+
+/* Definitions */
+#define HIF_CAPTURE_MAGIC				(0xA1B2C3D4)	/* pcap magic number, microsecond timestamps */
+#define HIF_CAPTURE_VERSION_MAJOR		(2)
+#define HIF_CAPTURE_VERSION_MINOR		(4)
+#define HIF_CAPTURE_BUFFER_NUM			(2)
+
+/* Custom types */
+#pragma pack(push, 1)
+
+/* pcap global header */
+typedef struct hif_capture_file_header_str
+{
+	uint32_t	magic;
+	uint16_t	version_major;
+	uint16_t	version_minor;
+	int32_t		thiszone;
+	uint32_t	sigfigs;
+	uint32_t	snaplen;
+	uint32_t	network;
+} hif_capture_file_header_t;
+
+/* pcap record header, followed by the direction */
+typedef struct hif_capture_record_header_str
+{
+	hif_capture_time_t	time;
+	uint32_t			incl_len;
+	uint32_t			orig_len;
+	uint8_t				dir;
+} hif_capture_record_header_t;
+
+#pragma pack(pop)
+
+typedef struct hif_capture_buffer_str
+{
+	uint8_t		data[HIF_CAPTURE_BUFFER_SIZE];
+	uint32_t	len;
+} hif_capture_buffer_t;
+
+typedef struct hif_capture_handler_str
+{
+	hif_capture_buffer_t	buffer[HIF_CAPTURE_BUFFER_NUM];
+	uint8_t					fill_index;		/* Buffer receiving the frames */
+	volatile bool			write_pending;	/* The other buffer is waiting to be written to the uSD card */
+	volatile bool			enabled;		/* The capture file is open */
+	uint32_t				dropped;		/* Frames dropped because both buffers were in use */
+	uint32_t				dropped_reported;
+	uint32_t				written;		/* Bytes written to the capture file */
+} hif_capture_handler_t;
+
+/* External Variables */
+extern TIM_HandleTypeDef	htimSys; /* Systick Timer */
+
+extern osSemaphoreId_t		semHifCaptureHandle;
+
+/* Private variables */
+static hif_capture_handler_t	capture_handler;
+
+static FATFS	capture_fs;
+static FIL		capture_file;
+
+/* Private functions */
+
+/**
+  * @brief This functions swaps the buffers, handing the one being filled to the capture task.
+  * @param None
+  * @retval 'true' if the buffers were swapped, 'false' if the other buffer is still in use
+  * @note Must be called with interrupts masked.
+  */
+static bool hif_capture_swap_buffers(void)
+{
+	bool swapped = false;
+
+	if (!capture_handler.write_pending)
+	{
+		capture_handler.write_pending = true;
+		capture_handler.fill_index ^= 1U;
+		swapped = true;
+	}
+
+	return swapped;
+}
+
+/**
+  * @brief This functions opens a new capture file, with the first free name, and writes the pcap header.
+  * @param None
+  * @retval FatFS result
+  */
+static FRESULT hif_capture_open_file(void)
+{
+	FRESULT 	fres;
+	FILINFO		file_info;
+	UINT		bytes_written;
+	uint32_t	file_n = 0;
+	char		file_name[13];
+
+	const hif_capture_file_header_t header = {
+		.magic         = HIF_CAPTURE_MAGIC,
+		.version_major = HIF_CAPTURE_VERSION_MAJOR,
+		.version_minor = HIF_CAPTURE_VERSION_MINOR,
+		.thiszone      = 0,
+		.sigfigs       = 0,
+		.snaplen       = HIF_CAPTURE_SNAP_LEN + sizeof(uint8_t),
+		.network       = HIF_CAPTURE_LINKTYPE,
+	};
+
+	/* Previous captures are kept, they might hold the history of a reset */
+	do
+	{
+		snprintf(file_name, sizeof(file_name), "HIF%03u.CAP", (unsigned) file_n);
+		fres = f_stat(file_name, &file_info);
+		file_n++;
+	} while ((fres == FR_OK) && (file_n < HIF_CAPTURE_FILE_MAX));
+
+	if (fres == FR_NO_FILE)
+	{
+		fres = f_open(&capture_file, file_name, FA_WRITE | FA_CREATE_ALWAYS);
+	}
+	else if (fres == FR_OK)
+	{
+		fres = FR_DENIED; /* All the file names are taken */
+	}
+
+	if (fres == FR_OK)
+	{
+		fres = f_write(&capture_file, &header, sizeof(header), &bytes_written);
+
+		if ((fres == FR_OK) && (bytes_written != sizeof(header)))
+		{
+			fres = FR_DENIED; /* Disk full */
+		}
+
+		if (fres == FR_OK)
+		{
+			fres = f_sync(&capture_file);
+		}
+
+		if (fres == FR_OK)
+		{
+			PRINT("HIF capture started on %s\n", file_name);
+		}
+		else
+		{
+			f_close(&capture_file);
+		}
+	}
+
+	return fres;
+}
+
+/**
+  * @brief This functions writes the buffer handed by hif_capture_swap_buffers() to the capture file.
+  * @param None
+  * @retval None
+  */
+static void hif_capture_write_buffer(void)
+{
+	hif_capture_buffer_t *buffer = &capture_handler.buffer[capture_handler.fill_index ^ 1U];
+	FRESULT fres;
+	UINT    bytes_written;
+
+	fres = f_write(&capture_file, buffer->data, buffer->len, &bytes_written);
+
+	if ((fres == FR_OK) && (bytes_written != buffer->len))
+	{
+		fres = FR_DENIED; /* Disk full */
+	}
+
+	/* Updates the directory entry, the capture survives a reset or a power loss */
+	if (fres == FR_OK)
+	{
+		fres = f_sync(&capture_file);
+	}
+
+	if (fres == FR_OK)
+	{
+		capture_handler.written += bytes_written;
+	}
+	else
+	{
+		capture_handler.enabled = false;
+		f_close(&capture_file);
+
+		PRINT_G3_MSG_CRITICAL("HIF capture stopped, write error (%u) after %u bytes\n", fres, capture_handler.written);
+	}
+
+	/* The buffer is available again */
+	buffer->len = 0;
+	capture_handler.write_pending = false;
+
+	if (capture_handler.dropped != capture_handler.dropped_reported)
+	{
+		capture_handler.dropped_reported = capture_handler.dropped;
+
+		PRINT_G3_MSG_WARNING("HIF capture: %u frames dropped\n", capture_handler.dropped_reported);
+	}
+}
+
+/* Public functions */
+
+/**
+  * @brief This functions initializes the capture of the Host Interface.
+  * @param None
+  * @retval None
+  */
+void hif_capture_init(void)
+{
+	memset(&capture_handler, 0, sizeof(capture_handler));
+}
+
+/**
+  * @brief This functions executes the capture task routine.
+  * @param None
+  * @retval None
+  */
+void hif_capture_exec(void)
+{
+	FRESULT fres;
+
+	fres = f_mount(&capture_fs, "", 1);
+
+	if (fres == FR_OK)
+	{
+		fres = hif_capture_open_file();
+	}
+
+	if (fres == FR_OK)
+	{
+		capture_handler.enabled = true;
+	}
+	else
+	{
+		PRINT_G3_MSG_CRITICAL("HIF capture not started, uSD card error (%u)\n", fres);
+	}
+
+	for(;;)
+	{
+		/* Waits for a full buffer, or for the flush period */
+		if (osSemaphoreAcquire(semHifCaptureHandle, HIF_CAPTURE_FLUSH_PERIOD) != osOK)
+		{
+			UBaseType_t int_status = taskENTER_CRITICAL_FROM_ISR();
+
+			if (capture_handler.buffer[capture_handler.fill_index].len > 0)
+			{
+				hif_capture_swap_buffers();
+			}
+
+			taskEXIT_CRITICAL_FROM_ISR(int_status);
+		}
+
+		if (capture_handler.write_pending)
+		{
+			if (capture_handler.enabled)
+			{
+				hif_capture_write_buffer();
+			}
+			else
+			{
+				/* Capture stopped, releases the buffer to avoid signaling it again */
+				capture_handler.buffer[capture_handler.fill_index ^ 1U].len = 0;
+				capture_handler.write_pending = false;
+			}
+		}
+	}
+}
+
+/**
+  * @brief This functions gets the current time, for the timestamp of a frame.
+  * @param time Pointer to the timestamp to fill.
+  * @retval None
+  * @note Can be called from an ISR.
+  */
+void hif_capture_get_time(hif_capture_time_t *time)
+{
+	uint32_t tick = HAL_GetTick();
+
+	/* Time base counts microseconds within each tick */
+	time->sec  = tick / 1000U;
+	time->usec = ((tick % 1000U) * 1000U) + htimSys.Instance->CNT;
+}
+
+/**
+  * @brief This functions adds a frame of the Host Interface to the capture, never waiting.
+  * @param dir Direction of the frame.
+  * @param time Timestamp of the frame.
+  * @param head Pointer to the first part of the frame.
+  * @param head_len Length of the first part of the frame.
+  * @param tail Pointer to the second part of the frame (NULL if the frame is contiguous).
+  * @param tail_len Length of the second part of the frame.
+  * @retval None
+  * @note Can be called from an ISR. Frames longer than HIF_CAPTURE_SNAP_LEN are truncated.
+  */
+void hif_capture_frame(hif_capture_dir_t dir, const hif_capture_time_t *time, const uint8_t *head, uint16_t head_len, const uint8_t *tail, uint16_t tail_len)
+{
+	hif_capture_record_header_t record;
+	hif_capture_buffer_t *buffer;
+	bool notify = false;
+
+	if (capture_handler.enabled)
+	{
+		record.time     = *time;
+		record.orig_len = sizeof(record.dir) + head_len + tail_len;
+		record.dir      = (uint8_t) dir;
+
+		/* Truncation to the snap length */
+		if (head_len > HIF_CAPTURE_SNAP_LEN)
+		{
+			head_len = HIF_CAPTURE_SNAP_LEN;
+		}
+
+		if (tail_len > (HIF_CAPTURE_SNAP_LEN - head_len))
+		{
+			tail_len = HIF_CAPTURE_SNAP_LEN - head_len;
+		}
+
+		record.incl_len = sizeof(record.dir) + head_len + tail_len;
+
+		/* Masks the interrupts (except the ones above the FreeRTOS priority) to be usable from any context */
+		UBaseType_t int_status = taskENTER_CRITICAL_FROM_ISR();
+
+		buffer = &capture_handler.buffer[capture_handler.fill_index];
+
+		if ((buffer->len + sizeof(record) + head_len + tail_len) > HIF_CAPTURE_BUFFER_SIZE)
+		{
+			notify = hif_capture_swap_buffers();
+			buffer = &capture_handler.buffer[capture_handler.fill_index];
+		}
+
+		if ((buffer->len + sizeof(record) + head_len + tail_len) <= HIF_CAPTURE_BUFFER_SIZE)
+		{
+			memcpy(&buffer->data[buffer->len], &record, sizeof(record));
+			buffer->len += sizeof(record);
+
+			memcpy(&buffer->data[buffer->len], head, head_len);
+			buffer->len += head_len;
+
+			if (tail_len > 0)
+			{
+				memcpy(&buffer->data[buffer->len], tail, tail_len);
+				buffer->len += tail_len;
+			}
+		}
+		else
+		{
+			capture_handler.dropped++;
+		}
+
+		taskEXIT_CRITICAL_FROM_ISR(int_status);
+
+		if (notify)
+		{
+			osSemaphoreRelease(semHifCaptureHandle);
+		}
+	}
+}
+
+/**
+  * @}
+  */
+
+#endif /* ENABLE_HIF_CAPTURE */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -123,6 +123,11 @@ void host_if_task_exec()
 			/* Parses only HIF message received from the Host UART */
 			if (task_msg.message_type == HIF_RX_MSG)
 			{
+#if ENABLE_HIF_CAPTURE
+				/* Captures the frame as received, before the integrity check */
+				hif_capture_frame(hif_capture_dir_rx, &hif_msg->rx_time, hif_msg->preamble, sizeof(hif_msg->preamble), hif_msg->payload_crc, hif_msg->payload_len + HIF_CRC_LEN);
+#endif
+
 				/* Verifies and parses a message from the Host Interface */
 				if (host_if_parse_message(hif_msg))
 				{
@@ -161,6 +166,11 @@ void host_if_task_exec()
 					case HIF_ICMP_ECHO_CNF:
 					/* In case more CNF message handlers are added, add the CNF ID here */
 						osSemaphoreRelease(semConfirmationHandle);
+
+						/* The place released can be taken by an urgent frame waiting for it */
+						taskENTER_CRITICAL();
+						host_if_send_queued_urgent_frame();
+						taskEXIT_CRITICAL();
 						break;
 					default:
 						break;
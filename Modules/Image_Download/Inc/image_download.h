@@ -74,6 +74,7 @@ extern "C" {
 /* Timing */
 #define REQUEST_TIMEOUT         1000	/* In ms */
 #define RESPONSE_TIMEOUT        1000	/* In ms */
+#define PROBE_TIMEOUT           100		/* In ms, for the probe of the ST8500 bootloader */
 
 /* Custom types */
 
@@ -146,11 +147,28 @@ typedef struct ud_res_struc {
 
 #pragma pack(pop)
 
+/* Boot phases, for the boot-time report */
+typedef enum boot_phase_enum
+{
+	BOOT_PHASE_RESET = 0,	/* ST8500 reset */
+	BOOT_PHASE_DOWNLOAD,	/* ST8500 image download (or check of the running images) */
+	BOOT_PHASE_CONFIG,		/* G3 configuration */
+	BOOT_PHASE_NETWORK,		/* Network start (PAN start or join) */
+	BOOT_PHASE_NUM
+} boot_phase_t;
+
 /* Public functions */
 
 /* Handle images transfer from the STM32 to the ST8500 */
 bool downloadImageToST8500(void);
 
+/* Checks if the ST8500 still runs the images to download (host-only reset) */
+bool checkImagesRunningOnST8500(void);
+bool isImageDownloadSkipped(void);
+
+/* Boot-time report */
+void setBootPhaseEnd(boot_phase_t phase);
+
 #ifdef __cplusplus
 }
 #endif
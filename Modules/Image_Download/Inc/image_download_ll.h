@@ -61,6 +61,8 @@ extern "C" {
 
 /* Functions */
 void     sendRequest(    UART_HandleTypeDef* huart, ud_req_t* req);
+bool     startRequest(   UART_HandleTypeDef* huart, ud_req_t* req);
+bool     waitRequestSent(UART_HandleTypeDef* huart, uint32_t timeout);
 uint32_t receiveResponse(UART_HandleTypeDef* huart, ud_res_t* res, uint32_t timeout);
 
 /**
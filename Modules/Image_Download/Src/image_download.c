@@ -23,12 +23,40 @@
 #include <image_download.h>
 #include <image_management.h>
 
+/* Reserved Inclusions */
+#define INCUDE_USER_DOWNLOAD_LL
+#include <image_download_ll.h>
+#undef INCUDE_USER_DOWNLOAD_LL
+
+/* Private variables */
+static uint32_t boot_phase_end[BOOT_PHASE_NUM];	/* End of each boot phase, in ms from the start */
 
 #if ENABLE_DOWNLOAD
 
-/* Imported functions */
-extern void     sendRequest(    UART_HandleTypeDef* huart, ud_req_t* req);
-extern uint32_t receiveResponse(UART_HandleTypeDef* huart, ud_res_t* res, uint32_t timeout);
+/* Definitions */
+#define DOWNLOAD_TIMESTAMP_US()		((HAL_GetTick() * 1000) + htimSys.Instance->CNT)	/* Time base counts microseconds within each tick */
+
+/* Custom types */
+typedef struct download_timing_str
+{
+	uint32_t read_us;		/* SPI FLASH reads */
+	uint32_t send_us;		/* UART transmission, not overlapped by the SPI FLASH reads */
+	uint32_t ack_us;		/* ST8500 acknowledges */
+	uint32_t total_us;
+	uint32_t blocks;
+} download_timing_t;
+
+/* External variables */
+extern TIM_HandleTypeDef htimSys; /* Systick Timer */
+
+/* Private variables */
+static bool     images_scanned   = false;
+static uint32_t pe_img_address   = IMAGE_NOT_FOUND;
+static uint32_t rte_img_address  = IMAGE_NOT_FOUND;
+#if ENABLE_DOWNLOAD_SKIP
+static bool     download_skipped = false;
+#endif
+
 
 /**
   * @brief  Sets UART parameters for the STM<->ST8500 communication.
@@ -147,39 +175,59 @@ static bool initDownload(image_header_t *header, uint32_t header_size, ud_req_t*
 }
 
 /**
-  * @brief  Sends a image data block to the ST8500. The data must be already stored in 'req->payload'.
+  * @brief  Starts sending a image data block to the ST8500. The data must be already stored in 'req->payload'.
+  *         'req' must not be modified until 'blockDownloadEnd' returns.
   * @param  block_size: size of the image data block (in bytes).
   * @param  req: pointer to the request message buffer.
+  * @retval 'true' if the transmission is started, 'false' otherwise.
+  */
+static bool blockDownloadStart(uint32_t block_size, ud_req_t* req)
+{
+    assert(req != NULL);
+
+    /* Do not memset req to 0 */
+    req->preamb.cmd_id = UD_CMD_ID_IMG_WRITE;
+    req->preamb.msg_len = block_size;
+    /* 'req->payload' filled previously outside the function */
+
+    return startRequest(&huartHostIf, req);
+}
+
+/**
+  * @brief  Waits for the end of the transmission of a image data block and for the ST8500 response.
+  * @param  req: pointer to the request message buffer, passed to 'blockDownloadStart'.
   * @param  res: pointer to the response message buffer.
+  * @param  timing: pointer to the timing structure to update.
   * @retval 'true' if a positive response is received, 'false' otherwise.
   */
-static bool blockDownload(uint32_t block_size, ud_req_t* req, ud_res_t* res)
+static bool blockDownloadEnd(ud_req_t* req, ud_res_t* res, download_timing_t *timing)
 {
     assert(req != NULL);
     assert(res != NULL);
-    
+
     bool result = false;
-    
-    /* Do not memset req to 0 */
-    memset(res, 0, sizeof(ud_res_t));
+    uint32_t timestamp = DOWNLOAD_TIMESTAMP_US();
 
-    req->preamb.cmd_id = UD_CMD_ID_IMG_WRITE;
-    req->preamb.msg_len = block_size;
-    /* 'req->payload' filled previously outside the function */
+    memset(res, 0, sizeof(ud_res_t));
 
-    /* Payload and length set previously */
-    sendRequest(&huartHostIf, req);
-    
-    receiveResponse(&huartHostIf, res, RESPONSE_TIMEOUT);
-    
-    if (res->preamb.state == UD_STATE_ACK)
+    if (waitRequestSent(&huartHostIf, REQUEST_TIMEOUT))
     {
-        if (res->preamb.cmd_id == req->preamb.cmd_id)
+    	timing->send_us += DOWNLOAD_TIMESTAMP_US() - timestamp;
+    	timestamp = DOWNLOAD_TIMESTAMP_US();
+
+        receiveResponse(&huartHostIf, res, RESPONSE_TIMEOUT);
+
+        timing->ack_us += DOWNLOAD_TIMESTAMP_US() - timestamp;
+
+        if (res->preamb.state == UD_STATE_ACK)
         {
-            result = true;
+            if (res->preamb.cmd_id == req->preamb.cmd_id)
+            {
+                result = true;
+            }
         }
     }
-    
+
     return result;
 }
 
@@ -219,13 +267,15 @@ static bool startST8500(ud_req_t* req, ud_res_t* res)
 
 /**
   * @brief  Handle the full transfer of a single image to the ST8500.
+  *         Blocks are double-buffered: the next block is read from SFLASH while the
+  *         current one is sent by DMA (the ST8500 cannot answer before receiving it).
   * @param  img_address: address of the image to transfer in SFLASH.
-  * @param  req: pointer to the request message buffer.
+  * @param  req: pointers to the two request message buffers.
   * @param  res: pointer to the response message buffer.
   * @retval 'true' if the image is successfully transfered and
   *          started, 'false' otherwise.
   */
-static bool transferRtePeImage(uint32_t image_address, ud_req_t *req, ud_res_t *res)
+static bool transferRtePeImage(uint32_t image_address, ud_req_t *req[2], ud_res_t *res)
 {
 	bool result;
 	image_header_t      header;
@@ -233,61 +283,237 @@ static bool transferRtePeImage(uint32_t image_address, ud_req_t *req, ud_res_t *
 
 	uint32_t total_bytes;
 	uint32_t bytes_sent;
+	uint32_t bytes_read;
 	uint32_t block_size;
-	uint32_t download_blink_ts = 0;
+	uint32_t next_block_size = 0;
+	uint8_t  current = 0;
+	uint32_t timestamp;
+
+	download_timing_t timing;
+
+	memset(&timing, 0, sizeof(timing));
+	timing.total_us = DOWNLOAD_TIMESTAMP_US();
 
 	getImgHeader(image_address, &header, &header_size);
 
 	total_bytes = getFwSize(image_address);
 	bytes_sent  = 0;
+	bytes_read  = 0;
 
-	result = initDownload(&header, header_size, req, res);
+	result = initDownload(&header, header_size, req[0], res);
 
-	if (result == true)
+	while ((result == true) && (bytes_sent < total_bytes))
 	{
-		while(bytes_sent < total_bytes)
+		/* Reads the first block, the next ones are read during the transmission of the previous one */
+		if (bytes_read == bytes_sent)
 		{
-			if ((total_bytes - bytes_sent) >= sizeof(req->payload))
-			{
-				block_size = sizeof(req->payload);
-			}
-			else
-			{
-				block_size = total_bytes - bytes_sent;
-			}
+			next_block_size = ((total_bytes - bytes_read) >= sizeof(req[current]->payload)) ? sizeof(req[current]->payload) : (total_bytes - bytes_read);
 
-			/* Read flash memory and downloads block to ST8500, must start after the header */
-			result = getDataBlock(image_address, &req->payload[0], block_size, header_size + bytes_sent);
+			timestamp = DOWNLOAD_TIMESTAMP_US();
+			result = getDataBlock(image_address, &req[current]->payload[0], next_block_size, header_size + bytes_read);
+			timing.read_us += DOWNLOAD_TIMESTAMP_US() - timestamp;
 
-			if (result == true)
-			{
-				result = blockDownload(block_size, req, res);
-			}
+			bytes_read += next_block_size;
+		}
 
-			if (result == true)
+		if (result == true)
+		{
+			block_size = next_block_size;
+
+			result = blockDownloadStart(block_size, req[current]);
+		}
+
+		if (result == true)
+		{
+			/* Reads the next block in the other buffer, must start after the header */
+			if (bytes_read < total_bytes)
 			{
-				bytes_sent += block_size;
+				next_block_size = ((total_bytes - bytes_read) >= sizeof(req[current ^ 1]->payload)) ? sizeof(req[current ^ 1]->payload) : (total_bytes - bytes_read);
+
+				timestamp = DOWNLOAD_TIMESTAMP_US();
+				result = getDataBlock(image_address, &req[current ^ 1]->payload[0], next_block_size, header_size + bytes_read);
+				timing.read_us += DOWNLOAD_TIMESTAMP_US() - timestamp;
+
+				bytes_read += next_block_size;
 			}
-			else
+
+			/* Waits for the block to be sent even if the read failed, the buffer is in use by the DMA */
+			if (blockDownloadEnd(req[current], res, &timing) == false)
 			{
-				break;
+				result = false;
 			}
 		}
 
-		if (bytes_sent == total_bytes)
+		if (result == true)
 		{
-			/* Start downloaded image*/
-			result = startST8500(req, res);
+			bytes_sent += block_size;
+			timing.blocks++;
+			current ^= 1;
 		}
-		else
+	}
+
+	if (result == true)
+	{
+		/* Start downloaded image*/
+		result = startST8500(req[0], res);
+	}
+
+	timing.total_us = DOWNLOAD_TIMESTAMP_US() - timing.total_us;
+
+	PRINT("MAIN:       %u bytes in %u blocks, %u ms (SFLASH read: %u ms, UART send: %u ms, ACK wait: %u ms)\n",
+		  bytes_sent, timing.blocks, timing.total_us / 1000, timing.read_us / 1000, timing.send_us / 1000, timing.ack_us / 1000);
+
+	return result;
+}
+
+
+/**
+  * @brief  Selects the PE and RTE images to download (primary ones if present, secondary ones otherwise).
+  *         The images in SFLASH are scanned and validated at the first call only.
+  * @param  None
+  * @retval 'true' if both images are found, 'false' otherwise.
+  */
+static bool selectImagesToLoad(void)
+{
+	bool result;
+
+	if (images_scanned == false)
+	{
+		/* First, checks and fixes the validity field for all images */
+		PRINT("MAIN:       Scanning for new images...\n");
+
+		if (scanForImagesToValidate() == true)
 		{
-			result = false;
+			PRINT("MAIN:       Validating new images...\n");
 		}
+
+		images_scanned = true;
+	}
+
+	/* Looks for a primary PE image and a primary RTE image */
+	result = findImagesToLoad(&pe_img_address, &rte_img_address, IMG_VALIDATED_FIRST);
+
+	/* At least one primary image is missing, so it is necessary to look for a secondary one */
+	if (result == false)
+	{
+		if (pe_img_address == IMAGE_NOT_FOUND)
+		{
+			PRINT("MAIN:       Missing PE primary image.\n");
+		}
+
+		if (rte_img_address == IMAGE_NOT_FOUND)
+		{
+			PRINT("MAIN:       Missing RTE primary image.\n");
+		}
+
+		PRINT("MAIN:       Scanning for secondary images...\n");
+		result = findImagesToLoad(&pe_img_address, &rte_img_address, IMG_VALIDATED_SECOND);
 	}
 
 	return result;
 }
 
+#if ENABLE_DOWNLOAD_SKIP
+/**
+  * @brief  Checks if the ST8500 bootloader answers (no image running).
+  *         Sends a MIB get request at the bootloader baudrate: a running ST8500
+  *         firmware discards it as an invalid frame and does not answer.
+  * @param  req: pointer to the request message buffer.
+  * @param  res: pointer to the response message buffer.
+  * @retval 'true' if the bootloader answers, 'false' otherwise.
+  */
+static bool probeST8500Bootloader(ud_req_t* req, ud_res_t* res)
+{
+    assert(req != NULL);
+    assert(res != NULL);
+
+    bool result = false;
+
+    uint32_t prev_hif_baudrate = huartHostIf.Init.BaudRate;
+    uint8_t  prev_hif_parity   = huartHostIf.Init.Parity;
+    uint8_t  prev_hif_stop     = huartHostIf.Init.StopBits;
+
+    memset(req, 0, sizeof(ud_req_t));
+
+    req->preamb.cmd_id  = UD_CMD_ID_MIB_GET;
+    req->preamb.msg_len = sizeof(mib_get_req_payload_t);
+    req->payload[0]     = UD_MIB_ID_RTE_BOOT_STATUS;
+
+    USART_changeSettings(&huartHostIf, ST8500_BOOTLOADER_BAUDRATE, UART_PARITY_NONE, UART_STOPBITS_1);
+
+    sendRequest(&huartHostIf, req);
+
+    if (receiveResponse(&huartHostIf, res, PROBE_TIMEOUT) == UD_STATE_ACK)
+    {
+        result = (res->preamb.cmd_id == req->preamb.cmd_id);
+    }
+
+    USART_changeSettings(&huartHostIf, prev_hif_baudrate, prev_hif_parity, prev_hif_stop);
+
+    return result;
+}
+
+/**
+  * @brief  Checks if the ST8500 still runs the images selected for download, which
+  *         is possible only after a reset of the host (watchdog, software or pin reset).
+  *         Must be called before resetting the ST8500. If 'true' is returned, the ST8500
+  *         must not be reset and 'downloadImageToST8500' must not be called.
+  * @param  None
+  * @retval 'true' if the ST8500 runs the selected images, 'false' otherwise.
+  */
+bool checkImagesRunningOnST8500(void)
+{
+    bool result = false;
+
+    image_load_record_t record;
+    image_identity_t    pe_identity;
+    image_identity_t    rte_identity;
+
+    /* A power-on or brown-out reset also resets the ST8500 */
+    bool power_reset = (__HAL_RCC_GET_FLAG(RCC_FLAG_PORRST) || __HAL_RCC_GET_FLAG(RCC_FLAG_BORRST));
+
+    __HAL_RCC_CLEAR_RESET_FLAGS();
+
+    if ((power_reset == false) && (getImageLoadRecord(&record) == true) && (selectImagesToLoad() == true))
+    {
+    	getImageIdentity(pe_img_address,  &pe_identity);
+    	getImageIdentity(rte_img_address, &rte_identity);
+
+    	if ((memcmp(&record.pe,  &pe_identity,  sizeof(pe_identity))  == 0) &&
+    		(memcmp(&record.rte, &rte_identity, sizeof(rte_identity)) == 0)	)
+    	{
+    	    ud_req_t *req = MEMPOOL_MALLOC(sizeof(ud_req_t)); /* Request buffer */
+    	    ud_res_t *res = MEMPOOL_MALLOC(sizeof(ud_res_t)); /* Response buffer */
+
+    	    result = (probeST8500Bootloader(req, res) == false);
+
+    	    MEMPOOL_FREE(req);
+    	    MEMPOOL_FREE(res);
+    	}
+    }
+
+    if (result == true)
+    {
+    	/* Cleans terminal screen */
+    	PRINT(RESET_DISPLAY_STRING);
+    	PRINT("MAIN:       ST8500 already running the selected images, download skipped.\n");
+    }
+
+    download_skipped = result;
+
+    return result;
+}
+
+/**
+  * @brief  Returns if the image download was skipped at startup ('checkImagesRunningOnST8500').
+  * @param  None
+  * @retval 'true' if the ST8500 was not reset and kept its running images, 'false' otherwise.
+  */
+bool isImageDownloadSkipped(void)
+{
+	return download_skipped;
+}
+#endif /* ENABLE_DOWNLOAD_SKIP */
 
 /**
   * @brief  Handle the download procedure of a single image from the host.
@@ -298,52 +524,23 @@ bool downloadImageToST8500(void)
 {
     bool result = false;
     
-    ud_req_t *req = MEMPOOL_MALLOC(sizeof(ud_req_t)); /* Request buffer */
+    ud_req_t *req[2] = {MEMPOOL_MALLOC(sizeof(ud_req_t)), MEMPOOL_MALLOC(sizeof(ud_req_t))}; /* Request buffers (double buffering) */
     ud_res_t *res = MEMPOOL_MALLOC(sizeof(ud_res_t)); /* Response buffer */
 
     uint32_t prev_hif_baudrate = huartHostIf.Init.BaudRate;
     uint8_t  prev_hif_parity   = huartHostIf.Init.Parity;
     uint8_t  prev_hif_stop     = huartHostIf.Init.StopBits;
 
-    uint32_t pe_img_address  = IMAGE_NOT_FOUND;
-    uint32_t rte_img_address = IMAGE_NOT_FOUND;
-
     /* Cleans terminal screen */
     PRINT(RESET_DISPLAY_STRING);
 
-    /* First, checks and fixes the validity field for all images */
-	PRINT("MAIN:       Scanning for new images...\n");
-
-	if (scanForImagesToValidate() == true)
-	{
-		PRINT("MAIN:       Validating new images...\n");
-	}
-
 	PRINT("MAIN:       Downloading images to ST8500...\n");
     /* Sets the baudrate of the HIF uart to the default value to communicate with the ST8500 */
     USART_changeSettings(&huartHostIf, ST8500_BOOTLOADER_BAUDRATE, UART_PARITY_NONE, UART_STOPBITS_1);
     
     do
 	{
-    	/* Looks for a primary PE image and a primary RTE image */
-		result = findImagesToLoad(&pe_img_address, &rte_img_address, IMG_VALIDATED_FIRST);
-
-		/* At least one primary image is missing, so it is necessary to look for a secondary one */
-		if (result == false)
-		{
-			if (pe_img_address == IMAGE_NOT_FOUND)
-			{
-				PRINT("MAIN:       Missing PE primary image.\n");
-			}
-
-			if (rte_img_address == IMAGE_NOT_FOUND)
-			{
-				PRINT("MAIN:       Missing RTE primary image.\n");
-			}
-
-			PRINT("MAIN:       Scanning for secondary images...\n");
-			result = findImagesToLoad(&pe_img_address, &rte_img_address, IMG_VALIDATED_SECOND);
-		}
+		result = selectImagesToLoad();
 
 		if (result == false)
 		{
@@ -352,7 +549,7 @@ bool downloadImageToST8500(void)
 		}
 
 		/* Warning! 'setUartConfig' changes huartHif configuration, too! */
-		result = setUartConfig(UD_BAUDRATE_USED, UD_PARITY_NONE, UD_STOP_1, req, res);
+		result = setUartConfig(UD_BAUDRATE_USED, UD_PARITY_NONE, UD_STOP_1, req[0], res);
 
 		if (result == false)
 		{
@@ -377,9 +574,17 @@ bool downloadImageToST8500(void)
 			PRINT("MAIN:       Could not download the PE image.\n");
 			break;
 		}
+#if ENABLE_DOWNLOAD_SKIP
+		/* Records the loaded images, to skip the download after a reset of the host only */
+		if (setImageLoadRecord(pe_img_address, rte_img_address) == false)
+		{
+			PRINT("MAIN:       Could not record the loaded images.\n");
+		}
+#endif /* ENABLE_DOWNLOAD_SKIP */
 	} while(0);
 
-    MEMPOOL_FREE(req);
+    MEMPOOL_FREE(req[0]);
+    MEMPOOL_FREE(req[1]);
     MEMPOOL_FREE(res);
 
     /* Restores huartHif configuration (undoes 'setUartConfig' effects) */
@@ -400,4 +605,37 @@ bool downloadImageToST8500(void)
 
 #endif /* ENABLE_DOWNLOAD */
 
+/**
+  * @brief  Marks the end of a boot phase. The boot-time report is printed at the end of the last phase.
+  *         Phases that end more than once (e.g. network start after a rejoin) are only marked the first time.
+  * @param  phase: boot phase that ends.
+  * @retval None
+  */
+void setBootPhaseEnd(boot_phase_t phase)
+{
+	if ((phase < BOOT_PHASE_NUM) && (boot_phase_end[phase] == 0))
+	{
+		boot_phase_end[phase] = HAL_GetTick();
+
+		if (phase == BOOT_PHASE_NETWORK)
+		{
+			/* A phase starts at the end of the previous one, skipped phases last 0 ms */
+			for (uint32_t i = 1; i < BOOT_PHASE_NUM; i++)
+			{
+				if (boot_phase_end[i] < boot_phase_end[i - 1])
+				{
+					boot_phase_end[i] = boot_phase_end[i - 1];
+				}
+			}
+
+			PRINT("Boot time: %u ms (reset: %u ms, download: %u ms, config: %u ms, network start: %u ms)\n",
+				  boot_phase_end[BOOT_PHASE_NETWORK],
+				  boot_phase_end[BOOT_PHASE_RESET],
+				  boot_phase_end[BOOT_PHASE_DOWNLOAD] - boot_phase_end[BOOT_PHASE_RESET],
+				  boot_phase_end[BOOT_PHASE_CONFIG]   - boot_phase_end[BOOT_PHASE_DOWNLOAD],
+				  boot_phase_end[BOOT_PHASE_NETWORK]  - boot_phase_end[BOOT_PHASE_CONFIG]);
+		}
+	}
+}
+
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -36,16 +36,15 @@
 
 /* Private functions */
 
-/* Public functions */
-
 /**
-  * @brief  Sends a request message through the given UART.
-  * @param  huart: UART handle.
+  * @brief  Completes a request message with its fixed fields and CRC.
   * @param  req: pointer to the request message buffer.
-  * @retval None.
+  * @retval Number of bytes to send (0 if the payload is too long).
   */
-void sendRequest(UART_HandleTypeDef* huart, ud_req_t* req)
+static uint32_t prepareRequest(ud_req_t* req)
 {
+    uint32_t length = 0;
+
     if (req->preamb.msg_len <= sizeof(req->payload))
     {
     	uint16_t crc16;
@@ -59,9 +58,29 @@ void sendRequest(UART_HandleTypeDef* huart, ud_req_t* req)
 		req->payload[req->preamb.msg_len]     = LOW_BYTE(crc16);
 		req->payload[req->preamb.msg_len + 1] = HIGH_BYTE(crc16);
 
+		length = sizeof(req->preamb) + req->preamb.msg_len + sizeof(crc16);
+    }
+
+    return length;
+}
+
+/* Public functions */
+
+/**
+  * @brief  Sends a request message through the given UART.
+  * @param  huart: UART handle.
+  * @param  req: pointer to the request message buffer.
+  * @retval None.
+  */
+void sendRequest(UART_HandleTypeDef* huart, ud_req_t* req)
+{
+    uint32_t length = prepareRequest(req);
+
+    if (length > 0)
+    {
         if ((osKernelGetState() == osKernelInactive) || (osKernelGetState() == osKernelReady))
 		{
-        	HAL_UART_Transmit(huart, (uint8_t*) req, sizeof(req->preamb) + req->preamb.msg_len + sizeof(crc16), REQUEST_TIMEOUT);
+        	HAL_UART_Transmit(huart, (uint8_t*) req, length, REQUEST_TIMEOUT);
 		}
 		else
 		{
@@ -70,6 +89,56 @@ void sendRequest(UART_HandleTypeDef* huart, ud_req_t* req)
     }
 }
 
+/**
+  * @brief  Starts sending a request message through the given UART, by DMA.
+  *         The request buffer must not be modified until 'waitRequestSent' returns.
+  * @param  huart: UART handle.
+  * @param  req: pointer to the request message buffer.
+  * @retval 'true' if the transmission is started, 'false' otherwise.
+  */
+bool startRequest(UART_HandleTypeDef* huart, ud_req_t* req)
+{
+    bool     result = false;
+    uint32_t length = prepareRequest(req);
+
+    if (length > 0)
+    {
+        if ((osKernelGetState() == osKernelInactive) || (osKernelGetState() == osKernelReady))
+		{
+        	result = (HAL_UART_Transmit_DMA(huart, (uint8_t*) req, length) == HAL_OK);
+		}
+		else
+		{
+			Error_Handler(); /* Must be called before starting FreeRTOS */
+		}
+    }
+
+    return result;
+}
+
+/**
+  * @brief  Waits for the end of the transmission started by 'startRequest'.
+  * @param  huart: UART handle.
+  * @param  timeout: transmission timeout (in ms).
+  * @retval 'true' if the request was sent, 'false' otherwise (the transmission is aborted).
+  */
+bool waitRequestSent(UART_HandleTypeDef* huart, uint32_t timeout)
+{
+	uint32_t start_tick = HAL_GetTick();
+
+	/* The state is set back to ready by the UART interrupt, at the end of the transmission */
+	while (huart->gState != HAL_UART_STATE_READY)
+	{
+		if ((HAL_GetTick() - start_tick) > timeout)
+		{
+			HAL_UART_AbortTransmit(huart);
+			break;
+		}
+	}
+
+	return (huart->gState == HAL_UART_STATE_READY) && (huart->ErrorCode == HAL_UART_ERROR_NONE);
+}
+
 /**
   * @brief  Receives a response message through the given UART.
   * @param  huart: UART handle.
@@ -50,6 +50,25 @@ extern "C" {
 /* Images must be located at multiple addresses of IMAGE_SLOT_SIZE */
 #define SFLASH_SLOT(x)							(x * IMAGE_SLOT_SIZE)
 
+/* Transfer progress records, one SFLASH sector per slot after the image slots */
+#define IMAGE_PROGRESS_AREA_SIZE				(65536) /* in bytes (one SFLASH sector) */
+#define IMAGE_PROGRESS_BLOCK_SIZE				(1024)	/* in bytes, granularity of the progress record */
+#define IMAGE_PROGRESS_MAP_SIZE					(IMAGE_SLOT_SIZE / IMAGE_PROGRESS_BLOCK_SIZE / 8) /* in bytes */
+#define IMAGE_PROGRESS_MAGIC					0x50524F47
+#define SFLASH_PROGRESS(image_address)			((IMAGE_SLOTS_NUM * IMAGE_SLOT_SIZE) + (((image_address) / IMAGE_SLOT_SIZE) * IMAGE_PROGRESS_AREA_SIZE))
+
+/* Staging area of the compressed images being transferred, after the transfer progress records */
+#define IMAGE_STAGING_SIZE						IMAGE_SLOT_SIZE /* in bytes */
+#define SFLASH_STAGING							((IMAGE_SLOTS_NUM * IMAGE_SLOT_SIZE) + (IMAGE_SLOTS_NUM * IMAGE_PROGRESS_AREA_SIZE))
+
+/* Record of the images loaded in the ST8500, after the staging area */
+#define IMAGE_LOAD_RECORD_SIZE					(65536) /* in bytes (one SFLASH sector) */
+#define IMAGE_LOAD_RECORD_MAGIC					0x4C4F4144
+#define SFLASH_LOAD_RECORD						(SFLASH_STAGING + IMAGE_STAGING_SIZE)
+
+/* End of the SFLASH areas of the image management (slots, progress records, staging area and load record) */
+#define SFLASH_IMAGE_AREA_END					(SFLASH_LOAD_RECORD + IMAGE_LOAD_RECORD_SIZE)
+
 #define IMG_TYPE_IS_VALID(type)					(	(type == FW_PE_IMAGE	) || \
 													(type == FW_RTE_IMAGE	) )
 
@@ -107,6 +126,33 @@ typedef struct image_header_struct
 
 #pragma pack(pop)
 
+/* Transfer progress record */
+typedef struct image_progress_struct
+{
+  uint32_t              magic;
+  uint32_t              image_type;
+  uint32_t              image_size;
+  uint16_t              image_crc16;
+  uint32_t              stream_size; /* Size of the data transferred, lower than image_size if the image is received compressed in the staging area */
+  uint8_t               missing_map[IMAGE_PROGRESS_MAP_SIZE]; /* Bit set (erased): block missing, bit cleared: block received */
+} image_progress_t;
+
+/* Identity of an image loaded in the ST8500 */
+typedef struct image_identity_struct
+{
+  uint32_t              address;
+  uint32_t              fw_size;
+  uint16_t              crc16;
+} image_identity_t;
+
+/* Load record, identity of the images last loaded in the ST8500 */
+typedef struct image_load_record_struct
+{
+  uint32_t              magic;
+  image_identity_t      pe;
+  image_identity_t      rte;
+} image_load_record_t;
+
 typedef struct slot_info_str
 {
 	bool     free;
@@ -137,10 +183,23 @@ uint16_t calculateImageCRC(  uint32_t image_address, uint32_t image_size);
 
 /* Image writing/programming */
 bool prepareImageSlot(			uint32_t image_address);
+bool prepareStagingArea(		void);
 bool setDataBlock(           	uint32_t image_address, uint8_t *block, uint16_t block_size, uint32_t offset);
 bool setImageValidity(       	uint32_t image_address, uint32_t new_validity);
 bool setImageCRC(            	uint32_t image_address, uint16_t crc16);
 
+/* Transfer progress management */
+bool getTransferProgress(		uint32_t image_address, image_progress_t *progress);
+bool setTransferProgress(		uint32_t image_address, uint32_t image_type, uint32_t image_size, uint16_t image_crc16, uint32_t stream_size);
+bool setTransferBlockReceived(	uint32_t image_address, uint32_t block_index);
+bool invalidateTransferProgress(uint32_t image_address);
+
+/* Load record management */
+void getImageIdentity(			uint32_t image_address, image_identity_t *identity);
+bool getImageLoadRecord(		image_load_record_t *record);
+bool setImageLoadRecord(		uint32_t pe_img_address, uint32_t rte_img_address);
+bool invalidateImageLoadRecord(	void);
+
 /* Validity management */
 bool downgradeImageValidity( uint32_t image_address);
 bool invalidateImageValidity(uint32_t image_address);
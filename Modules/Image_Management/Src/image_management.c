@@ -16,6 +16,7 @@
 
 /* Inclusions */
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <usart.h>
 #include <debug_print.h>
@@ -268,7 +269,25 @@ uint16_t calculateImageCRC(uint32_t image_address, uint32_t image_size)
   */
 bool prepareImageSlot(uint32_t image_address)
 {
-    return SFLASH_ERASE(image_address, IMAGE_SLOT_SIZE);
+    bool result = SFLASH_ERASE(image_address, IMAGE_SLOT_SIZE);
+
+    if (result == true)
+    {
+        /* The transfer progress record of the slot is no longer valid */
+        result = SFLASH_ERASE(SFLASH_PROGRESS(image_address), IMAGE_PROGRESS_AREA_SIZE);
+    }
+
+    return result;
+}
+
+/**
+  * @brief  Erases the staging area of the compressed images in SFLASH memory.
+  * @param  None
+  * @retval 'true' if the SFLASH operations are successful, 'false' otherwise.
+  */
+bool prepareStagingArea(void)
+{
+    return SFLASH_ERASE(SFLASH_STAGING, IMAGE_STAGING_SIZE);
 }
 
 /**
@@ -314,6 +333,148 @@ bool setImageValidity(uint32_t image_address, uint32_t new_validity)
     return result;
 }
 
+/**
+  * @brief  Reads the transfer progress record of an image slot.
+  * @param  image_address Address of the image in the SFLASH.
+  * @param  progress Pointer to the progress record structure.
+  * @retval 'true' if a valid progress record was found, 'false' otherwise.
+  */
+bool getTransferProgress(uint32_t image_address, image_progress_t *progress)
+{
+    bool result = SFLASH_READ((uint8_t*) progress, SFLASH_PROGRESS(image_address), sizeof(image_progress_t));
+
+    return ((result == true) && (progress->magic == IMAGE_PROGRESS_MAGIC));
+}
+
+/**
+  * @brief  Writes the identity of the image being received in the transfer progress record of its slot.
+  *         The slot must have been prepared before (erased record, all blocks missing).
+  * @param  image_address Address of the image in the SFLASH.
+  * @param  image_type Type of the image being received.
+  * @param  image_size Size of the image being received.
+  * @param  image_crc16 CRC16-CCITT of the image being received.
+  * @param  stream_size Size of the data being received (compressed size, or image_size if not compressed).
+  * @retval 'true' if the SFLASH write operation is successful, 'false' otherwise.
+  */
+bool setTransferProgress(uint32_t image_address, uint32_t image_type, uint32_t image_size, uint16_t image_crc16, uint32_t stream_size)
+{
+    image_progress_t progress;
+
+    progress.magic       = IMAGE_PROGRESS_MAGIC;
+    progress.image_type  = image_type;
+    progress.image_size  = image_size;
+    progress.image_crc16 = image_crc16;
+    progress.stream_size = stream_size;
+
+    /* Only the identity is written, the bitmap is left erased */
+    return SFLASH_WRITE(SFLASH_PROGRESS(image_address), (uint8_t*) &progress, offsetof(image_progress_t, missing_map));
+}
+
+/**
+  * @brief  Marks a block as received in the transfer progress record of an image slot.
+  *         Only clears one bit of the record, no erase is needed.
+  * @param  image_address Address of the image in the SFLASH.
+  * @param  block_index Index of the received block (of IMAGE_PROGRESS_BLOCK_SIZE bytes).
+  * @retval 'true' if the SFLASH write operation is successful, 'false' otherwise.
+  */
+bool setTransferBlockReceived(uint32_t image_address, uint32_t block_index)
+{
+    bool result = false;
+
+    if (block_index < (IMAGE_PROGRESS_MAP_SIZE * 8))
+    {
+        uint8_t map_byte = ~(1U << (block_index % 8));
+
+        result = SFLASH_WRITE(SFLASH_PROGRESS(image_address) + offsetof(image_progress_t, missing_map) + (block_index / 8), &map_byte, sizeof(map_byte));
+    }
+
+    return result;
+}
+
+/**
+  * @brief  Invalidates the transfer progress record of an image slot (the transfer cannot be resumed).
+  * @param  image_address Address of the image in the SFLASH.
+  * @retval 'true' if the SFLASH write operation is successful, 'false' otherwise.
+  */
+bool invalidateTransferProgress(uint32_t image_address)
+{
+    uint32_t magic = 0;
+
+    return SFLASH_WRITE(SFLASH_PROGRESS(image_address), (uint8_t*) &magic, sizeof(magic));
+}
+
+/**
+  * @brief  Reads the identity of an image (address, firmware size and CRC).
+  * @param  image_address Address of the image in the SFLASH.
+  * @param  identity Pointer to the structure to fill.
+  * @retval None
+  */
+void getImageIdentity(uint32_t image_address, image_identity_t *identity)
+{
+    memset(identity, 0, sizeof(image_identity_t));
+
+    identity->address = image_address;
+    identity->fw_size = getFwSize(image_address);
+    identity->crc16   = getImageCRC(image_address);
+}
+
+/**
+  * @brief  Reads the record of the images last loaded in the ST8500.
+  * @param  record Pointer to the structure to fill.
+  * @retval 'true' if a valid record is found, 'false' otherwise.
+  */
+bool getImageLoadRecord(image_load_record_t *record)
+{
+    bool result = SFLASH_READ((uint8_t*) record, SFLASH_LOAD_RECORD, sizeof(image_load_record_t));
+
+    return ((result == true) && (record->magic == IMAGE_LOAD_RECORD_MAGIC));
+}
+
+/**
+  * @brief  Records the images loaded in the ST8500. The SFLASH sector is only
+  *         rewritten if the record changes.
+  * @param  pe_img_address Address of the PE image loaded.
+  * @param  rte_img_address Address of the RTE image loaded.
+  * @retval 'true' if the SFLASH operations are successful, 'false' otherwise.
+  */
+bool setImageLoadRecord(uint32_t pe_img_address, uint32_t rte_img_address)
+{
+    bool result = true;
+
+    image_load_record_t record;
+    image_load_record_t stored_record;
+
+    memset(&record, 0, sizeof(record));
+
+    record.magic = IMAGE_LOAD_RECORD_MAGIC;
+    getImageIdentity(pe_img_address,  &record.pe);
+    getImageIdentity(rte_img_address, &record.rte);
+
+    if ((getImageLoadRecord(&stored_record) == false) || (memcmp(&record, &stored_record, sizeof(record)) != 0))
+    {
+        result = SFLASH_ERASE(SFLASH_LOAD_RECORD, IMAGE_LOAD_RECORD_SIZE);
+
+        if (result == true)
+        {
+            result = SFLASH_WRITE(SFLASH_LOAD_RECORD, (uint8_t*) &record, sizeof(record));
+        }
+    }
+
+    return result;
+}
+
+/**
+  * @brief  Invalidates the record of the images loaded in the ST8500 (a download is needed at the next start).
+  * @param  None
+  * @retval 'true' if the SFLASH write operation is successful, 'false' otherwise.
+  */
+bool invalidateImageLoadRecord(void)
+{
+    uint32_t magic = 0;
+
+    return SFLASH_WRITE(SFLASH_LOAD_RECORD, (uint8_t*) &magic, sizeof(magic));
+}
+
 /**
   * @brief  Changes the validity field of an image in SFLASH to secondary (must be primary).
   * @param  image_address Address of the image in the SFLASH.
@@ -514,6 +675,8 @@ bool findImagesToLoad(uint32_t *pe_img_address_ptr, uint32_t *rte_img_address_pt
   */
 void checkMemoryContent(slot_info_t *slot_vect)
 {
+	image_progress_t progress;
+
 	assert_param(slot_vect != NULL);
 
 	PRINT("  SFLASH memory content:\n");
@@ -562,6 +725,18 @@ void checkMemoryContent(slot_info_t *slot_vect)
 			PRINT("  > Slot %u free.\n", i + 1);
 		}
 
+		if (getTransferProgress(slot_vect[i].address, &progress))
+		{
+			if (progress.stream_size < progress.image_size)
+			{
+				PRINT("    Incomplete transfer of a %u bytes image (CRC16-CCITT: %04X), compressed to %u bytes, can be resumed.\n", progress.image_size, progress.image_crc16, progress.stream_size);
+			}
+			else
+			{
+				PRINT("    Incomplete transfer of a %u bytes image (CRC16-CCITT: %04X), can be resumed.\n", progress.image_size, progress.image_crc16);
+			}
+		}
+
 	}
 	PRINT_NOTS("\n");
 }
@@ -577,20 +752,22 @@ bool eraseMemorySector(uint32_t slot_index)
 
 	if (slot_index < IMAGE_SLOTS_NUM)
 	{
-		result = SFLASH_ERASE(SFLASH_SLOT(slot_index), IMAGE_SLOT_SIZE);
+		result = prepareImageSlot(SFLASH_SLOT(slot_index));
 	}
 
 	return result;
 }
 
 /**
-  * @brief  Erases the entire SFLASH memory.
+  * @brief  Erases the SFLASH areas of the image management: all the image slots, their
+  *         transfer progress records, the staging area and the load record.
+  * @note   The data stored after SFLASH_IMAGE_AREA_END (e.g. by the Boot Server) is preserved.
   * @param  None
-  * @retval 'true' if the SFLASH write operation is successful, 'false' otherwise.
+  * @retval 'true' if the SFLASH erase operation is successful, 'false' otherwise.
   */
 bool eraseMemory(void)
 {
-	return SFLASH_BULK_ERASE();
+	return SFLASH_ERASE(SFLASH_SLOT(0), SFLASH_IMAGE_AREA_END - SFLASH_SLOT(0));
 }
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
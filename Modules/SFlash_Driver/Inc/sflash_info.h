@@ -24,8 +24,8 @@ extern "C" {
 #define SPI_FLASH_PAGE_SIZE                 ((uint16_t) 0x100)         	/*!< Flash page size, in bytes (256) */
 #define SPI_FLASH_PAGES_PER_SECTOR       	((uint16_t) 0x100)			/*!< Number of flash pages in a sector (256) */
 #define SPI_FLASH_SECTORS_CNT               ((uint16_t) 0x20)			/*!< Number of sectors (32) */
-#define SPI_FLASH_SECTOR_SIZE               ((uint32_t) 0x10000)		/*!< Sector size, in bytes (65536) */
-#define SPI_FLASH_SIZE                      ((uint32_t) 0x200000) 		/*!< Flash memory size, in bytes (2097152) */
+#define SPI_FLASH_SECTOR_SIZE               (0x10000UL)					/*!< Sector size, in bytes (65536), no cast to be used in #if */
+#define SPI_FLASH_SIZE                      (0x200000UL) 				/*!< Flash memory size, in bytes (2097152), no cast to be used in #if */
 
 #define SPI_FLASH_PAGE_MASK                 (0xFF)						/*!< Flash page size mask */
 #define SPI_FLASH_TOT_MASK                  (0x1FFFFF)					/*!< Flash memory size mask */
@@ -0,0 +1,120 @@
+/**
+  ******************************************************************************
+  * @file    lzss.h
+  * @author  AMG/IPC Application Team
+  * @brief   Header for LZSS compression/decompression functionalities.
+  *
+  * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+  * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+  * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+  * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+  * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  *******************************************************************************/
+
+#ifndef LZSS_H_
+#define LZSS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Inclusions */
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @defgroup LZSS_Utility Compression and streaming decompression of data (LZSS)
+  * @{
+  */
+
+/* Stream format:
+ * - groups of up to 8 items, each group starts with a flag byte (bit 0 for the first item)
+ * - flag bit set: the item is a literal byte
+ * - flag bit cleared: the item is a 16-bit little endian token, copying (length) bytes found (distance) bytes before
+ *   bits 0-9: distance - 1, bits 10-15: length - LZSS_MATCH_MIN
+ * The stream has no header: the decompressed size is known by the receiver.
+ */
+
+/* Definitions */
+#define LZSS_WINDOW_BITS		10
+#define LZSS_WINDOW_SIZE		(1 << LZSS_WINDOW_BITS)						/* Maximum distance of a match, in bytes */
+#define LZSS_LENGTH_BITS		(16 - LZSS_WINDOW_BITS)
+#define LZSS_MATCH_MIN			3											/* Shorter matches are sent as literals */
+#define LZSS_MATCH_MAX			(LZSS_MATCH_MIN + (1 << LZSS_LENGTH_BITS) - 1)
+
+#define LZSS_HASH_SIZE			1024										/* Number of entries of the hash table of the encoder */
+#define LZSS_GROUP_SIZE			(1 + 8 * sizeof(uint16_t))					/* Maximum size of a group (flag byte and 8 tokens) */
+#define LZSS_ENCODER_BUFFER_SIZE	(2 * LZSS_WINDOW_SIZE + LZSS_MATCH_MAX)		/* History and look-ahead of the encoder */
+#define LZSS_ENCODER_OUTPUT_SIZE	256											/* Output of the encoder is written by chunks of this size */
+
+/* Custom types */
+
+/**
+  * @brief  Callback used to read the input data of the encoder.
+  * @param  context User context.
+  * @param  data Pointer to the buffer to fill.
+  * @param  size Number of bytes to read.
+  * @param  offset Offset of the data to read (from the start of the input).
+  * @retval 'true' if the read operation is successful, 'false' otherwise.
+  */
+typedef bool lzss_input_t(void *context, uint8_t *data, uint32_t size, uint32_t offset);
+
+/**
+  * @brief  Callback used to write the output data of the encoder/decoder.
+  * @param  context User context.
+  * @param  data Pointer to the data to write.
+  * @param  size Number of bytes to write.
+  * @param  offset Offset of the data to write (from the start of the output).
+  * @retval 'true' if the write operation is successful, 'false' otherwise (stops the encoder/decoder).
+  */
+typedef bool lzss_output_t(void *context, const uint8_t *data, uint32_t size, uint32_t offset);
+
+/* Encoder state */
+typedef struct lzss_encoder_str
+{
+	uint8_t			buffer[LZSS_ENCODER_BUFFER_SIZE];	/*!< Input data, from 'buffer_offset' */
+	uint32_t		hash_head[LZSS_HASH_SIZE];			/*!< Last input position (+1) of each 3-byte sequence hash, 0 if none */
+	uint8_t			group[LZSS_GROUP_SIZE];				/*!< Group being built */
+	uint8_t			group_len;
+	uint8_t			group_items;
+	uint8_t			output[LZSS_ENCODER_OUTPUT_SIZE];	/*!< Output data not written yet */
+	uint16_t		output_len;
+	uint32_t		output_size;						/*!< Output data written */
+	lzss_output_t	*output_cb;
+	void			*context;
+} lzss_encoder_t;
+
+/* Decoder state (no dynamic allocation, the window is the only buffer needed) */
+typedef struct lzss_decoder_str
+{
+	uint8_t			window[LZSS_WINDOW_SIZE];			/*!< Last bytes decompressed */
+	uint16_t		window_pos;							/*!< Position of the next byte in the window */
+	uint16_t		flush_pos;							/*!< Position of the first byte of the window not written yet */
+	uint8_t			flags;								/*!< Flags of the remaining items of the current group */
+	uint8_t			flag_count;							/*!< Number of remaining items of the current group */
+	uint8_t			token_low;							/*!< First byte of a token split between two chunks */
+	bool			token_pending;
+	uint32_t		output_size;						/*!< Number of bytes decompressed */
+	uint32_t		output_max;							/*!< Maximum number of bytes to decompress */
+	lzss_output_t	*output_cb;
+	void			*context;
+} lzss_decoder_t;
+
+/* Public functions */
+uint32_t lzss_encode(lzss_encoder_t *encoder, uint32_t input_size, lzss_input_t *input_cb, lzss_output_t *output_cb, void *context);
+
+void     lzss_decoder_init(lzss_decoder_t *decoder, uint32_t output_max, lzss_output_t *output_cb, void *context);
+bool     lzss_decoder_feed(lzss_decoder_t *decoder, const uint8_t *data, uint32_t size);
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LZSS_H_ */
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
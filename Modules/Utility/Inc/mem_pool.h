@@ -61,6 +61,7 @@ void *mem_pool_alloc(const uint32_t mem_size);
 void *mem_pool_free(void *mem_address);
 #endif
 bool mem_pool_check(const void *mem_address);
+bool mem_pool_is_big(const void *mem_address);
 
 /**
   * @}
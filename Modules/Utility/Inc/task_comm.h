@@ -61,6 +61,7 @@ typedef enum msg_type_enum
    BOOT_REKEY_MSG,	/* Messages reserved for the Boot Server module (re-keying) */
    BOOT_CLT_MSG,	/* Messages reserved for the Boot Client module */
    KA_MSG,			/* Messages reserved for the Boot module */
+   BOOT_LOG_MSG,	/* Messages reserved for the Boot module (frame counters in the connected device log) */
    LAST_GASP_MSG,	/* Messages reserved for the Last Gasp module */
    USER_MSG,		/* Messages reserved for the user application */
    SFLASH_MSG,		/* Messages reserved for the SFlash task */
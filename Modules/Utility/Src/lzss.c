@@ -0,0 +1,376 @@
+/**
+  ******************************************************************************
+  * @file    lzss.c
+  * @author  AMG/IPC Application Team
+  * @brief   Source code for LZSS compression/decompression functionalities.
+  *
+  * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+  * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+  * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+  * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+  * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  *******************************************************************************/
+
+/* Inclusions */
+#include <string.h>
+#include <lzss.h>
+
+/** @addgroup LZSS_Utility
+  * @{
+  */
+
+/* Definitions */
+#define LZSS_DISTANCE_MASK		(LZSS_WINDOW_SIZE - 1)
+#define LZSS_HASH(ptr)			((((uint32_t) (ptr)[0] << 6) ^ ((uint32_t) (ptr)[1] << 3) ^ (ptr)[2]) & (LZSS_HASH_SIZE - 1))
+
+#if (LZSS_HASH_SIZE & (LZSS_HASH_SIZE - 1)) != 0
+#error "LZSS_HASH_SIZE must be a power of 2"
+#endif
+
+/* Private functions */
+
+/**
+  * @brief    Writes the output data buffered by the encoder.
+  * @param    [in] encoder Pointer to the encoder state
+  * @return   'true' if the write operation is successful, 'false' otherwise
+  */
+static bool lzss_encoder_flush_output(lzss_encoder_t *encoder)
+{
+    bool result = true;
+
+    if (encoder->output_len > 0)
+    {
+        result = encoder->output_cb(encoder->context, encoder->output, encoder->output_len, encoder->output_size);
+
+        encoder->output_size += encoder->output_len;
+        encoder->output_len = 0;
+    }
+
+    return result;
+}
+
+/**
+  * @brief    Moves the current group to the output buffer of the encoder.
+  * @param    [in] encoder Pointer to the encoder state
+  * @return   'true' if the write operation is successful, 'false' otherwise
+  */
+static bool lzss_encoder_flush_group(lzss_encoder_t *encoder)
+{
+    bool result = true;
+
+    if (encoder->group_items > 0)
+    {
+        if ((encoder->output_len + encoder->group_len) > LZSS_ENCODER_OUTPUT_SIZE)
+        {
+            result = lzss_encoder_flush_output(encoder);
+        }
+
+        memcpy(&encoder->output[encoder->output_len], encoder->group, encoder->group_len);
+        encoder->output_len += encoder->group_len;
+
+        encoder->group[0]    = 0;
+        encoder->group_len   = 1;
+        encoder->group_items = 0;
+    }
+
+    return result;
+}
+
+/**
+  * @brief    Adds a literal or a match to the current group.
+  * @param    [in] encoder Pointer to the encoder state
+  * @param    [in] literal Literal byte (used if length is 0)
+  * @param    [in] distance Distance of the match
+  * @param    [in] length Length of the match (0 for a literal)
+  * @return   'true' if the write operation is successful, 'false' otherwise
+  */
+static bool lzss_encoder_put(lzss_encoder_t *encoder, uint8_t literal, uint32_t distance, uint32_t length)
+{
+    bool result = true;
+
+    if (length == 0)
+    {
+        encoder->group[0] |= (1U << encoder->group_items);
+        encoder->group[encoder->group_len++] = literal;
+    }
+    else
+    {
+        uint16_t token = ((distance - 1) & LZSS_DISTANCE_MASK) | ((length - LZSS_MATCH_MIN) << LZSS_WINDOW_BITS);
+
+        encoder->group[encoder->group_len++] = token & 0xFF;
+        encoder->group[encoder->group_len++] = token >> 8;
+    }
+
+    if (++encoder->group_items == 8)
+    {
+        result = lzss_encoder_flush_group(encoder);
+    }
+
+    return result;
+}
+
+/**
+  * @brief    Writes the bytes of the window decompressed since the last write to the output.
+  * @param    [in] decoder Pointer to the decoder state
+  * @return   'true' if the write operation is successful, 'false' otherwise
+  */
+static bool lzss_decoder_flush(lzss_decoder_t *decoder)
+{
+    bool result = true;
+
+    if (decoder->window_pos > decoder->flush_pos)
+    {
+        uint32_t size = decoder->window_pos - decoder->flush_pos;
+
+        result = decoder->output_cb(decoder->context, &decoder->window[decoder->flush_pos], size, decoder->output_size - size);
+
+        decoder->flush_pos = decoder->window_pos;
+    }
+
+    return result;
+}
+
+/**
+  * @brief    Writes a decompressed byte in the window, writing the window to the output when it is full.
+  * @param    [in] decoder Pointer to the decoder state
+  * @param    [in] byte Decompressed byte
+  * @return   'true' if the byte is accepted, 'false' if the output is full or the write operation failed
+  */
+static bool lzss_decoder_put(lzss_decoder_t *decoder, uint8_t byte)
+{
+    bool result = false;
+
+    if (decoder->output_size < decoder->output_max)
+    {
+        decoder->window[decoder->window_pos++] = byte;
+        decoder->output_size++;
+
+        result = true;
+
+        if (decoder->window_pos == LZSS_WINDOW_SIZE)
+        {
+            result = lzss_decoder_flush(decoder);
+
+            decoder->window_pos = 0;
+            decoder->flush_pos  = 0;
+        }
+    }
+
+    return result;
+}
+
+/* Public functions */
+
+/**
+  * @brief    Compresses data, reading the input and writing the output by chunks.
+  * @param    [in] encoder Pointer to the encoder state (no initialization needed)
+  * @param    [in] input_size Size of the input data
+  * @param    [in] input_cb Callback used to read the input data
+  * @param    [in] output_cb Callback used to write the output data
+  * @param    [in] context User context, passed to the callbacks
+  * @return   The size of the compressed data, 0 if a callback failed
+  */
+uint32_t lzss_encode(lzss_encoder_t *encoder, uint32_t input_size, lzss_input_t *input_cb, lzss_output_t *output_cb, void *context)
+{
+    bool     result = true;
+    uint32_t buffer_offset = 0;     /* Input position of buffer[0] */
+    uint32_t buffer_len    = 0;     /* Input bytes in the buffer */
+    uint32_t position      = 0;     /* Input position being encoded */
+
+    memset(encoder->hash_head, 0, sizeof(encoder->hash_head));
+
+    encoder->group[0]    = 0;
+    encoder->group_len   = 1;
+    encoder->group_items = 0;
+    encoder->output_len  = 0;
+    encoder->output_size = 0;
+    encoder->output_cb   = output_cb;
+    encoder->context     = context;
+
+    while (result && (position < input_size))
+    {
+        /* Refills the look-ahead, keeping a full window of history */
+        if (((position - buffer_offset + LZSS_MATCH_MAX) > buffer_len) && ((buffer_offset + buffer_len) < input_size))
+        {
+            if ((position - buffer_offset) > LZSS_WINDOW_SIZE)
+            {
+                uint32_t shift = position - buffer_offset - LZSS_WINDOW_SIZE;
+
+                memmove(encoder->buffer, &encoder->buffer[shift], buffer_len - shift);
+                buffer_offset += shift;
+                buffer_len    -= shift;
+            }
+
+            uint32_t read_len = LZSS_ENCODER_BUFFER_SIZE - buffer_len;
+
+            if (read_len > (input_size - buffer_offset - buffer_len))
+            {
+                read_len = input_size - buffer_offset - buffer_len;
+            }
+
+            result = input_cb(context, &encoder->buffer[buffer_len], read_len, buffer_offset + buffer_len);
+            buffer_len += read_len;
+
+            if (!result)
+            {
+                break;
+            }
+        }
+
+        uint8_t  *current    = &encoder->buffer[position - buffer_offset];
+        uint32_t available   = buffer_offset + buffer_len - position;
+        uint32_t best_len    = 0;
+        uint32_t best_dist   = 0;
+
+        if (available > LZSS_MATCH_MAX)
+        {
+            available = LZSS_MATCH_MAX;
+        }
+
+        if (available >= LZSS_MATCH_MIN)
+        {
+            uint32_t hash      = LZSS_HASH(current);
+            uint32_t candidate = encoder->hash_head[hash];
+
+            /* Single candidate: the last position with the same hash, if still in the window */
+            if ((candidate > 0) && ((candidate - 1) >= buffer_offset) && ((position - (candidate - 1)) <= LZSS_WINDOW_SIZE))
+            {
+                uint8_t *match = &encoder->buffer[candidate - 1 - buffer_offset];
+
+                while ((best_len < available) && (match[best_len] == current[best_len]))
+                {
+                    best_len++;
+                }
+
+                best_dist = position - (candidate - 1);
+            }
+
+            encoder->hash_head[hash] = position + 1;
+        }
+
+        if (best_len >= LZSS_MATCH_MIN)
+        {
+            result = lzss_encoder_put(encoder, 0, best_dist, best_len);
+
+            /* Inserts the positions covered by the match */
+            for (uint32_t i = 1; i < best_len; i++)
+            {
+                if ((position + i + LZSS_MATCH_MIN) <= (buffer_offset + buffer_len))
+                {
+                    encoder->hash_head[LZSS_HASH(&current[i])] = position + i + 1;
+                }
+            }
+
+            position += best_len;
+        }
+        else
+        {
+            result = lzss_encoder_put(encoder, *current, 0, 0);
+
+            position++;
+        }
+    }
+
+    if (result)
+    {
+        result = lzss_encoder_flush_group(encoder);
+    }
+
+    if (result)
+    {
+        result = lzss_encoder_flush_output(encoder);
+    }
+
+    return (result) ? encoder->output_size : 0;
+}
+
+/**
+  * @brief    Initializes the decoder state for a new stream.
+  * @param    [in] decoder Pointer to the decoder state
+  * @param    [in] output_max Maximum number of bytes to decompress (size of the original data)
+  * @param    [in] output_cb Callback used to write the decompressed data (by chunks of up to LZSS_WINDOW_SIZE bytes)
+  * @param    [in] context User context, passed to the callback
+  * @return   None
+  */
+void lzss_decoder_init(lzss_decoder_t *decoder, uint32_t output_max, lzss_output_t *output_cb, void *context)
+{
+    decoder->window_pos    = 0;
+    decoder->flush_pos     = 0;
+    decoder->flags         = 0;
+    decoder->flag_count    = 0;
+    decoder->token_low     = 0;
+    decoder->token_pending = false;
+    decoder->output_size   = 0;
+    decoder->output_max    = output_max;
+    decoder->output_cb     = output_cb;
+    decoder->context       = context;
+}
+
+/**
+  * @brief    Decompresses the next chunk of the stream. Chunks can be split at any byte.
+  * @param    [in] decoder Pointer to the decoder state
+  * @param    [in] data Pointer to the chunk of the stream
+  * @param    [in] size Size of the chunk
+  * @return   'true' if the chunk is decompressed and written, 'false' if the stream is corrupted or a write operation failed
+  */
+bool lzss_decoder_feed(lzss_decoder_t *decoder, const uint8_t *data, uint32_t size)
+{
+    bool result = true;
+
+    for (uint32_t i = 0; result && (i < size); i++)
+    {
+        if (decoder->flag_count == 0)
+        {
+            decoder->flags      = data[i];
+            decoder->flag_count = 8;
+        }
+        else if (decoder->flags & 0x01)
+        {
+            result = lzss_decoder_put(decoder, data[i]);
+
+            decoder->flags >>= 1;
+            decoder->flag_count--;
+        }
+        else if (!decoder->token_pending)
+        {
+            decoder->token_low     = data[i];
+            decoder->token_pending = true;
+        }
+        else
+        {
+            uint16_t token    = decoder->token_low | ((uint16_t) data[i] << 8);
+            uint32_t distance = (token & LZSS_DISTANCE_MASK) + 1;
+            uint32_t length   = (token >> LZSS_WINDOW_BITS) + LZSS_MATCH_MIN;
+
+            if (distance > decoder->output_size)
+            {
+                /* Refers to data before the start of the stream */
+                result = false;
+            }
+
+            for (uint32_t j = 0; result && (j < length); j++)
+            {
+                result = lzss_decoder_put(decoder, decoder->window[(decoder->window_pos - distance) & LZSS_DISTANCE_MASK]);
+            }
+
+            decoder->token_pending = false;
+            decoder->flags >>= 1;
+            decoder->flag_count--;
+        }
+    }
+
+    if (result)
+    {
+        result = lzss_decoder_flush(decoder);
+    }
+
+    return result;
+}
+
+/**
+  * @}
+  */
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -371,6 +371,18 @@ bool mem_pool_check(const void *mem_address)
 	return mem_pool_is_block(block);
 }
 
+/**
+  * @brief    This function is used to check if a memory block buffer belongs to the big pools.
+  * @param    [in] mem_address Address of the memory block buffer to check.
+  * @return   True if the buffer is in a big pool, false otherwise.
+  */
+bool mem_pool_is_big(const void *mem_address)
+{
+	const uint8_t *address = mem_address;
+
+	return ((address >= (const uint8_t*) &mem_pool.big[0]) && (address < (const uint8_t*) &mem_pool.big[MEM_BLOCK_NUM_BIG]));
+}
+
 #pragma GCC pop_options
 
 /**
@@ -16,6 +16,7 @@
 #include "usart.h"
 #include "spi.h"
 #include <main.h>
+#include <utils.h>
 #include <modbus.h>
 #include <host_if.h>
 #include <user_if.h>
@@ -26,7 +27,12 @@
 #include <user_g3_common.h>
 #include <user_image_transfer.h>
 #include <user_mac.h>
+#include <user_poll.h>
+#include <user_bench.h>
 #include <user_terminal.h>
+#if USE_SD_SPI_DMA
+#include <user_diskio_spi.h>
+#endif
 
 /* Definitions */
 #define DEFAULT_TEST_MSG_NUMBER		10
@@ -72,7 +78,11 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
 	if (huart->Instance == huartHostIf.Instance)
 	{
-		host_if_tx_handler();
+		/* Before the OS start, the Host IF is only used by the image download (no handler needed) */
+		if (OS_IS_ACTIVE())
+		{
+			host_if_tx_handler();
+		}
 	}
 	else if (huart->Instance == huartUserIf.Instance)
 	{
@@ -121,6 +131,13 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
   */
 void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
 {
+#if USE_SD_SPI_DMA
+	if (USER_SPI_TransferCplt(hspi))
+	{
+		/* Block transfer of the uSD card driver, its task is already unblocked */
+	}
+	else
+#endif
 	if (hspi->Instance == hspiSFlash.Instance)
 	{
 		/* Unblocks the task that requested the SPI transfer */
@@ -128,6 +145,20 @@ void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
 	}
 }
 
+#if USE_SD_SPI_DMA
+/**
+  * @brief  Tx Transfer completed callback.
+  * @param  hspi pointer to a SPI_HandleTypeDef structure that contains
+  *               the configuration information for SPI module.
+  * @retval None
+  */
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+	/* Only the uSD card driver uses transmit-only transfers */
+	USER_SPI_TransferCplt(hspi);
+}
+#endif
+
 /**
   * @brief  EXTI line detection callback.
   * @param  GPIO_Pin Specifies the port pin connected to corresponding EXTI line.
@@ -142,6 +173,18 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 
 }
 
+#if !IS_COORD && ENABLE_LAST_GASP && ENABLE_LAST_GASP_PVD
+/**
+  * @brief  PVD callback, the supply voltage dropped below the configured level.
+  * @param  None
+  * @retval None
+  */
+void HAL_PWR_PVDCallback(void)
+{
+	g3_app_last_gasp_start();
+}
+#endif
+
 /**
   * @brief  SPI error callback.
   * @param  hspi pointer to a SPI_HandleTypeDef structure that contains
@@ -228,6 +271,30 @@ void transferTimerCallback(void *argument)
 }
 #endif
 
+#if IS_COORD && ENABLE_METER_POLLING
+/**
+  * @brief Callback wrapper function for the pollTimer FreeRTOStimer.
+  * @param argument Passed argument.
+  * @retval None
+  */
+void pollTimerCallback(void *argument)
+{
+	UserPoll_TimeoutCallback(argument);
+}
+#endif
+
+#if ENABLE_BENCHMARK
+/**
+  * @brief Callback wrapper function for the benchTimer FreeRTOStimer.
+  * @param argument Passed argument.
+  * @retval None
+  */
+void benchTimerCallback(void *argument)
+{
+	UserBench_TimeoutCallback(argument);
+}
+#endif
+
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST
 /**
   * @brief Callback wrapper function for the serverTimer FreeRTOStimer.
@@ -240,6 +307,30 @@ void serverTimerCallback(void *argument)
 }
 #endif
 
+#if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+/**
+  * @brief Callback wrapper function for the counterTimer FreeRTOStimer.
+  * @param argument Passed argument.
+  * @retval None
+  */
+void counterTimerCallback(void *argument)
+{
+	g3_app_boot_counter_timeoutCallback(argument);
+}
+#endif
+
+#if IS_COORD && ENABLE_LAST_GASP
+/**
+  * @brief Callback wrapper function for the lastGaspTimer FreeRTOStimer.
+  * @param argument Passed argument.
+  * @retval None
+  */
+void lastGaspTimerCallback(void *argument)
+{
+	g3_app_last_gasp_timer_callback(argument);
+}
+#endif
+
 /**
   * @}
   */
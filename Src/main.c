@@ -108,13 +108,25 @@ int main(void)
 
 	mem_pool_init();
 
-#if RESET_AT_START
-	/* Put ST8500 under reset  */
-	assertResetOnST8500();
-#endif /* RESET_AT_START */
-
 	/* Reads the boot mode for ST8500 */
 	bool download_requested    = (readBootModeST8500() == ST8500_BOOT_FROM_UART);
+	bool st8500_running        = false;
+
+#if ENABLE_DOWNLOAD && ENABLE_DOWNLOAD_SKIP
+	/* After a reset of the host only, the ST8500 may still run the images to download */
+	if (download_requested == true)
+	{
+		st8500_running = checkImagesRunningOnST8500();
+	}
+#endif /* ENABLE_DOWNLOAD && ENABLE_DOWNLOAD_SKIP */
+
+#if RESET_AT_START
+	if (st8500_running == false)
+	{
+		/* Put ST8500 under reset  */
+		assertResetOnST8500();
+	}
+#endif /* RESET_AT_START */
 
 #if ENABLE_LPMODE
 	GPIO_InitTypeDef GPIO_InitStruct = IN_PIN_STR(ST8500_LPMODE_Pin);
@@ -124,26 +136,30 @@ int main(void)
 	/* Sets the BOOT pins as output and sets their value, according to the boot modes */
 	setBootPinsAsOutput(download_requested);
 #if RESET_AT_START
-	/* Wait for the GPIO to stabilize */
-	utils_delay_ms(RESET_PULSE_DURATION);
-
-	/* Releases ST8500 reset and loads its images */
-	deassertResetOnST8500();
+	if (st8500_running == false)
+	{
+		/* Wait for the GPIO to stabilize */
+		utils_delay_ms(RESET_PULSE_DURATION);
 
+		/* Releases ST8500 reset and loads its images */
+		deassertResetOnST8500();
+	}
 #endif /* RESET_AT_START */
+	setBootPhaseEnd(BOOT_PHASE_RESET);
 
 #if ENABLE_DOWNLOAD
 	/* If the ST8500 boots from UART, downloads the image */
-	if (download_requested == true)
+	if ((download_requested == true) && (st8500_running == false))
 	{
 		/* Downloads both the PE and RTE the images to ST8500 */
 		downloadImageToST8500();
 	}
-	else
+	else if (download_requested == false)
 	{
 		PRINT(RESET_DISPLAY_STRING);
 	}
 #endif /* ENABLE_DOWNLOAD */
+	setBootPhaseEnd(BOOT_PHASE_DOWNLOAD);
 	passthrough_mode();
 
   /* USER CODE END 2 */
@@ -178,6 +178,9 @@ typedef StaticEventGroup_t osStaticEventGroupDef_t;
 
 /* Mutexes */
 ALLOC_STATIC_MUTEX(mutexPrint);
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+ALLOC_STATIC_MUTEX(mutexAccessList);
+#endif
 
 /* Semaphores */
 ALLOC_STATIC_SEMAPHORE(semHostIfTxComplete);
@@ -185,6 +188,12 @@ ALLOC_STATIC_SEMAPHORE(semUserIfTxComplete);
 ALLOC_STATIC_SEMAPHORE(semStartPrint);
 ALLOC_STATIC_SEMAPHORE(semConfirmation);
 ALLOC_STATIC_SEMAPHORE(semSPI);
+#if ENABLE_HIF_CAPTURE
+ALLOC_STATIC_SEMAPHORE(semHifCapture);
+#endif
+#if ENABLE_MODBUS_GATEWAY && !IS_COORD
+ALLOC_STATIC_SEMAPHORE(semModbusGw);
+#endif
 
 /* Timers */
 
@@ -196,6 +205,12 @@ ALLOC_STATIC_TIMER(kaTimer);
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST
 ALLOC_STATIC_TIMER(serverTimer);
 #endif
+#if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+ALLOC_STATIC_TIMER(counterTimer);
+#endif
+#if IS_COORD && ENABLE_LAST_GASP
+ALLOC_STATIC_TIMER(lastGaspTimer);
+#endif
 
 /* User timers */
 ALLOC_STATIC_TIMER(commTimer);
@@ -203,6 +218,12 @@ ALLOC_STATIC_TIMER(userTimeoutTimer);
 #if ENABLE_IMAGE_TRANSFER
 ALLOC_STATIC_TIMER(transferTimer);
 #endif
+#if IS_COORD && ENABLE_METER_POLLING
+ALLOC_STATIC_TIMER(pollTimer);
+#endif
+#if ENABLE_BENCHMARK
+ALLOC_STATIC_TIMER(benchTimer);
+#endif
 
 /* Queues */
 ALLOC_STATIC_QUEUE(host_if_queue,	HOST_IF_QUEUE_LENGTH,	HOST_IF_QUEUE_SIZE);
@@ -216,6 +237,12 @@ ALLOC_STATIC_THREAD(print_task,		PRINT_TASK_STACK_SIZE,		osPriorityLow);
 ALLOC_STATIC_THREAD(sflash_task,	SFLASH_TASK_STACK_SIZE,		osPriorityBelowNormal);
 ALLOC_STATIC_THREAD(g3_task,		G3_TASK_STACK_SIZE, 		osPriorityAboveNormal);
 ALLOC_STATIC_THREAD(user_task,		USER_TASK_STACK_SIZE,		osPriorityNormal);
+#if ENABLE_HIF_CAPTURE
+ALLOC_STATIC_THREAD(hif_capture_task,	HIF_CAPTURE_TASK_STACK_SIZE,	osPriorityLow);
+#endif
+#if ENABLE_MODBUS_GATEWAY && !IS_COORD
+ALLOC_STATIC_THREAD(modbus_gw_task,	MODBUS_GW_TASK_STACK_SIZE,	osPriorityBelowNormal);
+#endif
 
 /* Event Flags */
 ALLOC_STATIC_EVENT_FLAG(eventSync);
@@ -233,6 +260,12 @@ extern void start_print_task(void *argument);
 extern void start_g3_task(void *argument);
 extern void start_user_task(void *argument);
 extern void start_sflash_task(void *argument);
+#if ENABLE_HIF_CAPTURE
+extern void start_hif_capture_task(void *argument);
+#endif
+#if ENABLE_MODBUS_GATEWAY && !IS_COORD
+extern void start_modbus_gw_task(void *argument);
+#endif
 
 /* Callbacks */
 
@@ -244,6 +277,12 @@ extern void kaTimerCallback(void *argument);
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST
 extern void serverTimerCallback(void *argument);
 #endif
+#if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+extern void counterTimerCallback(void *argument);
+#endif
+#if IS_COORD && ENABLE_LAST_GASP
+extern void lastGaspTimerCallback(void *argument);
+#endif
 
 /* User timers */
 extern void commTimerCallback(void *argument);
@@ -251,6 +290,12 @@ extern void userTimeoutTimerCallback(void *argument);
 #if ENABLE_IMAGE_TRANSFER
 extern void transferTimerCallback(void *argument);
 #endif
+#if IS_COORD && ENABLE_METER_POLLING
+extern void pollTimerCallback(void *argument);
+#endif
+#if ENABLE_BENCHMARK
+extern void benchTimerCallback(void *argument);
+#endif
 
 /* Public functions */
 
@@ -263,12 +308,21 @@ void FreeRTOS_DefaultInit(void)
 {
 	/* Mutexes */
 	CREATE_STATIC_MUTEX(mutexPrint);
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+	CREATE_STATIC_MUTEX(mutexAccessList);
+#endif
 
 	/* Semaphores */
 	CREATE_STATIC_BINARY_SEMAPHORE(semHostIfTxComplete, BINARY_SEM_FREE_AT_STARTUP);	/* Must start with count = 1 */
 	CREATE_STATIC_BINARY_SEMAPHORE(semUserIfTxComplete, BINARY_SEM_BUSY_AT_STARTUP);	/* Must start with count = 0 */
 	CREATE_STATIC_BINARY_SEMAPHORE(semStartPrint, 		BINARY_SEM_BUSY_AT_STARTUP);	/* Must start with count = 0 */
 	CREATE_STATIC_BINARY_SEMAPHORE(semSPI, 				BINARY_SEM_BUSY_AT_STARTUP);	/* Must start with count = 0 */
+#if ENABLE_HIF_CAPTURE
+	CREATE_STATIC_BINARY_SEMAPHORE(semHifCapture,		BINARY_SEM_BUSY_AT_STARTUP);	/* Must start with count = 0 */
+#endif
+#if ENABLE_MODBUS_GATEWAY && !IS_COORD
+	CREATE_STATIC_BINARY_SEMAPHORE(semModbusGw,		BINARY_SEM_BUSY_AT_STARTUP);	/* Must start with count = 0 */
+#endif
 
 	CREATE_STATIC_COUNTING_SEMAPHORE(semConfirmation, 	CONFIRMATION_SEMAPHORE_COUNT, CONFIRMATION_SEMAPHORE_COUNT);	/* Must start with count = 2 */
 
@@ -282,9 +336,21 @@ void FreeRTOS_DefaultInit(void)
 #if ENABLE_IMAGE_TRANSFER
 	CREATE_STATIC_TIMER(transferTimer,		osTimerOnce);
 #endif
+#if IS_COORD && ENABLE_METER_POLLING
+	CREATE_STATIC_TIMER(pollTimer,			osTimerOnce);
+#endif
+#if ENABLE_BENCHMARK
+	CREATE_STATIC_TIMER(benchTimer,			osTimerOnce);
+#endif
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST
 	CREATE_STATIC_TIMER(serverTimer,		osTimerOnce);
 #endif
+#if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_DEVICE_TABLE_RESTORE
+	CREATE_STATIC_TIMER(counterTimer,		osTimerPeriodic);
+#endif
+#if IS_COORD && ENABLE_LAST_GASP
+	CREATE_STATIC_TIMER(lastGaspTimer,		osTimerOnce);
+#endif
 
 	/* Queues */
 	CREATE_STATIC_QUEUE(host_if_queue,	HOST_IF_QUEUE_LENGTH,	HOST_IF_QUEUE_SIZE);
@@ -298,6 +364,12 @@ void FreeRTOS_DefaultInit(void)
 	CREATE_STATIC_THREAD(sflash_task,	start_sflash_task);
 	CREATE_STATIC_THREAD(g3_task, 		start_g3_task);
 	CREATE_STATIC_THREAD(user_task, 	start_user_task);
+#if ENABLE_HIF_CAPTURE
+	CREATE_STATIC_THREAD(hif_capture_task,	start_hif_capture_task);
+#endif
+#if ENABLE_MODBUS_GATEWAY && !IS_COORD
+	CREATE_STATIC_THREAD(modbus_gw_task,	start_modbus_gw_task);
+#endif
 
 	/* Event Flags */
 	CREATE_STATIC_EVENT_FLAGS(eventSync);
@@ -23,6 +23,8 @@
 #include <user_task.h>
 #include <print_task.h>
 #include <sflash_task.h>
+#include <host_if_capture.h>
+#include <user_modbus_gw.h>
 
 /* Definitions */
 
@@ -32,9 +34,14 @@
 #define SFLASH_TASK_BIT 		(1 << 2)
 #define G3_TASK_BIT 			(1 << 3)
 #define USER_TASK_BIT 			(1 << 4)
+#define HIF_CAPTURE_TASK_BIT 	(1 << 5)
 
 /* Task synchronization bitmask */
+#if ENABLE_HIF_CAPTURE
+#define ALL_TASKS_BITS			(HOST_IF_TASK_BIT | PRINT_TASK_BIT | G3_TASK_BIT | USER_TASK_BIT | SFLASH_TASK_BIT | HIF_CAPTURE_TASK_BIT)
+#else
 #define ALL_TASKS_BITS			(HOST_IF_TASK_BIT | PRINT_TASK_BIT | G3_TASK_BIT | USER_TASK_BIT | SFLASH_TASK_BIT)
+#endif
 
 /* Custom types */
 
@@ -179,4 +186,41 @@ void start_user_task(void *argument)
 	user_app_exec();
 }
 
+#if ENABLE_HIF_CAPTURE
+/**
+* @brief Function implementing the hif_capture_task thread.
+* @param argument: Not used
+* @retval None
+*/
+void start_hif_capture_task(void *argument)
+{
+	UNUSED(argument);
+
+	/* HIF capture context initialization */
+	hif_capture_init();
+
+	/* Task synchronization */
+	osEventFlagsSet(eventSyncHandle, HIF_CAPTURE_TASK_BIT);
+	osEventFlagsWait(eventSyncHandle, ALL_TASKS_BITS, osFlagsWaitAll | osFlagsNoClear, osWaitForever);
+
+	/* HIF capture task */
+	hif_capture_exec();
+}
+#endif
+
+#if ENABLE_MODBUS_GATEWAY && !IS_COORD
+/**
+* @brief Function implementing the modbus_gw_task thread.
+* @param argument: Not used
+* @retval None
+*/
+void start_modbus_gw_task(void *argument)
+{
+	UNUSED(argument);
+
+	/* Modbus gateway task, it waits for the batches handed over by the User task (no synchronization needed) */
+	UserModbusGw_TaskExec();
+}
+#endif
+
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
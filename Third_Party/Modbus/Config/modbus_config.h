@@ -18,10 +18,13 @@
 /* Set to 1 the following line to enable support for Modbus RTU USART DMA mode. */
 #define ENABLE_MODBUS_USART_DMA 	0
 
-#define T35  			5       // Timer T35 period (in ticks) for end frame detection.
+/* Set to 1 the following line to merge the queued reads of adjacent/overlapping registers or coils of a slave into a single query (master only). */
+#define ENABLE_MODBUS_COALESCING	1
+
+#define T35  			5       // Timer T35 period (in ticks) for end frame detection, adapted to the baud rate by ModbusStart.
 #define MAX_BUFFER  	128	    // Maximum size for the communication buffer in bytes.
 #define TIMEOUT_MODBUS 	1000 	// Timeout for master query (in ticks)
 #define MAX_M_HANDLERS 	1    	// Maximum number of modbus handlers that can work concurrently
-#define MAX_TELEGRAMS 	2     	// Max number of Telegrams in master queue
+#define MAX_TELEGRAMS 	8     	// Max number of Telegrams in master queue
 
 #endif /* MODBUS_CONFIG_H_ */
@@ -25,6 +25,13 @@
 #include "timers.h"
 #include "main.h"
 
+#if ENABLE_MODBUS_COALESCING
+/* Limits of a merged read: the protocol limits, reduced to what fits in the communication buffer (ID, function code, byte count and CRC take 5 bytes) */
+#define MAX_MERGED_REGS		(((MAX_BUFFER - 5) / 2) < 125 ? ((MAX_BUFFER - 5) / 2) : 125)
+#define MAX_MERGED_COILS	(((MAX_BUFFER - 5) * 8) < 2000 ? ((MAX_BUFFER - 5) * 8) : 2000)
+#define MAX_MERGED_WORDS	((MAX_BUFFER - 4) / 2)	// Words of the memory image of a merged read (coils are packed 16 per word)
+#endif
+
 
 typedef enum
 {
@@ -146,6 +153,7 @@ typedef struct
     uint16_t u16CoilsNo;   		/*!< Number of coils or registers to access */
     uint16_t *u16reg;     		/*!< Pointer to memory image in master */
     uint32_t *u32CurrentTask; 	/*!< Pointer to the task that will receive notifications from Modbus */
+    uint32_t *u32Result;		/*!< Pointer to the result of the query, the task is then notified with xTaskNotifyGive. NULL: the result is the notification value */
 } modbus_t;
 
 /**
@@ -195,9 +203,33 @@ typedef struct modbusHandler_str
 	// type of hardware  TCP, USB CDC, USART
 	mb_hardware_t xTypeHW;
 
+	// CRC of the bytes received so far (USART_HW), and of the whole last frame (0 if valid)
+	uint16_t u16RxCRC;
+	uint16_t u16FrameCRC;
+
+#if ENABLE_MODBUS_USART_DMA
+	// the frame received by DMA in u8Buffer was processed, the reception must be restarted
+	bool bRxRestart;
+#endif
+
+#if ENABLE_MODBUS_COALESCING
+	// Telegrams taken from the queue and not sent yet (master only)
+	modbus_t xBatch[MAX_TELEGRAMS];
+	uint8_t u8BatchSize;
+
+	// Telegrams answered by the query in progress, when merged (master only)
+	modbus_t xMerged[MAX_TELEGRAMS];
+	uint8_t u8MergedNo;
+	uint8_t u8NoMergeCnt; // number of queries sent without merging, after a merged query failed with an exception
+	uint16_t u16MergeRegs[MAX_MERGED_WORDS]; // memory image of a merged read
+	uint16_t u16MergedCnt; // keep statistics of the telegrams served by a merged query
+#endif
+
 } modbusHandler_t;
 
 
+#define MB_CRC_INIT		0xFFFF	// Initial value of the CRC-16/Modbus
+
 enum
 {
     RESPONSE_SIZE = 6,
@@ -222,6 +254,7 @@ void ModbusQueryInject(modbusHandler_t * modH, modbus_t telegram); //put a query
 void StartTaskModbusSlave(void *argument); //slave
 void StartTaskModbusMaster(void *argument); //master
 uint16_t calcCRC(uint8_t *Buffer, uint8_t u8length);
+uint16_t calcCRCUpdate(uint16_t u16crc, const uint8_t *Buffer, uint16_t u16length); // incremental crc, starting from MB_CRC_INIT
 
 //Function prototypes for ModbusRingBuffer
 void RingAdd(modbusRingBuffer_t *xRingBuffer, uint8_t u8Val); // adds a byte to the ring buffer
@@ -20,6 +20,7 @@
 #include "semphr.h"
 #include "modbus.h"
 #include "settings.h"
+#include <string.h>
 
 #if ENABLE_MODBUS
 
@@ -102,26 +103,40 @@ void TimerT35Callback(TimerHandle_t *timer_handle);
 void TimerTimeoutCallback(TimerHandle_t *timer_handle);
 
 static int8_t SendQuery(modbusHandler_t *modH ,  modbus_t telegram);
+#if ENABLE_MODBUS_USART_DMA
+static void   restartRxDMA(modbusHandler_t *modH);
+#endif
+static void   notifyQuery(modbusHandler_t *modH, modbus_t *telegram, uint32_t u32result);
+#if ENABLE_MODBUS_COALESCING
+static void   nextQuery(modbusHandler_t *modH, modbus_t *telegram);
+#endif
 
 
 /* Ring Buffer functions */
 // This function must be called only after disabling USART RX interrupt or inside of the RX interrupt
 void RingAdd(modbusRingBuffer_t *xRingBuffer, uint8_t u8Val)
 {
-
 	xRingBuffer->uxBuffer[xRingBuffer->u8end] = u8Val;
-	xRingBuffer->u8end = (xRingBuffer->u8end + 1) % MAX_BUFFER;
+
+	if (++xRingBuffer->u8end == MAX_BUFFER)
+	{
+		xRingBuffer->u8end = 0;
+	}
+
 	if (xRingBuffer->u8available == MAX_BUFFER)
 	{
 		xRingBuffer->overflow = true;
-		xRingBuffer->u8start = (xRingBuffer->u8start + 1) % MAX_BUFFER;
+
+		if (++xRingBuffer->u8start == MAX_BUFFER)
+		{
+			xRingBuffer->u8start = 0;
+		}
 	}
 	else
 	{
 		xRingBuffer->overflow = false;
 		xRingBuffer->u8available++;
 	}
-
 }
 
 // This function must be called only after disabling USART RX interrupt
@@ -133,18 +148,30 @@ uint8_t RingGetAllBytes(modbusRingBuffer_t *xRingBuffer, uint8_t *buffer)
 // This function must be called only after disabling USART RX interrupt
 uint8_t RingGetNBytes(modbusRingBuffer_t *xRingBuffer, uint8_t *buffer, uint8_t uNumber)
 {
-	uint8_t uCounter;
+	uint8_t uCounter, uSlice;
 	if(xRingBuffer->u8available == 0  || uNumber == 0 ) return 0;
 	if(uNumber > MAX_BUFFER) return 0;
 
-	for(uCounter = 0; uCounter < uNumber && uCounter< xRingBuffer->u8available ; uCounter++)
+	uCounter = (uNumber < xRingBuffer->u8available) ? uNumber : xRingBuffer->u8available;
+
+	// copy in (at most) two slices: up to the end of the buffer, then from its beginning
+	uSlice = MAX_BUFFER - xRingBuffer->u8start;
+	if (uSlice > uCounter)
+	{
+		uSlice = uCounter;
+	}
+
+	memcpy(buffer, &xRingBuffer->uxBuffer[xRingBuffer->u8start], uSlice);
+	memcpy(&buffer[uSlice], xRingBuffer->uxBuffer, uCounter - uSlice);
+
+	xRingBuffer->u8start = (uSlice < uCounter) ? (uCounter - uSlice) : (xRingBuffer->u8start + uSlice);
+	if (xRingBuffer->u8start == MAX_BUFFER)
 	{
-		buffer[uCounter] = xRingBuffer->uxBuffer[xRingBuffer->u8start];
-		xRingBuffer->u8start = (xRingBuffer->u8start + 1) % MAX_BUFFER;
+		xRingBuffer->u8start = 0;
 	}
+
 	xRingBuffer->u8available = xRingBuffer->u8available - uCounter;
 	xRingBuffer->overflow = false;
-	RingClear(xRingBuffer);
 
 	return uCounter;
 }
@@ -166,6 +193,43 @@ void RingClear(modbusRingBuffer_t *xRingBuffer)
 
 
 
+// CRC-16/Modbus (reflected polynomial 0xA001) of each byte value
+static const uint16_t crcTable[256] =
+{
+	0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+	0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+	0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+	0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+	0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+	0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+	0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+	0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+	0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+	0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+	0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+	0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+	0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+	0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+	0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+	0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+	0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+	0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+	0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+	0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+	0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+	0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+	0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+	0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+	0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+	0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+	0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+	0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+	0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+	0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+	0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+	0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+
 const unsigned char fctsupported[] =
 {
 	MB_FC_READ_COILS,
@@ -194,6 +258,7 @@ void ModbusInit(modbusHandler_t * modH)
 		//Initialize the ring buffer
 
 		RingClear(&modH->xBufferRX);
+		modH->u16RxCRC = MB_CRC_INIT;
 
 		if(modH->uModbusType == MB_SLAVE)
 		{
@@ -297,7 +362,10 @@ void ModbusStart(modbusHandler_t * modH)
 #if ENABLE_MODBUS_USART_DMA
 	if (modH->xTypeHW == USART_HW_DMA)
 	{
-		if (HAL_UARTEx_ReceiveToIdle_DMA(modH->port, modH->xBufferRX.uxBuffer, MAX_BUFFER) != HAL_OK)
+		// frames are received directly in u8Buffer, where they are validated and parsed
+		modH->bRxRestart = false;
+
+		if (HAL_UARTEx_ReceiveToIdle_DMA(modH->port, modH->u8Buffer, MAX_BUFFER) != HAL_OK)
 		{
 			Error_Handler(); //error UART initialization
 		}
@@ -326,8 +394,22 @@ void ModbusStart(modbusHandler_t * modH)
 		Error_Handler(); //error Slave ID must not be zero
 	}
 
+	// end of frame detection after 3.5 characters of 11 bits (1.75 ms above 19200 baud), instead of the fixed T35
+	uint32_t u32t35us = (modH->port->Init.BaudRate > 19200) ? 1750 : ((38500000UL + modH->port->Init.BaudRate - 1) / modH->port->Init.BaudRate);
+	TickType_t xT35 = (TickType_t) (((u32t35us * configTICK_RATE_HZ) + 999999UL) / 1000000UL) + 1; // one more tick, as the first one is partial
+
+	if (xT35 < T35)
+	{
+		xTimerChangePeriod(modH->TimerT35, xT35, 0);
+		xTimerStop(modH->TimerT35, 0); // changing the period starts the timer
+	}
+
 	modH->u8lastRec = modH->u8BufferSize = 0;
 	modH->u16InCnt = modH->u16OutCnt = modH->u16errCnt = 0;
+#if ENABLE_MODBUS_COALESCING
+	modH->u8BatchSize = modH->u8MergedNo = modH->u8NoMergeCnt = 0;
+	modH->u16MergedCnt = 0;
+#endif
 }
 
 /**
@@ -423,6 +505,10 @@ void StartTaskModbusSlave(void *argument)
 	{
 		modH->i8lastError = 0;
 
+#if ENABLE_MODBUS_USART_DMA
+		restartRxDMA(modH);
+#endif
+
 		ulTaskNotifyTake(pdTRUE, portMAX_DELAY); /* Block until a Modbus Frame arrives */
 
 		if (getRxBuffer(modH) == ERR_BUFF_OVERFLOW)
@@ -505,7 +591,7 @@ bool ModbusQuery(modbusHandler_t * modH, modbus_t telegram)
 	if (modH->uModbusType == MB_MASTER)
 	{
 		telegram.u32CurrentTask = (uint32_t *) osThreadGetId();
-		xQueueSendToBack(modH->QueueTelegramHandle, &telegram, 0);
+		success = (xQueueSendToBack(modH->QueueTelegramHandle, &telegram, 0) == pdTRUE);
 	}
 	else
 	{
@@ -654,8 +740,29 @@ void StartTaskModbusMaster(void *argument)
 
 	for(;;)
 	{
+#if ENABLE_MODBUS_USART_DMA
+		restartRxDMA(modH);
+#endif
+
+#if ENABLE_MODBUS_COALESCING
+		if (modH->u8BatchSize == 0)
+		{
+			/* Wait indefinitely for a telegram to send */
+			xQueueReceive(modH->QueueTelegramHandle, &modH->xBatch[0], portMAX_DELAY);
+			modH->u8BatchSize = 1;
+		}
+
+		/* Take the other queued telegrams too, so that the reads can be merged */
+		while ((modH->u8BatchSize < MAX_TELEGRAMS) && (xQueueReceive(modH->QueueTelegramHandle, &modH->xBatch[modH->u8BatchSize], 0) == pdTRUE))
+		{
+			modH->u8BatchSize++;
+		}
+
+		nextQuery(modH, &telegram);
+#else
 		/* Wait indefinitely for a telegram to send */
 		xQueueReceive(modH->QueueTelegramHandle, &telegram, portMAX_DELAY);
+#endif
 
 		/* This is the case for implementations with only USART support */
 		SendQuery(modH, telegram);
@@ -667,10 +774,13 @@ void StartTaskModbusMaster(void *argument)
 		modH->i8lastError = 0;
 		if(ulNotificationValue)
 		{
+#if ENABLE_MODBUS_USART_DMA
+			modH->bRxRestart = true; // drop the bytes of an incomplete answer
+#endif
 			modH->i8state = COM_IDLE;
 			modH->i8lastError = ERR_TIME_OUT;
 			modH->u16errCnt++;
-			xTaskNotify((TaskHandle_t)telegram.u32CurrentTask, modH->i8lastError, eSetValueWithOverwrite);
+			notifyQuery(modH, &telegram, modH->i8lastError);
 			continue;
 		}
 
@@ -681,7 +791,7 @@ void StartTaskModbusMaster(void *argument)
 			modH->i8state = COM_IDLE;
 			modH->i8lastError = ERR_BAD_SIZE;
 			modH->u16errCnt++;
-			xTaskNotify((TaskHandle_t)telegram.u32CurrentTask, modH->i8lastError, eSetValueWithOverwrite);
+			notifyQuery(modH, &telegram, modH->i8lastError);
 			continue;
 		}
 
@@ -694,7 +804,7 @@ void StartTaskModbusMaster(void *argument)
 		{
 			modH->i8state = COM_IDLE;
 			modH->i8lastError = u8exception;
-			xTaskNotify((TaskHandle_t)telegram.u32CurrentTask, modH->i8lastError, eSetValueWithOverwrite);
+			notifyQuery(modH, &telegram, modH->i8lastError);
 			continue;
 		}
 
@@ -728,7 +838,7 @@ void StartTaskModbusMaster(void *argument)
 		if (modH->i8lastError ==0) // no error the error_OK, we need to use a different value than 0 to detect the timeout
 		{
 			osSemaphoreRelease(modH->ModBusSphrHandle); //Release the semaphore
-			xTaskNotify((TaskHandle_t)telegram.u32CurrentTask, ERR_OK_QUERY, eSetValueWithOverwrite);
+			notifyQuery(modH, &telegram, ERR_OK_QUERY);
 		}
 
 
@@ -737,6 +847,198 @@ void StartTaskModbusMaster(void *argument)
 
 }
 
+// Notifies the result of a telegram to the task that queued it
+static void notifyTelegram(modbus_t *telegram, uint32_t u32result)
+{
+	if (telegram->u32Result != NULL)
+	{
+		*telegram->u32Result = u32result;
+		xTaskNotifyGive((TaskHandle_t)telegram->u32CurrentTask);
+	}
+	else
+	{
+		xTaskNotify((TaskHandle_t)telegram->u32CurrentTask, u32result, eSetValueWithOverwrite);
+	}
+}
+
+#if ENABLE_MODBUS_COALESCING
+static bool isReadFct(mb_functioncode_t u8fct)
+{
+	return ((u8fct == MB_FC_READ_COILS) || (u8fct == MB_FC_READ_DISCRETE_INPUT) ||
+			(u8fct == MB_FC_READ_REGISTERS) || (u8fct == MB_FC_READ_INPUT_REGISTER));
+}
+
+static uint16_t mergeLimit(mb_functioncode_t u8fct)
+{
+	return ((u8fct == MB_FC_READ_COILS) || (u8fct == MB_FC_READ_DISCRETE_INPUT)) ? MAX_MERGED_COILS : MAX_MERGED_REGS;
+}
+
+/**
+ * @brief
+ * Copies the part of the answer of a merged read requested by one of its telegrams.
+ *
+ * @param modH  modbus handler
+ * @param merged  merged query
+ * @param member  telegram answered by the merged query
+ */
+static void splitAnswer(modbusHandler_t *modH, const modbus_t *merged, modbus_t *member)
+{
+	uint16_t u16offset = member->u16RegAdd - merged->u16RegAdd;
+
+	if ((member->u8fct == MB_FC_READ_REGISTERS) || (member->u8fct == MB_FC_READ_INPUT_REGISTER))
+	{
+		memcpy(member->u16reg, &modH->u16MergeRegs[u16offset], member->u16CoilsNo * sizeof(uint16_t));
+	}
+	else
+	{
+		// coils are packed 16 per word, the first one in the LSB (see get_FC1)
+		for (uint16_t i = 0; i < member->u16CoilsNo; i++)
+		{
+			uint16_t u16coil = u16offset + i;
+
+			bitWrite(member->u16reg[i / 16], i % 16, bitRead(modH->u16MergeRegs[u16coil / 16], u16coil % 16));
+		}
+	}
+}
+
+/**
+ * @brief
+ * Builds the next query from the telegrams taken from the queue.
+ * The first telegram, if it is a read, is merged with the following reads of the same
+ * function code and slave whose range overlaps or is adjacent to it, up to the protocol limit.
+ * A read is never merged over a write to the same slave, to keep the order of the operations.
+ *
+ * @param modH  modbus handler
+ * @param telegram  query to send
+ */
+static void nextQuery(modbusHandler_t *modH, modbus_t *telegram)
+{
+	bool bTaken[MAX_TELEGRAMS] = { true }; // the first telegram is always sent
+	modbus_t *first = &modH->xBatch[0];
+	uint8_t u8merged = 1;
+
+	*telegram = *first;
+	modH->u8MergedNo = 0;
+
+	if (modH->u8NoMergeCnt > 0)
+	{
+		modH->u8NoMergeCnt--;
+	}
+	else if (isReadFct(first->u8fct))
+	{
+		uint32_t u32start = first->u16RegAdd;
+		uint32_t u32end   = u32start + first->u16CoilsNo;
+		bool bChanged = true;
+
+		modH->xMerged[0] = *first;
+
+		// a telegram can become adjacent to the range only after another one is merged
+		while (bChanged)
+		{
+			bChanged = false;
+
+			for (uint8_t i = 1; i < modH->u8BatchSize; i++)
+			{
+				modbus_t *candidate = &modH->xBatch[i];
+
+				if (candidate->u8id == first->u8id)
+				{
+					if (!isReadFct(candidate->u8fct))
+					{
+						break;
+					}
+
+					uint32_t u32candStart = candidate->u16RegAdd;
+					uint32_t u32candEnd   = u32candStart + candidate->u16CoilsNo;
+					uint32_t u32newStart  = (u32candStart < u32start) ? u32candStart : u32start;
+					uint32_t u32newEnd    = (u32candEnd > u32end) ? u32candEnd : u32end;
+
+					if ((!bTaken[i]) && (candidate->u8fct == first->u8fct) &&
+						(u32candStart <= u32end) && (u32candEnd >= u32start) &&
+						((u32newEnd - u32newStart) <= mergeLimit(first->u8fct)))
+					{
+						u32start = u32newStart;
+						u32end   = u32newEnd;
+
+						modH->xMerged[u8merged++] = *candidate;
+						bTaken[i] = true;
+						bChanged = true;
+					}
+				}
+			}
+		}
+
+		if (u8merged > 1)
+		{
+			telegram->u16RegAdd  = (uint16_t) u32start;
+			telegram->u16CoilsNo = (uint16_t) (u32end - u32start);
+			telegram->u16reg     = modH->u16MergeRegs;
+
+			modH->u8MergedNo = u8merged;
+			modH->u16MergedCnt += u8merged - 1;
+		}
+	}
+
+	// remove the telegrams of the query from the batch, keeping the order of the others
+	uint8_t u8left = 0;
+
+	for (uint8_t i = 0; i < modH->u8BatchSize; i++)
+	{
+		if (!bTaken[i])
+		{
+			modH->xBatch[u8left++] = modH->xBatch[i];
+		}
+	}
+
+	modH->u8BatchSize = u8left;
+}
+#endif
+
+/**
+ * @brief
+ * Notifies the result of a query to the task(s) that made it.
+ * The answer of a merged read is split back into the memory image of each telegram.
+ *
+ * @param modH  modbus handler
+ * @param telegram  query sent
+ * @param u32result  result of the query (ERR_OK_QUERY or error)
+ */
+static void notifyQuery(modbusHandler_t *modH, modbus_t *telegram, uint32_t u32result)
+{
+#if ENABLE_MODBUS_COALESCING
+	if (modH->u8MergedNo > 0)
+	{
+		if ((u32result == ERR_EXCEPTION) && ((modH->u8BatchSize + modH->u8MergedNo) <= MAX_TELEGRAMS))
+		{
+			// the exception may concern only one of the telegrams: they are sent again, one by one
+			memmove(&modH->xBatch[modH->u8MergedNo], &modH->xBatch[0], modH->u8BatchSize * sizeof(modbus_t));
+			memcpy(&modH->xBatch[0], modH->xMerged, modH->u8MergedNo * sizeof(modbus_t));
+
+			modH->u8BatchSize += modH->u8MergedNo;
+			modH->u8NoMergeCnt = modH->u8MergedNo;
+		}
+		else
+		{
+			for (uint8_t i = 0; i < modH->u8MergedNo; i++)
+			{
+				if (u32result == ERR_OK_QUERY)
+				{
+					splitAnswer(modH, telegram, &modH->xMerged[i]);
+				}
+
+				notifyTelegram(&modH->xMerged[i], u32result);
+			}
+		}
+
+		modH->u8MergedNo = 0;
+	}
+	else
+#endif
+	{
+		notifyTelegram(telegram, u32result);
+	}
+}
+
 /**
  * This method processes functions 1 & 2 (for master)
  * This method puts the slave answer into master data buffer
@@ -789,10 +1091,8 @@ void get_FC3(modbusHandler_t *modH)
  */
 uint8_t validateAnswer(modbusHandler_t *modH)
 {
-	// check message crc vs calculated crc
-	uint16_t u16MsgCRC = ((modH->u8Buffer[modH->u8BufferSize - 2] << 8) | modH->u8Buffer[modH->u8BufferSize - 1]); // combine the crc Low & High bytes
-
-	if (calcCRC(modH->u8Buffer,  modH->u8BufferSize-2) != u16MsgCRC)
+	// check message crc: the crc of the whole frame, computed at reception, is 0
+	if (modH->u16FrameCRC != 0)
 	{
 		modH->u16errCnt++;
 
@@ -850,21 +1150,65 @@ int16_t getRxBuffer(modbusHandler_t *modH)
 		RingClear(&modH->xBufferRX); // clean up the overflowed buffer
 		i16result =  ERR_BUFF_OVERFLOW;
 	}
+#if ENABLE_MODBUS_USART_DMA
+	else if (modH->xTypeHW == USART_HW_DMA)
+	{
+		// the frame was received by DMA directly in u8Buffer, no copy is needed
+		modH->u8BufferSize = modH->xBufferRX.u8available;
+		modH->u16FrameCRC = calcCRCUpdate(MB_CRC_INIT, modH->u8Buffer, modH->u8BufferSize);
+		modH->xBufferRX.u8available = 0;
+		modH->u16InCnt++;
+		i16result = modH->u8BufferSize;
+	}
+#endif
 	else
 	{
 		modH->u8BufferSize = RingGetAllBytes(&modH->xBufferRX, modH->u8Buffer);
+		modH->u16FrameCRC = modH->u16RxCRC; // updated byte by byte at reception
 		modH->u16InCnt++;
 		i16result = modH->u8BufferSize;
 	}
 
 	if (modH->xTypeHW == USART_HW)
 	{
+		RingClear(&modH->xBufferRX); // the next frame starts at the beginning of the buffer, with a new crc
+		modH->u16RxCRC = MB_CRC_INIT;
 		HAL_UART_Receive_IT(modH->port, &modH->dataRX, 1);
 	}
+#if ENABLE_MODBUS_USART_DMA
+	else
+	{
+		// the reception is restarted once the frame in u8Buffer is no longer used
+		modH->bRxRestart = true;
+	}
+#endif
 
 	return i16result;
 }
 
+#if ENABLE_MODBUS_USART_DMA
+/**
+ * @brief
+ * This method restarts the DMA reception in u8Buffer, once the last frame received there has been processed.
+ *
+ * @ingroup modH Modbus handler
+ */
+static void restartRxDMA(modbusHandler_t *modH)
+{
+	if ((modH->xTypeHW == USART_HW_DMA) && modH->bRxRestart)
+	{
+		modH->bRxRestart = false;
+
+		while (HAL_UARTEx_ReceiveToIdle_DMA(modH->port, modH->u8Buffer, MAX_BUFFER) != HAL_OK)
+		{
+			HAL_UART_DMAStop(modH->port);
+		}
+
+		__HAL_DMA_DISABLE_IT(modH->port->hdmarx, DMA_IT_HT); // we don't need half-transfer interrupt
+	}
+}
+#endif
+
 /**
  * @brief
  * This method validates slave incoming messages
@@ -874,10 +1218,8 @@ int16_t getRxBuffer(modbusHandler_t *modH)
  */
 uint8_t validateRequest(modbusHandler_t *modH)
 {
-	// check message crc vs calculated crc
-	uint16_t u16MsgCRC= ((modH->u8Buffer[modH->u8BufferSize - 2] << 8) | modH->u8Buffer[modH->u8BufferSize - 1]); // combine the crc Low & High bytes
-
-	if ( calcCRC( modH->u8Buffer,  modH->u8BufferSize-2 ) != u16MsgCRC )
+	// check message crc: the crc of the whole frame, computed at reception, is 0
+	if (modH->u16FrameCRC != 0)
 	{
 		modH->u16errCnt ++;
 		return ERR_BAD_CRC;
@@ -978,20 +1320,9 @@ uint16_t word(uint8_t H, uint8_t L)
  */
 uint16_t calcCRC(uint8_t *Buffer, uint8_t u8length)
 {
-	unsigned int temp, temp2, flag;
-	temp = 0xFFFF;
+	unsigned int temp, temp2;
+	temp = calcCRCUpdate(MB_CRC_INIT, Buffer, u8length);
 
-	for (unsigned char i = 0; i < u8length; i++)
-	{
-		temp = temp ^ Buffer[i];
-		for (unsigned char j = 1; j <= 8; j++)
-		{
-			flag = temp & 0x0001;
-			temp >>=1;
-			if (flag)
-				temp ^= 0xA001;
-		}
-	}
 	// Reverse byte order.
 	temp2 = temp >> 8;
 	temp = (temp << 8) | temp2;
@@ -1002,6 +1333,26 @@ uint16_t calcCRC(uint8_t *Buffer, uint8_t u8length)
 
 }
 
+/**
+ * @brief
+ * This method updates a CRC with more bytes (CRC-16/Modbus, one table look-up per byte)
+ * Start with MB_CRC_INIT. The CRC of a frame followed by its own CRC (low byte first) is 0.
+ *
+ * @return uint16_t updated CRC value, not swapped
+ * @ingroup u16crc CRC of the previous bytes
+ * @ingroup Buffer
+ * @ingroup u16length
+ */
+uint16_t calcCRCUpdate(uint16_t u16crc, const uint8_t *Buffer, uint16_t u16length)
+{
+	for (uint16_t i = 0; i < u16length; i++)
+	{
+		u16crc = (u16crc >> 8) ^ crcTable[(u16crc ^ Buffer[i]) & 0xFF];
+	}
+
+	return u16crc;
+}
+
 
 /**
  * @brief
@@ -67,6 +67,7 @@ void Modbus_RxCpltCallback(UART_HandleTypeDef *huart)
 			if (mHandlers[i]->xTypeHW == USART_HW)
 			{
 				RingAdd(&mHandlers[i]->xBufferRX, mHandlers[i]->dataRX);
+				mHandlers[i]->u16RxCRC = calcCRCUpdate(mHandlers[i]->u16RxCRC, &mHandlers[i]->dataRX, 1);
 				HAL_UART_Receive_IT(mHandlers[i]->port, &mHandlers[i]->dataRX, 1);
 				xTimerResetFromISR(mHandlers[i]->TimerT35, &xHigherPriorityTaskWoken);
 			}
@@ -94,7 +95,7 @@ void Modbus_ErrorCallback(UART_HandleTypeDef *huart)
 		{
 			if (mHandlers[i]->xTypeHW == USART_HW_DMA)
 			{
-				while (HAL_UARTEx_ReceiveToIdle_DMA(mHandlers[i]->port, mHandlers[i]->xBufferRX.uxBuffer, MAX_BUFFER) != HAL_OK)
+				while (HAL_UARTEx_ReceiveToIdle_DMA(mHandlers[i]->port, mHandlers[i]->u8Buffer, MAX_BUFFER) != HAL_OK)
 				{
 					HAL_UART_DMAStop(mHandlers[i]->port);
 				}
@@ -127,17 +128,16 @@ void Modbus_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 			{
 				if (Size) //check if we have received any byte
 				{
+					// the frame stays in u8Buffer, the task restarts the reception once it is processed
 					mHandlers[i]->xBufferRX.u8available = Size;
 					mHandlers[i]->xBufferRX.overflow = false;
 
-					while(HAL_UARTEx_ReceiveToIdle_DMA(mHandlers[i]->port, mHandlers[i]->xBufferRX.uxBuffer, MAX_BUFFER) != HAL_OK)
+					if (mHandlers[i]->uModbusType == MB_MASTER)
 					{
-						HAL_UART_DMAStop(mHandlers[i]->port);
+						xTimerStopFromISR(mHandlers[i]->TimerTimeout, &xHigherPriorityTaskWoken);
 					}
 
-					__HAL_DMA_DISABLE_IT(mHandlers[i]->port->hdmarx, DMA_IT_HT); // we don't need half-transfer interrupt
-
-					xTaskNotifyFromISR(mHandlers[i]->myTaskModbusAHandle, 0 , eSetValueWithOverwrite, &xHigherPriorityTaskWoken);
+					xTaskNotifyFromISR(mHandlers[i]->modbus_taskHandle, 0 , eSetValueWithOverwrite, &xHigherPriorityTaskWoken);
 				}
 			}
 
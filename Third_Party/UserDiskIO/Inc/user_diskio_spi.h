@@ -21,6 +21,12 @@
 #include "integer.h" //from FatFs middleware library
 #include "diskio.h" //from FatFs middleware library
 #include "ff_gen_drv.h" //from FatFs middleware library
+#include <main.h> //for the SPI handle of the HAL
+
+//number of sectors (512 bytes each) of the write cache: the sectors written one after the other are
+//gathered and written by a multi-block write when the window (aligned to its size) is complete, or at
+//the next CTRL_SYNC (f_sync, f_close)
+#define USER_SPI_WCACHE_SECTORS	8
 
 //we define these as inline because we don't want them to be actual function calls (they get "called" from the cubemx autogenerated user_diskio file)
 //we define them as extern because they are defined in a separate .c file to user_diskio.c (which #includes this .h file)
@@ -35,4 +41,7 @@ extern DRESULT USER_SPI_read (BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
   extern DRESULT USER_SPI_ioctl (BYTE pdrv, BYTE cmd, void *buff);
 #endif /* _USE_IOCTL == 1 */
 
+//to be called from HAL_SPI_TxCpltCallback and HAL_SPI_TxRxCpltCallback, returns 1 if the transfer was of this driver
+extern int USER_SPI_TransferCplt (SPI_HandleTypeDef *hspi);
+
 #endif
@@ -24,7 +24,9 @@
 
 //It is designed to be wrapped by a cubemx generated user_diskio.c file.
 
+#include <string.h>
 #include <main.h> /* Provide the low-level HAL functions */
+#include "cmsis_os.h"
 #include "user_diskio_spi.h"
 
 //Make sure you set #define SD_SPI_HANDLE as some hspix in main.h
@@ -36,7 +38,13 @@ extern SPI_HandleTypeDef SD_SPI_HANDLE;
 
 //(Note that the _256 is used as a mask to clear the prescalar bits as it provides binary 111 in the correct position)
 #define FCLK_SLOW() { MODIFY_REG(SD_SPI_HANDLE.Instance->CR1, SPI_BAUDRATEPRESCALER_256, SPI_BAUDRATEPRESCALER_128); }	/* Set SCLK = slow, approx 280 KBits/s*/
-#define FCLK_FAST() { MODIFY_REG(SD_SPI_HANDLE.Instance->CR1, SPI_BAUDRATEPRESCALER_256, SPI_BAUDRATEPRESCALER_8); }	/* Set SCLK = fast, approx 4.5 MBits/s */
+#define FCLK_FAST() { MODIFY_REG(SD_SPI_HANDLE.Instance->CR1, SPI_BAUDRATEPRESCALER_256, SPI_BAUDRATEPRESCALER_4); }	/* Set SCLK = fast, approx 9 MBits/s */
+
+//Block transfers use the DMA of the SPI when FreeRTOS is running, the end of each transfer
+//must be signaled by calling USER_SPI_TransferCplt from the HAL_SPI_TxCpltCallback and
+//HAL_SPI_TxRxCpltCallback of the application
+#define SPI_DMA_MIN_SIZE	16		/* Transfers shorter than this are done by polling (in bytes) */
+#define SPI_DMA_TIMEOUT		100		/* Timeout of a DMA transfer of a data block (in ms) */
 
 #define CS_HIGH()	{HAL_GPIO_WritePin(SD_CS_GPIO_Port, SD_CS_Pin, GPIO_PIN_SET);}
 #define CS_LOW()	{HAL_GPIO_WritePin(SD_CS_GPIO_Port, SD_CS_Pin, GPIO_PIN_RESET);}
@@ -84,6 +92,36 @@ DSTATUS Stat = STA_NOINIT;	/* Physical drive status */
 static
 BYTE CardType;			/* Card type flags */
 
+/* DMA transfers */
+static
+BYTE DummyTx[512];		/* 0xFF bytes sent while receiving a data block */
+
+static volatile
+BYTE DmaBusy;			/* A DMA transfer of this driver is in progress */
+
+static
+osSemaphoreId_t DmaSem;	/* Signals the end of the DMA transfers */
+
+static
+StaticSemaphore_t DmaSemControlBlock;
+
+static
+const osSemaphoreAttr_t DmaSemAttributes = {
+	.name = "SdSpiDmaSem",
+	.cb_mem = &DmaSemControlBlock,
+	.cb_size = sizeof(DmaSemControlBlock),
+};
+
+/* Write cache: the sectors written one after the other are gathered and written by multi-block writes */
+static
+BYTE WrCache[USER_SPI_WCACHE_SECTORS * 512] __attribute__((aligned(4)));
+
+static
+DWORD WrCacheSector;	/* First sector (LBA) held in the write cache */
+
+static
+UINT WrCacheCount;		/* Number of sectors held in the write cache, 0 if empty */
+
 uint32_t spiTimerTickStart;
 uint32_t spiTimerTickDelay;
 
@@ -119,31 +157,87 @@ BYTE xchg_spi (
 }
 
 
+/* Check if a transfer can use the DMA */
+static
+int use_dma (
+		UINT len		/* Number of bytes to transfer */
+)
+{
+	return (len >= SPI_DMA_MIN_SIZE) && (len <= sizeof(DummyTx)) && (DmaSem != NULL) && (osKernelGetState() == osKernelRunning);
+}
+
+
+/* Wait for the end of a DMA transfer */
+static
+int wait_dma (	/* 1:OK, 0:Error or timeout */
+		HAL_StatusTypeDef result	/* Result of the start of the transfer */
+)
+{
+	if (result == HAL_OK)
+	{
+		if (osSemaphoreAcquire(DmaSem, SPI_DMA_TIMEOUT) != osOK)
+		{
+			HAL_SPI_Abort(&SD_SPI_HANDLE);
+			result = HAL_TIMEOUT;
+		}
+	}
+
+	DmaBusy = 0;
+
+	return (result == HAL_OK) ? 1 : 0;
+}
+
+
 /* Receive multiple byte */
 static
-void rcvr_spi_multi (
+int rcvr_spi_multi (	/* 1:OK, 0:Error */
 		BYTE *buff,		/* Pointer to data buffer */
 		UINT btr		/* Number of bytes to receive (even number) */
 )
 {
-	for(UINT i=0; i<btr; i++)
+	int res = 1;
+
+	if (use_dma(btr))
+	{
+		DmaBusy = 1;
+		res = wait_dma(HAL_SPI_TransmitReceive_DMA(&SD_SPI_HANDLE, DummyTx, buff, btr));
+	}
+	else
 	{
-		*(buff+i) = xchg_spi(0xFF);
+		for(UINT i=0; i<btr; i++)
+		{
+			*(buff+i) = xchg_spi(0xFF);
+		}
 	}
+
+	return res;
 }
 
 
 #if _USE_WRITE
 /* Send multiple byte */
 static
-void xmit_spi_multi (
+int xmit_spi_multi (	/* 1:OK, 0:Error */
 		const BYTE *buff,	/* Pointer to the data */
 		UINT btx			/* Number of bytes to send (even number) */
 )
 {
-	for(UINT i=0; i<btx; i++) {
-		xchg_spi(*(buff+i));
+	int res = 1;
+
+	if (use_dma(btx))
+	{
+		/* The bytes received are discarded, the overrun is cleared by the HAL at the end of the transfer */
+		DmaBusy = 1;
+		res = wait_dma(HAL_SPI_Transmit_DMA(&SD_SPI_HANDLE, (BYTE*)buff, btx));
 	}
+	else
+	{
+		for(UINT i=0; i<btx; i++) {
+			xchg_spi(*(buff+i));
+		}
+	}
+
+	return res;
 }
 #endif
 
@@ -238,7 +332,11 @@ int rcvr_datablock (	/* 1:OK, 0:Error */
 		return 0;		/* Function fails if invalid DataStart token or timeout */
 	}
 
-	rcvr_spi_multi(buff, btr);		/* Store trailing data to the buffer */
+	if (!rcvr_spi_multi(buff, btr))	/* Store trailing data to the buffer */
+	{
+		return 0;
+	}
+
 	xchg_spi(0xFF); xchg_spi(0xFF);	/* Discard CRC */
 
 	return 1;						/* Function succeeded */
@@ -268,7 +366,11 @@ int xmit_datablock (	/* 1:OK, 0:Failed */
 
 	if (token != 0xFD)
 	{	/* Send data if token is other than StopTran */
-		xmit_spi_multi(buff, 512);		/* Data */
+		if (!xmit_spi_multi(buff, 512))	/* Data */
+		{
+			return 0;
+		}
+
 		xchg_spi(0xFF); xchg_spi(0xFF);	/* Dummy CRC */
 
 		resp = xchg_spi(0xFF);				/* Receive data resp */
@@ -342,6 +444,64 @@ BYTE send_cmd (		/* Return value: R1 resp (bit7==1:Failed to send) */
 }
 
 
+
+/*-----------------------------------------------------------------------*/
+/* Write blocks to the MMC                                               */
+/*-----------------------------------------------------------------------*/
+
+#if _USE_WRITE
+static
+UINT write_blocks (	/* Number of sectors not written (0:OK) */
+		const BYTE *buff,	/* Pointer to the data to write */
+		DWORD sector,		/* Start sector number (LBA) */
+		UINT count			/* Number of sectors to write */
+)
+{
+	if (!(CardType & CT_BLOCK)) sector *= 512;	/* LBA ==> BA conversion (byte addressing cards) */
+
+	if (count == 1) {	/* Single sector write */
+		if ((send_cmd(CMD24, sector) == 0)	/* WRITE_BLOCK */
+				&& xmit_datablock(buff, 0xFE)) {
+			count = 0;
+		}
+	}
+	else {				/* Multiple sector write */
+		if (CardType & CT_SDC) send_cmd(ACMD23, count);	/* Pre-erase the sectors to write (a hint, its failure is not an error) */
+		if (send_cmd(CMD25, sector) == 0) {	/* WRITE_MULTIPLE_BLOCK */
+			do {
+				if (!xmit_datablock(buff, 0xFC)) break;
+				buff += 512;
+			} while (--count);
+			if (!xmit_datablock(0, 0xFD)) count = 1;	/* STOP_TRAN token */
+			if (!wait_ready(500)) count = 1;			/* Wait for the end of the programming */
+		}
+	}
+	despiselect();
+
+	return count;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write the sectors held in the write cache                             */
+/*-----------------------------------------------------------------------*/
+
+static
+DRESULT flush_cache (void)
+{
+	DRESULT res = RES_OK;
+
+	if (WrCacheCount) {
+		if (write_blocks(WrCache, WrCacheSector, WrCacheCount)) res = RES_ERROR;
+		WrCacheCount = 0;	/* The sectors not written are lost, the error is reported to the caller */
+	}
+
+	return res;
+}
+#endif
+
+
 /*--------------------------------------------------------------------------
    Public FatFs Functions (wrapped in user_diskio.c)
 ---------------------------------------------------------------------------*/
@@ -382,6 +542,14 @@ inline DSTATUS USER_SPI_initialize (
 		return Stat;	/* Is card existing in the socket? */
 	}
 
+	if ((DmaSem == NULL) && (osKernelGetState() == osKernelRunning))
+	{
+		DmaSem = osSemaphoreNew(1, 0, &DmaSemAttributes);
+	}
+
+	memset(DummyTx, 0xFF, sizeof(DummyTx));
+	WrCacheCount = 0;	/* The card may have been replaced */
+
 	FCLK_SLOW();
 	for (n = 10; n; n--) xchg_spi(0xFF);	/* Send 80 dummy clocks */
 
@@ -491,6 +659,12 @@ inline DRESULT USER_SPI_read (
 	if (Stat & STA_NODISK) return RES_ERROR;	/* Is card existing in the socket? */
 	if (Stat & STA_NOINIT) return RES_NOTRDY;	/* Check if drive is ready */
 
+#if _USE_WRITE
+	if (WrCacheCount && (sector < WrCacheSector + WrCacheCount) && (WrCacheSector < sector + count)) {
+		if (flush_cache() != RES_OK) return RES_ERROR;	/* The sectors to read are in the write cache */
+	}
+#endif
+
 	if (!(CardType & CT_BLOCK)) sector *= 512;	/* LBA ot BA conversion (byte addressing cards) */
 
 	if (count == 1) {	/* Single sector read */
@@ -528,6 +702,9 @@ inline DRESULT USER_SPI_write (
 		UINT count			/* Number of sectors to write (1..128) */
 )
 {
+	DRESULT res = RES_OK;
+	UINT n;
+
 	if (drv || !count) return RES_PARERR;		/* Check parameter */
 
 	if (SD_CARD_ABSENT())
@@ -539,27 +716,28 @@ inline DRESULT USER_SPI_write (
 	if (Stat & STA_NOINIT) return RES_NOTRDY;	/* Check drive status */
 	if (Stat & STA_PROTECT) return RES_WRPRT;	/* Check write protect */
 
-	if (!(CardType & CT_BLOCK)) sector *= 512;	/* LBA ==> BA conversion (byte addressing cards) */
-
-	if (count == 1) {	/* Single sector write */
-		if ((send_cmd(CMD24, sector) == 0)	/* WRITE_BLOCK */
-				&& xmit_datablock(buff, 0xFE)) {
-			count = 0;
+	/* The cache holds consecutive sectors of one window of USER_SPI_WCACHE_SECTORS sectors, aligned to its size */
+	while (count && (res == RES_OK)) {
+		if (WrCacheCount && ((sector != WrCacheSector + WrCacheCount) || (sector / USER_SPI_WCACHE_SECTORS != WrCacheSector / USER_SPI_WCACHE_SECTORS))) {
+			res = flush_cache();	/* Not consecutive to the cached sectors */
 		}
-	}
-	else {				/* Multiple sector write */
-		if (CardType & CT_SDC) send_cmd(ACMD23, count);	/* Predefine number of sectors */
-		if (send_cmd(CMD25, sector) == 0) {	/* WRITE_MULTIPLE_BLOCK */
-			do {
-				if (!xmit_datablock(buff, 0xFC)) break;
-				buff += 512;
-			} while (--count);
-			if (!xmit_datablock(0, 0xFD)) count = 1;	/* STOP_TRAN token */
+		else if (!WrCacheCount && !(sector % USER_SPI_WCACHE_SECTORS) && (count >= USER_SPI_WCACHE_SECTORS)) {
+			n = count - (count % USER_SPI_WCACHE_SECTORS);	/* Whole windows are written directly */
+			if (write_blocks(buff, sector, n)) res = RES_ERROR;
+			buff += n * 512; sector += n; count -= n;
+		}
+		else {
+			if (!WrCacheCount) WrCacheSector = sector;
+			n = USER_SPI_WCACHE_SECTORS - (sector % USER_SPI_WCACHE_SECTORS);	/* Room up to the end of the window */
+			if (n > count) n = count;
+			memcpy(&WrCache[WrCacheCount * 512], buff, n * 512);
+			WrCacheCount += n;
+			buff += n * 512; sector += n; count -= n;
+			if (!(sector % USER_SPI_WCACHE_SECTORS)) res = flush_cache();	/* Window complete */
 		}
 	}
-	despiselect();
 
-	return count ? RES_ERROR : RES_OK;	/* Return result */
+	return res;
 }
 #endif
 
@@ -594,8 +772,12 @@ inline DRESULT USER_SPI_ioctl (
 
 	switch (cmd)
 	{
-	case CTRL_SYNC :		/* Wait for end of internal write process of the drive */
+	case CTRL_SYNC :		/* Write the cached sectors, and wait for end of internal write process of the drive */
+#if _USE_WRITE
+		if ((flush_cache() == RES_OK) && spiselect())
+#else
 		if (spiselect())
+#endif
 		{
 			res = RES_OK;
 		}
@@ -664,6 +846,11 @@ inline DRESULT USER_SPI_ioctl (
 
 		dp = buff; st = dp[0]; ed = dp[1];				/* Load sector block */
 
+#if _USE_WRITE
+		if (flush_cache() != RES_OK)
+			break;	/* The cached sectors are written before the erase */
+#endif
+
 		if (!(CardType & CT_BLOCK))
 		{
 			st *= 512; ed *= 512;
@@ -684,3 +871,25 @@ inline DRESULT USER_SPI_ioctl (
 	return res;
 }
 #endif
+
+
+
+/*-----------------------------------------------------------------------*/
+/* End of a DMA transfer (called from the SPI callbacks of the HAL)      */
+/*-----------------------------------------------------------------------*/
+
+int USER_SPI_TransferCplt (	/* 1:The transfer was of this driver, 0:Otherwise */
+		SPI_HandleTypeDef *hspi	/* SPI handle of the transfer */
+)
+{
+	int owned = 0;
+
+	if (DmaBusy && (hspi->Instance == SD_SPI_HANDLE.Instance))
+	{
+		DmaBusy = 0;
+		osSemaphoreRelease(DmaSem);
+		owned = 1;
+	}
+
+	return owned;
+}
@@ -0,0 +1,305 @@
+/**
+  ******************************************************************************
+  * @file    hif_capture_tool.c
+  * @author  AMG/IPC Application Team
+  * @brief   Host tool that decodes the capture of the Host Interface traffic,
+  *          written to the uSD card when ENABLE_HIF_CAPTURE is set.
+  *
+  *          Uses the same CRC16 implementation of the firmware, build it with:
+  *            gcc -O2 -I../../Modules/Utility/Inc -o hif_capture_tool hif_capture_tool.c ../../Modules/Utility/Src/crc.c
+  *
+  *          Usage:
+  *            hif_capture_tool <capture>      lists the frames (time, direction, command ID, length, CRC16 check)
+  *            hif_capture_tool -x <capture>   also dumps the payload of each frame
+  *
+  *          The capture is a pcap file (LINKTYPE_USER0), it can also be opened
+  *          with Wireshark: the first byte of each packet is the direction
+  *          (0: host to modem, 1: modem to host), followed by the HIF frame.
+  *
+  * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+  * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+  * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+  * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+  * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  *******************************************************************************/
+
+/* Inclusions */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <crc.h>
+
+/* Definitions */
+#define PCAP_MAGIC				0xA1B2C3D4	/* Microsecond timestamps, same byte order as the host */
+#define PCAP_MAGIC_SWAPPED		0xD4C3B2A1	/* Microsecond timestamps, opposite byte order */
+#define PCAP_FILE_HEADER_SIZE	24
+#define PCAP_RECORD_HEADER_SIZE	16
+#define PCAP_LINKTYPE_USER0		147
+
+#define HIF_DIR_TX				0			/* From the host to the ST8500 modem */
+#define HIF_DIR_RX				1			/* From the ST8500 modem to the host */
+#define HIF_PREAMBLE_LEN		10			/* SYNC, CMD_ID, LEN, MODE, CNT */
+#define HIF_PREAMBLE_FIELD		0x1616
+#define HIF_CRC_LEN				2
+
+#define DUMP_BYTES_PER_LINE		32
+
+/* Custom types */
+typedef struct capture_stats_str
+{
+	uint32_t frames[2];		/* Frames in each direction */
+	uint32_t bytes[2];		/* Bytes in each direction */
+	uint32_t truncated;		/* Frames truncated by the snap length */
+	uint32_t invalid;		/* Frames with invalid sync, length or CRC16 */
+} capture_stats_t;
+
+/* Private variables */
+static bool swapped;
+
+/* Private functions */
+
+static uint32_t get_u32(const uint8_t *data)
+{
+	uint32_t value = (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+
+	if (swapped)
+	{
+		value = ((value & 0x000000FF) << 24) | ((value & 0x0000FF00) << 8) | ((value & 0x00FF0000) >> 8) | ((value & 0xFF000000) >> 24);
+	}
+
+	return value;
+}
+
+/* Fields of the HIF frame are always little-endian */
+static uint16_t get_le16(const uint8_t *data)
+{
+	return (uint16_t) (data[0] | (data[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *data)
+{
+	return (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static bool read_file_header(FILE *file)
+{
+	bool    result = false;
+	uint8_t header[PCAP_FILE_HEADER_SIZE];
+
+	if (fread(header, 1, sizeof(header), file) == sizeof(header))
+	{
+		uint32_t magic = get_u32(header);
+
+		if ((magic == PCAP_MAGIC) || (magic == PCAP_MAGIC_SWAPPED))
+		{
+			swapped = (magic == PCAP_MAGIC_SWAPPED);
+
+			if (get_u32(&header[20]) == PCAP_LINKTYPE_USER0)
+			{
+				result = true;
+			}
+			else
+			{
+				fprintf(stderr, "Unexpected link type %u\n", get_u32(&header[20]));
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Not a pcap file (magic %08X)\n", magic);
+		}
+	}
+	else
+	{
+		fprintf(stderr, "File too short\n");
+	}
+
+	return result;
+}
+
+static void dump_payload(const uint8_t *data, uint32_t size)
+{
+	for (uint32_t i = 0; i < size; i++)
+	{
+		printf("%s%02X", ((i % DUMP_BYTES_PER_LINE) == 0) ? "\n\t" : " ", data[i]);
+	}
+
+	printf("\n");
+}
+
+static void decode_frame(const uint8_t *record, uint32_t incl_len, uint32_t orig_len, bool dump, capture_stats_t *stats)
+{
+	uint8_t        dir   = record[0];
+	const uint8_t *frame = &record[1];
+	uint32_t       size  = incl_len - 1;
+
+	if (dir <= HIF_DIR_RX)
+	{
+		stats->frames[dir]++;
+		stats->bytes[dir] += orig_len - 1;
+	}
+
+	printf("%s ", (dir == HIF_DIR_TX) ? "TX" : ((dir == HIF_DIR_RX) ? "RX" : "??"));
+
+	if (size < HIF_PREAMBLE_LEN)
+	{
+		printf("short frame, %u bytes\n", size);
+		stats->invalid++;
+	}
+	else
+	{
+		uint16_t len      = get_le16(&frame[3]);
+		bool     complete = (size >= (uint32_t) (HIF_PREAMBLE_LEN + len + HIF_CRC_LEN));
+
+		printf("CMD 0x%02X LEN %-4u MODE %u CNT %-6u", frame[2], len, frame[5], get_le32(&frame[6]));
+
+		/* The LEN field of confirms and indications includes the EC */
+		if ((dir == HIF_DIR_RX) && (len > 0))
+		{
+			printf(" EC %u", frame[HIF_PREAMBLE_LEN]);
+		}
+
+		if (get_le16(frame) != HIF_PREAMBLE_FIELD)
+		{
+			printf(" INVALID SYNC");
+			stats->invalid++;
+		}
+		else if (!complete)
+		{
+			printf(" TRUNCATED (%u of %u bytes)", size, orig_len - 1);
+			stats->truncated++;
+		}
+		else
+		{
+			crc16_t crc_calc = CRC16_XMODEM(frame, HIF_PREAMBLE_LEN + len);
+			crc16_t crc_recv = get_le16(&frame[HIF_PREAMBLE_LEN + len]);
+
+			if (crc_calc != crc_recv)
+			{
+				printf(" INVALID CRC16 (%04X instead of %04X)", crc_recv, crc_calc);
+				stats->invalid++;
+			}
+		}
+
+		if (dump && (size > HIF_PREAMBLE_LEN))
+		{
+			uint32_t payload_len = size - HIF_PREAMBLE_LEN;
+
+			if (complete)
+			{
+				payload_len = len;
+			}
+
+			dump_payload(&frame[HIF_PREAMBLE_LEN], payload_len);
+		}
+		else
+		{
+			printf("\n");
+		}
+	}
+}
+
+static bool decode_capture(FILE *file, bool dump)
+{
+	bool			result = true;
+	uint8_t			header[PCAP_RECORD_HEADER_SIZE];
+	uint8_t			*record = NULL;
+	uint32_t		record_max = 0;
+	uint64_t		first_time = 0;
+	uint64_t		last_time = 0;
+	uint32_t		index = 0;
+	capture_stats_t	stats = { 0 };
+
+	while (result && (fread(header, 1, sizeof(header), file) == sizeof(header)))
+	{
+		uint64_t time     = ((uint64_t) get_u32(&header[0]) * 1000000) + get_u32(&header[4]);
+		uint32_t incl_len = get_u32(&header[8]);
+		uint32_t orig_len = get_u32(&header[12]);
+
+		if (incl_len > record_max)
+		{
+			record_max = incl_len;
+			record     = realloc(record, record_max);
+		}
+
+		if ((incl_len == 0) || (record == NULL) || (fread(record, 1, incl_len, file) != incl_len))
+		{
+			fprintf(stderr, "Record %u is incomplete, end of the capture\n", index);
+			result = false;
+		}
+		else
+		{
+			if (index == 0)
+			{
+				first_time = time;
+				last_time  = time;
+			}
+
+			printf("%-6u %10.6f +%-9llu ", index, time / 1000000.0, (unsigned long long) (time - last_time));
+
+			decode_frame(record, incl_len, orig_len, dump, &stats);
+
+			last_time = time;
+			index++;
+		}
+	}
+
+	printf("\n%u frames in %.3f s\n", index, (last_time - first_time) / 1000000.0);
+	printf("TX: %u frames, %u bytes\n", stats.frames[HIF_DIR_TX], stats.bytes[HIF_DIR_TX]);
+	printf("RX: %u frames, %u bytes\n", stats.frames[HIF_DIR_RX], stats.bytes[HIF_DIR_RX]);
+
+	if ((stats.truncated > 0) || (stats.invalid > 0))
+	{
+		printf("Truncated: %u, invalid: %u\n", stats.truncated, stats.invalid);
+	}
+
+	free(record);
+
+	/* A capture cut by a reset or a power loss can end with an incomplete record */
+	return (index > 0);
+}
+
+int main(int argc, char *argv[])
+{
+	bool		result = false;
+	bool		dump   = false;
+	const char	*path  = NULL;
+
+	if ((argc == 3) && (strcmp(argv[1], "-x") == 0))
+	{
+		dump = true;
+		path = argv[2];
+	}
+	else if (argc == 2)
+	{
+		path = argv[1];
+	}
+
+	if (path != NULL)
+	{
+		FILE *file = fopen(path, "rb");
+
+		if (file != NULL)
+		{
+			result = read_file_header(file) && decode_capture(file, dump);
+
+			fclose(file);
+		}
+		else
+		{
+			fprintf(stderr, "Cannot read %s\n", path);
+		}
+	}
+	else
+	{
+		fprintf(stderr, "Usage:\n");
+		fprintf(stderr, "  %s <capture>      lists the frames (time, direction, command ID, length, CRC16 check)\n", argv[0]);
+		fprintf(stderr, "  %s -x <capture>   also dumps the payload of each frame\n", argv[0]);
+	}
+
+	return (result) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,244 @@
+/**
+  ******************************************************************************
+  * @file    lzss_tool.c
+  * @author  AMG/IPC Application Team
+  * @brief   Host tool that produces and checks the compressed (LZSS) stream of
+  *          an ST8500 image, as sent by the image transfer.
+  *
+  *          Uses the same LZSS implementation of the firmware, build it with:
+  *            gcc -O2 -I../../Modules/Utility/Inc -o lzss_tool lzss_tool.c ../../Modules/Utility/Src/lzss.c
+  *
+  *          Usage:
+  *            lzss_tool c <image> <stream>          compresses an image
+  *            lzss_tool d <stream> <image> <size>   decompresses a stream of an image of <size> bytes
+  *            lzss_tool t <image>                   compresses and decompresses an image, reporting the gain
+  *
+  * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+  * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+  * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+  * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+  * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  *******************************************************************************/
+
+/* Inclusions */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lzss.h>
+
+/* Definitions */
+#define TRANSFER_BLOCK_SIZE		1024	/* Size of the blocks of the image transfer */
+#define TRANSFER_BLOCK_NUM(size)	(((size) + TRANSFER_BLOCK_SIZE - 1) / TRANSFER_BLOCK_SIZE)
+
+/* Custom types */
+typedef struct buffer_str
+{
+	uint8_t  *data;
+	uint32_t size;
+	uint32_t max;
+} buffer_t;
+
+typedef struct codec_str
+{
+	const buffer_t *input;
+	buffer_t       *output;
+} codec_t;
+
+/* Private variables */
+static lzss_encoder_t encoder;
+static lzss_decoder_t decoder;
+
+/* Private functions */
+
+static bool buffer_read(void *context, uint8_t *data, uint32_t size, uint32_t offset)
+{
+	const buffer_t *buffer = ((codec_t*) context)->input;
+
+	if ((offset + size) > buffer->size)
+	{
+		return false;
+	}
+
+	memcpy(data, &buffer->data[offset], size);
+
+	return true;
+}
+
+static bool buffer_write(void *context, const uint8_t *data, uint32_t size, uint32_t offset)
+{
+	buffer_t *buffer = ((codec_t*) context)->output;
+
+	if ((offset + size) > buffer->max)
+	{
+		return false;
+	}
+
+	memcpy(&buffer->data[offset], data, size);
+
+	if ((offset + size) > buffer->size)
+	{
+		buffer->size = offset + size;
+	}
+
+	return true;
+}
+
+static bool load_file(const char *path, buffer_t *buffer)
+{
+	bool  result = false;
+	FILE *file   = fopen(path, "rb");
+
+	if (file != NULL)
+	{
+		fseek(file, 0, SEEK_END);
+		buffer->size = ftell(file);
+		buffer->max  = buffer->size;
+		buffer->data = malloc(buffer->size + 1);
+		fseek(file, 0, SEEK_SET);
+
+		result = (buffer->data != NULL) && (fread(buffer->data, 1, buffer->size, file) == buffer->size);
+
+		fclose(file);
+	}
+
+	if (!result)
+	{
+		fprintf(stderr, "Cannot read %s\n", path);
+	}
+
+	return result;
+}
+
+static bool save_file(const char *path, const buffer_t *buffer)
+{
+	bool  result = false;
+	FILE *file   = fopen(path, "wb");
+
+	if (file != NULL)
+	{
+		result = (fwrite(buffer->data, 1, buffer->size, file) == buffer->size);
+
+		fclose(file);
+	}
+
+	if (!result)
+	{
+		fprintf(stderr, "Cannot write %s\n", path);
+	}
+
+	return result;
+}
+
+static bool compress(const buffer_t *image, buffer_t *stream)
+{
+	codec_t codec = { image, stream };
+
+	/* Worst case: all literals, one flag byte every 8 bytes */
+	stream->max  = image->size + (image->size / 8) + 1;
+	stream->size = 0;
+	stream->data = malloc(stream->max);
+
+	return (stream->data != NULL) && (lzss_encode(&encoder, image->size, buffer_read, buffer_write, &codec) > 0);
+}
+
+static bool decompress(const buffer_t *stream, buffer_t *image, uint32_t image_size)
+{
+	bool    result = false;
+	codec_t codec  = { stream, image };
+
+	image->max  = image_size;
+	image->size = 0;
+	image->data = malloc(image_size + 1);
+
+	if (image->data != NULL)
+	{
+		/* Fed by blocks, as the receiver of the image transfer does */
+		lzss_decoder_init(&decoder, image_size, buffer_write, &codec);
+
+		result = true;
+
+		for (uint32_t offset = 0; result && (offset < stream->size); offset += TRANSFER_BLOCK_SIZE)
+		{
+			uint32_t size = ((stream->size - offset) > TRANSFER_BLOCK_SIZE) ? TRANSFER_BLOCK_SIZE : (stream->size - offset);
+
+			result = lzss_decoder_feed(&decoder, &stream->data[offset], size);
+		}
+
+		result = result && (image->size == image_size);
+	}
+
+	if (!result)
+	{
+		fprintf(stderr, "Corrupted stream\n");
+	}
+
+	return result;
+}
+
+static void report(const buffer_t *image, const buffer_t *stream)
+{
+	printf("Image:  %u bytes, %u blocks\n", image->size, TRANSFER_BLOCK_NUM(image->size));
+	printf("Stream: %u bytes, %u blocks (%.1f%%)\n", stream->size, TRANSFER_BLOCK_NUM(stream->size), (100.0 * stream->size) / image->size);
+
+	if (stream->size >= image->size)
+	{
+		printf("The image does not compress, it is sent raw\n");
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	bool	 result = false;
+	buffer_t image  = { 0 };
+	buffer_t stream = { 0 };
+	buffer_t check  = { 0 };
+
+	if ((argc == 4) && (strcmp(argv[1], "c") == 0))
+	{
+		result = load_file(argv[2], &image) && compress(&image, &stream) && save_file(argv[3], &stream);
+
+		if (result)
+		{
+			report(&image, &stream);
+		}
+	}
+	else if ((argc == 5) && (strcmp(argv[1], "d") == 0))
+	{
+		result = load_file(argv[2], &stream) && decompress(&stream, &image, strtoul(argv[4], NULL, 0)) && save_file(argv[3], &image);
+	}
+	else if ((argc == 3) && (strcmp(argv[1], "t") == 0))
+	{
+		result = load_file(argv[2], &image) && compress(&image, &stream) && decompress(&stream, &check, image.size);
+
+		if (result)
+		{
+			result = (memcmp(image.data, check.data, image.size) == 0);
+
+			if (result)
+			{
+				report(&image, &stream);
+			}
+			else
+			{
+				fprintf(stderr, "Mismatch after decompression\n");
+			}
+		}
+	}
+	else
+	{
+		fprintf(stderr, "Usage:\n");
+		fprintf(stderr, "  %s c <image> <stream>          compresses an image\n", argv[0]);
+		fprintf(stderr, "  %s d <stream> <image> <size>   decompresses a stream of an image of <size> bytes\n", argv[0]);
+		fprintf(stderr, "  %s t <image>                   compresses and decompresses an image, reporting the gain\n", argv[0]);
+	}
+
+	free(image.data);
+	free(stream.data);
+	free(check.data);
+
+	return (result) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * @file    user_bench.h
+  * @author  AMG/IPC Application Team
+  * @brief   Header file for the scripted benchmark of the User Terminal.
+  *
+  * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+  * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+  * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+  * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+  * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  *******************************************************************************/
+
+#ifndef USER_BENCH_H
+#define USER_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Inclusions */
+#include <settings.h>
+#include <hi_msgs_impl.h>
+#include <hi_mac_sap_interface.h>
+
+#if ENABLE_BENCHMARK
+
+/* Definitions */
+#define USER_BENCH_SIZES_MAX			(8)		/* Maximum number of payload sizes in a run */
+#define USER_BENCH_SAMPLES_MAX			(256)	/* Maximum number of requests for each payload size (one round-trip sample each) */
+#define USER_BENCH_WINDOW_MAX			(4)		/* Maximum number of requests in flight */
+#define USER_BENCH_PAYLOAD_MAX			(1024)	/* Maximum payload size, in bytes */
+
+/* Custom types */
+typedef enum user_bench_type_enum
+{
+	user_bench_udp,		/* UDP loopback, answered by the benchmark of the destination */
+	user_bench_icmp,	/* ICMP echo, answered by the modem of the destination */
+	user_bench_mac,		/* MAC ping-pong of the User MAC (MAC PLC mode only) */
+} user_bench_type_t;
+
+/* Parameters of a run, as given on the command line */
+typedef struct user_bench_params_str
+{
+	user_bench_type_t	type;									/* Type of benchmark */
+	uint16_t			short_addr;								/* Destination short address (UDP and ICMP) */
+	uint8_t				ext_addr[MAC_ADDR64_SIZE];				/* Destination extended address (MAC) */
+	uint16_t			sizes[USER_BENCH_SIZES_MAX];			/* Payload sizes, in bytes */
+	uint8_t				size_num;								/* Number of payload sizes */
+	uint16_t			count;									/* Number of requests for each payload size */
+	uint32_t			interval;								/* Minimum time between two requests, in ms */
+	uint8_t				concurrency;							/* Maximum number of requests in flight */
+} user_bench_params_t;
+
+/* Public Functions */
+void	UserBench_Init(void);
+bool	UserBench_MsgNeeded(const g3_msg_t *g3_msg);
+void	UserBench_MsgHandler(const g3_msg_t *g3_msg);
+void	UserBench_FsmManager(void);
+
+bool	UserBench_ParseCommand(char *command, user_bench_params_t *params);
+bool	UserBench_Start(const user_bench_params_t *params);
+void	UserBench_Stop(void);
+bool	UserBench_InProgress(void);
+void	UserBench_PrintUsage(void);
+
+/* Interface for the runs driven by the User MAC */
+void	UserBench_SizeStart(const uint16_t size);
+void	UserBench_AddSample(const uint32_t rtt);
+void	UserBench_AddSent(void);
+void	UserBench_SizeEnd(void);
+
+void	UserBench_TimeoutCallback(void *argument);
+
+#endif /* ENABLE_BENCHMARK */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_BENCH_H */
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -61,6 +61,11 @@ extern "C" {
   * @{
   */
 
+/* Definitions */
+#define USER_G3_RX_QUEUE_SIZE		3	/* Maximum number of received UDP packets queued for each connection (each one holds a memory pool block) */
+#define USER_G3_TX_QUEUE_SIZE		2	/* Maximum number of UDP packets waiting to be sent for each connection (each one holds a memory pool block) */
+#define USER_G3_TX_WINDOW_SIZE		3	/* Maximum number of G3UDP-DATA.Request messages waiting for their confirm, for all connections */
+
 /* User event macros */
 #define USER_EVENT_RISEN(event_pos)	((user_term_fsm.user_events  	   & (1 << event_pos)) ==  (1 << event_pos))
 #define USER_EVENT_OK(event_pos)	((user_term_fsm.user_events_status & (1 << event_pos)) ==  (1 << event_pos))
@@ -126,8 +131,30 @@ typedef struct udp_packet_tx_str
   uint16_t 		port;			/* Selected UDP port */
   uint16_t 		length;			/* Length of the payload, in bytes */
   void     		*payload;		/* Pointer to the payload buffer */
+  void			*buffer;		/* Memory pool block that contains the payload (received packets only) */
 } udp_packet_t;
 
+/* Counters of the UDP packets received on a connection */
+typedef struct udp_rx_stats_str
+{
+	uint32_t	received;		/* Number of packets queued */
+	uint32_t	dropped;		/* Number of packets dropped because the queue was full (the oldest one is dropped) */
+	uint8_t		queued;			/* Number of packets currently in the queue */
+} udp_rx_stats_t;
+
+/* Counters of the UDP packets sent on a connection */
+typedef struct udp_tx_stats_str
+{
+	uint32_t	sent;			/* Number of G3UDP-DATA.Request messages sent */
+	uint32_t	confirmed;		/* Number of positive G3UDP-DATA.Confirm messages received */
+	uint32_t	failed;			/* Number of packets with negative or missing confirm */
+	uint32_t	rejected;		/* Number of packets rejected because the transmit queue was full */
+	uint8_t		queued;			/* Number of packets currently waiting to be sent */
+} udp_tx_stats_t;
+
+/* Function called when a UDP packet is confirmed, with the status of the G3UDP-DATA.Confirm (G3_SUCCESS or error) */
+typedef void userg3_tx_callback_t(const uint8_t connection_id, const uint8_t handle, const uint8_t status);
+
 typedef struct userg3_common_data_str
 {
 	uint8_t      		connection_number;     		/*!<  Counter of connections that have been set */
@@ -150,19 +177,44 @@ typedef struct connection_table_str
 {
 	user_conn_t  		TestConn;              		/*!<  Stores info about connection setup for UDP tests */
 	user_conn_t  		TransferConn;				/*!<  Stores info about connection setup for UDP transfers */
+#if ENABLE_METER_POLLING
+	user_conn_t  		PollConn;					/*!<  Stores info about connection setup for the polling of the devices */
+#endif
+#if ENABLE_BENCHMARK
+	user_conn_t  		BenchConn;					/*!<  Stores info about connection setup for benchmarks */
+#endif
+#if ENABLE_MODBUS_GATEWAY
+	user_conn_t  		ModbusGwConn;				/*!<  Stores info about connection setup for the Modbus gateway */
+#endif
 #if ENABLE_LAST_GASP
 	user_conn_t  		LastGaspConn;              	/*!<  Stores info about connection setup for UDP Last Gasp connection (of the G3 module) */
 #endif
 	/* Add more connections to set here (update connection_list as well) */
 } connection_table_t;
 
+/* Entry points of a User application running on the UDP connections of the User G3 */
+typedef struct user_g3_app_str
+{
+	void (*init)(void);								/*!<  Initialization */
+	bool (*msg_needed)(const g3_msg_t *g3_msg);		/*!<  Checks if a G3 message is needed */
+	void (*msg_handler)(const g3_msg_t *g3_msg);	/*!<  Handles a G3 message */
+	void (*fsm_manager)(void);						/*!<  Runs the FSM (NULL for the end of the list) */
+} user_g3_app_t;
+
 /* Public functions */
 void UserG3_Init(void);
 
 /* Message handler and FSM */
 bool UserG3_MsgNeeded( const g3_msg_t *msg);
-void UserG3_MsgHandler(const g3_msg_t *msg);
+void UserG3_MsgHandler(g3_msg_t *msg);
 void UserG3_FsmManager(void);
+void UserG3_RequestFsmExecution(const uint32_t operation_counter);
+
+/* User applications on the UDP connections */
+void UserG3_AppsInit(void);
+bool UserG3_AppsMsgNeeded(const g3_msg_t *msg);
+void UserG3_AppsMsgHandler(const g3_msg_t *msg);
+void UserG3_AppsFsmManager(void);
 
 /* Debug tool info */
 void UserG3_PlatformInfoRequest(void);
@@ -179,8 +231,15 @@ void UserG3_AbortUdpDataLoopback(void);
 /* UDP data */
 uint8_t 	 	UserG3_SendUdpDataToShortAddress(const uint8_t connection_id, const uint16_t dest_short_addr, void *data, const uint32_t length);
 uint8_t 		UserG3_SendUdpData(              const uint8_t connection_id, const ip6_addr_t dest_ip_addr,  void *data, const uint32_t length);
+uint8_t 		UserG3_SendUdpDataAsync(         const uint8_t connection_id, const ip6_addr_t dest_ip_addr,  void *data, const uint32_t length, userg3_tx_callback_t *callback);
+uint8_t			UserG3_GetUdpTxSpace(            const uint8_t connection_id);
+void			UserG3_GetUdpTxStats(            const uint8_t connection_id, udp_tx_stats_t *stats);
+bool			UserG3_TxInProgress(void);
 udp_packet_t	UserG3_GetUdpData(               const uint8_t connection_id);
 void 			UserG3_DiscardUdpData(           const uint8_t connection_id);
+uint8_t			UserG3_DequeueUdpData(           const uint8_t connection_id, udp_packet_t *packets, const uint8_t max_packets);
+void			UserG3_ReleaseUdpData(udp_packet_t *packet);
+void			UserG3_GetUdpRxStats(            const uint8_t connection_id, udp_rx_stats_t *stats);
 
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST
 /* Re-keying */
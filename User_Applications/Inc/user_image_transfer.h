@@ -27,6 +27,11 @@ extern "C" {
 
 #if ENABLE_IMAGE_TRANSFER
 
+/* Definitions */
+#define USER_IMG_TRANSFER_WINDOW_MAX		(32)	/* Maximum number of blocks in flight (limited by the size of the selective ACK bitmap) */
+#define USER_IMG_TRANSFER_WINDOW_DEFAULT	(8)		/* Number of blocks in flight proposed by default */
+#define USER_IMG_TRANSFER_COMPRESSION		1		/* Set to 1 to send the images compressed (LZSS), when it makes them smaller */
+
 /* Custom types */
 typedef enum user_image_transfer_error_code_enum
 {
@@ -35,6 +40,7 @@ typedef enum user_image_transfer_error_code_enum
 	uit_data_timeout_error,
 	uit_crc_error,
 	uit_aborted,
+	uit_device_error,	/* Multicast only, at least one device rejected the image or did not receive it */
 } user_image_transfer_error_code_t;
 
 /* Public Functions */
@@ -44,7 +50,8 @@ void								UserImgTransfer_MsgHandler(const g3_msg_t *msg);
 void								UserImgTransfer_FsmManager(void);
 
 #if IS_COORD
-void 								UserImgTransfer_StartSend(uint8_t image_slot, uint16_t dest_short_addr);
+void 								UserImgTransfer_StartSend(uint8_t image_slot, uint16_t dest_short_addr, uint8_t window_size);
+void 								UserImgTransfer_StartMulticast(uint8_t image_slot);
 #else
 void 								UserImgTransfer_StartReceive(uint8_t image_slot);
 #endif
@@ -65,6 +65,9 @@ extern "C" {
 /* User event macros */
 
 /* Macros */
+#define USERMAC_GEN_FRAME_SIZE_MIN	(16)					/* Minimum frame size of the traffic generator, in bytes */
+#define USERMAC_GEN_FRAME_SIZE_MAX	MAC_PAYLOAD_MAX_SIZE	/* Maximum frame size of the traffic generator, in bytes */
+
 #define LED_MAC_RX_GPIO_Port       LED2_GPIO_Port
 #define LED_MAC_RX_Pin             LED2_Pin
 
@@ -97,6 +100,16 @@ typedef enum mac_test_state_enum
 	mac_internal_error       = 0x0C,
 } mac_test_state_t;
 
+/* Parameters of the traffic generator */
+typedef struct usermac_gen_params_str
+{
+	uint8_t				dst_addr[MAC_ADDR64_SIZE];	/* Destination extended address (all 0xFF for broadcast) */
+	usermac_test_type_t	media;						/* Media of the frames (PLC and RF: alternated frame by frame) */
+	uint16_t			frame_size;					/* MSDU size, in bytes */
+	uint32_t			frame_n;					/* Number of frames to send */
+	uint32_t			rate;						/* Target rate, in bit/s of MSDU (0: as fast as the modem accepts the requests) */
+} usermac_gen_params_t;
+
 
 /* User G3 events */
 
@@ -114,6 +127,10 @@ bool UserMac_IsReady();
 
 /* Callbacks */
 void UserMac_StartTxCallback(uint8_t *dst_addr, usermac_test_type_t test_type, uint32_t msg_number);
+#if ENABLE_BENCHMARK
+void UserMac_StartBenchmark(uint8_t *dst_addr, uint32_t msg_number);
+#endif
+bool UserMac_StartGenerator(const usermac_gen_params_t *params);
 void UserMac_TimeoutCallback(void *argument);
 
 /**
@@ -46,6 +46,7 @@ extern "C" {
 
 /* Inclusions */
 #include <user_if.h>
+#include <modbus.h>
 
 #define MODBUS_MASTER_ID	0	/* For master only */
 #define MODBUS_SLAVE_ID		1 	/* For slave only */
@@ -61,6 +62,7 @@ void UserModbus_init(modbus_role_t role);
 void UserModbus_start(void);
 void UserModbus_deinit(void);
 void UserModbus_exec(void);
+bool UserModbus_query(modbus_t telegram);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,89 @@
+/**
+  ******************************************************************************
+  * @file    user_modbus_gw.h
+  * @author  AMG/IPC Application Team
+  * @brief   Header file for the gateway between the coordinator (UDP) and the
+  *          Modbus slaves of the devices (RTU).
+  *
+  * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+  * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+  * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+  * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+  * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  *******************************************************************************/
+
+#ifndef USER_MODBUS_GW_H
+#define USER_MODBUS_GW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Inclusions */
+#include <settings.h>
+#include <hi_msgs_impl.h>
+
+#if ENABLE_MODBUS_GATEWAY
+
+/*
+ * Format of the datagrams (all fields are big-endian, as in Modbus):
+ *
+ * Header:	TRANSACTION_ID (2 bytes, echoed in the reply) | COUNT (1 byte, number of entries)
+ * Entry:	UNIT_ID (1 byte) | PDU_LENGTH (1 byte) | PDU (function code and data, as in Modbus TCP)
+ *
+ * The reply holds one entry for each entry of the request, in the same order, with the response PDU of the slave.
+ * A request that fails is answered with an exception PDU (function code | 0x80, exception code).
+ */
+
+/* Definitions */
+#define USER_MBGW_HEADER_SIZE			(3)		/* Size of the header of a datagram, in bytes */
+#define USER_MBGW_ENTRY_HEADER_SIZE		(2)		/* Size of the header of an entry, in bytes */
+#define USER_MBGW_REQUEST_MAX			(8)		/* Maximum number of requests in a datagram, must not exceed MAX_TELEGRAMS of the Modbus master */
+#define USER_MBGW_PDU_MAX_SIZE			(125)	/* Maximum size of a PDU, in bytes (the Modbus RTU buffer of 128 bytes, without slave address and CRC) */
+#define USER_MBGW_DATAGRAM_MAX_SIZE		(USER_MBGW_HEADER_SIZE + (USER_MBGW_REQUEST_MAX * (USER_MBGW_ENTRY_HEADER_SIZE + USER_MBGW_PDU_MAX_SIZE)))
+
+/* Exception codes generated by the gateway */
+#define USER_MBGW_EXC_ILLEGAL_FUNCTION	(0x01)	/* Function code not supported by the gateway */
+#define USER_MBGW_EXC_ILLEGAL_VALUE		(0x03)	/* Malformed request, or quantity out of range */
+#define USER_MBGW_EXC_DEVICE_FAILURE	(0x04)	/* The slave answered with an exception, or with an invalid frame */
+#define USER_MBGW_EXC_PATH_UNAVAILABLE	(0x0A)	/* The request could not be queued to the Modbus master */
+#define USER_MBGW_EXC_TARGET_FAILED		(0x0B)	/* The slave did not answer */
+
+/* Custom types */
+
+/* Request or response of a batch */
+typedef struct user_mbgw_pdu_str
+{
+	uint8_t		unit_id;						/* Modbus slave address (1 - 247) */
+	uint8_t		length;							/* Length of the PDU, in bytes */
+	uint8_t		pdu[USER_MBGW_PDU_MAX_SIZE];	/* Function code and data */
+} user_mbgw_pdu_t;
+
+#if IS_COORD
+/* Function called with the responses of a batch */
+typedef void user_mbgw_reply_cb_t(const uint16_t short_addr, const uint16_t transaction_id, const user_mbgw_pdu_t *responses, const uint8_t response_n);
+#endif
+
+/* Public Functions */
+void	UserModbusGw_Init(void);
+bool	UserModbusGw_MsgNeeded(const g3_msg_t *g3_msg);
+void	UserModbusGw_MsgHandler(const g3_msg_t *g3_msg);
+void	UserModbusGw_FsmManager(void);
+
+#if IS_COORD
+uint16_t UserModbusGw_Send(const uint16_t short_addr, const user_mbgw_pdu_t *requests, const uint8_t request_n, user_mbgw_reply_cb_t *callback);
+#else
+void	UserModbusGw_TaskExec(void);
+#endif
+
+#endif /* ENABLE_MODBUS_GATEWAY */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_MODBUS_GW_H */
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
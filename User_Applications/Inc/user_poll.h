@@ -0,0 +1,127 @@
+/**
+  ******************************************************************************
+  * @file    user_poll.h
+  * @author  AMG/IPC Application Team
+  * @brief   Header file for the polling of the devices (data concentrator).
+  *
+  * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+  * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+  * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+  * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+  * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  *******************************************************************************/
+
+#ifndef USER_POLL_H
+#define USER_POLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Inclusions */
+#include <settings.h>
+#include <hi_msgs_impl.h>
+#include <g3_boot_srv_join_entry_tbl.h>
+
+#if ENABLE_METER_POLLING
+
+/* Definitions */
+#define USER_POLL_REPLY_MAX_SIZE		(64)	/* Maximum size of the reply of a device kept in the results, in bytes (longer replies are truncated) */
+#define USER_POLL_REPLY_HEADER_SIZE		(1)		/* Size of the status of the meter reading, at the start of the reply */
+
+/* Custom types */
+
+/* Status of the meter reading, first byte of the reply of a device (followed by the data read) */
+typedef enum user_poll_read_status_enum
+{
+	user_poll_read_ok = 0,		/* The meter was read */
+	user_poll_read_no_reader,	/* No meter reader is configured on the device */
+	user_poll_read_error,		/* The reading of the meter failed */
+} user_poll_read_status_t;
+
+#if IS_COORD
+#define USER_POLL_MAX_DEVICES			BOOT_MAX_NUM_JOINING_NODES	/* Maximum number of devices polled in a sweep */
+#define USER_POLL_REQUEST_MAX_SIZE		(64)	/* Maximum size of the request template, in bytes */
+#define USER_POLL_WINDOW_MIN			(1)		/* Minimum number of requests in flight */
+#define USER_POLL_WINDOW_MAX			(8)		/* Maximum number of requests in flight */
+#define USER_POLL_RETRIES_MAX			(3)		/* Maximum number of requests sent to a device in a sweep */
+#define USER_POLL_BATCH_SIZE			(4)		/* Number of results delivered at once */
+#define USER_POLL_HOPS_MAX				(8)		/* Maximum hop count with its own round-trip statistics (the longer routes are counted in the last one) */
+
+typedef enum user_poll_status_enum
+{
+	user_poll_ok,				/* The device replied with the meter data */
+	user_poll_timeout,			/* The device did not reply after all retries */
+	user_poll_send_error,		/* The requests could not be sent to the device */
+	user_poll_read_failed,		/* The device replied, but could not read the meter (see read_status) */
+} user_poll_status_t;
+
+/* Result of the polling of a device */
+typedef struct user_poll_result_str
+{
+	uint16_t			short_addr;							/* Short address of the device */
+	user_poll_status_t	status;								/* Result of the polling */
+	uint8_t				hops;								/* Hop count of the route to the device (0 if unknown) */
+	uint8_t				attempts;							/* Number of requests sent to the device */
+	uint32_t			rtt;								/* Round-trip time of the request that was answered, in ms */
+	uint8_t				read_status;						/* Status of the meter reading (user_poll_read_status_t), if the device replied */
+	uint16_t			length;								/* Length of the meter data kept in data, in bytes */
+	uint8_t				data[USER_POLL_REPLY_MAX_SIZE];		/* Meter data of the reply of the device */
+} user_poll_result_t;
+
+/* Round-trip statistics of the devices with the same hop count */
+typedef struct user_poll_hop_stats_str
+{
+	uint32_t	replies;			/* Number of replies */
+	uint32_t	rtt_sum;			/* Sum of the round-trip times, in ms */
+	uint32_t	rtt_min;			/* Minimum round-trip time, in ms */
+	uint32_t	rtt_max;			/* Maximum round-trip time, in ms */
+} user_poll_hop_stats_t;
+
+/* Statistics of the last sweep */
+typedef struct user_poll_stats_str
+{
+	uint16_t				devices;						/* Number of devices polled */
+	uint16_t				replied;						/* Number of devices that replied */
+	uint16_t				failed;							/* Number of devices that did not reply */
+	uint32_t				requests;						/* Number of requests sent */
+	uint32_t				timeouts;						/* Number of requests not answered in time */
+	uint32_t				duration;						/* Duration of the sweep, in ms */
+	uint32_t				srtt;							/* Smoothed round-trip time, in ms */
+	uint8_t					window;							/* Current number of requests allowed in flight */
+	uint8_t					window_peak;					/* Highest number of requests in flight */
+	user_poll_hop_stats_t	hop[USER_POLL_HOPS_MAX + 1];	/* Round-trip statistics for each hop count (index 0: unknown) */
+} user_poll_stats_t;
+
+/* Function called with each batch of results, 'last' is true for the last batch of the sweep */
+typedef void user_poll_batch_cb_t(const user_poll_result_t *results, const uint8_t count, const bool last);
+#endif /* IS_COORD */
+
+/* Public Functions */
+void	UserPoll_Init(void);
+bool	UserPoll_MsgNeeded(const g3_msg_t *msg);
+void	UserPoll_MsgHandler(const g3_msg_t *msg);
+void	UserPoll_FsmManager(void);
+
+#if IS_COORD
+bool	UserPoll_Start(const uint16_t *short_addr_list, const uint16_t device_num, const void *request, const uint16_t length, user_poll_batch_cb_t *callback);
+bool	UserPoll_StartConnected(const void *request, const uint16_t length, user_poll_batch_cb_t *callback);
+void	UserPoll_Stop(void);
+bool	UserPoll_InProgress(void);
+void	UserPoll_GetStats(user_poll_stats_t *stats);
+void	UserPoll_TimeoutCallback(void *argument);
+#else
+user_poll_read_status_t	UserPoll_ReadMeter(const uint8_t *request, const uint16_t length, uint8_t *data, uint16_t *data_len);
+#endif
+
+#endif /* ENABLE_METER_POLLING */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USER_POLL_H */
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,1163 @@
+/**
+ ******************************************************************************
+ * @file    user_bench.c
+ * @author  AMG/IPC Application Team
+ * @brief   Implementation of the scripted benchmark of the User Terminal.
+ *
+ * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+ * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+ * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+ * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+ * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+ *
+ *******************************************************************************/
+
+/* Inclusions */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <cmsis_os.h>
+#include <utils.h>
+#include <main.h>
+#include <debug_print.h>
+#include <mem_pool.h>
+#include <user_if.h>
+#include <user_g3_common.h>
+#include <user_mac.h>
+#include <user_bench.h>
+
+/** @addtogroup User_App
+ * @{
+ */
+
+/** @addtogroup User_Bench
+ * @{
+ */
+
+/** @addtogroup User_Bench_Private_Code
+ * @{
+ */
+
+#if ENABLE_BENCHMARK
+
+/* Definitions */
+#define USER_BENCH_MSG_ID				0xBE		/* ID value of the benchmark messages (differs from the one of the Keep-Alive) */
+#define USER_BENCH_REQUEST				1
+#define USER_BENCH_ANSWER				2
+
+#define USER_BENCH_DEFAULT_SIZE			(32)		/* In bytes */
+#define USER_BENCH_DEFAULT_COUNT		(10)
+
+#define USER_BENCH_CMD_DELIMITER		" \t\r\n"
+#define USER_BENCH_SIZE_DELIMITER		","
+#define USER_BENCH_CSV_TAG				"BENCH"		/* First field of each CSV line, to filter them from the rest of the output */
+
+/* Timing */
+#define USER_BENCH_REPLY_TIMEOUT		(10000U)	/* In ms, time after which a request is counted as lost */
+
+/* Macros */
+#define USER_BENCH_MIN(a, b)				(((a) < (b)) ? (a) : (b))
+#define USER_BENCH_PERCENTILE_INDEX(p, n)	((((p) * (n)) + 99U) / 100U - 1U)	/* Nearest-rank index of the percentile p of n sorted samples */
+
+/* Custom types */
+typedef enum user_bench_event_enum
+{
+	USER_BENCH_EV_NONE = 0,
+	USER_BENCH_EV_START,
+	USER_BENCH_EV_REPLY,
+	USER_BENCH_EV_TIMEOUT,
+	USER_BENCH_EV_STOP,
+	USER_BENCH_EV_CNT
+} user_bench_event_t;
+
+typedef enum user_bench_state_enum
+{
+	USER_BENCH_ST_IDLE = 0,
+	USER_BENCH_ST_RUNNING,
+	USER_BENCH_ST_CNT
+} user_bench_state_t;
+
+#pragma pack(push, 1)
+
+/* Header of the benchmark requests and answers, followed by a pattern up to the payload size */
+typedef struct user_bench_msg_str
+{
+	uint8_t		id;			/* USER_BENCH_MSG_ID */
+	uint8_t		type;		/* Request or answer */
+	uint8_t		run;		/* ID of the payload size being tested, to discard the late answers */
+	uint16_t	seq;		/* Sequence number of the request */
+} user_bench_msg_t;
+
+#pragma pack(pop)
+
+/* Request in flight */
+typedef struct user_bench_slot_str
+{
+	bool		used;
+	uint8_t		handle;		/* Handle of the G3UDP-DATA or G3ICMP-ECHO request */
+	uint16_t	seq;		/* Sequence number of the request */
+	uint32_t	sent_ts;	/* Time of the request, in ms */
+} user_bench_slot_t;
+
+/* Results for one payload size */
+typedef struct user_bench_size_stats_str
+{
+	uint16_t	size;								/* Payload size, in bytes */
+	uint32_t	sent;								/* Number of requests sent */
+	uint16_t	received;							/* Number of answers received */
+	uint32_t	start_ts;							/* Time of the start of the test, in ms */
+	uint32_t	rtt_sum;							/* Sum of the round-trip times, in ms */
+	uint32_t	rtt[USER_BENCH_SAMPLES_MAX];		/* Round-trip time of each answer, in ms */
+} user_bench_size_stats_t;
+
+typedef struct user_bench_fsm_str
+{
+	/* FSM */
+	user_bench_state_t		curr_state;							/*!<  Current state of the benchmark */
+	user_bench_event_t		curr_event;							/*!<  Current event of the benchmark */
+	uint32_t				operation_counter;					/*!<  Operation counter of the benchmark FSM */
+
+	/* Run */
+	user_bench_params_t		params;								/*!<  Parameters of the run */
+	uint8_t					size_index;							/*!<  Index of the payload size being tested */
+	uint8_t					run_id;								/*!<  ID of the payload size being tested, carried by the requests */
+	uint16_t				next_seq;							/*!<  Sequence number of the next request */
+	uint8_t					in_flight;							/*!<  Number of requests waiting for the answer */
+	uint8_t					icmp_handle;						/*!<  Handle of the last G3ICMP-ECHO request */
+	uint32_t				last_send_ts;						/*!<  Time of the last request, in ms */
+	user_bench_slot_t		slot[USER_BENCH_WINDOW_MAX];		/*!<  Requests in flight */
+	uint8_t					buffer[USER_BENCH_PAYLOAD_MAX];		/*!<  Request to send */
+
+	user_bench_size_stats_t	stats;								/*!<  Results of the payload size being tested */
+} user_bench_fsm_t;
+
+/* External variables */
+extern osMessageQueueId_t	user_queueHandle;
+extern osTimerId_t 			benchTimerHandle;
+
+extern plc_mode_t			working_plc_mode;
+extern userg3_common_t		userg3_common;
+
+/* Private variables */
+static user_bench_fsm_t		user_bench_fsm;
+
+static const char *user_bench_type_str[] = { "udp", "icmp", "mac" };
+
+/* Private function pointer type */
+typedef user_bench_state_t user_bench_fsm_func(void);
+
+/* Private FSM function prototypes */
+static user_bench_state_t user_bench_fsm_default(void);
+static user_bench_state_t user_bench_fsm_start(void);
+static user_bench_state_t user_bench_fsm_run(void);
+static user_bench_state_t user_bench_fsm_stop(void);
+
+/* Private FSM function pointer array */
+static user_bench_fsm_func *user_bench_fsm_func_tbl[USER_BENCH_ST_CNT][USER_BENCH_EV_CNT] = {
+/*				NONE,                    START,                   REPLY,                   TIMEOUT,                 STOP */
+/* IDLE    */ { user_bench_fsm_default,  user_bench_fsm_start,    user_bench_fsm_default,  user_bench_fsm_default,  user_bench_fsm_default	},
+/* RUNNING */ { user_bench_fsm_default,  user_bench_fsm_default,  user_bench_fsm_run,      user_bench_fsm_run,      user_bench_fsm_stop		},
+};
+
+/* Private functions */
+
+/**
+ * @brief Compares two round-trip times, for the sorting of the samples.
+ * @param a Pointer to the first round-trip time.
+ * @param b Pointer to the second round-trip time.
+ * @retval Negative, zero or positive value if the first one is lower, equal or higher
+ */
+static int user_bench_compare_rtt(const void *a, const void *b)
+{
+	uint32_t rtt_a = *((const uint32_t*) a);
+	uint32_t rtt_b = *((const uint32_t*) b);
+
+	return (rtt_a > rtt_b) - (rtt_a < rtt_b);
+}
+
+/**
+ * @brief Prints the CSV header of the results.
+ * @param None
+ * @retval None
+ */
+static void user_bench_print_header(void)
+{
+	PRINT_NOTS("%s,type,target,size,count,sent,received,loss_pct,rtt_min_ms,rtt_mean_ms,rtt_p50_ms,rtt_p95_ms,rtt_p99_ms,duration_ms,throughput_bps\n", USER_BENCH_CSV_TAG);
+}
+
+/**
+ * @brief Prints the CSV line with the results of the payload size just tested.
+ * @param None
+ * @retval None
+ */
+static void user_bench_print_results(void)
+{
+	user_bench_size_stats_t *stats = &user_bench_fsm.stats;
+	const user_bench_params_t *params = &user_bench_fsm.params;
+
+	char		target_str[(2 * MAC_ADDR64_SIZE) + 1];
+	uint32_t	duration = HAL_GetTick() - stats->start_ts;
+	uint32_t	rtt_min = 0, rtt_mean = 0, rtt_p50 = 0, rtt_p95 = 0, rtt_p99 = 0;
+	uint32_t	throughput = 0;
+	uint16_t	n = stats->received;
+
+	if (params->type == user_bench_mac)
+	{
+		for (uint8_t i = 0; i < MAC_ADDR64_SIZE; i++)
+		{
+			sprintf(&target_str[2 * i], "%02X", params->ext_addr[i]);
+		}
+	}
+	else
+	{
+		sprintf(target_str, "%u", params->short_addr);
+	}
+
+	if (n > 0)
+	{
+		qsort(stats->rtt, n, sizeof(stats->rtt[0]), user_bench_compare_rtt);
+
+		rtt_min  = stats->rtt[0];
+		rtt_mean = stats->rtt_sum / n;
+		rtt_p50  = stats->rtt[USER_BENCH_PERCENTILE_INDEX(50U, n)];
+		rtt_p95  = stats->rtt[USER_BENCH_PERCENTILE_INDEX(95U, n)];
+		rtt_p99  = stats->rtt[USER_BENCH_PERCENTILE_INDEX(99U, n)];
+	}
+
+	if (duration > 0)
+	{
+		/* Goodput of the echoed payload */
+		throughput = (uint32_t) (((uint64_t) n * stats->size * 8U * 1000U) / duration);
+	}
+
+	/* The loss is computed on the requests expected, a request retried by the User MAC counts once */
+	float loss_pct = (params->count > 0) ? (100.0f * (float) (params->count - USER_BENCH_MIN(n, params->count)) / (float) params->count) : 0.0f;
+
+	PRINT_NOTS("%s,%s,%s,%u,%u,%u,%u,%.2f,%u,%u,%u,%u,%u,%u,%u\n", USER_BENCH_CSV_TAG, user_bench_type_str[params->type], target_str,
+			stats->size, params->count, stats->sent, n, loss_pct, rtt_min, rtt_mean, rtt_p50, rtt_p95, rtt_p99, duration, throughput);
+}
+
+/**
+ * @brief Ends the run.
+ * @param aborted True if the run was stopped before its end.
+ * @retval None
+ */
+static void user_bench_finish(const bool aborted)
+{
+	osTimerStop(benchTimerHandle);
+
+	memset(user_bench_fsm.slot, 0, sizeof(user_bench_fsm.slot));
+	user_bench_fsm.in_flight = 0;
+
+	PRINT_NOTS("%s,end,%s\n", USER_BENCH_CSV_TAG, (aborted) ? "aborted" : "done");
+
+	user_bench_fsm.curr_state = USER_BENCH_ST_IDLE;
+}
+
+/**
+ * @brief Prepares the test of the current payload size.
+ * @param None
+ * @retval None
+ */
+static void user_bench_size_begin(void)
+{
+	uint16_t size = user_bench_fsm.params.sizes[user_bench_fsm.size_index];
+
+	user_bench_fsm.run_id++;
+	user_bench_fsm.next_seq		= 0;
+	user_bench_fsm.in_flight	= 0;
+	memset(user_bench_fsm.slot, 0, sizeof(user_bench_fsm.slot));
+
+	/* Pattern after the header, the header is written for each request */
+	for (uint16_t i = sizeof(user_bench_msg_t); i < size; i++)
+	{
+		user_bench_fsm.buffer[i] = (uint8_t) i;
+	}
+
+	UserBench_SizeStart(size);
+}
+
+/**
+ * @brief Looks for the request in flight with a sequence number or a handle.
+ * @param seq Sequence number of the request.
+ * @param handle Handle of the request, used instead of the sequence number if seq is UINT16_MAX.
+ * @retval Pointer to the request, or NULL if not found
+ */
+static user_bench_slot_t* user_bench_find_slot(const uint16_t seq, const uint8_t handle)
+{
+	for (uint8_t i = 0; i < USER_BENCH_WINDOW_MAX; i++)
+	{
+		user_bench_slot_t *slot = &user_bench_fsm.slot[i];
+
+		if ((slot->used) && (((seq != UINT16_MAX) && (slot->seq == seq)) || ((seq == UINT16_MAX) && (slot->handle == handle))))
+		{
+			return slot;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Closes a request in flight.
+ * @param slot Pointer to the request.
+ * @param answered True if the answer was received, false if the request is lost.
+ * @retval None
+ */
+static void user_bench_close_slot(user_bench_slot_t *slot, const bool answered)
+{
+	if (answered)
+	{
+		UserBench_AddSample(HAL_GetTick() - slot->sent_ts);
+	}
+
+	slot->used = false;
+	user_bench_fsm.in_flight--;
+}
+
+/**
+ * @brief Handles an answer to one of the requests.
+ * @param msg Pointer to the header of the answer.
+ * @param length Length of the answer, in bytes.
+ * @retval None
+ */
+static void user_bench_handle_answer(const user_bench_msg_t *msg, const uint32_t length)
+{
+	if ((user_bench_fsm.curr_state == USER_BENCH_ST_RUNNING) && (length >= sizeof(user_bench_msg_t)) &&
+		(msg->id == USER_BENCH_MSG_ID) && (msg->type == USER_BENCH_ANSWER) && (msg->run == user_bench_fsm.run_id))
+	{
+		user_bench_slot_t *slot = user_bench_find_slot(msg->seq, 0);
+
+		/* Late or duplicated answers are discarded */
+		if (slot != NULL)
+		{
+			user_bench_close_slot(slot, true);
+
+			user_bench_fsm.curr_event = USER_BENCH_EV_REPLY;
+		}
+	}
+}
+
+/**
+ * @brief Parses the packets received on the benchmark connection, answering the requests.
+ * @param None
+ * @retval None
+ * @note The requests are left in the queue while the User G3 cannot take the answers, they are answered later.
+ */
+static void user_bench_parse_packets(void)
+{
+	udp_packet_t packet;
+
+	while ((UserG3_GetUdpTxSpace(BENCH_CONN_ID) > 0) && (UserG3_DequeueUdpData(BENCH_CONN_ID, &packet, 1) > 0))
+	{
+		const user_bench_msg_t *msg = packet.payload;
+
+		if ((packet.length < sizeof(user_bench_msg_t)) || (msg->id != USER_BENCH_MSG_ID))
+		{
+			PRINT_USER_G3_WARNING("Unexpected packet on the benchmark connection\n");
+		}
+		else if (msg->type == USER_BENCH_REQUEST)
+		{
+			/* The answer is the request itself, with its type changed */
+			uint8_t *answer = MEMPOOL_MALLOC(packet.length);
+
+			memcpy(answer, packet.payload, packet.length);
+			((user_bench_msg_t*) answer)->type = USER_BENCH_ANSWER;
+
+			if (UserG3_SendUdpData(BENCH_CONN_ID, packet.ip_addr, answer, packet.length) == 0)
+			{
+				PRINT_USER_G3_WARNING("Benchmark answer not sent\n");
+			}
+		}
+		else
+		{
+			user_bench_handle_answer(msg, packet.length);
+		}
+
+		UserG3_ReleaseUdpData(&packet);
+	}
+}
+
+/**
+ * @brief Counts as lost the requests not answered in time.
+ * @param None
+ * @retval None
+ */
+static void user_bench_expire(void)
+{
+	uint32_t now = HAL_GetTick();
+
+	for (uint8_t i = 0; i < USER_BENCH_WINDOW_MAX; i++)
+	{
+		user_bench_slot_t *slot = &user_bench_fsm.slot[i];
+
+		if ((slot->used) && ((now - slot->sent_ts) >= USER_BENCH_REPLY_TIMEOUT))
+		{
+			user_bench_close_slot(slot, false);
+		}
+	}
+}
+
+/**
+ * @brief Function called by the User G3 when a request is confirmed.
+ * @param connection_id ID of the connection of the request.
+ * @param handle Handle of the request.
+ * @param status Status of the G3UDP-DATA.Confirm.
+ * @retval None
+ */
+static void user_bench_tx_callback(const uint8_t connection_id, const uint8_t handle, const uint8_t status)
+{
+	UNUSED(connection_id);
+
+	if (status != G3_SUCCESS)
+	{
+		user_bench_slot_t *slot = user_bench_find_slot(UINT16_MAX, handle);
+
+		/* No answer can arrive */
+		if (slot != NULL)
+		{
+			user_bench_close_slot(slot, false);
+
+			user_bench_fsm.curr_event = USER_BENCH_EV_TIMEOUT;
+		}
+	}
+}
+
+/**
+ * @brief Sends the next request.
+ * @param slot Pointer to the free slot for the request.
+ * @retval True if the request was sent, false if it must be sent later
+ */
+static bool user_bench_send(user_bench_slot_t *slot)
+{
+	user_bench_msg_t	*msg = (user_bench_msg_t*) user_bench_fsm.buffer;
+	uint16_t			size = user_bench_fsm.stats.size;
+	ip6_addr_t			dst_ip_addr;
+	uint8_t				handle = 0;
+
+	msg->id		= USER_BENCH_MSG_ID;
+	msg->type	= USER_BENCH_REQUEST;
+	msg->run	= user_bench_fsm.run_id;
+	msg->seq	= user_bench_fsm.next_seq;
+
+	hi_ipv6_set_ipaddr(&dst_ip_addr, userg3_common.pan_id, user_bench_fsm.params.short_addr);
+
+	if (user_bench_fsm.params.type == user_bench_udp)
+	{
+		/* Back-pressure from the transmit queue of the User G3 */
+		if (UserG3_GetUdpTxSpace(BENCH_CONN_ID) > 0)
+		{
+			handle = UserG3_SendUdpDataAsync(BENCH_CONN_ID, dst_ip_addr, user_bench_fsm.buffer, size, user_bench_tx_callback);
+		}
+	}
+	else
+	{
+		IP_G3IcmpDataRequest_t *icmp_data_req = MEMPOOL_MALLOC(sizeof(IP_G3IcmpDataRequest_t));
+
+		/* Handle 0 is used for the rejected requests */
+		if (++user_bench_fsm.icmp_handle == 0)
+		{
+			user_bench_fsm.icmp_handle++;
+		}
+
+		handle = user_bench_fsm.icmp_handle;
+
+		uint16_t len = hi_ipv6_echoreq_fill(icmp_data_req, dst_ip_addr, handle, size, user_bench_fsm.buffer);
+		g3_send_message(HIF_TX_MSG, HIF_ICMP_ECHO_REQ, icmp_data_req, len);
+	}
+
+	if (handle != 0)
+	{
+		slot->used		= true;
+		slot->handle	= handle;
+		slot->seq		= user_bench_fsm.next_seq++;
+		slot->sent_ts	= HAL_GetTick();
+
+		user_bench_fsm.last_send_ts = slot->sent_ts;
+		user_bench_fsm.in_flight++;
+
+		UserBench_AddSent();
+	}
+
+	return (handle != 0);
+}
+
+/**
+ * @brief Sends the requests allowed by the concurrency and by the interval.
+ * @param None
+ * @retval None
+ */
+static void user_bench_send_pending(void)
+{
+	while ((user_bench_fsm.next_seq < user_bench_fsm.params.count) && (user_bench_fsm.in_flight < user_bench_fsm.params.concurrency))
+	{
+		if ((user_bench_fsm.next_seq > 0) && ((HAL_GetTick() - user_bench_fsm.last_send_ts) < user_bench_fsm.params.interval))
+		{
+			break;
+		}
+
+		user_bench_slot_t *slot = NULL;
+
+		for (uint8_t i = 0; i < USER_BENCH_WINDOW_MAX; i++)
+		{
+			if (!user_bench_fsm.slot[i].used)
+			{
+				slot = &user_bench_fsm.slot[i];
+				break;
+			}
+		}
+
+		if ((slot == NULL) || (!user_bench_send(slot)))
+		{
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Starts the timer for the next request or for the request that times out first.
+ * @param None
+ * @retval None
+ */
+static void user_bench_restart_timer(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t timeout = 0;
+
+	/* Next request delayed by the interval */
+	if ((user_bench_fsm.next_seq < user_bench_fsm.params.count) && (user_bench_fsm.in_flight < user_bench_fsm.params.concurrency))
+	{
+		uint32_t elapsed = now - user_bench_fsm.last_send_ts;
+
+		timeout = (elapsed < user_bench_fsm.params.interval) ? (user_bench_fsm.params.interval - elapsed) : 1;
+	}
+
+	for (uint8_t i = 0; i < USER_BENCH_WINDOW_MAX; i++)
+	{
+		const user_bench_slot_t *slot = &user_bench_fsm.slot[i];
+
+		if (slot->used)
+		{
+			uint32_t elapsed	= now - slot->sent_ts;
+			uint32_t remaining	= (elapsed < USER_BENCH_REPLY_TIMEOUT) ? (USER_BENCH_REPLY_TIMEOUT - elapsed) : 1;
+
+			if ((timeout == 0) || (remaining < timeout))
+			{
+				timeout = remaining;
+			}
+		}
+	}
+
+	if (timeout > 0)
+	{
+		osTimerStart(benchTimerHandle, timeout);
+	}
+	else
+	{
+		osTimerStop(benchTimerHandle);
+	}
+}
+
+/**
+ * @brief Parses a number of the command line.
+ * @param token Token of the command line, can be NULL.
+ * @param default_value Value used if the token is missing.
+ * @param value Pointer to the parsed value.
+ * @retval True if the number is valid, false otherwise
+ */
+static bool user_bench_parse_number(const char *token, const uint32_t default_value, uint32_t *value)
+{
+	char *end = NULL;
+
+	if (token == NULL)
+	{
+		*value = default_value;
+		return true;
+	}
+
+	*value = strtoul(token, &end, 10);
+
+	return ((end != token) && (*end == '\0'));
+}
+
+/**
+ * @brief Parses an extended address, 16 hexadecimal digits.
+ * @param token Token of the command line.
+ * @param ext_addr Pointer to the parsed address.
+ * @retval True if the address is valid, false otherwise
+ */
+static bool user_bench_parse_ext_addr(const char *token, uint8_t *ext_addr)
+{
+	char byte_str[3] = { 0 };
+	char *end = NULL;
+
+	if (strlen(token) != (2 * MAC_ADDR64_SIZE))
+	{
+		return false;
+	}
+
+	for (uint8_t i = 0; i < MAC_ADDR64_SIZE; i++)
+	{
+		byte_str[0] = token[2 * i];
+		byte_str[1] = token[(2 * i) + 1];
+
+		ext_addr[i] = (uint8_t) strtoul(byte_str, &end, 16);
+
+		if (*end != '\0')
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Benchmark FSM function that maintains the current state, with no further action.
+ * @param None
+ * @retval The next state of the benchmark FSM (equal to the current one)
+ */
+static user_bench_state_t user_bench_fsm_default(void)
+{
+	user_bench_fsm.curr_event = USER_BENCH_EV_NONE;
+
+	return user_bench_fsm.curr_state;
+}
+
+/**
+ * @brief Benchmark FSM function that starts the run.
+ * @param None
+ * @retval The next state of the benchmark FSM
+ */
+static user_bench_state_t user_bench_fsm_start(void)
+{
+	user_bench_fsm.curr_state = USER_BENCH_ST_RUNNING;
+
+	user_bench_print_header();
+
+	user_bench_fsm.size_index = 0;
+	user_bench_size_begin();
+
+	return user_bench_fsm_run();
+}
+
+/**
+ * @brief Benchmark FSM function that sends the requests and moves to the next payload size when all the answers are in.
+ * @param None
+ * @retval The next state of the benchmark FSM
+ */
+static user_bench_state_t user_bench_fsm_run(void)
+{
+	user_bench_state_t next_state = USER_BENCH_ST_RUNNING;
+
+	user_bench_expire();
+
+	if ((user_bench_fsm.next_seq >= user_bench_fsm.params.count) && (user_bench_fsm.in_flight == 0))
+	{
+		UserBench_SizeEnd();
+
+		if (++user_bench_fsm.size_index < user_bench_fsm.params.size_num)
+		{
+			user_bench_size_begin();
+		}
+		else
+		{
+			user_bench_finish(false);
+
+			next_state = USER_BENCH_ST_IDLE;
+		}
+	}
+
+	if (next_state == USER_BENCH_ST_RUNNING)
+	{
+		user_bench_send_pending();
+		user_bench_restart_timer();
+	}
+
+	user_bench_fsm.curr_event = USER_BENCH_EV_NONE;
+
+	return next_state;
+}
+
+/**
+ * @brief Benchmark FSM function that aborts the run.
+ * @param None
+ * @retval The next state of the benchmark FSM
+ */
+static user_bench_state_t user_bench_fsm_stop(void)
+{
+	user_bench_finish(true);
+
+	user_bench_fsm.curr_event = USER_BENCH_EV_NONE;
+
+	return USER_BENCH_ST_IDLE;
+}
+
+/**
+ * @brief Handles the G3ICMP-ECHO.Confirm of the requests.
+ * @param payload Pointer to the payload of the received message.
+ * @retval None
+ */
+static void user_bench_handle_echo_cnf(const void *payload)
+{
+	const IP_G3IcmpDataConfirm_t *echo_cnf = payload;
+
+	if ((user_bench_fsm.curr_state == USER_BENCH_ST_RUNNING) && (user_bench_fsm.params.type == user_bench_icmp) && (echo_cnf->status != G3_SUCCESS))
+	{
+		user_bench_slot_t *slot = user_bench_find_slot(UINT16_MAX, echo_cnf->handle);
+
+		if (slot != NULL)
+		{
+			user_bench_close_slot(slot, false);
+
+			user_bench_fsm.curr_event = USER_BENCH_EV_TIMEOUT;
+		}
+	}
+}
+
+/**
+ * @brief Handles the G3ICMP-ECHOREP.Indication of the requests.
+ * @param payload Pointer to the payload of the received message.
+ * @retval None
+ */
+static void user_bench_handle_echorep_ind(const void *payload)
+{
+	const IP_IcmpDataIndication_t *data_ind = hi_ipv6_extract_icmp_from_ip(payload);
+	uint16_t src_pan_id, src_short_addr;
+
+	if ((user_bench_fsm.curr_state == USER_BENCH_ST_RUNNING) && (user_bench_fsm.params.type == user_bench_icmp))
+	{
+		hi_ipv6_get_saddr_panid(data_ind->source_address, &src_pan_id, &src_short_addr);
+
+		if (src_short_addr == user_bench_fsm.params.short_addr)
+		{
+			user_bench_handle_answer((const user_bench_msg_t*) data_ind->data, data_ind->data_len);
+		}
+	}
+}
+
+/**
+ * @}
+ */
+
+/** @addtogroup User_Bench_Exported_Code
+ * @{
+ */
+
+/**
+ * @brief Function that handles the initialization of the benchmark.
+ * @param None
+ * @retval None
+ */
+void UserBench_Init(void)
+{
+	memset(&user_bench_fsm, 0, sizeof(user_bench_fsm));
+
+	user_bench_fsm.curr_state = USER_BENCH_ST_IDLE;
+	user_bench_fsm.curr_event = USER_BENCH_EV_NONE;
+}
+
+/**
+ * @brief Function that checks if a message is needed by the benchmark.
+ * @param g3_msg Pointer to the G3 message structure to evaluate
+ * @return 'true' if the message is needed, 'false' otherwise.
+ */
+bool UserBench_MsgNeeded(const g3_msg_t *g3_msg)
+{
+	switch(g3_msg->command_id)
+	{
+	case HIF_UDP_DATA_IND:
+	case HIF_ICMP_ECHO_CNF:
+	case HIF_ICMP_ECHO_REP_IND:
+		return true;
+		break;
+	default:
+		return false;
+		break;
+	}
+}
+
+/**
+ * @brief Function that handles the G3 messages coming from the G3 task.
+ * @param g3_msg Pointer to the received G3 message
+ * @retval None
+ */
+void UserBench_MsgHandler(const g3_msg_t *g3_msg)
+{
+	assert(g3_msg->payload != NULL); /* All expected messages have payload */
+
+	switch (g3_msg->command_id)
+	{
+	case HIF_UDP_DATA_IND:
+		/* The packet is queued by the User G3, it is taken from the benchmark connection by the FSM */
+		break;
+	case HIF_ICMP_ECHO_CNF:
+		user_bench_handle_echo_cnf(g3_msg->payload);
+		break;
+	case HIF_ICMP_ECHO_REP_IND:
+		user_bench_handle_echorep_ind(g3_msg->payload);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Function that handles the state of the benchmark FSM.
+ * @param None
+ * @retval None
+ * @note Entry function called from User task infinite execution loop.
+ */
+void UserBench_FsmManager(void)
+{
+	user_bench_fsm.operation_counter++;
+
+	/* The requests of the other nodes are answered in any state */
+	user_bench_parse_packets();
+
+	user_bench_fsm.curr_state = user_bench_fsm_func_tbl[user_bench_fsm.curr_state][user_bench_fsm.curr_event]();
+}
+
+/**
+ * @brief Function that parses the command line of a run.
+ * @param command String with the command line, null-terminated (modified by the parsing).
+ * @param params Pointer to the parsed parameters.
+ * @retval True if the command line is valid, false otherwise
+ * @note Format: "udp|icmp <short_addr> [sizes] [count] [interval] [concurrency]" or "mac <ext_addr> [count]", the sizes separated by commas.
+ */
+bool UserBench_ParseCommand(char *command, user_bench_params_t *params)
+{
+	char		*token[6] = { NULL };
+	char		*sizes_str;
+	uint32_t	value;
+	bool		valid = true;
+
+	assert(command != NULL);
+	assert(params != NULL);
+
+	memset(params, 0, sizeof(*params));
+
+	token[0] = strtok(command, USER_BENCH_CMD_DELIMITER);
+
+	for (uint8_t i = 1; (i < NUM_OF_ELEM(token)) && (token[i - 1] != NULL); i++)
+	{
+		token[i] = strtok(NULL, USER_BENCH_CMD_DELIMITER);
+	}
+
+	/* Type */
+	if ((token[0] != NULL) && (strcmp(token[0], "udp") == 0))
+	{
+		params->type = user_bench_udp;
+	}
+	else if ((token[0] != NULL) && (strcmp(token[0], "icmp") == 0))
+	{
+		params->type = user_bench_icmp;
+	}
+	else if ((token[0] != NULL) && (strcmp(token[0], "mac") == 0))
+	{
+		params->type = user_bench_mac;
+	}
+	else
+	{
+		PRINT("Unknown benchmark type\n");
+		valid = false;
+	}
+
+	/* Target */
+	if (valid)
+	{
+		if (token[1] == NULL)
+		{
+			PRINT("Missing benchmark target\n");
+			valid = false;
+		}
+		else if (params->type == user_bench_mac)
+		{
+			valid = user_bench_parse_ext_addr(token[1], params->ext_addr);
+		}
+		else
+		{
+			valid = user_bench_parse_number(token[1], 0, &value) && (value <= UINT16_MAX);
+			params->short_addr = (uint16_t) value;
+		}
+
+		if (!valid)
+		{
+			PRINT("Invalid benchmark target: %s\n", token[1]);
+		}
+	}
+
+	/* The User MAC exchanges frames of fixed size, one at a time: only the count can be set */
+	if (valid && (params->type == user_bench_mac))
+	{
+		if (token[3] != NULL)
+		{
+			PRINT("The MAC benchmark does not support payload sizes, interval and concurrency\n");
+			valid = false;
+		}
+		else
+		{
+			/* The count follows the target, the other parameters keep their defaults */
+			token[3] = token[2];
+			token[2] = NULL;
+		}
+	}
+
+	/* Payload sizes */
+	if (valid)
+	{
+		if (token[2] == NULL)
+		{
+			params->sizes[params->size_num++] = USER_BENCH_DEFAULT_SIZE;
+		}
+		else
+		{
+			/* The other tokens are already split, strtok can be used again on this one */
+			sizes_str = strtok(token[2], USER_BENCH_SIZE_DELIMITER);
+
+			while ((valid) && (sizes_str != NULL))
+			{
+				if ((params->size_num < USER_BENCH_SIZES_MAX) && user_bench_parse_number(sizes_str, 0, &value) &&
+					(value >= sizeof(user_bench_msg_t)) && (value <= USER_BENCH_PAYLOAD_MAX))
+				{
+					params->sizes[params->size_num++] = (uint16_t) value;
+				}
+				else
+				{
+					PRINT("Invalid payload size: %s (%u - %u bytes, up to %u sizes)\n", sizes_str, (unsigned) sizeof(user_bench_msg_t), USER_BENCH_PAYLOAD_MAX, USER_BENCH_SIZES_MAX);
+					valid = false;
+				}
+
+				sizes_str = strtok(NULL, USER_BENCH_SIZE_DELIMITER);
+			}
+		}
+	}
+
+	/* Count */
+	if (valid)
+	{
+		valid = user_bench_parse_number(token[3], USER_BENCH_DEFAULT_COUNT, &value) && (value > 0) && (value <= USER_BENCH_SAMPLES_MAX);
+		params->count = (uint16_t) value;
+
+		if (!valid)
+		{
+			PRINT("Invalid count: %s (1 - %u)\n", token[3], USER_BENCH_SAMPLES_MAX);
+		}
+	}
+
+	/* Interval */
+	if (valid)
+	{
+		valid = user_bench_parse_number(token[4], 0, &params->interval);
+
+		if (!valid)
+		{
+			PRINT("Invalid interval: %s\n", token[4]);
+		}
+	}
+
+	/* Concurrency */
+	if (valid)
+	{
+		valid = user_bench_parse_number(token[5], 1, &value) && (value > 0) && (value <= USER_BENCH_WINDOW_MAX);
+		params->concurrency = (uint8_t) value;
+
+		if (!valid)
+		{
+			PRINT("Invalid concurrency: %s (1 - %u)\n", token[5], USER_BENCH_WINDOW_MAX);
+		}
+	}
+
+	return valid;
+}
+
+/**
+ * @brief Function that starts a run.
+ * @param params Pointer to the parameters of the run.
+ * @retval True if the run was started, false otherwise
+ * @note The MAC runs are executed by the User MAC (MAC PLC mode), the UDP and ICMP runs by this FSM (IPv6 PLC modes).
+ */
+bool UserBench_Start(const user_bench_params_t *params)
+{
+	bool started = false;
+	bool mac_mode = (working_plc_mode == PLC_MODE_MAC);
+
+	assert(params != NULL);
+
+	if (user_bench_fsm.curr_state != USER_BENCH_ST_IDLE)
+	{
+		PRINT("Benchmark already in progress\n");
+	}
+	else if ((params->type == user_bench_mac) != mac_mode)
+	{
+		PRINT("The %s benchmark is not available in this PLC mode\n", user_bench_type_str[params->type]);
+	}
+	else if (mac_mode)
+	{
+		if (UserMac_IsReady())
+		{
+			user_bench_fsm.params = *params;
+
+			user_bench_fsm.curr_state = USER_BENCH_ST_RUNNING;
+
+			user_bench_print_header();
+
+			/* The User MAC reverses the address in place */
+			uint8_t dst_addr[MAC_ADDR64_SIZE];
+			memcpy(dst_addr, params->ext_addr, sizeof(dst_addr));
+
+			UserMac_StartBenchmark(dst_addr, params->count);
+
+			started = true;
+		}
+		else
+		{
+			PRINT("MAC test in progress\n");
+		}
+	}
+	else
+	{
+		user_bench_fsm.params		= *params;
+		user_bench_fsm.curr_event	= USER_BENCH_EV_START;
+
+		UserG3_RequestFsmExecution(user_bench_fsm.operation_counter);
+
+		started = true;
+	}
+
+	return started;
+}
+
+/**
+ * @brief Function that aborts the current run.
+ * @param None
+ * @retval None
+ */
+void UserBench_Stop(void)
+{
+	if (user_bench_fsm.curr_state == USER_BENCH_ST_RUNNING)
+	{
+		user_bench_fsm.curr_event = USER_BENCH_EV_STOP;
+
+		RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+	}
+}
+
+/**
+ * @brief Function that checks if a run is in progress.
+ * @param None
+ * @retval True if a run is in progress, false otherwise
+ */
+bool UserBench_InProgress(void)
+{
+	return ((user_bench_fsm.curr_state != USER_BENCH_ST_IDLE) || (user_bench_fsm.curr_event == USER_BENCH_EV_START));
+}
+
+/**
+ * @brief Function that prints the format of the command line.
+ * @param None
+ * @retval None
+ */
+void UserBench_PrintUsage(void)
+{
+	if (working_plc_mode == PLC_MODE_MAC)
+	{
+		PRINT("Benchmark: mac <ext_addr> [count] (fixed frame size, one frame at a time)\n");
+		PRINT("Defaults: %u requests. Results are printed as CSV lines starting with '%s'\n",
+				USER_BENCH_DEFAULT_COUNT, USER_BENCH_CSV_TAG);
+	}
+	else
+	{
+		PRINT("Benchmark: udp|icmp <short_addr> [size1,size2,...] [count] [interval_ms] [concurrency]\n");
+		PRINT("Defaults: %u bytes, %u requests, no interval, concurrency 1. Results are printed as CSV lines starting with '%s'\n",
+				USER_BENCH_DEFAULT_SIZE, USER_BENCH_DEFAULT_COUNT, USER_BENCH_CSV_TAG);
+	}
+}
+
+/**
+ * @brief Function that starts the statistics of a payload size.
+ * @param size Payload size, in bytes.
+ * @retval None
+ */
+void UserBench_SizeStart(const uint16_t size)
+{
+	memset(&user_bench_fsm.stats, 0, sizeof(user_bench_fsm.stats));
+
+	user_bench_fsm.stats.size		= size;
+	user_bench_fsm.stats.start_ts	= HAL_GetTick();
+}
+
+/**
+ * @brief Function that adds a round-trip time to the statistics of the current payload size.
+ * @param rtt Round-trip time, in ms.
+ * @retval None
+ */
+void UserBench_AddSample(const uint32_t rtt)
+{
+	if (user_bench_fsm.stats.received < USER_BENCH_SAMPLES_MAX)
+	{
+		user_bench_fsm.stats.rtt[user_bench_fsm.stats.received++] = rtt;
+		user_bench_fsm.stats.rtt_sum += rtt;
+	}
+}
+
+/**
+ * @brief Function that counts a request in the statistics of the current payload size.
+ * @param None
+ * @retval None
+ */
+void UserBench_AddSent(void)
+{
+	user_bench_fsm.stats.sent++;
+}
+
+/**
+ * @brief Function that ends the statistics of the current payload size, printing them.
+ * @param None
+ * @retval None
+ * @note For the MAC runs, this also ends the run.
+ */
+void UserBench_SizeEnd(void)
+{
+	user_bench_print_results();
+
+	if (user_bench_fsm.params.type == user_bench_mac)
+	{
+		user_bench_finish(false);
+	}
+}
+
+/**
+ * @brief Callback function of the benchTimer FreeRTOS timer.
+ * @param argument Unused argument.
+ * @retval None
+ */
+void UserBench_TimeoutCallback(void *argument)
+{
+	UNUSED(argument);
+
+	if (user_bench_fsm.curr_event == USER_BENCH_EV_NONE)
+	{
+		user_bench_fsm.curr_event = USER_BENCH_EV_TIMEOUT;
+	}
+
+	RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+}
+
+#endif /* ENABLE_BENCHMARK */
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -25,7 +25,11 @@
 #include <g3_app_config.h>
 #include <g3_app_keep_alive.h>
 #include <g3_app_last_gasp.h>
+#include <image_download.h>
 #include <user_g3_common.h>
+#include <user_bench.h>
+#include <user_modbus_gw.h>
+#include <user_poll.h>
 
 /** @addtogroup User_App
   * @{
@@ -51,6 +55,8 @@
 #define CONFIRM_TIMEOUT                         (30000U)	/* In ms */
 
 /* Private constants and macros */
+#define USER_G3_RX_BIG_BLOCKS					(MEM_BLOCK_NUM_BIG - 2)	/* Maximum number of big memory pool blocks held by the received UDP packets of all connections
+																		   (one is left to the Host Interface reception, one to the message in progress) */
 
 /* User event private macros */
 #define RAISE_USER_EVENT(event_pos, msg_ok) 	userg3_common.user_events 			|= (            1UL    << event_pos);	\
@@ -83,6 +89,46 @@ typedef enum userg3_event_enum
 
 /* Private structures */
 
+/* Queue of the UDP packets received on a connection, each packet owns the payload of its G3UDP-DATA.Ind message */
+typedef struct udp_rx_queue_str
+{
+	udp_packet_t		packet[USER_G3_RX_QUEUE_SIZE];
+	uint8_t				head;								/*!<  Index of the oldest packet */
+	uint8_t				count;								/*!<  Number of queued packets */
+	uint32_t			received;							/*!<  Number of packets queued */
+	uint32_t			dropped;							/*!<  Number of packets dropped because the queue was full, or no memory pool block was left */
+} udp_rx_queue_t;
+
+/* UDP packet waiting to be sent on a connection */
+typedef struct udp_tx_entry_str
+{
+	udp_packet_t			packet;								/*!<  Packet to send, its payload is a memory pool block */
+	uint8_t					handle;								/*!<  Handle assigned to the packet */
+	userg3_tx_callback_t	*callback;							/*!<  Function called when the packet is confirmed (can be NULL) */
+} udp_tx_entry_t;
+
+/* Queue of the UDP packets waiting to be sent on a connection */
+typedef struct udp_tx_queue_str
+{
+	udp_tx_entry_t		entry[USER_G3_TX_QUEUE_SIZE];
+	uint8_t				head;								/*!<  Index of the oldest packet */
+	uint8_t				count;								/*!<  Number of queued packets */
+	uint32_t			sent;								/*!<  Number of G3UDP-DATA.Request messages sent */
+	uint32_t			confirmed;							/*!<  Number of positive confirms received */
+	uint32_t			failed;								/*!<  Number of negative or missing confirms */
+	uint32_t			rejected;							/*!<  Number of packets rejected because the queue was full */
+} udp_tx_queue_t;
+
+/* G3UDP-DATA.Request sent to the platform and waiting for its confirm */
+typedef struct udp_tx_pending_str
+{
+	bool					used;								/*!<  Indicates if the element of the window is in use */
+	uint8_t					connection_id;						/*!<  Connection of the request */
+	uint8_t					handle;								/*!<  Handle of the request */
+	userg3_tx_callback_t	*callback;							/*!<  Function called when the request is confirmed (can be NULL) */
+	uint32_t				timestamp;							/*!<  Time of the request, in ms */
+} udp_tx_pending_t;
+
 /* User G3 UDP FSM */
 typedef struct userg3_fsm_info_str
 {
@@ -90,15 +136,33 @@ typedef struct userg3_fsm_info_str
 	userg3_event_t 		curr_event;							/*!<  Current UserG3 FSM event */
 	uint32_t			operation_counter;					/*!<  Operation counter of the User G3 FSM */
 	loop_info_t  		loopback;							/*!<  Stores info about UDP loop-back */
-	udp_packet_t 		data_received[CONN_NUMBER];			/*!<  Each element contains the data related to the last G3-UDP packet received */
-	udp_packet_t		data_to_send;						/*!<  Contains the data related to G3UDP packet to send */
-	uint8_t 			handle;								/*!<  Handle of the last G3UDP packet sent */
+	udp_rx_queue_t 		rx_queue[CONN_NUMBER];				/*!<  Each element contains the G3-UDP packets received on a connection */
+	uint8_t				rx_big_blocks;						/*!<  Number of big memory pool blocks held by the received packets */
+	udp_tx_queue_t		tx_queue[CONN_NUMBER];				/*!<  Each element contains the G3-UDP packets waiting to be sent on a connection */
+	udp_tx_pending_t	tx_window[USER_G3_TX_WINDOW_SIZE];	/*!<  G3UDP-DATA.Request messages waiting for their confirm */
+	uint8_t				tx_pending;							/*!<  Number of used elements of the window */
+	uint8_t				tx_next;							/*!<  Connection served first when the window has room (round-robin) */
 	uint8_t 			connection_handle[CONN_NUMBER]; 	/*!<  Handle of the last G3UDP packet sent, for each connection */
 } userg3_fsm_t;
 
 /* Private variables */
 static userg3_fsm_t 	userg3_fsm;				/*!<  Contains the FSM data for the User G3 */
 
+/* User applications on the UDP connections, in the order they get the G3 messages and run their FSM */
+static const user_g3_app_t user_g3_apps[] = {
+#if ENABLE_METER_POLLING
+	{ UserPoll_Init,		UserPoll_MsgNeeded,		UserPoll_MsgHandler,		UserPoll_FsmManager		},
+#endif
+#if ENABLE_BENCHMARK
+	{ UserBench_Init,		UserBench_MsgNeeded,	UserBench_MsgHandler,		UserBench_FsmManager	},
+#endif
+#if ENABLE_MODBUS_GATEWAY
+	{ UserModbusGw_Init,	UserModbusGw_MsgNeeded,	UserModbusGw_MsgHandler,	UserModbusGw_FsmManager	},
+#endif
+	/* Add here more User applications */
+	{ NULL,					NULL,					NULL,						NULL					}
+};
+
 /**
   * @}
   */
@@ -140,15 +204,14 @@ static userg3_state_t userg3_fsm_default(void);
 static userg3_state_t userg3_fsm_set_connection(void);
 static userg3_state_t userg3_fsm_send_data(void);
 static userg3_state_t userg3_fsm_next_connection(void);
-static userg3_state_t userg3_fsm_set_ready(void);
 
 /* Private FSM function pointer array */
 static userg3_fsm_func *userg3_fsm_func_tbl[USER_G3_ST_CNT][USER_G3_EV_CNT] = {
 /*                            NONE,               SET_CONNECTION,            RECEIVED_SET_CNF,           SEND_UDP_DATA,        RECEIVED_UDP_DATA_CNF,	RECEIVED_UDP_DATA_IND,	CNF_TIMEOUT */
 /* UDP_INIT              */ { userg3_fsm_default, userg3_fsm_set_connection, userg3_fsm_default,         userg3_fsm_default,   userg3_fsm_default,		userg3_fsm_default,		userg3_fsm_default			},
-/* UDP_READY             */ { userg3_fsm_default, userg3_fsm_set_connection, userg3_fsm_default,         userg3_fsm_send_data, userg3_fsm_default,		userg3_fsm_default,		userg3_fsm_default			},
+/* UDP_READY             */ { userg3_fsm_default, userg3_fsm_set_connection, userg3_fsm_default,         userg3_fsm_send_data, userg3_fsm_send_data,	userg3_fsm_default,		userg3_fsm_send_data		},
 /* WAIT_FOR_UDP_SET_CNF  */ { userg3_fsm_default, userg3_fsm_default,        userg3_fsm_next_connection, userg3_fsm_default,   userg3_fsm_default,		userg3_fsm_default,		userg3_fsm_next_connection	},
-/* WAIT_FOR_UDP_DATA_CNF */ { userg3_fsm_default, userg3_fsm_default,        userg3_fsm_default,         userg3_fsm_default,   userg3_fsm_set_ready,	userg3_fsm_default,		userg3_fsm_set_ready		}
+/* WAIT_FOR_UDP_DATA_CNF */ { userg3_fsm_default, userg3_fsm_default,        userg3_fsm_default,         userg3_fsm_default,   userg3_fsm_send_data,	userg3_fsm_default,		userg3_fsm_send_data		}
 };
 
 /* Private functions */
@@ -231,6 +294,208 @@ static bool userg3_set_next_connection()
 	return found;
 }
 
+/**
+  * @brief User G3 function that removes the next UDP packet to send from the transmit queues, serving the connections in turn.
+  * @param entry Pointer to the structure where the packet is moved.
+  * @return True if a packet was found, false if all queues are empty.
+  */
+static bool userg3_tx_dequeue(udp_tx_entry_t *entry)
+{
+	bool found = false;
+
+	for (uint8_t i = 0; i < CONN_NUMBER; i++)
+	{
+		uint8_t connection_id = (userg3_fsm.tx_next + i) % CONN_NUMBER;
+		udp_tx_queue_t *tx_queue = &userg3_fsm.tx_queue[connection_id];
+
+		if (tx_queue->count > 0)
+		{
+			if (osKernelLock() == osOK)
+			{
+				*entry = tx_queue->entry[tx_queue->head];
+
+				tx_queue->head = (tx_queue->head + 1) % USER_G3_TX_QUEUE_SIZE;
+				tx_queue->count--;
+
+				osKernelUnlock();
+			}
+			else
+			{
+				Error_Handler();
+			}
+
+			/* The next search starts from the following connection */
+			userg3_fsm.tx_next = (connection_id + 1) % CONN_NUMBER;
+
+			found = true;
+			break;
+		}
+	}
+
+	return found;
+}
+
+/**
+  * @brief User G3 function that sends a G3UDP-DATA.Request to ST8500 and adds it to the transmit window.
+  * @param entry Pointer to the packet to send, its payload is freed.
+  * @retval None
+  */
+static void userg3_tx_request(udp_tx_entry_t *entry)
+{
+	uint8_t 				connection_id = entry->packet.connection_id;
+	ip6_addr_t          	dst_ip_addr;
+	uint16_t            	dest_port;
+	IP_G3UdpDataRequest_t	*udpdata_req = MEMPOOL_MALLOC(sizeof(IP_G3UdpDataRequest_t)); /* Use memory pool due to big structure size */
+
+	if (userg3_fsm.loopback.requested == true)
+	{
+		userg3_fsm.loopback.requested = false; /* must be set to true everytime */
+
+		dst_ip_addr = userg3_fsm.loopback.dest_ip_addr;
+		dest_port	= userg3_fsm.loopback.remote_port;
+	}
+	else
+	{
+		dst_ip_addr = entry->packet.ip_addr;
+		dest_port	= entry->packet.port;
+	}
+
+#if (DEBUG_USER_G3 >= DEBUG_LEVEL_INFO)
+	ALLOC_DYNAMIC_HEX_STRING(dst_ip_addr_str, dst_ip_addr.u8, sizeof(dst_ip_addr.u8));
+	PRINT_USER_G3_INFO("Sending UDP data to connection %u, IPv6 %s, destination port %u, handle %u.\n", connection_id, dst_ip_addr_str, dest_port, entry->handle);
+	FREE_DYNAMIC_HEX_STRING(dst_ip_addr_str);
+#endif
+
+#if IS_COORD && ENABLE_ICMP_KEEP_ALIVE
+	/* Wait for Keep-Alive */
+	if (g3_app_ka_in_progress())
+	{
+		PRINT_USER_G3_WARNING("Waiting for Keep-Alive...\n");
+		while (g3_app_ka_in_progress())
+		{
+			utils_delay_ms(1);
+		}
+		PRINT_USER_G3_WARNING("Resumed\n");
+	}
+#endif
+
+	/* Send the message to ST8500 */
+	uint16_t len = hi_ipv6_udpdatareq_fill(udpdata_req, connection_id, dst_ip_addr, entry->handle, dest_port, entry->packet.length, entry->packet.payload);
+	g3_send_message(HIF_TX_MSG, HIF_UDP_DATA_REQ, udpdata_req, len);
+
+	/* Free memory pool used for payload */
+	MEMPOOL_FREE(entry->packet.payload);
+
+	/* Takes a free element of the window */
+	for (uint8_t i = 0; i < USER_G3_TX_WINDOW_SIZE; i++)
+	{
+		udp_tx_pending_t *pending = &userg3_fsm.tx_window[i];
+
+		if (!pending->used)
+		{
+			pending->used			= true;
+			pending->connection_id	= connection_id;
+			pending->handle			= entry->handle;
+			pending->callback		= entry->callback;
+			pending->timestamp		= HAL_GetTick();
+
+			userg3_fsm.tx_pending++;
+			break;
+		}
+	}
+
+	userg3_fsm.connection_handle[connection_id] = entry->handle;
+	userg3_fsm.tx_queue[connection_id].sent++;
+}
+
+/**
+  * @brief User G3 function that removes a request from the transmit window and notifies its result.
+  * @param pending Pointer to the element of the window.
+  * @param status Status of the G3UDP-DATA.Confirm (G3_SUCCESS or error).
+  * @retval None
+  */
+static void userg3_tx_complete(udp_tx_pending_t *pending, const uint8_t status)
+{
+	udp_tx_queue_t *tx_queue = &userg3_fsm.tx_queue[pending->connection_id];
+
+	if (status == G3_SUCCESS)
+	{
+		tx_queue->confirmed++;
+	}
+	else
+	{
+		tx_queue->failed++;
+	}
+
+	pending->used = false;
+	userg3_fsm.tx_pending--;
+
+	if (pending->callback != NULL)
+	{
+		pending->callback(pending->connection_id, pending->handle, status);
+	}
+}
+
+/**
+  * @brief User G3 function that removes from the transmit window the requests whose confirm did not arrive in time.
+  * @param None
+  * @retval None
+  */
+static void userg3_tx_expire(void)
+{
+	uint32_t now = HAL_GetTick();
+
+	for (uint8_t i = 0; i < USER_G3_TX_WINDOW_SIZE; i++)
+	{
+		udp_tx_pending_t *pending = &userg3_fsm.tx_window[i];
+
+		if ((pending->used) && ((now - pending->timestamp) >= CONFIRM_TIMEOUT))
+		{
+			PRINT_USER_G3_WARNING("UDP data confirm timeout (handle %u)\n", pending->handle);
+
+			/* Raise negative user event for User Terminal */
+			RAISE_USER_EVENT(USEREVT_G3_UDP_DATA_CNF, false);
+
+			userg3_tx_complete(pending, G3_RTE_INTERFACE_TIMEOUT);
+		}
+	}
+}
+
+/**
+  * @brief User G3 function that starts the timer for the oldest request of the transmit window, or stops it if the window is empty.
+  * @param None
+  * @retval None
+  */
+static void userg3_tx_restart_timer(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t timeout = 0;
+
+	for (uint8_t i = 0; i < USER_G3_TX_WINDOW_SIZE; i++)
+	{
+		udp_tx_pending_t *pending = &userg3_fsm.tx_window[i];
+
+		if (pending->used)
+		{
+			uint32_t remaining = CONFIRM_TIMEOUT - (now - pending->timestamp);
+
+			if ((timeout == 0) || (remaining < timeout))
+			{
+				timeout = remaining;
+			}
+		}
+	}
+
+	if (timeout > 0)
+	{
+		osTimerStart(commTimerHandle, timeout);
+	}
+	else
+	{
+		osTimerStop(commTimerHandle);
+	}
+}
+
 /**
   * @brief User G3 FSM function that maintains the current state, with no further action.
   * @param None
@@ -276,7 +541,8 @@ static userg3_state_t userg3_fsm_next_connection(void)
     	/* Otherwise, it has finished */
     	osTimerStop(commTimerHandle);
 
-    	next_state = USER_G3_ST_UDP_READY; /* All connections are set */
+    	/* All connections are set, sends the packets queued meanwhile */
+    	next_state = userg3_fsm_send_data();
     }
 
 	userg3_fsm.curr_event = USER_G3_EV_NONE;
@@ -285,108 +551,52 @@ static userg3_state_t userg3_fsm_next_connection(void)
 }
 
 /**
-  * @brief Function that handles the preparation and sending of HIF_UDP_DATA_REQ message to ST8500.
+  * @brief Function that handles the preparation and sending of HIF_UDP_DATA_REQ messages to ST8500, while the transmit window has room.
   * @param None
-  * @retval None
+  * @retval The next state of the User G3 FSM (WAIT_FOR_UDP_DATA_CNF if the window is full, UDP_READY otherwise).
   */
 static userg3_state_t userg3_fsm_send_data(void)
 {
-	userg3_state_t next_state;
+	udp_tx_entry_t entry;
+
+	/* Releases the requests whose confirm did not arrive in time */
+	userg3_tx_expire();
 
 #if !IS_COORD
 	if (g3_app_last_gasp_is_active())
 	{
 		/* Data cannot be sent in Last Gasp mode */
-		next_state = USER_G3_ST_UDP_READY;
-
-		PRINT_USER_G3_CRITICAL("Cannot sent UDP data in Last Gasp");
-	}
-	else
-	{
-#endif
-		uint8_t 				connection_id;
-		ip6_addr_t          	dst_ip_addr;
-		uint16_t            	dest_port;
-		IP_G3UdpDataRequest_t	*udpdata_req = MEMPOOL_MALLOC(sizeof(IP_G3UdpDataRequest_t)); /* Use memory pool due to big structure size */
-
-		connection_id = userg3_fsm.data_to_send.connection_id;
-
-		if (userg3_fsm.loopback.requested == true)
+		while (userg3_tx_dequeue(&entry))
 		{
-			userg3_fsm.loopback.requested = false; /* must be set to true everytime */
+			PRINT_USER_G3_CRITICAL("Cannot sent UDP data in Last Gasp");
 
-			dst_ip_addr = userg3_fsm.loopback.dest_ip_addr;
-			dest_port	= userg3_fsm.loopback.remote_port;
-		}
-		else
-		{
-			dst_ip_addr = userg3_fsm.data_to_send.ip_addr;
-			dest_port	= userg3_fsm.data_to_send.port;
-		}
-
-#if (DEBUG_USER_G3 >= DEBUG_LEVEL_INFO)
-		ALLOC_DYNAMIC_HEX_STRING(dst_ip_addr_str, dst_ip_addr.u8, sizeof(dst_ip_addr.u8));
-		PRINT_USER_G3_INFO("Sending UDP data to connection %u, IPv6 %s, destination port %u.\n", connection_id, dst_ip_addr_str, dest_port);
-		FREE_DYNAMIC_HEX_STRING(dst_ip_addr_str);
-#endif
+			MEMPOOL_FREE(entry.packet.payload);
 
-		bool found = false;
+			userg3_fsm.tx_queue[entry.packet.connection_id].failed++;
 
-		for (uint8_t i = 0; i < userg3_common.connection_total_number; i++)
-		{
-			if (connection_list[i]->connection_id == connection_id)
+			if (entry.callback != NULL)
 			{
-				userg3_fsm.handle = userg3_fsm.connection_handle[i];
-				found = true;
-				break;
+				entry.callback(entry.packet.connection_id, entry.handle, G3_FAILED);
 			}
 		}
-
-		assert(found);
-
-#if IS_COORD && ENABLE_ICMP_KEEP_ALIVE
-		/* Wait for Keep-Alive */
-		if (g3_app_ka_in_progress())
+	}
+	else
+	{
+#endif
+		while ((userg3_fsm.tx_pending < USER_G3_TX_WINDOW_SIZE) && userg3_tx_dequeue(&entry))
 		{
-			PRINT_USER_G3_WARNING("Waiting for Keep-Alive...\n");
-			while (g3_app_ka_in_progress())
-			{
-				utils_delay_ms(1);
-			}
-			PRINT_USER_G3_WARNING("Resumed\n");
+			userg3_tx_request(&entry);
 		}
-#endif
-
-		/* Send the message to ST8500 */
-		uint16_t len = hi_ipv6_udpdatareq_fill(udpdata_req, connection_id, dst_ip_addr, userg3_fsm.handle, dest_port, userg3_fsm.data_to_send.length, userg3_fsm.data_to_send.payload);
-		g3_send_message(HIF_TX_MSG, HIF_UDP_DATA_REQ, udpdata_req, len);
-
-		/* Start timer to handle eventual timeout */
-		osTimerStart(commTimerHandle, CONFIRM_TIMEOUT);
-
-		/* Free memory pool used for payload */
-		MEMPOOL_FREE(userg3_fsm.data_to_send.payload);
-
-		next_state = USER_G3_ST_WAIT_FOR_UDP_DATA_CNF;
 #if !IS_COORD
 	}
 #endif
 
-	userg3_fsm.curr_event = USER_G3_EV_NONE;
+	/* Times out the oldest request of the window */
+	userg3_tx_restart_timer();
 
-    return next_state;
-}
+	userg3_fsm.curr_event = USER_G3_EV_NONE;
 
-/**
-  * @brief Function that handles sets ready the FSM for UDP.
-  * @param None
-  * @retval None
-  */
-static userg3_state_t userg3_fsm_set_ready(void)
-{
-    userg3_fsm.curr_event = USER_G3_EV_NONE;
-      
-    return USER_G3_ST_UDP_READY;
+	return (userg3_fsm.tx_pending < USER_G3_TX_WINDOW_SIZE) ? USER_G3_ST_UDP_READY : USER_G3_ST_WAIT_FOR_UDP_DATA_CNF;
 }
 
 /**
@@ -432,6 +642,8 @@ static void userg3_handle_server_start_cnf(const void *payload)
 
 		/* Goes online */
 		userg3_common.online = true;
+
+		setBootPhaseEnd(BOOT_PHASE_NETWORK);
 	}
 }
 
@@ -484,6 +696,8 @@ static void userg3_handle_device_start_cnf(const void *payload)
 
         /* Goes online */
     	userg3_common.online = true;
+
+    	setBootPhaseEnd(BOOT_PHASE_NETWORK);
     }
     else
     {
@@ -549,26 +763,33 @@ static void userg3_handle_udp_data_cnf(const void *payload)
     const IP_G3UdpDataConfirm_t *udp_data_cnf = payload;
     assert(udp_data_cnf != NULL);
     
-    if (udp_data_cnf->handle == userg3_fsm.handle)
-	{
-        userg3_fsm.curr_event = USER_G3_EV_RECEIVED_UDP_DATA_CNF;
+    /* Matches the confirm with a request of the window */
+    for (uint8_t i = 0; i < USER_G3_TX_WINDOW_SIZE; i++)
+    {
+    	udp_tx_pending_t *pending = &userg3_fsm.tx_window[i];
 
-        osTimerStop(commTimerHandle);
+    	if ((pending->used) && (udp_data_cnf->handle == pending->handle))
+		{
+			userg3_fsm.curr_event = USER_G3_EV_RECEIVED_UDP_DATA_CNF;
 
-        HANDLE_CNF_ERROR(HIF_UDP_DATA_CNF, udp_data_cnf->status);
-	}
+			HANDLE_CNF_ERROR(HIF_UDP_DATA_CNF, udp_data_cnf->status);
+
+			userg3_tx_complete(pending, udp_data_cnf->status);
+			break;
+		}
+    }
 }
 
 /**
   * @brief Function that handles the G3UDP-DATA.Ind coming from the G3 task.
-  * @param payload Pointer to the payload of the received message.
+  * @param g3_msg Pointer to the received message, its payload is taken by the receive queue of the connection.
   * @retval True if the message is related the the User G3, false otherwise
   */
-static bool userg3_handle_udp_data_ind(const void *payload)
+static bool userg3_handle_udp_data_ind(g3_msg_t *g3_msg)
 {
 	bool userg3_related = false;
-	const IP_DataIndication_t    *ip_udp_ind   = payload;
-	const IP_UdpDataIndication_t *udp_data_ind = hi_ipv6_extract_udp_from_ip(ip_udp_ind);
+	const IP_DataIndication_t *ip_udp_ind   = g3_msg->payload;
+	IP_UdpDataIndication_t    *udp_data_ind = hi_ipv6_extract_udp_from_ip(ip_udp_ind);
 
 	userg3_fsm.curr_event = USER_G3_EV_RECEIVED_UDP_DATA_IND;
 
@@ -583,16 +804,14 @@ static bool userg3_handle_udp_data_ind(const void *payload)
 		   )
 		{
 			userg3_related = true;
-			userg3_fsm.data_received[i].length = udp_data_ind->data_len;
 
-			if (userg3_fsm.data_received[i].payload != NULL)
+			if (udp_data_ind->data_len > 0)
 			{
-				MEMPOOL_FREE(userg3_fsm.data_received[i].payload); /* Free previous payload, if it wasn't freed by calling  */
-				PRINT_USER_G3_WARNING("Discarded last UDP data\n");
-			}
+				udp_rx_queue_t *rx_queue = &userg3_fsm.rx_queue[udp_data_ind->connection_id];
+				udp_packet_t   *packet;
+				void		   *buffer	= g3_msg->payload;
+				void		   *payload	= udp_data_ind->data;
 
-			if (userg3_fsm.data_received[i].length > 0)
-			{
 				/* Only in case of loopback test */
 				if (userg3_fsm.loopback.requested == true)
 				{
@@ -601,26 +820,75 @@ static bool userg3_handle_udp_data_ind(const void *payload)
 					userg3_fsm.loopback.remote_port     = udp_data_ind->source_port;
 				}
 
-				userg3_fsm.data_received[i].connection_id = udp_data_ind->connection_id;
-				userg3_fsm.data_received[i].ip_addr       = udp_data_ind->source_address;
-				userg3_fsm.data_received[i].port		  = udp_data_ind->source_port;
+				if (rx_queue->count >= USER_G3_RX_QUEUE_SIZE)
+				{
+					/* Drops the oldest packet, keeping the most recent ones */
+					UserG3_ReleaseUdpData(&rx_queue->packet[rx_queue->head]);
+					rx_queue->head = (rx_queue->head + 1) % USER_G3_RX_QUEUE_SIZE;
+					rx_queue->count--;
+					rx_queue->dropped++;
+
+					PRINT_USER_G3_WARNING("Discarded oldest UDP data of connection %u (%u dropped)\n", udp_data_ind->connection_id, rx_queue->dropped);
+				}
+
+				/* The Host Interface needs a big block to receive the next long frame, the queues cannot take all of them */
+				if (mem_pool_is_big(buffer) && (userg3_fsm.rx_big_blocks >= USER_G3_RX_BIG_BLOCKS))
+				{
+					buffer = NULL;
 
-				userg3_fsm.data_received[i].payload = MEMPOOL_MALLOC(userg3_fsm.data_received[i].length);
+					/* Copies the packet in a smaller block, if it fits */
+					if (udp_data_ind->data_len <= MEM_BLOCK_SIZE_MEDIUM)
+					{
+						buffer = MEMPOOL_MALLOC(udp_data_ind->data_len);
+
+						if (mem_pool_is_big(buffer))
+						{
+							MEMPOOL_FREE(buffer);
+						}
+						else
+						{
+							memcpy(buffer, udp_data_ind->data, udp_data_ind->data_len);
+							payload = buffer;
+						}
+					}
+				}
 
+				if (buffer == NULL)
+				{
+					rx_queue->dropped++;
 
-#if (DEBUG_USER_G3 >= DEBUG_LEVEL_INFO)
-				ALLOC_DYNAMIC_HEX_STRING(src_ip_addr_str, udp_data_ind->source_address.u8, sizeof(udp_data_ind->source_address.u8));
-				PRINT_USER_G3_INFO("Received UDP packet of %u bytes from connection %u, IPv6 %s, remote port %u\n", udp_data_ind->data_len, udp_data_ind->connection_id, src_ip_addr_str, udp_data_ind->source_port);
-				FREE_DYNAMIC_HEX_STRING(src_ip_addr_str);
-#endif
-				if (userg3_fsm.data_received[i].payload != NULL)
+					PRINT_USER_G3_WARNING("Discarded UDP data of connection %u, no memory pool block left (%u dropped)\n", udp_data_ind->connection_id, rx_queue->dropped);
+					break;
+				}
+
+				packet = &rx_queue->packet[(rx_queue->head + rx_queue->count) % USER_G3_RX_QUEUE_SIZE];
+
+				packet->connection_id = udp_data_ind->connection_id;
+				packet->ip_addr       = udp_data_ind->source_address;
+				packet->port		  = udp_data_ind->source_port;
+				packet->length		  = udp_data_ind->data_len;
+				packet->payload		  = payload;
+				packet->buffer		  = buffer;
+
+				if (buffer == g3_msg->payload)
 				{
-					memcpy(userg3_fsm.data_received[i].payload, udp_data_ind->data, userg3_fsm.data_received[i].length);
+					/* The packet takes the memory pool block of the message, which is not freed by the User task */
+					g3_msg->payload	  = NULL;
 				}
-				else
+
+				if (mem_pool_is_big(buffer))
 				{
-					PRINT_USER_G3_INFO("Received UDP packet is too long (%u bytes)\n", udp_data_ind->data_len);
+					userg3_fsm.rx_big_blocks++;
 				}
+
+				rx_queue->count++;
+				rx_queue->received++;
+
+#if (DEBUG_USER_G3 >= DEBUG_LEVEL_INFO)
+				ALLOC_DYNAMIC_HEX_STRING(src_ip_addr_str, packet->ip_addr.u8, sizeof(packet->ip_addr.u8));
+				PRINT_USER_G3_INFO("Received UDP packet of %u bytes from connection %u, IPv6 %s, remote port %u\n", packet->length, packet->connection_id, src_ip_addr_str, packet->port);
+				FREE_DYNAMIC_HEX_STRING(src_ip_addr_str);
+#endif
 			}
 			break;
 		}
@@ -674,8 +942,12 @@ void UserG3_Init(void)
 	userg3_fsm.loopback.requested         	= false;
 
     /* UDP packets */
-	memset(&userg3_fsm.data_received, 0, sizeof(userg3_fsm.data_received));
-	memset(&userg3_fsm.data_to_send,  0, sizeof(userg3_fsm.data_to_send));
+	memset(&userg3_fsm.rx_queue, 0, sizeof(userg3_fsm.rx_queue));
+	userg3_fsm.rx_big_blocks = 0;
+	memset(&userg3_fsm.tx_queue, 0, sizeof(userg3_fsm.tx_queue));
+	memset(&userg3_fsm.tx_window, 0, sizeof(userg3_fsm.tx_window));
+	userg3_fsm.tx_pending = 0;
+	userg3_fsm.tx_next    = 0;
 
 	/* No set connection at startup */
 	userg3_common.connection_number       = 0;
@@ -708,10 +980,46 @@ void UserG3_Init(void)
 	connection_table.TransferConn.remote_port 	 = TRANSFER_REMOTE_PORT;
 	connection_table.TransferConn.local_port  	 = TRANSFER_LOCAL_PORT;
 
+#if ENABLE_METER_POLLING
+	/* Polling connection parameters */
+	connection_table.PollConn.applied		 	 = false;
+	connection_table.PollConn.connection_id  	 = POLL_CONN_ID;
+	memset(&connection_table.PollConn.remote_address, 0, sizeof(ip6_addr_t));
+	connection_table.PollConn.remote_port 	 	 = POLL_REMOTE_PORT;
+	connection_table.PollConn.local_port  	 	 = POLL_LOCAL_PORT;
+#endif
+
+#if ENABLE_BENCHMARK
+	/* Benchmark connection parameters */
+	connection_table.BenchConn.applied		 	 = false;
+	connection_table.BenchConn.connection_id  	 = BENCH_CONN_ID;
+	memset(&connection_table.BenchConn.remote_address, 0, sizeof(ip6_addr_t));
+	connection_table.BenchConn.remote_port 	 	 = BENCH_REMOTE_PORT;
+	connection_table.BenchConn.local_port  	 	 = BENCH_LOCAL_PORT;
+#endif
+
+#if ENABLE_MODBUS_GATEWAY
+	/* Modbus gateway connection parameters */
+	connection_table.ModbusGwConn.applied		 = false;
+	connection_table.ModbusGwConn.connection_id  = MODBUS_GW_CONN_ID;
+	memset(&connection_table.ModbusGwConn.remote_address, 0, sizeof(ip6_addr_t));
+	connection_table.ModbusGwConn.remote_port 	 = MODBUS_GW_REMOTE_PORT;
+	connection_table.ModbusGwConn.local_port  	 = MODBUS_GW_LOCAL_PORT;
+#endif
+
 	/* Fill connection list */
 	uint8_t list_index = 0;
 	connection_list[list_index++] = &connection_table.TestConn;
 	connection_list[list_index++] = &connection_table.TransferConn;
+#if ENABLE_METER_POLLING
+	connection_list[list_index++] = &connection_table.PollConn;
+#endif
+#if ENABLE_BENCHMARK
+	connection_list[list_index++] = &connection_table.BenchConn;
+#endif
+#if ENABLE_MODBUS_GATEWAY
+	connection_list[list_index++] = &connection_table.ModbusGwConn;
+#endif
 
 #if ENABLE_LAST_GASP
 	/* Transfer connection parameters */
@@ -780,7 +1088,7 @@ bool UserG3_MsgNeeded(const g3_msg_t *g3_msg)
   * @param g3_msg Pointer to the received G3 message
   * @retval None
   */
-void UserG3_MsgHandler(const g3_msg_t *g3_msg)
+void UserG3_MsgHandler(g3_msg_t *g3_msg)
 {
 	bool cnf_ok = false;
 
@@ -867,7 +1175,7 @@ void UserG3_MsgHandler(const g3_msg_t *g3_msg)
 		RAISE_USER_EVENT(USEREVT_G3_UDP_DATA_CNF, cnf_ok);
         break;
     case HIF_UDP_DATA_IND:
-    	if (userg3_handle_udp_data_ind(g3_msg->payload))
+    	if (userg3_handle_udp_data_ind(g3_msg))
     	{
     		RAISE_USER_EVENT(USEREVT_G3_UDP_DATA_IND, true);
     	}
@@ -905,6 +1213,81 @@ void UserG3_FsmManager(void)
     userg3_fsm.curr_state = userg3_fsm_func_tbl[userg3_fsm.curr_state][userg3_fsm.curr_event]();
 }
 
+/**
+  * @brief Function that requests a new execution of the User task, after an event was given to a FSM.
+  * @param operation_counter Operation counter of the FSM that got the event.
+  * @retval None
+  * @note If the operation counter of the FSM is equal to the user task operation counter, the FSM already ran
+  * 	  in the current execution of the user task (or runs in it before the event is consumed), which must be repeated.
+  */
+void UserG3_RequestFsmExecution(const uint32_t operation_counter)
+{
+	if (user_task_operation_couter == operation_counter)
+	{
+		RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+	}
+}
+
+/**
+  * @brief Function that initializes the User applications on the UDP connections.
+  * @param None
+  * @retval None
+  */
+void UserG3_AppsInit(void)
+{
+	for (const user_g3_app_t *app = user_g3_apps; app->fsm_manager != NULL; app++)
+	{
+		app->init();
+	}
+}
+
+/**
+  * @brief Function that checks if a message is needed by any of the User applications on the UDP connections.
+  * @param g3_msg Pointer to the G3 message structure to evaluate
+  * @return 'true' if the message is needed, 'false' otherwise.
+  */
+bool UserG3_AppsMsgNeeded(const g3_msg_t *g3_msg)
+{
+	bool needed = false;
+
+	for (const user_g3_app_t *app = user_g3_apps; (app->fsm_manager != NULL) && (!needed); app++)
+	{
+		needed = app->msg_needed(g3_msg);
+	}
+
+	return needed;
+}
+
+/**
+  * @brief Function that forwards a G3 message to the User applications on the UDP connections that need it.
+  * @param g3_msg Pointer to the received G3 message
+  * @retval None
+  */
+void UserG3_AppsMsgHandler(const g3_msg_t *g3_msg)
+{
+	for (const user_g3_app_t *app = user_g3_apps; app->fsm_manager != NULL; app++)
+	{
+		if (app->msg_needed(g3_msg))
+		{
+			app->msg_handler(g3_msg);
+		}
+	}
+}
+
+/**
+  * @brief Function that runs the FSM of the User applications on the UDP connections.
+  * @param None
+  * @retval None
+  * @note Entry function called from User task infinite execution loop.
+  */
+void UserG3_AppsFsmManager(void)
+{
+	for (const user_g3_app_t *app = user_g3_apps; app->fsm_manager != NULL; app++)
+	{
+		app->fsm_manager();
+	}
+}
+
 /**
   * @brief Function that provides board platform information (ST8500 FW version, PLC info, ...).
   * @note This function prepares and sends the USER_HI_TOOLS_REQ message to the ST8500.
@@ -988,11 +1371,7 @@ void UserG3_StartUdpConnSetup(void)
     /* Makes the FSM request the connection setup */
     userg3_fsm.curr_event = USER_G3_EV_SET_CONNECTION;
 
-	if (user_task_operation_couter == userg3_fsm.operation_counter)
-	{
-		/* If the operation counter of the FSM is equal to the user task operation counter, the user task needs to be executed again */
-		RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
-    }
+	UserG3_RequestFsmExecution(userg3_fsm.operation_counter);
 }
 
 /**
@@ -1044,6 +1423,21 @@ uint8_t UserG3_SendUdpDataToShortAddress(const uint8_t connection_id, const uint
   * @retval UDP handle of the G3UDP packet sent
   */
 uint8_t UserG3_SendUdpData(const uint8_t connection_id, const ip6_addr_t dest_ip_addr, void *data, const uint32_t length)
+{
+	return UserG3_SendUdpDataAsync(connection_id, dest_ip_addr, data, length, NULL);
+}
+
+/**
+  * @brief This function queues a UDP packet on a connection, the G3UDP-DATA.Request message is sent as soon as the transmit window has room.
+  * @Note Allocates a memory pool if the data argument is not pointing a memory pool already. Does not block.
+  * @param connection_id The ID of the connection to use.
+  * @param dest_ip_addr Destination IPv6 address.
+  * @param data Pointer to the buffer containing the data to send as payload. If it points to a memory pool, it is freed in case of error.
+  * @param length Size of the buffer containing the data to send as payload.
+  * @param callback Function called by the User task when the packet is confirmed or times out (can be NULL).
+  * @retval UDP handle of the G3UDP packet queued, 0 if it was rejected (e.g. the transmit queue of the connection is full)
+  */
+uint8_t UserG3_SendUdpDataAsync(const uint8_t connection_id, const ip6_addr_t dest_ip_addr, void *data, const uint32_t length, userg3_tx_callback_t *callback)
 {
 	bool success = false;
 	bool found = false;
@@ -1056,7 +1450,9 @@ uint8_t UserG3_SendUdpData(const uint8_t connection_id, const ip6_addr_t dest_ip
 		{
 			found = true;
 
-			if (userg3_fsm.curr_state == USER_G3_ST_UDP_READY)
+			udp_tx_queue_t *tx_queue = &userg3_fsm.tx_queue[connection_id];
+
+			if (tx_queue->count < USER_G3_TX_QUEUE_SIZE)
 			{
 				void *payload_data;
 
@@ -1082,16 +1478,29 @@ uint8_t UserG3_SendUdpData(const uint8_t connection_id, const ip6_addr_t dest_ip
 
 				if (payload_data != NULL)
 				{
-					/* Fill UDP FSM data */
-					userg3_fsm.data_to_send.connection_id = connection_list[i]->connection_id;
-					userg3_fsm.data_to_send.ip_addr       = dest_ip_addr;
-					userg3_fsm.data_to_send.port		  = connection_list[i]->remote_port;
-					userg3_fsm.data_to_send.length		  = length;
-					userg3_fsm.data_to_send.payload		  = payload_data;
-
 					if (osKernelLock() == osOK)
 					{
-						userg3_fsm.connection_handle[connection_id] = ++udp_handle;
+						udp_tx_entry_t *entry = &tx_queue->entry[(tx_queue->head + tx_queue->count) % USER_G3_TX_QUEUE_SIZE];
+
+						/* Handle 0 is reserved to signal a rejected packet, LAST_GASP_UDP_HANDLE to the pre-built Last Gasp frames */
+						do
+						{
+							udp_handle++;
+						} while ((udp_handle == 0) || (udp_handle == LAST_GASP_UDP_HANDLE));
+
+						/* Fill UDP packet data */
+						entry->packet.connection_id = connection_list[i]->connection_id;
+						entry->packet.ip_addr       = dest_ip_addr;
+						entry->packet.port		    = connection_list[i]->remote_port;
+						entry->packet.length		= length;
+						entry->packet.payload		= payload_data;
+						entry->packet.buffer		= NULL;
+						entry->handle				= udp_handle;
+						entry->callback				= callback;
+
+						tx_queue->count++;
+
+						handle = udp_handle;
 
 						osKernelUnlock();
 					}
@@ -1100,22 +1509,18 @@ uint8_t UserG3_SendUdpData(const uint8_t connection_id, const ip6_addr_t dest_ip
 						Error_Handler();
 					}
 
-					handle = userg3_fsm.connection_handle[connection_id];
-
 					success = true;
 
 					userg3_fsm.curr_event = USER_G3_EV_SEND_UDP_DATA;
 
-					if (user_task_operation_couter == userg3_fsm.operation_counter)
-					{
-						/* If the operation counter of the FSM is equal to the user task operation counter, the user task needs to be executed again */
-						RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
-					}
+					UserG3_RequestFsmExecution(userg3_fsm.operation_counter);
 				}
 			}
 			else
 			{
-				PRINT_USER_G3_CRITICAL("Cannot send UDP data, not ready (state: %u).\n", userg3_fsm.curr_state);
+				tx_queue->rejected++;
+
+				PRINT_USER_G3_WARNING("Cannot send UDP data, transmit queue of connection %u full (state: %u).\n", connection_id, userg3_fsm.curr_state);
 			}
 			break;
 		}
@@ -1136,19 +1541,62 @@ uint8_t UserG3_SendUdpData(const uint8_t connection_id, const ip6_addr_t dest_ip
 }
 
 /**
-  * @brief This function returns the buffer with the data received with the last G3UDP-DATA.Indication message.
+  * @brief This function returns the number of UDP packets that can still be queued on a connection, to apply back-pressure before sending.
+  * @param connection_id ID of the connection
+  * @retval Number of free elements of the transmit queue of the connection
+  */
+uint8_t UserG3_GetUdpTxSpace(const uint8_t connection_id)
+{
+	assert(connection_id < CONN_NUMBER);
+
+	return USER_G3_TX_QUEUE_SIZE - userg3_fsm.tx_queue[connection_id].count;
+}
+
+/**
+  * @brief This function gets the counters of the UDP packets sent on a connection.
+  * @param connection_id ID of the connection
+  * @param stats Pointer to the structure where the counters are copied
+  * @retval None
+  */
+void UserG3_GetUdpTxStats(const uint8_t connection_id, udp_tx_stats_t *stats)
+{
+	assert(connection_id < CONN_NUMBER);
+	assert(stats != NULL);
+
+	stats->sent		 = userg3_fsm.tx_queue[connection_id].sent;
+	stats->confirmed = userg3_fsm.tx_queue[connection_id].confirmed;
+	stats->failed	 = userg3_fsm.tx_queue[connection_id].failed;
+	stats->rejected	 = userg3_fsm.tx_queue[connection_id].rejected;
+	stats->queued	 = userg3_fsm.tx_queue[connection_id].count;
+}
+
+/**
+  * @brief This function returns the oldest UDP packet received on a connection, without removing it from the queue.
   * @param connection_id ID of the connection where the packet was received
-  * @retval The last UDP packet received
+  * @retval The oldest UDP packet received (with NULL payload if the queue is empty)
   */
 udp_packet_t UserG3_GetUdpData(const uint8_t connection_id)
 {
+	udp_packet_t packet;
+
 	assert(connection_id < CONN_NUMBER);
 
-	return userg3_fsm.data_received[connection_id];
+	udp_rx_queue_t *rx_queue = &userg3_fsm.rx_queue[connection_id];
+
+	if (rx_queue->count > 0)
+	{
+		packet = rx_queue->packet[rx_queue->head];
+	}
+	else
+	{
+		memset(&packet, 0, sizeof(packet));
+	}
+
+	return packet;
 }
 
 /**
-  * @brief This function discards the data received from the last G3UDP-DATA.Indication message.
+  * @brief This function discards the oldest UDP packet received on a connection.
   * @param connection_id ID of the connection where the packet was received
   * @retval None
   */
@@ -1156,9 +1604,21 @@ void UserG3_DiscardUdpData(const uint8_t connection_id)
 {
 	assert(connection_id < CONN_NUMBER);
 
-	if (userg3_fsm.data_received[connection_id].payload != NULL)
+	udp_rx_queue_t *rx_queue = &userg3_fsm.rx_queue[connection_id];
+
+	if (rx_queue->count > 0)
 	{
-		MEMPOOL_FREE(userg3_fsm.data_received[connection_id].payload); /* Free previous UDP data payload received */
+		UserG3_ReleaseUdpData(&rx_queue->packet[rx_queue->head]); /* Free the UDP data payload received */
+
+		rx_queue->head = (rx_queue->head + 1) % USER_G3_RX_QUEUE_SIZE;
+		rx_queue->count--;
+
+		if (rx_queue->count > 0)
+		{
+			/* Signals the next packet of the queue */
+			RAISE_USER_EVENT(USEREVT_G3_UDP_DATA_IND, true);
+			RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+		}
 	}
 	else
 	{
@@ -1166,6 +1626,73 @@ void UserG3_DiscardUdpData(const uint8_t connection_id)
 	}
 }
 
+/**
+  * @brief This function moves the UDP packets received on a connection to an array, in order of reception.
+  * @param connection_id ID of the connection where the packets were received
+  * @param packets Array where the packets are moved
+  * @param max_packets Maximum number of packets to move
+  * @retval Number of packets moved
+  * @note The caller takes the ownership of the packets, which must be released with UserG3_ReleaseUdpData.
+  */
+uint8_t UserG3_DequeueUdpData(const uint8_t connection_id, udp_packet_t *packets, const uint8_t max_packets)
+{
+	uint8_t n = 0;
+
+	assert(connection_id < CONN_NUMBER);
+	assert(packets != NULL);
+
+	udp_rx_queue_t *rx_queue = &userg3_fsm.rx_queue[connection_id];
+
+	while ((n < max_packets) && (rx_queue->count > 0))
+	{
+		packets[n++] = rx_queue->packet[rx_queue->head];
+
+		rx_queue->head = (rx_queue->head + 1) % USER_G3_RX_QUEUE_SIZE;
+		rx_queue->count--;
+	}
+
+	return n;
+}
+
+/**
+  * @brief This function releases a UDP packet obtained with UserG3_DequeueUdpData.
+  * @param packet Pointer to the packet to release
+  * @retval None
+  */
+void UserG3_ReleaseUdpData(udp_packet_t *packet)
+{
+	assert(packet != NULL);
+
+	if (packet->buffer != NULL)
+	{
+		if (mem_pool_is_big(packet->buffer))
+		{
+			userg3_fsm.rx_big_blocks--;
+		}
+
+		MEMPOOL_FREE(packet->buffer);
+	}
+
+	packet->payload = NULL;
+	packet->length  = 0;
+}
+
+/**
+  * @brief This function gets the counters of the UDP packets received on a connection.
+  * @param connection_id ID of the connection
+  * @param stats Pointer to the structure where the counters are copied
+  * @retval None
+  */
+void UserG3_GetUdpRxStats(const uint8_t connection_id, udp_rx_stats_t *stats)
+{
+	assert(connection_id < CONN_NUMBER);
+	assert(stats != NULL);
+
+	stats->received	= userg3_fsm.rx_queue[connection_id].received;
+	stats->dropped	= userg3_fsm.rx_queue[connection_id].dropped;
+	stats->queued	= userg3_fsm.rx_queue[connection_id].count;
+}
+
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_REKEYING
 /**
   * @brief Function that starts a Re-keying procedure.
@@ -1194,11 +1721,23 @@ void UserG3_SendRekeyingAbortRequest(void)
 
 #endif /* IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_REKEYING */
 
-
+/**
+  * @brief Function that checks if UDP packets are queued or waiting for their confirm.
+  * @param None
+  * @retval True if a transmission is in progress, false otherwise
+  */
 bool UserG3_TxInProgress(void)
 {
-	return (userg3_fsm.curr_state == USER_G3_ST_WAIT_FOR_UDP_DATA_CNF);
+	bool queued = false;
+
+	for (uint8_t i = 0; i < CONN_NUMBER; i++)
+	{
+		queued |= (userg3_fsm.tx_queue[i].count > 0);
+	}
+
+	return (queued || (userg3_fsm.tx_pending > 0));
 }
+
 /**
   * @brief Function that starts counting the time in order to measure it.
   * @param None
@@ -1239,24 +1778,18 @@ void UserG3_TimeoutCallback(void *argument)
 	UNUSED(argument);
 	userg3_fsm.curr_event = USER_G3_EV_CNF_TIMEOUT;
 
-	if (userg3_fsm.curr_state == USER_G3_ST_WAIT_FOR_UDP_DATA_CNF)
-	{
-		PRINT_USER_G3_WARNING("UDP data confirm timeout\n");
-
-		/* Raise negative user event for User Terminal */
-		RAISE_USER_EVENT(USEREVT_G3_UDP_DATA_CNF, false);
-	}
-	else if (userg3_fsm.curr_state == USER_G3_ST_WAIT_FOR_UDP_SET_CNF)
+	if (userg3_fsm.curr_state == USER_G3_ST_WAIT_FOR_UDP_SET_CNF)
 	{
 		PRINT_USER_G3_WARNING("UDP connection set confirm timeout\n");
 
 		/* Raise negative user event for User Terminal */
 		RAISE_USER_EVENT(USEREVT_G3_UDP_CONN_SET_CNF, false);
 	}
-	else
+	else if (userg3_fsm.curr_state == USER_G3_ST_UDP_INIT)
 	{
 		Error_Handler();
 	}
+	/* Otherwise, the expired UDP data requests are released by the FSM */
 
 	/* Unblocks the User Task to execute UserG3 and UserIf FSMs */
 	RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
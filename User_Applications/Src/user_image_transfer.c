@@ -21,10 +21,12 @@
 #include <utils.h>
 #include <main.h>
 #include <crc.h>
+#include <lzss.h>
 #include <debug_print.h>
 #include <mem_pool.h>
 #include <image_management.h>
 #include <g3_app_config.h>
+#include <g3_app_boot_srv.h>
 #include <user_g3_common.h>
 #include <user_image_transfer.h>
 
@@ -56,11 +58,35 @@
 #define TRANSFER_IMAGE_DATA_MSG_SIZE(size)			(sizeof(image_data_t) - TRANSFER_IMAGE_DATA_SIZE + size)
 #define TRANSFER_IMAGE_DATA_PREVIEW_SIZE			8
 
+#define TRANSFER_IMAGE_BLOCK_NUM(size)				(((size) + TRANSFER_IMAGE_DATA_SIZE - 1) / TRANSFER_IMAGE_DATA_SIZE)
+#define TRANSFER_IMAGE_BLOCK_OFFSET(index)			((index) * TRANSFER_IMAGE_DATA_SIZE)
+
+#define TRANSFER_IMAGE_FLAG_ACK_REQ					(0x01)	/* Set on the last block of a burst, the receiver answers with a selective ACK */
+#define TRANSFER_IMAGE_FLAG_PASS_END				(0x02)	/* Set on the poll sent at the end of each multicast pass, the receivers answer with their missing blocks */
+
+#define TRANSFER_IMAGE_INFO_FLAG_MULTICAST			(0x01)	/* The image is sent to all devices at once, the blocks are not acknowledged */
+#define TRANSFER_IMAGE_INFO_FLAG_COMPRESSED			(0x02)	/* The blocks carry the LZSS stream of the image, decompressed by the receiver */
+
+#define TRANSFER_IMAGE_MAP_SIZE						((TRANSFER_IMAGE_BLOCK_NUM(IMAGE_SIZE) + 7) / 8)	/* Size of the bitmap of all blocks of an image, in bytes */
+#define TRANSFER_IMAGE_MAP_SET(map, index)			BIT_SET((map)[(index) / 8], ((index) % 8))
+#define TRANSFER_IMAGE_MAP_IS_SET(map, index)		BIT_IS_SET((map)[(index) / 8], ((index) % 8))
+
+/* Multicast address (used for broadcast) */
+#define IPV6_MULTICAST_ADDR 	{ 0xFF, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 }
+
 #define TRANSFER_PERCENTAGE_UPDATE					(10)
 #define TRANSFER_ERROR_N_MAX						(3)
 
-#define TRANSFER_UPDATE_MARK(current_size, total_size)		((current_size != 0) && ((current_size/TRANSFER_IMAGE_DATA_SIZE) % ((total_size/TRANSFER_IMAGE_DATA_SIZE) / TRANSFER_PERCENTAGE_UPDATE) == 0))
-#define TRANSFER_SHOW_PROGRESS(current_size, total_size)	((current_size == total_size) || TRANSFER_UPDATE_MARK(current_size, total_size))
+#define TRANSFER_UPDATE_MARK(current_size, last_size, total_size)	(((current_size) * TRANSFER_PERCENTAGE_UPDATE / (total_size)) != ((last_size) * TRANSFER_PERCENTAGE_UPDATE / (total_size)))
+#define TRANSFER_SHOW_PROGRESS(current_size, last_size, total_size)	((current_size == total_size) || TRANSFER_UPDATE_MARK(current_size, last_size, total_size))
+
+#if USER_IMG_TRANSFER_WINDOW_MAX > 32
+#error "USER_IMG_TRANSFER_WINDOW_MAX cannot exceed the size of the selective ACK bitmap (32)"
+#endif /* USER_IMG_TRANSFER_WINDOW_MAX > 32 */
+
+#if TRANSFER_IMAGE_DATA_SIZE != IMAGE_PROGRESS_BLOCK_SIZE
+#error "TRANSFER_IMAGE_DATA_SIZE must be equal to the block size of the transfer progress record (IMAGE_PROGRESS_BLOCK_SIZE)"
+#endif
 
 #if TRANSFER_PERCENTAGE_UPDATE==0
 #error "TRANSFER_PERCENTAGE_UPDATE must be > 0"
@@ -71,6 +97,13 @@
 /* Timing */
 #define TRANSFER_INFO_TIMEOUT                		(120000U)	/* In ms */
 #define TRANSFER_DATA_TIMEOUT                		(90000U)	/* In ms */
+#define TRANSFER_MCAST_NACK_WINDOW					(20000U)	/* In ms, time the coordinator waits for the info ACKs, and for the NACKs after each multicast pass */
+#define TRANSFER_MCAST_NACK_BACKOFF_MAX				(15000U)	/* In ms, maximum random delay of the info ACK and of the NACK of a device (must be lower than the NACK window) */
+#define TRANSFER_MCAST_PASS_MAX						(10)		/* Maximum number of passes of a multicast transfer */
+
+#if TRANSFER_MCAST_NACK_BACKOFF_MAX >= TRANSFER_MCAST_NACK_WINDOW
+#error "TRANSFER_MCAST_NACK_BACKOFF_MAX must be lower than TRANSFER_MCAST_NACK_WINDOW"
+#endif
 
 /* Private structure */
 
@@ -79,9 +112,22 @@
 typedef enum user_image_transfer_ack_enum
 {
 	TRANSFER_IMAGE_ACK		 = 1,
-	TRANSFER_IMAGE_NACK		 = 2
+	TRANSFER_IMAGE_NACK		 = 2,
+	TRANSFER_IMAGE_DONE		 = 3,	/* Multicast only, the image is complete and its CRC is correct */
+	TRANSFER_IMAGE_FAILED	 = 4	/* Multicast only, the image is complete but its CRC is wrong */
 } user_image_transfer_ack_t;
 
+#if IS_COORD
+/* Progress of each device expected to receive a multicast transfer */
+typedef enum user_image_transfer_mcast_device_enum
+{
+	TRANSFER_MCAST_DEVICE_SILENT = 0,	/* No answer received yet */
+	TRANSFER_MCAST_DEVICE_JOINED,		/* Image info acknowledged, receiving the blocks */
+	TRANSFER_MCAST_DEVICE_DONE,			/* Image received, CRC correct */
+	TRANSFER_MCAST_DEVICE_FAILED		/* Image info rejected, or image received with a wrong CRC */
+} user_image_transfer_mcast_device_t;
+#endif
+
 typedef enum user_image_transfer_event_enum
 {
 	USER_IMG_TRANSFER_EV_NONE = 0,
@@ -98,6 +144,7 @@ typedef enum user_image_transfer_state_enum
 	USER_IMG_TRANSFER_ST_READY,
 	USER_IMG_TRANSFER_ST_SHARE_INFO,
 	USER_IMG_TRANSFER_ST_IN_PROGRESS,
+	USER_IMG_TRANSFER_ST_REPAIR,
 	USER_IMG_TRANSFER_ST_CNT
 } user_img_transfer_state_t;
 
@@ -120,17 +167,49 @@ typedef struct user_img_transfer_fsm_str
 	uint32_t	image_validity;
 	uint32_t	image_size;
 	uint16_t	image_crc16;
+	uint32_t	stream_size;	/*!<  Size of the data sent in blocks (compressed size, or image_size if not compressed) */
+	bool		compressed;		/*!<  The blocks carry the LZSS stream of the image, stored in the staging area */
 
 	/* Transfer details */
 #if IS_COORD
 	uint16_t 	dest_short_addr;
 #endif
 	uint32_t	transfered_bytes;
-	uint32_t	last_block_size;
 	uint32_t	retry_count;
 	bool		transfer_complete;
+	uint32_t	start_timestamp;
+	uint32_t	start_transfered_bytes;
 	uint32_t	last_timestamp;
 	uint32_t	last_transfered_bytes;
+
+	/* Sliding window */
+	uint8_t		window_size;	/*!<  Negotiated number of blocks in flight */
+	uint32_t	window_base;	/*!<  Index of the first block not received yet */
+	uint32_t	window_map;		/*!<  Bitmap of the blocks received after window_base (bit 0 is window_base) */
+#if IS_COORD
+	uint32_t	window_next;	/*!<  Index of the last block sent in the current burst */
+	uint32_t	window_last;	/*!<  Index of the last block to send in the current burst */
+#endif
+
+	/* Multicast */
+	bool		multicast;								/*!<  The image is sent to all devices at once */
+	uint8_t		pass;									/*!<  Current multicast pass */
+	uint8_t		block_map[TRANSFER_IMAGE_MAP_SIZE];		/*!<  Coordinator: blocks to send in the current pass. Device: blocks received */
+#if IS_COORD
+	uint8_t		repair_map[TRANSFER_IMAGE_MAP_SIZE];	/*!<  Blocks requested by the devices for the next pass */
+	uint32_t	block_next;								/*!<  Index of the next block to check in the current pass */
+	uint32_t	nack_count;								/*!<  Number of NACKs received */
+	uint32_t	frame_count;							/*!<  Number of G3UDP-DATA.Request sent */
+	uint32_t	frame_timestamp;						/*!<  Time of the last G3UDP-DATA.Request sent */
+	uint32_t	airtime;								/*!<  Sum of the times between each G3UDP-DATA.Request and its confirm, in ms */
+	uint16_t	device_num;													/*!<  Number of devices expected to receive the image */
+	uint16_t	device_addr[BOOT_MAX_NUM_JOINING_NODES];					/*!<  Short addresses of the devices expected to receive the image */
+	user_image_transfer_mcast_device_t device_state[BOOT_MAX_NUM_JOINING_NODES];	/*!<  Progress of each device expected to receive the image */
+#else
+	uint16_t	coord_short_addr;						/*!<  Short address of the sender of the image */
+	uint32_t	blocks_received;						/*!<  Number of blocks set in the bitmap */
+	uint32_t	inflate_next;							/*!<  Index of the next block of the stream to decompress */
+#endif
 } user_img_transfer_fsm_t;
 
 /* Message structures used for the transfer */
@@ -143,6 +222,9 @@ typedef struct image_info_str
 	uint32_t type;
 	uint32_t size;
 	uint16_t crc16;
+	uint8_t  window_size;	/* Number of blocks in flight proposed by the sender */
+	uint8_t  flags;
+	uint32_t stream_size;	/* Size of the data sent in blocks (compressed size if TRANSFER_IMAGE_INFO_FLAG_COMPRESSED is set) */
 	uint32_t foot;
 } image_info_t;
 
@@ -150,16 +232,35 @@ typedef struct image_data_str
 {
 	uint32_t offset;
 	uint32_t size;
+	uint8_t  flags;
 	uint8_t  data[TRANSFER_IMAGE_DATA_SIZE];
 } image_data_t;
 
 typedef struct image_ack_str
 {
 	uint8_t  ack;
-	uint32_t next_offset;
+	uint32_t next_offset;	/* Offset of the first block not received yet */
 	uint32_t next_size;
+	uint8_t  window_size;	/* Number of blocks in flight accepted by the receiver */
+	uint32_t received_map;	/* Blocks already received after next_offset (bit 0 is the block at next_offset) */
 } image_ack_t;
 
+typedef struct image_poll_str
+{
+	uint32_t offset;		/* Same header as image_data_t, unused */
+	uint32_t size;			/* Same header as image_data_t, always 0 */
+	uint8_t  flags;			/* Same header as image_data_t, TRANSFER_IMAGE_FLAG_PASS_END */
+	uint8_t  pass;
+} image_poll_t;
+
+typedef struct image_nack_str
+{
+	uint8_t  ack;
+	uint8_t  pass;
+	uint16_t missing_num;
+	uint8_t  missing_map[TRANSFER_IMAGE_MAP_SIZE];	/* Blocks still missing on the device */
+} image_nack_t;
+
 #pragma pack(pop)
 
 /* External Variables */
@@ -171,9 +272,23 @@ extern osMessageQueueId_t	user_queueHandle;
 
 extern osTimerId_t 			transferTimerHandle;
 
+#if IS_COORD
+extern boot_server_t		boot_server;
+#endif
+
 /* Private variables */
 static user_img_transfer_fsm_t		user_img_transfer_fsm;
 
+static float						user_img_transfer_speed[USER_IMG_TRANSFER_WINDOW_MAX + 1]; /* Last throughput measured for each window size, in kB/s */
+
+#if IS_COORD
+#if USER_IMG_TRANSFER_COMPRESSION
+static lzss_encoder_t				user_img_transfer_encoder;
+#endif
+#else
+static lzss_decoder_t				user_img_transfer_decoder;
+#endif
+
 /* Private function pointer type */
 typedef user_img_transfer_state_t user_img_transfer_fsm_func(void);
 
@@ -185,12 +300,24 @@ static user_img_transfer_state_t user_img_transfer_fsm_abort(void);
 #if IS_COORD
 static user_img_transfer_state_t user_img_transfer_fsm_send_info(void);
 static user_img_transfer_state_t user_img_transfer_fsm_parse_info_ack();
+static user_img_transfer_state_t user_img_transfer_fsm_send_next_block(void);
 static user_img_transfer_state_t user_img_transfer_fsm_parse_ack(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_info_sent(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_parse_info_ack(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_info_timeout(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_send_next_block(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_parse_nack(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_timeout(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_end_pass(void);
 #else
-static user_img_transfer_state_t user_img_transfer_fsm_erase_flash(void);
+static user_img_transfer_state_t user_img_transfer_fsm_start_reception(void);
 static user_img_transfer_state_t user_img_transfer_fsm_parse_info(void);
 static user_img_transfer_state_t user_img_transfer_fsm_parse_block(void);
 static user_img_transfer_state_t user_img_transfer_fsm_ack_sent(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_parse_block(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_send_info_ack(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_timeout(void);
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_send_nack(void);
 #endif
 
 /* Private FSM function pointer array */
@@ -199,14 +326,34 @@ static user_img_transfer_fsm_func *user_img_transfer_fsm_func_tbl[USER_IMG_TRANS
 /*                   NONE,              			START,           			     UDP_CNF,           			UDP_IND						          TIMEOUT,                       STOP */
 /* READY 	     */	{user_img_transfer_fsm_default, user_img_transfer_fsm_send_info, user_img_transfer_fsm_default, user_img_transfer_fsm_default,        user_img_transfer_fsm_default, user_img_transfer_fsm_default  },
 /* SHARE_INFO    */	{user_img_transfer_fsm_default, user_img_transfer_fsm_default,   user_img_transfer_fsm_default, user_img_transfer_fsm_parse_info_ack, user_img_transfer_fsm_timeout, user_img_transfer_fsm_abort    },
-/* IN_PROGRESS   */	{user_img_transfer_fsm_default, user_img_transfer_fsm_default,   user_img_transfer_fsm_default, user_img_transfer_fsm_parse_ack,      user_img_transfer_fsm_timeout, user_img_transfer_fsm_abort    }
+/* IN_PROGRESS   */	{user_img_transfer_fsm_default, user_img_transfer_fsm_default,   user_img_transfer_fsm_send_next_block, user_img_transfer_fsm_parse_ack, user_img_transfer_fsm_timeout, user_img_transfer_fsm_abort    },
+/* REPAIR        */	{user_img_transfer_fsm_default, user_img_transfer_fsm_default,   user_img_transfer_fsm_default, user_img_transfer_fsm_default,        user_img_transfer_fsm_default, user_img_transfer_fsm_abort    }
+};
+
+/* Multicast transfer */
+static user_img_transfer_fsm_func *user_img_transfer_mcast_fsm_func_tbl[USER_IMG_TRANSFER_ST_CNT][USER_IMG_TRANSFER_EV_CNT] = {
+/*                   NONE,              			START,           			     UDP_CNF,           			              UDP_IND						               TIMEOUT,                                 STOP */
+/* READY 	     */	{user_img_transfer_fsm_default, user_img_transfer_fsm_send_info, user_img_transfer_fsm_default,                user_img_transfer_fsm_default,               user_img_transfer_fsm_default,           user_img_transfer_fsm_default  },
+/* SHARE_INFO    */	{user_img_transfer_fsm_default, user_img_transfer_fsm_default,   user_img_transfer_fsm_mcast_info_sent,        user_img_transfer_fsm_mcast_parse_info_ack,  user_img_transfer_fsm_mcast_info_timeout, user_img_transfer_fsm_abort    },
+/* IN_PROGRESS   */	{user_img_transfer_fsm_default, user_img_transfer_fsm_default,   user_img_transfer_fsm_mcast_send_next_block,  user_img_transfer_fsm_mcast_parse_nack,      user_img_transfer_fsm_mcast_timeout,     user_img_transfer_fsm_abort    },
+/* REPAIR        */	{user_img_transfer_fsm_default, user_img_transfer_fsm_default,   user_img_transfer_fsm_default,                user_img_transfer_fsm_mcast_parse_nack,      user_img_transfer_fsm_mcast_end_pass,    user_img_transfer_fsm_abort    }
 };
 #else
 static user_img_transfer_fsm_func *user_img_transfer_fsm_func_tbl[USER_IMG_TRANSFER_ST_CNT][USER_IMG_TRANSFER_EV_CNT] = {
 /*                 NONE,		                  START,           					 UDP_CNF						 UDP_IND,           				TIMEOUT,					   STOP */
-/* READY 	   */ {user_img_transfer_fsm_default, user_img_transfer_fsm_erase_flash, user_img_transfer_fsm_default,	 user_img_transfer_fsm_default,	    user_img_transfer_fsm_default, user_img_transfer_fsm_default },
+/* READY 	   */ {user_img_transfer_fsm_default, user_img_transfer_fsm_start_reception, user_img_transfer_fsm_default,	 user_img_transfer_fsm_default,	    user_img_transfer_fsm_default, user_img_transfer_fsm_default },
 /* SHARE_INFO  */ {user_img_transfer_fsm_default, user_img_transfer_fsm_default,     user_img_transfer_fsm_default,	 user_img_transfer_fsm_parse_info,	user_img_transfer_fsm_timeout, user_img_transfer_fsm_abort   },
-/* IN_PROGRESS */ {user_img_transfer_fsm_default, user_img_transfer_fsm_default,	 user_img_transfer_fsm_ack_sent, user_img_transfer_fsm_parse_block, user_img_transfer_fsm_timeout, user_img_transfer_fsm_abort   }
+/* IN_PROGRESS */ {user_img_transfer_fsm_default, user_img_transfer_fsm_default,	 user_img_transfer_fsm_ack_sent, user_img_transfer_fsm_parse_block, user_img_transfer_fsm_timeout, user_img_transfer_fsm_abort   },
+/* REPAIR      */ {user_img_transfer_fsm_default, user_img_transfer_fsm_default,	 user_img_transfer_fsm_default,	 user_img_transfer_fsm_default,		user_img_transfer_fsm_default, user_img_transfer_fsm_abort   }
+};
+
+/* Multicast transfer (selected when the image info received has the multicast flag) */
+static user_img_transfer_fsm_func *user_img_transfer_mcast_fsm_func_tbl[USER_IMG_TRANSFER_ST_CNT][USER_IMG_TRANSFER_EV_CNT] = {
+/*                 NONE,		                  START,           					 UDP_CNF						 UDP_IND,           				      TIMEOUT,					               STOP */
+/* READY 	   */ {user_img_transfer_fsm_default, user_img_transfer_fsm_start_reception, user_img_transfer_fsm_default,	 user_img_transfer_fsm_default,	          user_img_transfer_fsm_default,           user_img_transfer_fsm_default },
+/* SHARE_INFO  */ {user_img_transfer_fsm_default, user_img_transfer_fsm_default,     user_img_transfer_fsm_default,	 user_img_transfer_fsm_mcast_parse_block, user_img_transfer_fsm_mcast_send_info_ack, user_img_transfer_fsm_abort   },
+/* IN_PROGRESS */ {user_img_transfer_fsm_default, user_img_transfer_fsm_default,	 user_img_transfer_fsm_default,	 user_img_transfer_fsm_mcast_parse_block, user_img_transfer_fsm_mcast_timeout, user_img_transfer_fsm_abort   },
+/* REPAIR      */ {user_img_transfer_fsm_default, user_img_transfer_fsm_default,	 user_img_transfer_fsm_default,	 user_img_transfer_fsm_mcast_parse_block, user_img_transfer_fsm_mcast_send_nack, user_img_transfer_fsm_abort  }
 };
 #endif
 
@@ -248,6 +395,20 @@ static void user_img_transfer_end(user_image_transfer_error_code_t error_code)
 	RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
 }
 
+/**
+ * @brief Function that starts measuring the progress of the image transfer.
+ * @param None
+ * @retval None
+ * @note The bytes already transferred (resumed transfer) are not counted in the throughput.
+ */
+static void user_img_transfer_start_progress(void)
+{
+	user_img_transfer_fsm.last_timestamp = HAL_GetTick();
+	user_img_transfer_fsm.start_timestamp = user_img_transfer_fsm.last_timestamp;
+	user_img_transfer_fsm.last_transfered_bytes = user_img_transfer_fsm.transfered_bytes;
+	user_img_transfer_fsm.start_transfered_bytes = user_img_transfer_fsm.transfered_bytes;
+}
+
 /**
  * @brief Function that updates the progress of the image transfer.
  * @param None
@@ -255,14 +416,10 @@ static void user_img_transfer_end(user_image_transfer_error_code_t error_code)
  */
 static void user_img_transfer_update_progress(void)
 {
-	if (user_img_transfer_fsm.transfered_bytes == 0)
-	{
-		user_img_transfer_fsm.last_timestamp = HAL_GetTick();
-		user_img_transfer_fsm.last_transfered_bytes = 0;
-	}
-	else if (TRANSFER_SHOW_PROGRESS(user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.image_size))
+	if (	(user_img_transfer_fsm.transfered_bytes != user_img_transfer_fsm.last_transfered_bytes) &&
+			TRANSFER_SHOW_PROGRESS(user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.last_transfered_bytes, user_img_transfer_fsm.stream_size))
 	{
-		uint32_t progress = (100 * user_img_transfer_fsm.transfered_bytes) / user_img_transfer_fsm.image_size;
+		uint32_t progress = (100 * user_img_transfer_fsm.transfered_bytes) / user_img_transfer_fsm.stream_size;
 
 		uint32_t timestamp = HAL_GetTick();
 		float delta_time = timestamp - user_img_transfer_fsm.last_timestamp;
@@ -271,17 +428,153 @@ static void user_img_transfer_update_progress(void)
 		float transfer_speed = CONVERT_B_PER_MS_TO_KB_PER_S(delta_bytes / delta_time);
 
 #if IS_COORD
-		PRINT("Sent %u/%u bytes - %u%% - %.2f kB/s\n", user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.image_size, progress, transfer_speed);
+		PRINT("Sent %u/%u bytes - %u%% - %.2f kB/s\n", user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.stream_size, progress, transfer_speed);
 #else
-		PRINT("%u/%u bytes received - %u%% - %.2f kB/s\n", user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.image_size, progress, transfer_speed);
+		PRINT("%u/%u bytes received - %u%% - %.2f kB/s\n", user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.stream_size, progress, transfer_speed);
 #endif
 		user_img_transfer_fsm.last_transfered_bytes = user_img_transfer_fsm.transfered_bytes;
 		user_img_transfer_fsm.last_timestamp = timestamp;
 	}
 }
 
+/**
+ * @brief Function that reports the average throughput of the completed transfer, along with the one measured for the other window sizes.
+ * @param None
+ * @retval None
+ */
+static void user_img_transfer_report_throughput(void)
+{
+	uint32_t delta_time  = HAL_GetTick() - user_img_transfer_fsm.start_timestamp;
+	uint32_t delta_bytes = user_img_transfer_fsm.stream_size - user_img_transfer_fsm.start_transfered_bytes;
+
+	if (delta_time > 0)
+	{
+		float transfer_speed = CONVERT_B_PER_MS_TO_KB_PER_S((float) delta_bytes / delta_time);
+
+		user_img_transfer_speed[user_img_transfer_fsm.window_size] = transfer_speed;
+
+		PRINT("Transferred %u bytes in %u ms - window size %u - %.2f kB/s\n", delta_bytes, delta_time, user_img_transfer_fsm.window_size, transfer_speed);
+
+		if (user_img_transfer_fsm.compressed)
+		{
+			PRINT("Image of %u bytes compressed to %u bytes (%u%%)\n", user_img_transfer_fsm.image_size, user_img_transfer_fsm.stream_size, (100 * user_img_transfer_fsm.stream_size) / user_img_transfer_fsm.image_size);
+		}
+
+		PRINT("Throughput per window size:\n");
+
+		for (uint32_t i = 1; i <= USER_IMG_TRANSFER_WINDOW_MAX; i++)
+		{
+			if (user_img_transfer_speed[i] > 0)
+			{
+				PRINT("  > Window size %2u: %.2f kB/s\n", i, user_img_transfer_speed[i]);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Function that returns the SFLASH address of the data sent in blocks.
+ * @param None
+ * @retval Address of the staging area if the image is compressed, address of the image slot otherwise
+ */
+static uint32_t user_img_transfer_get_stream_address(void)
+{
+	return (user_img_transfer_fsm.compressed) ? SFLASH_STAGING : SFLASH_SLOT(user_img_transfer_fsm.image_slot);
+}
+
+/**
+ * @brief Function that returns the size of a block of the image.
+ * @param block_index Index of the block
+ * @retval Size of the block, in bytes
+ */
+static uint32_t user_img_transfer_get_block_size(uint32_t block_index)
+{
+	uint32_t bytes_left = user_img_transfer_fsm.stream_size - TRANSFER_IMAGE_BLOCK_OFFSET(block_index);
+
+	return (bytes_left >= TRANSFER_IMAGE_DATA_SIZE) ? TRANSFER_IMAGE_DATA_SIZE : bytes_left;
+}
+
+/**
+ * @brief Function that returns the index of the block that follows the current window.
+ * @param None
+ * @retval Index of the first block out of the window (or the number of blocks of the image)
+ */
+static uint32_t user_img_transfer_get_window_end(void)
+{
+	uint32_t block_num  = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
+	uint32_t window_end = user_img_transfer_fsm.window_base + user_img_transfer_fsm.window_size;
+
+	return (window_end < block_num) ? window_end : block_num;
+}
+
+#if IS_COORD
+/**
+ * @brief Function that tells if a block of the current window has already been received, according to the last selective ACK.
+ * @param block_index Index of the block
+ * @retval 'true' if the block was received, 'false' otherwise
+ */
+static bool user_img_transfer_block_received(uint32_t block_index)
+{
+	bool received = true;
+
+	if (block_index >= user_img_transfer_fsm.window_base)
+	{
+		received = BIT_IS_SET(user_img_transfer_fsm.window_map, (block_index - user_img_transfer_fsm.window_base));
+	}
+
+	return received;
+}
+#endif
+
+/**
+ * @brief Function that counts the blocks of the image set in a bitmap.
+ * @param map Pointer to the bitmap of the blocks
+ * @retval Number of blocks set
+ */
+static uint32_t user_img_transfer_count_blocks(const uint8_t *map)
+{
+	uint32_t block_num = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < block_num; i++)
+	{
+		if (TRANSFER_IMAGE_MAP_IS_SET(map, i))
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
 #if IS_COORD
 
+/**
+ * @brief Function that sends a message of the transfer to the destination device, or to all devices in multicast mode.
+ * @param data Pointer to the buffer containing the message
+ * @param length Length of the message, in bytes
+ * @retval None
+ */
+static void user_img_transfer_send_to_dest(void *data, uint32_t length)
+{
+	user_img_transfer_fsm.frame_count++;
+	user_img_transfer_fsm.frame_timestamp = HAL_GetTick();
+
+	if (user_img_transfer_fsm.multicast)
+	{
+		ip6_addr_t dst_ip_addr;
+
+		uint8_t broadcast_arr[IP_IPV6_ADDR128_UINT8_LEN] = IPV6_MULTICAST_ADDR;
+		memcpy(dst_ip_addr.u8, broadcast_arr, IP_IPV6_ADDR128_UINT8_LEN);
+
+		user_img_transfer_fsm.handle = UserG3_SendUdpData(TRANSFER_CONN_ID, dst_ip_addr, data, length);
+	}
+	else
+	{
+		user_img_transfer_fsm.handle = UserG3_SendUdpDataToShortAddress(TRANSFER_CONN_ID, user_img_transfer_fsm.dest_short_addr, data, length);
+	}
+}
+
 /**
  * @brief Load memory content into a slot.
  * @param slot_ptr Pointer to the slot info structure.
@@ -333,6 +626,71 @@ static void user_img_transfer_load_image_info(slot_info_t *slot_ptr, int8_t slot
 	}
 }
 
+#if USER_IMG_TRANSFER_COMPRESSION
+/**
+ * @brief Function that reads the image to compress from its slot.
+ * @param context Unused
+ * @param data Pointer to the buffer to fill
+ * @param size Number of bytes to read
+ * @param offset Offset of the data in the image
+ * @retval 'true' if the SFLASH read operation is successful, 'false' otherwise
+ */
+static bool user_img_transfer_read_image(void *context, uint8_t *data, uint32_t size, uint32_t offset)
+{
+	UNUSED(context);
+
+	return getDataBlock(SFLASH_SLOT(user_img_transfer_fsm.image_slot), data, size, offset);
+}
+
+/**
+ * @brief Function that writes the compressed image in the staging area.
+ * @param context Unused
+ * @param data Pointer to the compressed data
+ * @param size Number of bytes to write
+ * @param offset Offset of the data in the compressed stream
+ * @retval 'true' if the SFLASH write operation is successful, 'false' otherwise or if the stream is not smaller than the image
+ */
+static bool user_img_transfer_write_stream(void *context, const uint8_t *data, uint32_t size, uint32_t offset)
+{
+	UNUSED(context);
+
+	return (((offset + size) < user_img_transfer_fsm.image_size) && setDataBlock(SFLASH_STAGING, (uint8_t*) data, size, offset));
+}
+
+/**
+ * @brief Function that compresses the image into the staging area, falling back to the raw image if it does not get smaller.
+ * @param None
+ * @retval None
+ */
+static void user_img_transfer_compress(void)
+{
+	uint32_t start_timestamp = HAL_GetTick();
+
+	PRINT_USER_IT_INFO("Compressing image...\n");
+
+	user_img_transfer_fsm.stream_size = 0;
+
+	if (prepareStagingArea())
+	{
+		user_img_transfer_fsm.stream_size = lzss_encode(&user_img_transfer_encoder, user_img_transfer_fsm.image_size, user_img_transfer_read_image, user_img_transfer_write_stream, NULL);
+	}
+
+	if (user_img_transfer_fsm.stream_size > 0)
+	{
+		user_img_transfer_fsm.compressed = true;
+
+		PRINT_USER_IT_INFO("Image compressed to %u bytes in %u ms\n", user_img_transfer_fsm.stream_size, HAL_GetTick() - start_timestamp);
+	}
+	else
+	{
+		user_img_transfer_fsm.compressed  = false;
+		user_img_transfer_fsm.stream_size = user_img_transfer_fsm.image_size;
+
+		PRINT_USER_IT_INFO("Image not compressible, sent raw\n");
+	}
+}
+#endif
+
 static bool user_img_transfer_send_info(void)
 {
 	bool success = false;
@@ -349,6 +707,16 @@ static bool user_img_transfer_send_info(void)
 		user_img_transfer_fsm.image_size           = slot_info.size;
 		user_img_transfer_fsm.image_crc16	  	   = slot_info.crc16;
 
+		/* The image is compressed once, the info can be sent again */
+		if (user_img_transfer_fsm.stream_size == 0)
+		{
+#if USER_IMG_TRANSFER_COMPRESSION
+			user_img_transfer_compress();
+#else
+			user_img_transfer_fsm.stream_size = user_img_transfer_fsm.image_size;
+#endif
+		}
+
 		/* Send G3UDP-DATA.Request with image info */
 		image_info_t image_info;
 
@@ -357,15 +725,32 @@ static bool user_img_transfer_send_info(void)
 		image_info.type	    = slot_info.type;
 		image_info.size	    = slot_info.size;
 		image_info.crc16	= slot_info.crc16;
+		image_info.window_size = user_img_transfer_fsm.window_size;
+		image_info.flags    = (user_img_transfer_fsm.multicast) ? TRANSFER_IMAGE_INFO_FLAG_MULTICAST : 0;
+		image_info.flags   |= (user_img_transfer_fsm.compressed) ? TRANSFER_IMAGE_INFO_FLAG_COMPRESSED : 0;
+		image_info.stream_size = user_img_transfer_fsm.stream_size;
 		image_info.foot     = TRANSFER_IMAGE_INFO_END;
 
 		PRINT_USER_IT_INFO("Image type: %s\n",   translateImageType(user_img_transfer_fsm.image_type));
 		PRINT_USER_IT_INFO("Image size: %u\n",   user_img_transfer_fsm.image_size);
 		PRINT_USER_IT_INFO("Image CRC : 0x%X\n", user_img_transfer_fsm.image_crc16);
 
-		PRINT_USER_IT_INFO("Destination short address: %u\n", user_img_transfer_fsm.dest_short_addr);
+		if (user_img_transfer_fsm.compressed)
+		{
+			PRINT_USER_IT_INFO("Compressed size: %u\n", user_img_transfer_fsm.stream_size);
+		}
+
+		if (user_img_transfer_fsm.multicast)
+		{
+			PRINT_USER_IT_INFO("Destination: all devices (multicast)\n");
+		}
+		else
+		{
+			PRINT_USER_IT_INFO("Proposed window size: %u\n", user_img_transfer_fsm.window_size);
+			PRINT_USER_IT_INFO("Destination short address: %u\n", user_img_transfer_fsm.dest_short_addr);
+		}
 
-		user_img_transfer_fsm.handle = UserG3_SendUdpDataToShortAddress(TRANSFER_CONN_ID, user_img_transfer_fsm.dest_short_addr, &image_info, sizeof(image_info));
+		user_img_transfer_send_to_dest(&image_info, sizeof(image_info));
 
 		user_img_transfer_set_timeout(TRANSFER_INFO_TIMEOUT); /* Timeout indication */
 
@@ -379,36 +764,32 @@ static bool user_img_transfer_send_info(void)
  * @brief Functions that reads and sends the next block of data of the image as UDP packet
  * @param offset Memory offset of the data block
  * @param size Size of the data block, in bytes
+ * @param flags Flags of the data block (TRANSFER_IMAGE_FLAG_ACK_REQ to request a selective ACK)
  * @return None
  */
-static void user_img_transfer_send_block(uint32_t offset, uint32_t size)
+static void user_img_transfer_send_block(uint32_t offset, uint32_t size, uint8_t flags)
 {
 	uint32_t image_data_len = TRANSFER_IMAGE_DATA_MSG_SIZE(size);
 	image_data_t *image_data = MEMPOOL_MALLOC(image_data_len);
 
 	image_data->offset = offset;
 	image_data->size = size;
+	image_data->flags = flags;
 
 	/* Read flash memory and downloads block to ST8500 */
-	bool result = getDataBlock(SFLASH_SLOT(user_img_transfer_fsm.image_slot), image_data->data, image_data->size, image_data->offset);
+	bool result = getDataBlock(user_img_transfer_get_stream_address(), image_data->data, image_data->size, image_data->offset);
 
 	if (result)
 	{
-		user_img_transfer_fsm.transfered_bytes = image_data->offset + image_data->size;
-
 #if (DEBUG_USER_IT >= DEBUG_LEVEL_FULL)
 		ALLOC_DYNAMIC_HEX_STRING(block_str, image_data->data, TRANSFER_IMAGE_DATA_PREVIEW_SIZE);
-		PRINT_USER_IT_INFO("Sent data: %u/%u, raw data: %s\n", user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.image_size, block_str);
+		PRINT_USER_IT_INFO("Sent data: %u/%u, raw data: %s\n", image_data->offset + image_data->size, user_img_transfer_fsm.stream_size, block_str);
 		FREE_DYNAMIC_HEX_STRING(block_str)
 #else
-		PRINT_USER_IT_INFO("Sent data: %u/%u, raw data: %s\n", user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.image_size);
-
-		user_img_transfer_fsm.last_block_size = image_data->size;
+		PRINT_USER_IT_INFO("Sent data: %u/%u\n", image_data->offset + image_data->size, user_img_transfer_fsm.stream_size);
 #endif
 		/* Send UDP data request with image data */
-		user_img_transfer_fsm.handle = UserG3_SendUdpDataToShortAddress(TRANSFER_CONN_ID, user_img_transfer_fsm.dest_short_addr, image_data, image_data_len);
-
-		user_img_transfer_fsm.last_block_size = image_data->size;
+		user_img_transfer_send_to_dest(image_data, image_data_len);
 
 		user_img_transfer_set_timeout(TRANSFER_DATA_TIMEOUT); /* Timeout indication */
 	}
@@ -418,113 +799,345 @@ static void user_img_transfer_send_block(uint32_t offset, uint32_t size)
 	}
 }
 
-#else
-
 /**
- * @brief Function that sends the image transfer acknowledge to a specific address.
- * @param dest_addr Destination short address of the acknowledge
- * @param ack Type of acknowledge
- * @retval None
+ * @brief Function that sends a block of the current window, requesting the selective ACK if it is the last one of the burst.
+ * @param block_index Index of the block to send
+ * @return None
  */
-static void user_img_transfer_send_ack(uint16_t dest_addr, uint8_t ack)
+static void user_img_transfer_send_window_block(uint32_t block_index)
 {
-	image_ack_t	 *image_ack = MEMPOOL_MALLOC(sizeof(image_ack_t));
-	uint32_t bytes_left = user_img_transfer_fsm.image_size - user_img_transfer_fsm.transfered_bytes;
-
-	/* Result of the last operation */
-	image_ack->ack 		  = ack;
-
-	/* Specify next block offset */
-	image_ack->next_offset = user_img_transfer_fsm.transfered_bytes;
+	uint8_t flags = (block_index == user_img_transfer_fsm.window_last) ? TRANSFER_IMAGE_FLAG_ACK_REQ : 0;
 
-	/* Specify next block size */
-	if (bytes_left >= TRANSFER_IMAGE_DATA_SIZE)
-	{
-		image_ack->next_size = TRANSFER_IMAGE_DATA_SIZE; /* Standard block size */
-	}
-	else
-	{
-		image_ack->next_size = bytes_left; /* Last block size */
-	}
+	user_img_transfer_fsm.window_next = block_index;
 
-	user_img_transfer_fsm.handle = UserG3_SendUdpDataToShortAddress(TRANSFER_CONN_ID, dest_addr, image_ack, sizeof(image_ack_t));
+	user_img_transfer_send_block(TRANSFER_IMAGE_BLOCK_OFFSET(block_index), user_img_transfer_get_block_size(block_index), flags);
 }
 
-#endif /*COORD */
-
 /**
- * @brief Function that resets the User Image Transfer FSM.
+ * @brief Function that starts a new burst, sending all blocks of the window that were not received yet.
  * @param None
- * @retval None
+ * @return None
  */
-static void user_img_transfer_reset_state()
+static void user_img_transfer_send_window(void)
 {
-	user_img_transfer_fsm.curr_state = USER_IMG_TRANSFER_ST_READY;
-	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
-	user_img_transfer_fsm.error_code = 0;
-
-	/* SFLASH */
-	user_img_transfer_fsm.image_slot = 0;
-
-	/* Image information */
-	user_img_transfer_fsm.image_type = 0;
-	user_img_transfer_fsm.image_validity = 0;
-	user_img_transfer_fsm.image_size = 0;
-	user_img_transfer_fsm.image_crc16 = 0;
+	uint32_t window_end = user_img_transfer_get_window_end();
 
-	/* Transfer details */
-#if IS_COORD
-	user_img_transfer_fsm.dest_short_addr = 0;
-#endif
-	user_img_transfer_fsm.transfered_bytes = 0;
-	user_img_transfer_fsm.last_block_size = 0;
-	user_img_transfer_fsm.retry_count = 0;
-	user_img_transfer_fsm.transfer_complete = 0;
-	user_img_transfer_fsm.last_timestamp = 0;
-	user_img_transfer_fsm.last_transfered_bytes= 0;
-}
+	/* Finds the last missing block of the window, which carries the ACK request */
+	user_img_transfer_fsm.window_last = user_img_transfer_fsm.window_base;
 
-/**
- * @brief Function that maintains the current state, with no further action.
- * @return The next state of the User Image Transfer FSM.
- */
-static user_img_transfer_state_t user_img_transfer_fsm_default(void)
-{
-	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+	for (uint32_t i = window_end; i > user_img_transfer_fsm.window_base; i--)
+	{
+		if (!user_img_transfer_block_received(i - 1))
+		{
+			user_img_transfer_fsm.window_last = i - 1;
+			break;
+		}
+	}
 
-	return user_img_transfer_fsm.curr_state;
+	/* The first block of the window is always missing, the others are sent at each G3UDP-DATA.Confirm */
+	user_img_transfer_send_window_block(user_img_transfer_fsm.window_base);
 }
 
 /**
- * @brief Function that handles the timeout during the User Image Transfer, including retransmission
+ * @brief Function that sends the next block of the current multicast pass or, once all blocks of the pass are sent, the poll for the NACKs.
+ * @param None
  * @return The next state of the User Image Transfer FSM.
  */
-static user_img_transfer_state_t user_img_transfer_fsm_timeout(void)
+static user_img_transfer_state_t user_img_transfer_mcast_send_pass_block(void)
 {
 	user_img_transfer_state_t next_state = USER_IMG_TRANSFER_ST_IN_PROGRESS;
+	uint32_t block_num = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
 
-	PRINT_USER_IT_WARNING("Timeout on Image Transfer\n");
+	/* Skips the blocks not requested in this pass */
+	while (	(user_img_transfer_fsm.block_next < block_num) &&
+			(!TRANSFER_IMAGE_MAP_IS_SET(user_img_transfer_fsm.block_map, user_img_transfer_fsm.block_next)))
+	{
+		user_img_transfer_fsm.block_next++;
+	}
 
-	if (	(user_img_transfer_fsm.curr_state == USER_IMG_TRANSFER_ST_SHARE_INFO) ||
-			(user_img_transfer_fsm.retry_count >= TRANSFER_ERROR_N_MAX			) )
+	if (user_img_transfer_fsm.block_next < block_num)
 	{
-		/* Finished, failing */
-		PRINT_USER_IT_CRITICAL("Transfer failed\n");
+		uint32_t block_index = user_img_transfer_fsm.block_next++;
 
-		next_state = USER_IMG_TRANSFER_ST_READY;
+		user_img_transfer_send_block(TRANSFER_IMAGE_BLOCK_OFFSET(block_index), user_img_transfer_get_block_size(block_index), 0);
 
-		user_img_transfer_end(uit_info_timeout_error);
+		if (user_img_transfer_fsm.pass == 1)
+		{
+			user_img_transfer_fsm.transfered_bytes = TRANSFER_IMAGE_BLOCK_OFFSET(block_index) + user_img_transfer_get_block_size(block_index);
+
+			user_img_transfer_update_progress();
+		}
 	}
 	else
 	{
-		user_img_transfer_fsm.retry_count++;
-#if IS_COORD
-		user_img_transfer_send_block(user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.last_block_size);
+		/* End of the pass, the devices answer with their missing blocks */
+		image_poll_t image_poll;
 
-		user_img_transfer_update_progress();
-#else
-		user_img_transfer_set_timeout(TRANSFER_DATA_TIMEOUT); /* Timeout indication */
-#endif
+		image_poll.offset = 0;
+		image_poll.size   = 0;
+		image_poll.flags  = TRANSFER_IMAGE_FLAG_PASS_END;
+		image_poll.pass   = user_img_transfer_fsm.pass;
+
+		PRINT_USER_IT_INFO("End of pass %u, waiting for NACKs...\n", user_img_transfer_fsm.pass);
+
+		user_img_transfer_send_to_dest(&image_poll, sizeof(image_poll));
+
+		user_img_transfer_set_timeout(TRANSFER_MCAST_NACK_WINDOW); /* End of the NACK collection */
+
+		next_state = USER_IMG_TRANSFER_ST_REPAIR;
+	}
+
+	return next_state;
+}
+
+/**
+ * @brief Function that fills the list of the devices expected to receive the multicast transfer, with all devices connected to the PAN.
+ * @param None
+ * @retval None
+ */
+static void user_img_transfer_mcast_load_devices(void)
+{
+	user_img_transfer_fsm.device_num = 0;
+
+	for (uint16_t i = 0; i < BOOT_MAX_NUM_JOINING_NODES; i++)
+	{
+		if (boot_server.connected_devices[i].conn_state == boot_state_connected)
+		{
+			user_img_transfer_fsm.device_addr[user_img_transfer_fsm.device_num]  = boot_server.connected_devices[i].short_addr;
+			user_img_transfer_fsm.device_state[user_img_transfer_fsm.device_num] = TRANSFER_MCAST_DEVICE_SILENT;
+			user_img_transfer_fsm.device_num++;
+		}
+	}
+}
+
+/**
+ * @brief Function that finds a device in the list of the devices expected to receive the multicast transfer.
+ * @param short_addr Short address of the device
+ * @retval Index of the device in the list, -1 if not found
+ */
+static int32_t user_img_transfer_mcast_find_device(uint16_t short_addr)
+{
+	int32_t index = -1;
+
+	for (uint32_t i = 0; i < user_img_transfer_fsm.device_num; i++)
+	{
+		if (user_img_transfer_fsm.device_addr[i] == short_addr)
+		{
+			index = i;
+			break;
+		}
+	}
+
+	return index;
+}
+
+/**
+ * @brief Function that counts the devices of the multicast transfer in a given state.
+ * @param state State of the devices to count
+ * @retval Number of devices in the given state
+ */
+static uint32_t user_img_transfer_mcast_count_devices(user_image_transfer_mcast_device_t state)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < user_img_transfer_fsm.device_num; i++)
+	{
+		if (user_img_transfer_fsm.device_state[i] == state)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief Function that reports the completion time and the airtime of the multicast transfer, compared to sequential unicast transfers, and the result on each device.
+ * @param None
+ * @retval None
+ */
+static void user_img_transfer_mcast_report(void)
+{
+	uint32_t block_num  = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
+	uint32_t delta_time = HAL_GetTick() - user_img_transfer_fsm.start_timestamp;
+
+	PRINT("Multicast transfer: %u blocks, %u passes, %u frames sent, %u NACKs received\n", block_num, user_img_transfer_fsm.pass, user_img_transfer_fsm.frame_count, user_img_transfer_fsm.nack_count);
+	PRINT("  Completion time: %u ms, airtime: %u ms\n", delta_time, user_img_transfer_fsm.airtime);
+
+	if ((user_img_transfer_fsm.frame_count > 0) && (user_img_transfer_fsm.device_num > 0))
+	{
+		/* Sequential unicast needs at least one frame per block for each device, each one taking the average airtime measured */
+		uint32_t frame_airtime   = user_img_transfer_fsm.airtime / user_img_transfer_fsm.frame_count;
+		uint32_t unicast_airtime = frame_airtime * block_num * user_img_transfer_fsm.device_num;
+
+		PRINT("  Sequential unicast to %u devices (estimated): airtime and completion time >= %u ms\n", user_img_transfer_fsm.device_num, unicast_airtime);
+	}
+
+	PRINT("  Devices: %u completed, %u failed, %u without final report\n",
+			user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_DONE),
+			user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_FAILED),
+			user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_SILENT) + user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_JOINED));
+
+	for (uint32_t i = 0; i < user_img_transfer_fsm.device_num; i++)
+	{
+		switch (user_img_transfer_fsm.device_state[i])
+		{
+		case TRANSFER_MCAST_DEVICE_SILENT:
+			PRINT("  > Short address %u: FAILED, no answer\n", user_img_transfer_fsm.device_addr[i]);
+			break;
+		case TRANSFER_MCAST_DEVICE_JOINED:
+			PRINT("  > Short address %u: FAILED, image not completed\n", user_img_transfer_fsm.device_addr[i]);
+			break;
+		case TRANSFER_MCAST_DEVICE_FAILED:
+			PRINT("  > Short address %u: FAILED, image rejected or wrong CRC\n", user_img_transfer_fsm.device_addr[i]);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+#else
+
+/**
+ * @brief Function that sends the image transfer acknowledge to a specific address.
+ * @param dest_addr Destination short address of the acknowledge
+ * @param ack Type of acknowledge
+ * @retval None
+ */
+static void user_img_transfer_send_ack(uint16_t dest_addr, uint8_t ack)
+{
+	image_ack_t	 *image_ack = MEMPOOL_MALLOC(sizeof(image_ack_t));
+
+	/* Result of the last operation */
+	image_ack->ack 		  = ack;
+
+	/* Specify next block offset */
+	image_ack->next_offset = user_img_transfer_fsm.transfered_bytes;
+
+	/* Specify next block size */
+	if (user_img_transfer_fsm.transfered_bytes < user_img_transfer_fsm.stream_size)
+	{
+		image_ack->next_size = user_img_transfer_get_block_size(user_img_transfer_fsm.window_base);
+	}
+	else
+	{
+		image_ack->next_size = 0; /* Nothing left */
+	}
+
+	/* Selective ACK of the blocks received out of order */
+	image_ack->window_size  = user_img_transfer_fsm.window_size;
+	image_ack->received_map = user_img_transfer_fsm.window_map;
+
+	user_img_transfer_fsm.handle = UserG3_SendUdpDataToShortAddress(TRANSFER_CONN_ID, dest_addr, image_ack, sizeof(image_ack_t));
+}
+
+#endif /*COORD */
+
+/**
+ * @brief Function that resets the User Image Transfer FSM.
+ * @param None
+ * @retval None
+ */
+static void user_img_transfer_reset_state()
+{
+	user_img_transfer_fsm.curr_state = USER_IMG_TRANSFER_ST_READY;
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+	user_img_transfer_fsm.error_code = 0;
+
+	/* SFLASH */
+	user_img_transfer_fsm.image_slot = 0;
+
+	/* Image information */
+	user_img_transfer_fsm.image_type = 0;
+	user_img_transfer_fsm.image_validity = 0;
+	user_img_transfer_fsm.image_size = 0;
+	user_img_transfer_fsm.image_crc16 = 0;
+	user_img_transfer_fsm.stream_size = 0;
+	user_img_transfer_fsm.compressed = false;
+
+	/* Transfer details */
+#if IS_COORD
+	user_img_transfer_fsm.dest_short_addr = 0;
+#endif
+	user_img_transfer_fsm.transfered_bytes = 0;
+	user_img_transfer_fsm.retry_count = 0;
+	user_img_transfer_fsm.transfer_complete = 0;
+	user_img_transfer_fsm.start_timestamp = 0;
+	user_img_transfer_fsm.start_transfered_bytes = 0;
+	user_img_transfer_fsm.last_timestamp = 0;
+	user_img_transfer_fsm.last_transfered_bytes= 0;
+
+	/* Sliding window */
+	user_img_transfer_fsm.window_size = 1;
+	user_img_transfer_fsm.window_base = 0;
+	user_img_transfer_fsm.window_map  = 0;
+#if IS_COORD
+	user_img_transfer_fsm.window_next = 0;
+	user_img_transfer_fsm.window_last = 0;
+#endif
+
+	/* Multicast */
+	user_img_transfer_fsm.multicast = false;
+	user_img_transfer_fsm.pass = 0;
+	memset(user_img_transfer_fsm.block_map, 0, sizeof(user_img_transfer_fsm.block_map));
+#if IS_COORD
+	memset(user_img_transfer_fsm.repair_map, 0, sizeof(user_img_transfer_fsm.repair_map));
+	user_img_transfer_fsm.block_next = 0;
+	user_img_transfer_fsm.nack_count = 0;
+	user_img_transfer_fsm.frame_count = 0;
+	user_img_transfer_fsm.frame_timestamp = 0;
+	user_img_transfer_fsm.airtime = 0;
+	user_img_transfer_fsm.device_num = 0;
+	memset(user_img_transfer_fsm.device_addr, 0, sizeof(user_img_transfer_fsm.device_addr));
+	memset(user_img_transfer_fsm.device_state, 0, sizeof(user_img_transfer_fsm.device_state));
+#else
+	user_img_transfer_fsm.coord_short_addr = 0;
+	user_img_transfer_fsm.blocks_received = 0;
+	user_img_transfer_fsm.inflate_next = 0;
+#endif
+}
+
+/**
+ * @brief Function that maintains the current state, with no further action.
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_default(void)
+{
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return user_img_transfer_fsm.curr_state;
+}
+
+/**
+ * @brief Function that handles the timeout during the User Image Transfer, including retransmission
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_timeout(void)
+{
+	user_img_transfer_state_t next_state = USER_IMG_TRANSFER_ST_IN_PROGRESS;
+
+	PRINT_USER_IT_WARNING("Timeout on Image Transfer\n");
+
+	if (	(user_img_transfer_fsm.curr_state == USER_IMG_TRANSFER_ST_SHARE_INFO) ||
+			(user_img_transfer_fsm.retry_count >= TRANSFER_ERROR_N_MAX			) )
+	{
+		/* Finished, failing */
+		PRINT_USER_IT_CRITICAL("Transfer failed\n");
+
+		next_state = USER_IMG_TRANSFER_ST_READY;
+
+		user_img_transfer_end(uit_info_timeout_error);
+	}
+	else
+	{
+		user_img_transfer_fsm.retry_count++;
+#if IS_COORD
+		/* Probes the receiver with the last block of the burst, which requests the selective ACK */
+		user_img_transfer_send_window_block(user_img_transfer_fsm.window_last);
+#else
+		user_img_transfer_set_timeout(TRANSFER_DATA_TIMEOUT); /* Timeout indication */
+#endif
 	}
 
 	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
@@ -596,13 +1209,29 @@ static user_img_transfer_state_t user_img_transfer_fsm_parse_info_ack(void)
 
 		if (image_ack->ack == TRANSFER_IMAGE_ACK)
 		{
-			PRINT_USER_IT_INFO("Info ACK received\n");
+			/* The receiver can only reduce the proposed window */
+			if ((image_ack->window_size > 0) && (image_ack->window_size < user_img_transfer_fsm.window_size))
+			{
+				user_img_transfer_fsm.window_size = image_ack->window_size;
+			}
+
+			PRINT_USER_IT_INFO("Info ACK received, window size: %u\n", user_img_transfer_fsm.window_size);
 
 			user_img_transfer_fsm.retry_count = 0;
 
-			user_img_transfer_update_progress();
+			/* The receiver reports the first missing block, resuming a previous transfer of the same image */
+			user_img_transfer_fsm.transfered_bytes = image_ack->next_offset;
+			user_img_transfer_fsm.window_base      = image_ack->next_offset / TRANSFER_IMAGE_DATA_SIZE;
+			user_img_transfer_fsm.window_map       = image_ack->received_map;
+
+			if (user_img_transfer_fsm.transfered_bytes > 0)
+			{
+				PRINT_USER_IT_INFO("Resuming transfer from offset %u\n", user_img_transfer_fsm.transfered_bytes);
+			}
 
-			user_img_transfer_send_block(image_ack->next_offset, image_ack->next_size);
+			user_img_transfer_start_progress();
+
+			user_img_transfer_send_window();
 
 			next_state = USER_IMG_TRANSFER_ST_IN_PROGRESS;
 		}
@@ -635,7 +1264,30 @@ static user_img_transfer_state_t user_img_transfer_fsm_parse_info_ack(void)
 	return next_state;
 }
 
-/* @brief User Image Transfer FSM function that checks the ACK received and sends the next block.
+/**
+ * @brief User Image Transfer FSM function that sends the next missing block of the current burst, once the previous one is confirmed.
+ * @note
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_send_next_block(void)
+{
+	for (uint32_t i = user_img_transfer_fsm.window_next + 1; i <= user_img_transfer_fsm.window_last; i++)
+	{
+		if (!user_img_transfer_block_received(i))
+		{
+			user_img_transfer_send_window_block(i);
+			break;
+		}
+	}
+
+	/* After the last block of the burst, waits for the selective ACK */
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return user_img_transfer_fsm.curr_state;
+}
+
+/* @brief User Image Transfer FSM function that checks the selective ACK received and sends the missing blocks of the next window.
  * @note
  * @return The next state of the User Image Transfer FSM.
  */
@@ -644,7 +1296,7 @@ static user_img_transfer_state_t user_img_transfer_fsm_parse_ack(void)
 	user_img_transfer_state_t next_state = user_img_transfer_fsm.curr_state;
 
 	/* Gets UDP packet received, containing the image ACK */
-	udp_packet_t udp_packet_rx = UserG3_GetUdpData(TRANSFER_CONN_ID); // Sistema!
+	udp_packet_t udp_packet_rx = UserG3_GetUdpData(TRANSFER_CONN_ID);
 
 	if (udp_packet_rx.payload != NULL)
 	{
@@ -655,74 +1307,726 @@ static user_img_transfer_state_t user_img_transfer_fsm_parse_ack(void)
 
 		image_ack_t *image_ack = udp_packet_rx.payload;
 
+		/* Blocks confirmed before and after this selective ACK */
+		uint32_t prev_base = user_img_transfer_fsm.window_base;
+		uint32_t prev_map  = user_img_transfer_fsm.window_map;
+
+		user_img_transfer_fsm.transfered_bytes = image_ack->next_offset;
+		user_img_transfer_fsm.window_base      = image_ack->next_offset / TRANSFER_IMAGE_DATA_SIZE;
+		user_img_transfer_fsm.window_map       = image_ack->received_map;
+
 		/* Handle errors */
 		if (image_ack->ack == TRANSFER_IMAGE_NACK)
 		{
 			PRINT_USER_IT_WARNING("NACK received\n");
 			user_img_transfer_fsm.retry_count++;
-			user_img_transfer_fsm.transfered_bytes = image_ack->next_offset;
 		}
-		else if (image_ack->next_offset != user_img_transfer_fsm.transfered_bytes)
+		else if ((user_img_transfer_fsm.window_base == prev_base) && (user_img_transfer_fsm.window_map == prev_map))
 		{
-			PRINT_USER_IT_WARNING("Wrong next offset, got %u instead of %u\n", image_ack->next_offset, user_img_transfer_fsm.transfered_bytes);
+			PRINT_USER_IT_WARNING("No progress in window at offset %u\n", image_ack->next_offset);
 			user_img_transfer_fsm.retry_count++;
-			user_img_transfer_fsm.transfered_bytes = image_ack->next_offset;
 		}
 		else
 		{
 			user_img_transfer_fsm.retry_count = 0;
 		}
 
-		assert(user_img_transfer_fsm.transfered_bytes <= user_img_transfer_fsm.image_size);
+		assert(user_img_transfer_fsm.transfered_bytes <= user_img_transfer_fsm.stream_size);
+
+		if (user_img_transfer_fsm.retry_count >= TRANSFER_ERROR_N_MAX)
+		{
+			/* Finished, failing */
+			PRINT_USER_IT_CRITICAL("Transfer failed\n");
+
+			next_state = USER_IMG_TRANSFER_ST_READY;
+
+			user_img_transfer_end(uit_data_timeout_error);
+		}
+		else if (user_img_transfer_fsm.transfered_bytes == user_img_transfer_fsm.stream_size)
+		{
+			/* Finished */
+			PRINT_USER_IT_INFO("Transfer completed (CRC16: 0x%X)\n", user_img_transfer_fsm.image_crc16);
+
+			user_img_transfer_update_progress();
+
+			user_img_transfer_report_throughput();
+
+			next_state = USER_IMG_TRANSFER_ST_READY;
+
+			user_img_transfer_end(uit_no_error);
+		}
+		else
+		{
+			user_img_transfer_send_window();
+
+			user_img_transfer_update_progress();
+		}
+
+		UserG3_DiscardUdpData(TRANSFER_CONN_ID);
+	}
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return next_state;
+}
+
+/**
+ * @brief Function that starts the first multicast pass, once the devices acknowledged the image info.
+ * @param None
+ * @return The next state of the User Image Transfer FSM.
+ * @note Multicast only: all blocks of the image are sent in the first pass.
+ */
+static user_img_transfer_state_t user_img_transfer_mcast_start_pass(void)
+{
+	uint32_t block_num = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
+
+	user_img_transfer_remove_timeout();
+
+	for (uint32_t i = 0; i < block_num; i++)
+	{
+		TRANSFER_IMAGE_MAP_SET(user_img_transfer_fsm.block_map, i);
+	}
+
+	user_img_transfer_fsm.pass       = 1;
+	user_img_transfer_fsm.block_next = 0;
+	user_img_transfer_fsm.retry_count = 0;
+
+	PRINT_USER_IT_INFO("Pass %u, sending %u blocks to %u devices\n", user_img_transfer_fsm.pass, block_num, user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_JOINED));
+
+	user_img_transfer_fsm.transfered_bytes = 0;
+
+	user_img_transfer_start_progress();
+
+	return user_img_transfer_mcast_send_pass_block();
+}
+
+/**
+ * @brief Function that updates the progress of a device of the multicast transfer, according to the message received from it.
+ * @param short_addr Short address of the device
+ * @param ack Type of acknowledge received from the device
+ * @retval None
+ * @note An info ACK or a NACK received from a silent device means it is receiving the image.
+ */
+static void user_img_transfer_mcast_update_device(uint16_t short_addr, uint8_t ack)
+{
+	int32_t index = user_img_transfer_mcast_find_device(short_addr);
+
+	if (index >= 0)
+	{
+		user_image_transfer_mcast_device_t *state = &user_img_transfer_fsm.device_state[index];
+
+		switch (ack)
+		{
+		case TRANSFER_IMAGE_ACK:
+		case TRANSFER_IMAGE_NACK:
+			if (*state == TRANSFER_MCAST_DEVICE_SILENT)
+			{
+				*state = TRANSFER_MCAST_DEVICE_JOINED;
+			}
+			break;
+		case TRANSFER_IMAGE_DONE:
+			*state = TRANSFER_MCAST_DEVICE_DONE;
+			break;
+		default:
+			*state = TRANSFER_MCAST_DEVICE_FAILED;
+			break;
+		}
+	}
+	else
+	{
+		PRINT_USER_IT_WARNING("Short address %u was not connected at the start of the transfer\n", short_addr);
+	}
+}
+
+/**
+ * @brief User Image Transfer FSM function that starts collecting the info ACKs, once the image info is sent.
+ * @note Multicast only.
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_info_sent(void)
+{
+	PRINT_USER_IT_INFO("Image info sent, waiting for the ACKs of %u devices...\n", user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_SILENT));
+
+	user_img_transfer_set_timeout(TRANSFER_MCAST_NACK_WINDOW); /* End of the info ACK collection */
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return user_img_transfer_fsm.curr_state;
+}
+
+/**
+ * @brief User Image Transfer FSM function that records the info ACK of a device, starting the first pass once all devices answered.
+ * @note Multicast only. A device rejecting the image info answers with a NACK, and is reported as failed.
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_parse_info_ack(void)
+{
+	user_img_transfer_state_t next_state = user_img_transfer_fsm.curr_state;
+
+	udp_packet_t udp_packet_rx = UserG3_GetUdpData(TRANSFER_CONN_ID);
+
+	if (udp_packet_rx.payload != NULL)
+	{
+		uint16_t pan_id, short_addr;
+
+		hi_ipv6_get_saddr_panid(udp_packet_rx.ip_addr, &pan_id, &short_addr);
+
+		image_ack_t *image_ack = udp_packet_rx.payload;
+
+		if (udp_packet_rx.length == sizeof(image_ack_t))
+		{
+			if (image_ack->ack == TRANSFER_IMAGE_ACK)
+			{
+				PRINT_USER_IT_INFO("Info ACK from short address %u\n", short_addr);
+
+				user_img_transfer_mcast_update_device(short_addr, TRANSFER_IMAGE_ACK);
+			}
+			else
+			{
+				PRINT_USER_IT_WARNING("Info NACK from short address %u\n", short_addr);
+
+				user_img_transfer_mcast_update_device(short_addr, TRANSFER_IMAGE_FAILED);
+			}
+
+			if (user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_SILENT) == 0)
+			{
+				if (user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_JOINED) > 0)
+				{
+					/* All devices answered, no need to wait for the end of the collection */
+					next_state = user_img_transfer_mcast_start_pass();
+				}
+				else
+				{
+					/* Finished, failing */
+					PRINT_USER_IT_CRITICAL("Could not start transfer, all devices rejected the image\n");
+
+					user_img_transfer_remove_timeout();
+
+					user_img_transfer_mcast_report();
+
+					next_state = USER_IMG_TRANSFER_ST_READY;
+
+					user_img_transfer_end(uit_device_error);
+				}
+			}
+		}
+		else
+		{
+			PRINT_USER_IT_WARNING("Unexpected message from short address %u (length %u)\n", short_addr, udp_packet_rx.length);
+		}
+
+		UserG3_DiscardUdpData(TRANSFER_CONN_ID);
+	}
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return next_state;
+}
+
+/**
+ * @brief User Image Transfer FSM function that ends the info ACK collection, sending the info again to the silent devices or starting the first pass.
+ * @note Multicast only. The devices still silent after the last attempt are reported as failed at the end of the transfer.
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_info_timeout(void)
+{
+	user_img_transfer_state_t next_state = user_img_transfer_fsm.curr_state;
+
+	uint32_t silent_num = user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_SILENT);
+
+	PRINT_USER_IT_WARNING("No info ACK from %u devices\n", silent_num);
+
+	if (user_img_transfer_fsm.retry_count < TRANSFER_ERROR_N_MAX)
+	{
+		user_img_transfer_fsm.retry_count++;
+
+		/* The devices that already acknowledged the info answer again */
+		if (!user_img_transfer_send_info())
+		{
+			next_state = USER_IMG_TRANSFER_ST_READY;
+
+			user_img_transfer_end(uit_info_timeout_error);
+		}
+	}
+	else if (user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_JOINED) > 0)
+	{
+		next_state = user_img_transfer_mcast_start_pass();
+	}
+	else
+	{
+		/* Finished, failing */
+		PRINT_USER_IT_CRITICAL("Could not start transfer, no device acknowledged the image info\n");
+
+		user_img_transfer_mcast_report();
+
+		next_state = USER_IMG_TRANSFER_ST_READY;
+
+		user_img_transfer_end(uit_info_timeout_error);
+	}
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return next_state;
+}
+
+/**
+ * @brief User Image Transfer FSM function that sends the next block of the multicast pass, once the previous one is confirmed.
+ * @note Multicast only.
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_send_next_block(void)
+{
+	user_img_transfer_fsm.retry_count = 0;
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return user_img_transfer_mcast_send_pass_block();
+}
+
+/**
+ * @brief User Image Transfer FSM function that merges the missing blocks reported by a device into the blocks of the next pass, or records its final report.
+ * @note Multicast only. NACKs and final reports are also accepted while the pass is in progress, as some of them can arrive late.
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_parse_nack(void)
+{
+	udp_packet_t udp_packet_rx = UserG3_GetUdpData(TRANSFER_CONN_ID);
+
+	if (udp_packet_rx.payload != NULL)
+	{
+		uint16_t pan_id, short_addr;
+
+		hi_ipv6_get_saddr_panid(udp_packet_rx.ip_addr, &pan_id, &short_addr);
+
+		image_nack_t *image_nack = udp_packet_rx.payload;
+
+		if ((udp_packet_rx.length == sizeof(image_nack_t)) && (image_nack->ack == TRANSFER_IMAGE_NACK))
+		{
+			PRINT_USER_IT_INFO("NACK from short address %u (pass %u): %u blocks missing\n", short_addr, image_nack->pass, image_nack->missing_num);
+
+			user_img_transfer_fsm.nack_count++;
+
+			for (uint32_t i = 0; i < TRANSFER_IMAGE_MAP_SIZE; i++)
+			{
+				user_img_transfer_fsm.repair_map[i] |= image_nack->missing_map[i];
+			}
+
+			user_img_transfer_mcast_update_device(short_addr, image_nack->ack);
+		}
+		else if ((udp_packet_rx.length == sizeof(image_nack_t)) && ((image_nack->ack == TRANSFER_IMAGE_DONE) || (image_nack->ack == TRANSFER_IMAGE_FAILED)))
+		{
+			if (image_nack->ack == TRANSFER_IMAGE_DONE)
+			{
+				PRINT_USER_IT_INFO("Short address %u (pass %u): image received\n", short_addr, image_nack->pass);
+			}
+			else
+			{
+				PRINT_USER_IT_WARNING("Short address %u (pass %u): image received with a wrong CRC\n", short_addr, image_nack->pass);
+			}
+
+			user_img_transfer_mcast_update_device(short_addr, image_nack->ack);
+		}
+		else if ((udp_packet_rx.length == sizeof(image_ack_t)) && (image_nack->ack == TRANSFER_IMAGE_ACK))
+		{
+			/* Late info ACK, the device receives the blocks from the current pass */
+			PRINT_USER_IT_INFO("Late info ACK from short address %u\n", short_addr);
+
+			user_img_transfer_mcast_update_device(short_addr, image_nack->ack);
+		}
+		else
+		{
+			PRINT_USER_IT_WARNING("Unexpected message from short address %u (length %u)\n", short_addr, udp_packet_rx.length);
+		}
+
+		UserG3_DiscardUdpData(TRANSFER_CONN_ID);
+	}
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return user_img_transfer_fsm.curr_state;
+}
+
+/**
+ * @brief User Image Transfer FSM function that handles a missing G3UDP-DATA.Confirm during a multicast pass, sending the last block again.
+ * @note Multicast only.
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_timeout(void)
+{
+	user_img_transfer_state_t next_state;
+
+	PRINT_USER_IT_WARNING("Timeout on Image Transfer\n");
+
+	if (user_img_transfer_fsm.retry_count >= TRANSFER_ERROR_N_MAX)
+	{
+		/* Finished, failing */
+		PRINT_USER_IT_CRITICAL("Transfer failed\n");
+
+		next_state = USER_IMG_TRANSFER_ST_READY;
+
+		user_img_transfer_end(uit_data_timeout_error);
+	}
+	else
+	{
+		user_img_transfer_fsm.retry_count++;
+
+		/* The last block sent is still set in the bitmap of the pass */
+		if (user_img_transfer_fsm.block_next > 0)
+		{
+			user_img_transfer_fsm.block_next--;
+		}
+
+		next_state = user_img_transfer_mcast_send_pass_block();
+	}
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return next_state;
+}
+
+/**
+ * @brief User Image Transfer FSM function that ends the NACK collection, starting a new pass or ending the transfer once all devices sent their final report.
+ * @note Multicast only. The devices that did not report yet are polled again with the next pass, even when no block is missing.
+ * @return The next state of the User Image Transfer FSM.
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_end_pass(void)
+{
+	user_img_transfer_state_t next_state;
+
+	uint32_t missing_num = user_img_transfer_count_blocks(user_img_transfer_fsm.repair_map);
+	uint32_t failed_num  = user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_FAILED);
+	uint32_t pending_num = user_img_transfer_fsm.device_num - user_img_transfer_mcast_count_devices(TRANSFER_MCAST_DEVICE_DONE) - failed_num;
+
+	if (pending_num == 0)
+	{
+		if (failed_num == 0)
+		{
+			/* Finished, all devices reported the image as received */
+			PRINT_USER_IT_INFO("Transfer completed (CRC16: 0x%X)\n", user_img_transfer_fsm.image_crc16);
+
+			user_img_transfer_mcast_report();
+
+			user_img_transfer_end(uit_no_error);
+		}
+		else
+		{
+			/* Finished, failing on some devices */
+			PRINT_USER_IT_CRITICAL("Transfer failed on %u devices\n", failed_num);
+
+			user_img_transfer_mcast_report();
+
+			user_img_transfer_end(uit_device_error);
+		}
+
+		next_state = USER_IMG_TRANSFER_ST_READY;
+	}
+	else if (user_img_transfer_fsm.pass >= TRANSFER_MCAST_PASS_MAX)
+	{
+		/* Finished, failing */
+		PRINT_USER_IT_CRITICAL("Transfer failed, %u devices did not complete after %u passes (%u blocks still missing)\n", pending_num, user_img_transfer_fsm.pass, missing_num);
+
+		user_img_transfer_mcast_report();
+
+		next_state = USER_IMG_TRANSFER_ST_READY;
+
+		user_img_transfer_end(uit_data_timeout_error);
+	}
+	else
+	{
+		/* Repair pass, sending again only the blocks missing on at least one device (only the poll if none) */
+		memcpy(user_img_transfer_fsm.block_map, user_img_transfer_fsm.repair_map, sizeof(user_img_transfer_fsm.block_map));
+		memset(user_img_transfer_fsm.repair_map, 0, sizeof(user_img_transfer_fsm.repair_map));
+
+		user_img_transfer_fsm.pass++;
+		user_img_transfer_fsm.block_next  = 0;
+		user_img_transfer_fsm.retry_count = 0;
+
+		PRINT_USER_IT_INFO("Pass %u, sending %u blocks, %u devices did not report yet\n", user_img_transfer_fsm.pass, missing_num, pending_num);
+
+		next_state = user_img_transfer_mcast_send_pass_block();
+	}
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return next_state;
+}
+
+#else /* IS_COORD */
+
+/**
+ * @brief Function that checks the CRC of the image received, sets its validity and ends the transfer.
+ * @param None
+ * @retval None
+ */
+static void user_img_transfer_complete(void)
+{
+	user_image_transfer_error_code_t error_code;
+
+	user_img_transfer_remove_timeout();
+
+	if (user_img_transfer_fsm.compressed && (user_img_transfer_decoder.output_size != user_img_transfer_fsm.image_size))
+	{
+		PRINT_USER_IT_CRITICAL("  Error, %u bytes decompressed instead of %u\n", user_img_transfer_decoder.output_size, user_img_transfer_fsm.image_size);
+	}
+
+	/* Use image data block as buffer for calculating CRC16 */
+	uint16_t crc_calc = calculateImageCRC(SFLASH_SLOT(user_img_transfer_fsm.image_slot), user_img_transfer_fsm.image_size);
+	PRINT_USER_IT_INFO("  Transfer completed (CRC16: 0x%X)\n", crc_calc);
+
+	if (crc_calc == user_img_transfer_fsm.image_crc16)
+	{
+		error_code = uit_no_error;
+	}
+	else
+	{
+		error_code = uit_crc_error;
+		user_img_transfer_fsm.image_validity = IMG_INVALIDATED;
+		PRINT_USER_IT_CRITICAL("  Error, expected CRC16: 0x%04X instead of 0x%04X\n", user_img_transfer_fsm.image_crc16, crc_calc);
+	}
+
+	/* The transfer cannot be resumed anymore */
+	invalidateTransferProgress(SFLASH_SLOT(user_img_transfer_fsm.image_slot));
+
+	/* Validity isn't considered for CRC16 calculation */
+	setImageValidity(SFLASH_SLOT(user_img_transfer_fsm.image_slot), user_img_transfer_fsm.image_validity);
+
+	regradeImagesInMemory(SFLASH_SLOT(user_img_transfer_fsm.image_slot), user_img_transfer_fsm.image_validity);
+
+	user_img_transfer_report_throughput();
+
+	user_img_transfer_end(error_code);
+}
+
+/**
+ * @brief Function that starts the random delay before answering the coordinator of a multicast transfer (info ACK, NACK or final report).
+ * @param None
+ * @retval None
+ */
+static void user_img_transfer_mcast_schedule_answer(void)
+{
+	/* Spreads the answers of all devices over the collection window of the coordinator */
+	uint32_t backoff = 1 + (rand() % TRANSFER_MCAST_NACK_BACKOFF_MAX);
+
+	user_img_transfer_set_timeout(backoff); /* NACK transmission */
+}
+
+/**
+ * @brief Function that moves the window to the first missing block and updates the bitmap of the blocks received after it.
+ * @param None
+ * @retval None
+ */
+static void user_img_transfer_slide_window(void)
+{
+	uint32_t block_num = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
+
+	while (	(user_img_transfer_fsm.window_base < block_num) &&
+			TRANSFER_IMAGE_MAP_IS_SET(user_img_transfer_fsm.block_map, user_img_transfer_fsm.window_base))
+	{
+		user_img_transfer_fsm.window_base++;
+	}
+
+	user_img_transfer_fsm.window_map = 0;
+
+	for (uint32_t i = 0; (i < USER_IMG_TRANSFER_WINDOW_MAX) && ((user_img_transfer_fsm.window_base + i) < block_num); i++)
+	{
+		if (TRANSFER_IMAGE_MAP_IS_SET(user_img_transfer_fsm.block_map, user_img_transfer_fsm.window_base + i))
+		{
+			BIT_SET(user_img_transfer_fsm.window_map, i);
+		}
+	}
+
+	user_img_transfer_fsm.transfered_bytes = TRANSFER_IMAGE_BLOCK_OFFSET(user_img_transfer_fsm.window_base);
+
+	if (user_img_transfer_fsm.transfered_bytes > user_img_transfer_fsm.stream_size)
+	{
+		user_img_transfer_fsm.transfered_bytes = user_img_transfer_fsm.stream_size;
+	}
+}
+
+/**
+ * @brief Function that marks a block as received, in RAM and in the transfer progress record of the slot.
+ * @param block_index Index of the block received
+ * @retval None
+ */
+static void user_img_transfer_set_block_received(uint32_t block_index)
+{
+	TRANSFER_IMAGE_MAP_SET(user_img_transfer_fsm.block_map, block_index);
+
+	user_img_transfer_fsm.blocks_received++;
+
+	setTransferBlockReceived(SFLASH_SLOT(user_img_transfer_fsm.image_slot), block_index);
+}
+
+/**
+ * @brief Function that writes the decompressed image in its slot.
+ * @param context Unused
+ * @param data Pointer to the decompressed data
+ * @param size Number of bytes to write (up to LZSS_WINDOW_SIZE)
+ * @param offset Offset of the data in the image
+ * @retval 'true' if the SFLASH write operation is successful, 'false' otherwise
+ */
+static bool user_img_transfer_write_image(void *context, const uint8_t *data, uint32_t size, uint32_t offset)
+{
+	UNUSED(context);
+
+	return setDataBlock(SFLASH_SLOT(user_img_transfer_fsm.image_slot), (uint8_t*) data, size, offset);
+}
+
+/**
+ * @brief Function that decompresses the blocks of the stream received in sequence, writing the image in its slot.
+ * @param block_index Index of the block just received
+ * @param data Pointer to the data of the block just received (NULL if none)
+ * @retval None
+ * @note The blocks received out of order are read back from the staging area once the missing ones arrive.
+ */
+static void user_img_transfer_inflate(uint32_t block_index, const uint8_t *data)
+{
+	uint32_t block_num = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
+	uint8_t *buffer    = NULL;
+	bool	 result    = true;
+
+	while (	result 														&&
+			(user_img_transfer_fsm.inflate_next < block_num) 			&&
+			TRANSFER_IMAGE_MAP_IS_SET(user_img_transfer_fsm.block_map, user_img_transfer_fsm.inflate_next))
+	{
+		uint32_t size = user_img_transfer_get_block_size(user_img_transfer_fsm.inflate_next);
+
+		if ((user_img_transfer_fsm.inflate_next == block_index) && (data != NULL))
+		{
+			result = lzss_decoder_feed(&user_img_transfer_decoder, data, size);
+		}
+		else
+		{
+			if (buffer == NULL)
+			{
+				buffer = MEMPOOL_MALLOC(TRANSFER_IMAGE_DATA_SIZE);
+			}
+
+			result = getDataBlock(SFLASH_STAGING, buffer, size, TRANSFER_IMAGE_BLOCK_OFFSET(user_img_transfer_fsm.inflate_next)) &&
+					 lzss_decoder_feed(&user_img_transfer_decoder, buffer, size);
+		}
+
+		user_img_transfer_fsm.inflate_next++;
+	}
+
+	if (buffer != NULL)
+	{
+		MEMPOOL_FREE(buffer);
+	}
+
+	if (!result)
+	{
+		/* Stops decompressing, the CRC check of the image will fail */
+		PRINT_USER_IT_CRITICAL("Error, cannot decompress block %u\n", user_img_transfer_fsm.inflate_next - 1);
+
+		user_img_transfer_fsm.inflate_next = block_num;
+	}
+}
+
+/**
+ * @brief Function that prepares the slot for the image announced by the sender.
+ * @param None
+ * @retval None
+ * @note If the progress record of the slot belongs to the same image (type, size and CRC), the blocks already received are kept.
+ *       Otherwise, the slot is erased and the transfer starts from the first block.
+ *       A compressed image is received in the staging area and decompressed into the slot, from the first block at each resume.
+ */
+static void user_img_transfer_prepare_slot(void)
+{
+	uint32_t		 image_address = SFLASH_SLOT(user_img_transfer_fsm.image_slot);
+	uint32_t		 block_num     = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
+	image_progress_t progress;
+
+	memset(user_img_transfer_fsm.block_map, 0, sizeof(user_img_transfer_fsm.block_map));
+
+	user_img_transfer_fsm.blocks_received = 0;
+	user_img_transfer_fsm.window_base     = 0;
+
+	if (	getTransferProgress(image_address, &progress) 					&&
+			(progress.image_type  == user_img_transfer_fsm.image_type ) &&
+			(progress.image_size  == user_img_transfer_fsm.image_size ) &&
+			(progress.image_crc16 == user_img_transfer_fsm.image_crc16) &&
+			(progress.stream_size == user_img_transfer_fsm.stream_size) )
+	{
+		for (uint32_t i = 0; i < block_num; i++)
+		{
+			if (!TRANSFER_IMAGE_MAP_IS_SET(progress.missing_map, i))
+			{
+				TRANSFER_IMAGE_MAP_SET(user_img_transfer_fsm.block_map, i);
+
+				user_img_transfer_fsm.blocks_received++;
+			}
+		}
+	}
 
-		if (user_img_transfer_fsm.retry_count >= TRANSFER_ERROR_N_MAX)
-		{
-			/* Finished, failing */
-			PRINT_USER_IT_CRITICAL("Transfer failed\n");
+	if ((user_img_transfer_fsm.blocks_received > 0) && (user_img_transfer_fsm.blocks_received < block_num))
+	{
+		PRINT_USER_IT_INFO("Resuming transfer, %u/%u blocks already received\n", user_img_transfer_fsm.blocks_received, block_num);
+	}
+	else
+	{
+		/* Nothing to resume (a complete record means the transfer was interrupted before its validation) */
+		memset(user_img_transfer_fsm.block_map, 0, sizeof(user_img_transfer_fsm.block_map));
 
-			next_state = USER_IMG_TRANSFER_ST_READY;
+		user_img_transfer_fsm.blocks_received = 0;
 
-			user_img_transfer_end(uit_data_timeout_error);
-		}
-		else if (user_img_transfer_fsm.transfered_bytes == user_img_transfer_fsm.image_size)
-		{
-			/* Finished */
-			PRINT_USER_IT_INFO("Transfer completed (CRC16: 0x%X)\n", user_img_transfer_fsm.image_crc16);
+		PRINT_USER_IT_INFO("Erasing slot...\n");
 
-			next_state = USER_IMG_TRANSFER_ST_READY;
+		prepareImageSlot(image_address);
 
-			user_img_transfer_end(uit_no_error);
-		}
-		else
+		if (user_img_transfer_fsm.compressed)
 		{
-			user_img_transfer_send_block(image_ack->next_offset, image_ack->next_size);
+			prepareStagingArea();
 
-			user_img_transfer_update_progress();
+			/* The staging area is shared, the compressed transfers to other slots cannot be resumed anymore */
+			for (uint32_t i = 0; i < IMAGE_SLOTS_NUM; i++)
+			{
+				if (	(SFLASH_SLOT(i) != image_address						) &&
+						getTransferProgress(SFLASH_SLOT(i), &progress			) &&
+						(progress.stream_size < progress.image_size				) )
+				{
+					invalidateTransferProgress(SFLASH_SLOT(i));
+				}
+			}
 		}
 
-		UserG3_DiscardUdpData(TRANSFER_CONN_ID);
+		setTransferProgress(image_address, user_img_transfer_fsm.image_type, user_img_transfer_fsm.image_size, user_img_transfer_fsm.image_crc16, user_img_transfer_fsm.stream_size);
 	}
 
-	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+	if (user_img_transfer_fsm.compressed)
+	{
+		lzss_decoder_init(&user_img_transfer_decoder, user_img_transfer_fsm.image_size, user_img_transfer_write_image, NULL);
 
-	return next_state;
-}
+		user_img_transfer_fsm.inflate_next = 0;
 
-#else /* IS_COORD */
+		/* Decompresses again the blocks already received in sequence (same data written again) */
+		user_img_transfer_inflate(block_num, NULL);
+	}
+
+	user_img_transfer_slide_window();
+
+	if (user_img_transfer_fsm.multicast)
+	{
+		/* In multicast, the progress is the amount of blocks received */
+		user_img_transfer_fsm.transfered_bytes = TRANSFER_IMAGE_BLOCK_OFFSET(user_img_transfer_fsm.blocks_received);
+
+		if (user_img_transfer_fsm.transfered_bytes > user_img_transfer_fsm.stream_size)
+		{
+			user_img_transfer_fsm.transfered_bytes = user_img_transfer_fsm.stream_size;
+		}
+	}
+
+	user_img_transfer_start_progress();
+}
 
 /**
- * @brief User Image Transfer function that erase flash and initialize the Image reception
- * @note device FSM Function
+ * @brief User Image Transfer function that initializes the Image reception
+ * @note device FSM Function. The slot is prepared once the image info is received, to resume a previous transfer of the same image.
  * @param none.
  * @return img_transfer_coord_state_t next state of the FSM.
  */
-
-static user_img_transfer_state_t user_img_transfer_fsm_erase_flash(void)
+static user_img_transfer_state_t user_img_transfer_fsm_start_reception(void)
 {
-	PRINT_USER_IT_INFO("Erasing slot...\n");
-
-	prepareImageSlot(SFLASH_SLOT(user_img_transfer_fsm.image_slot));
-
 	PRINT_USER_IT_INFO("Starting image reception...\n");
 
 	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
@@ -764,17 +2068,61 @@ static user_img_transfer_state_t user_img_transfer_fsm_parse_info(void)
 				user_img_transfer_fsm.image_size     		= image_info->size;
 				user_img_transfer_fsm.image_crc16    		= image_info->crc16;
 
+				if (MASK_IS_SET(image_info->flags, TRANSFER_IMAGE_INFO_FLAG_COMPRESSED))
+				{
+					user_img_transfer_fsm.compressed  = true;
+					user_img_transfer_fsm.stream_size = image_info->stream_size;
+				}
+				else
+				{
+					user_img_transfer_fsm.compressed  = false;
+					user_img_transfer_fsm.stream_size = image_info->size;
+				}
+
+				/* Accepts the proposed window, up to the maximum supported */
+				if (image_info->window_size == 0)
+				{
+					user_img_transfer_fsm.window_size = 1;
+				}
+				else if (image_info->window_size > USER_IMG_TRANSFER_WINDOW_MAX)
+				{
+					user_img_transfer_fsm.window_size = USER_IMG_TRANSFER_WINDOW_MAX;
+				}
+				else
+				{
+					user_img_transfer_fsm.window_size = image_info->window_size;
+				}
+
 				PRINT_USER_IT_INFO("Image type: %s\n",   translateImageType(user_img_transfer_fsm.image_type));
 				PRINT_USER_IT_INFO("Image size: %u\n",   user_img_transfer_fsm.image_size);
 				PRINT_USER_IT_INFO("Image CRC : 0x%X\n", user_img_transfer_fsm.image_crc16);
+				PRINT_USER_IT_INFO("Window size: %u\n",  user_img_transfer_fsm.window_size);
+
+				if (user_img_transfer_fsm.compressed)
+				{
+					PRINT_USER_IT_INFO("Compressed size: %u\n", user_img_transfer_fsm.stream_size);
+				}
 
-				if (user_img_transfer_fsm.image_size <= IMAGE_SIZE)
+				if (user_img_transfer_fsm.stream_size > IMAGE_STAGING_SIZE)
+				{
+					PRINT_USER_IT_WARNING("Incoming compressed image is too big: %u kB (max size: %u kB)\n", user_img_transfer_fsm.stream_size/KB_SIZE, IMAGE_STAGING_SIZE/KB_SIZE);
+				}
+				else if (user_img_transfer_fsm.image_size <= IMAGE_SIZE)
 				{
 					ack = TRANSFER_IMAGE_ACK;
 
-					user_img_transfer_update_progress();
+					if (MASK_IS_SET(image_info->flags, TRANSFER_IMAGE_INFO_FLAG_MULTICAST))
+					{
+						PRINT_USER_IT_INFO("Multicast transfer\n");
 
-					next_state = USER_IMG_TRANSFER_ST_IN_PROGRESS;
+						user_img_transfer_fsm.multicast 	   = true;
+						user_img_transfer_fsm.coord_short_addr = short_addr;
+					}
+
+					user_img_transfer_prepare_slot();
+
+					/* In multicast, the info ACK is sent after a random delay */
+					next_state = (user_img_transfer_fsm.multicast) ? USER_IMG_TRANSFER_ST_SHARE_INFO : USER_IMG_TRANSFER_ST_IN_PROGRESS;
 				}
 				else
 				{
@@ -791,7 +2139,15 @@ static user_img_transfer_state_t user_img_transfer_fsm_parse_info(void)
 			PRINT_USER_IT_CRITICAL("Wrong image info length (%u instead of %u)\n", udp_packet_rx.length, sizeof(image_info_t));
 		}
 
-		user_img_transfer_send_ack(short_addr, ack);
+		if (user_img_transfer_fsm.multicast)
+		{
+			/* Blocks are not acknowledged in multicast, the missing ones are reported at the end of each pass */
+			user_img_transfer_mcast_schedule_answer();
+		}
+		else
+		{
+			user_img_transfer_send_ack(short_addr, ack);
+		}
 
 		UserG3_DiscardUdpData(TRANSFER_CONN_ID);
 	}
@@ -823,46 +2179,74 @@ static user_img_transfer_state_t user_img_transfer_fsm_parse_block(void)
 
 		assert(udp_packet_rx.length == TRANSFER_IMAGE_DATA_MSG_SIZE(image_data->size));
 
-		if (image_data->offset == user_img_transfer_fsm.transfered_bytes)
+		uint32_t block_index = image_data->offset / TRANSFER_IMAGE_DATA_SIZE;
+		bool	 ack_req	 = MASK_IS_SET(image_data->flags, TRANSFER_IMAGE_FLAG_ACK_REQ);
+
+		if (	((image_data->offset % TRANSFER_IMAGE_DATA_SIZE) == 0					) &&
+				(block_index <  user_img_transfer_get_window_end()					) &&
+				(image_data->size == user_img_transfer_get_block_size(block_index)	) )
 		{
-			bool result = setDataBlock(SFLASH_SLOT(user_img_transfer_fsm.image_slot), image_data->data, image_data->size, image_data->offset);
+			ack = TRANSFER_IMAGE_ACK;
 
-			if (result)
+			if (!TRANSFER_IMAGE_MAP_IS_SET(user_img_transfer_fsm.block_map, block_index))
 			{
-				user_img_transfer_fsm.retry_count = 0;
+				/* Blocks can be written in any order, the slot (or the staging area) was erased before the transfer */
+				bool result = setDataBlock(user_img_transfer_get_stream_address(), image_data->data, image_data->size, image_data->offset);
 
-				user_img_transfer_fsm.transfered_bytes += image_data->size;
+				if (result)
+				{
+					user_img_transfer_fsm.retry_count = 0;
+
+					user_img_transfer_set_block_received(block_index);
+
+					if (user_img_transfer_fsm.compressed)
+					{
+						user_img_transfer_inflate(block_index, image_data->data);
+					}
+
+					/* Slides the window over the blocks received in sequence */
+					user_img_transfer_slide_window();
 
 #if (DEBUG_USER_IT >= DEBUG_LEVEL_FULL)
-				ALLOC_DYNAMIC_HEX_STRING(block_str, image_data->data, TRANSFER_IMAGE_DATA_PREVIEW_SIZE);
-				PRINT_USER_IT_INFO("Received data: %u/%u, raw data: %s\n", user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.image_size, block_str);
-				FREE_DYNAMIC_HEX_STRING(block_str)
+					ALLOC_DYNAMIC_HEX_STRING(block_str, image_data->data, TRANSFER_IMAGE_DATA_PREVIEW_SIZE);
+					PRINT_USER_IT_INFO("Received block %u: %u/%u, raw data: %s\n", block_index, user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.stream_size, block_str);
+					FREE_DYNAMIC_HEX_STRING(block_str)
 #else
-				PRINT_USER_IT_INFO("Received data: %u/%u\n", user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.image_size);
+					PRINT_USER_IT_INFO("Received block %u: %u/%u\n", block_index, user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.stream_size);
 #endif
-				user_img_transfer_update_progress();
-
-				ack = TRANSFER_IMAGE_ACK;
+					user_img_transfer_update_progress();
+				}
+				else
+				{
+					Error_Handler();
+				}
 			}
 			else
 			{
-				Error_Handler();
+				PRINT_USER_IT_WARNING("Duplicated block %u\n", block_index);
 			}
 		}
 		else
 		{
-			PRINT_USER_IT_CRITICAL("Error, data offset is %u instead of %u\n", image_data->offset, user_img_transfer_fsm.transfered_bytes);
-
-			ack = TRANSFER_IMAGE_NACK;
+			PRINT_USER_IT_CRITICAL("Error, unexpected block at offset %u (size %u), window starts at %u\n", image_data->offset, image_data->size, user_img_transfer_fsm.transfered_bytes);
 		}
 
 		UserG3_DiscardUdpData(TRANSFER_CONN_ID);
 
-		uint16_t pan_id, short_addr;
+		if (ack_req)
+		{
+			/* End of the burst, reports the blocks received to the sender */
+			uint16_t pan_id, short_addr;
 
-		hi_ipv6_get_saddr_panid(udp_packet_rx.ip_addr, &pan_id, &short_addr);
+			hi_ipv6_get_saddr_panid(udp_packet_rx.ip_addr, &pan_id, &short_addr);
 
-		user_img_transfer_send_ack(short_addr, ack);
+			user_img_transfer_send_ack(short_addr, ack);
+		}
+		else
+		{
+			/* More blocks of the burst are coming */
+			user_img_transfer_set_timeout(TRANSFER_DATA_TIMEOUT); /* Timeout indication */
+		}
 	}
 
 	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
@@ -880,52 +2264,262 @@ static user_img_transfer_state_t user_img_transfer_fsm_ack_sent(void)
 {
 	user_img_transfer_state_t next_state = USER_IMG_TRANSFER_ST_IN_PROGRESS;
 
-	if (user_img_transfer_fsm.transfered_bytes < user_img_transfer_fsm.image_size)
+	if (user_img_transfer_fsm.transfered_bytes < user_img_transfer_fsm.stream_size)
 	{
 		/* More data is coming */
 		user_img_transfer_set_timeout(TRANSFER_DATA_TIMEOUT); /* Timeout indication */
 	}
-	else if (user_img_transfer_fsm.transfered_bytes == user_img_transfer_fsm.image_size)
+	else if (user_img_transfer_fsm.transfered_bytes == user_img_transfer_fsm.stream_size)
 	{
-		user_image_transfer_error_code_t error_code;
-
 		/* If no more data is coming, handles the completion of the transfer */
-		user_img_transfer_remove_timeout();
+		user_img_transfer_complete();
+
+		next_state = USER_IMG_TRANSFER_ST_READY;
+	}
+	else
+	{
+		/* Must never exceed expected data */
+		Error_Handler();
+	}
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return next_state;
+}
+
+/**
+ * @brief User Image Transfer function that writes a multicast block into Flash memory, or schedules the NACK at the end of a pass
+ * @note device FSM Function, multicast only
+ * @param None
+ * @return The next state of the FSM
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_parse_block(void)
+{
+	user_img_transfer_state_t next_state = user_img_transfer_fsm.curr_state;
+
+	udp_packet_t udp_packet_rx = UserG3_GetUdpData(TRANSFER_CONN_ID);
+
+	if (udp_packet_rx.payload != NULL)
+	{
+		image_data_t *image_data = udp_packet_rx.payload;
+		image_info_t *image_info = udp_packet_rx.payload;
+		uint32_t	  block_num  = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
+
+		if ((udp_packet_rx.length == sizeof(image_info_t)) && (image_info->head == TRANSFER_IMAGE_INFO_HEAD) && (image_info->foot == TRANSFER_IMAGE_INFO_END))
+		{
+			/* The coordinator did not get the info ACK, it is sent again */
+			if ((image_info->crc16 == user_img_transfer_fsm.image_crc16) && (image_info->size == user_img_transfer_fsm.image_size))
+			{
+				PRINT_USER_IT_INFO("Image info received again\n");
+
+				user_img_transfer_mcast_schedule_answer();
+
+				next_state = USER_IMG_TRANSFER_ST_SHARE_INFO;
+			}
+			else
+			{
+				PRINT_USER_IT_WARNING("Info of another image received, ignored\n");
+			}
+		}
+		else if ((udp_packet_rx.length == sizeof(image_poll_t)) && MASK_IS_SET(image_data->flags, TRANSFER_IMAGE_FLAG_PASS_END))
+		{
+			image_poll_t *image_poll = udp_packet_rx.payload;
+
+			user_img_transfer_fsm.pass = image_poll->pass;
 
-		/* Use image data block as buffer for calculating CRC16 */
-		uint16_t crc_calc = calculateImageCRC(SFLASH_SLOT(user_img_transfer_fsm.image_slot), user_img_transfer_fsm.image_size);
-		PRINT_USER_IT_INFO("  Transfer completed (CRC16: 0x%X)\n", crc_calc);
+			PRINT_USER_IT_INFO("End of pass %u, %u blocks missing\n", user_img_transfer_fsm.pass, block_num - user_img_transfer_fsm.blocks_received);
+
+			if (user_img_transfer_fsm.curr_state == USER_IMG_TRANSFER_ST_IN_PROGRESS)
+			{
+				user_img_transfer_mcast_schedule_answer();
 
-		if (crc_calc == user_img_transfer_fsm.image_crc16)
+				next_state = USER_IMG_TRANSFER_ST_REPAIR;
+			}
+		}
+		else if (udp_packet_rx.length == TRANSFER_IMAGE_DATA_MSG_SIZE(image_data->size))
 		{
-			error_code = uit_no_error;
+			uint32_t block_index = image_data->offset / TRANSFER_IMAGE_DATA_SIZE;
+
+			if (	((image_data->offset % TRANSFER_IMAGE_DATA_SIZE) == 0					) &&
+					(block_index < block_num											) &&
+					(image_data->size == user_img_transfer_get_block_size(block_index)	) )
+			{
+				if (!TRANSFER_IMAGE_MAP_IS_SET(user_img_transfer_fsm.block_map, block_index))
+				{
+					bool result = setDataBlock(user_img_transfer_get_stream_address(), image_data->data, image_data->size, image_data->offset);
+
+					if (result)
+					{
+						user_img_transfer_fsm.retry_count = 0;
+
+						user_img_transfer_set_block_received(block_index);
+
+						if (user_img_transfer_fsm.compressed)
+						{
+							user_img_transfer_inflate(block_index, image_data->data);
+						}
+
+						user_img_transfer_fsm.transfered_bytes = TRANSFER_IMAGE_BLOCK_OFFSET(user_img_transfer_fsm.blocks_received);
+
+						if (user_img_transfer_fsm.transfered_bytes > user_img_transfer_fsm.stream_size)
+						{
+							user_img_transfer_fsm.transfered_bytes = user_img_transfer_fsm.stream_size;
+						}
+
+						PRINT_USER_IT_INFO("Received block %u: %u/%u\n", block_index, user_img_transfer_fsm.transfered_bytes, user_img_transfer_fsm.stream_size);
+
+						user_img_transfer_update_progress();
+					}
+					else
+					{
+						Error_Handler();
+					}
+				}
+
+				if ((user_img_transfer_fsm.blocks_received == block_num) && (!user_img_transfer_fsm.transfer_complete))
+				{
+					user_img_transfer_complete();
+
+					/* Final report to the coordinator, then keeps answering its polls until the end of the multicast transfer */
+					user_img_transfer_mcast_schedule_answer();
+
+					next_state = USER_IMG_TRANSFER_ST_REPAIR;
+				}
+				else if (user_img_transfer_fsm.curr_state == USER_IMG_TRANSFER_ST_IN_PROGRESS)
+				{
+					user_img_transfer_set_timeout(TRANSFER_DATA_TIMEOUT); /* Timeout indication */
+				}
+			}
+			else
+			{
+				PRINT_USER_IT_CRITICAL("Error, unexpected block at offset %u (size %u)\n", image_data->offset, image_data->size);
+			}
 		}
 		else
 		{
-			error_code = uit_crc_error;
-			user_img_transfer_fsm.image_validity = IMG_INVALIDATED;
-			PRINT_USER_IT_CRITICAL("  Error, expected CRC16: 0x%04X instead of 0x%04X\n", user_img_transfer_fsm.image_crc16, crc_calc);
+			PRINT_USER_IT_WARNING("Unexpected message (length %u)\n", udp_packet_rx.length);
 		}
 
-		/* Validity isn't considered for CRC16 calculation */
-		setImageValidity(SFLASH_SLOT(user_img_transfer_fsm.image_slot), user_img_transfer_fsm.image_validity);
+		UserG3_DiscardUdpData(TRANSFER_CONN_ID);
+	}
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return next_state;
+}
+
+/**
+ * @brief User Image Transfer function that sends the info ACK of a multicast transfer to the coordinator
+ * @note device FSM Function, multicast only
+ * @param None
+ * @return The next state of the FSM
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_send_info_ack(void)
+{
+	PRINT_USER_IT_INFO("Sending info ACK\n");
+
+	user_img_transfer_send_ack(user_img_transfer_fsm.coord_short_addr, TRANSFER_IMAGE_ACK);
+
+	user_img_transfer_set_timeout(TRANSFER_DATA_TIMEOUT); /* Timeout indication */
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return USER_IMG_TRANSFER_ST_IN_PROGRESS;
+}
+
+/**
+ * @brief User Image Transfer function that handles the lack of multicast blocks, reporting the missing ones to the coordinator
+ * @note device FSM Function, multicast only. Covers the case where the poll at the end of the pass was lost.
+ *       Once the image is complete, the lack of polls means the coordinator ended the multicast transfer.
+ * @param None
+ * @return The next state of the FSM
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_timeout(void)
+{
+	user_img_transfer_state_t next_state;
+
+	if (user_img_transfer_fsm.transfer_complete)
+	{
+		PRINT_USER_IT_INFO("End of the multicast transfer\n");
 
-		regradeImagesInMemory(SFLASH_SLOT(user_img_transfer_fsm.image_slot), user_img_transfer_fsm.image_validity);
+		next_state = USER_IMG_TRANSFER_ST_READY;
+	}
+	else if (user_img_transfer_fsm.retry_count >= TRANSFER_ERROR_N_MAX)
+	{
+		/* Finished, failing */
+		PRINT_USER_IT_WARNING("Timeout on Image Transfer\n");
+		PRINT_USER_IT_CRITICAL("Transfer failed\n");
 
 		next_state = USER_IMG_TRANSFER_ST_READY;
 
-		user_img_transfer_end(error_code);
+		user_img_transfer_end(uit_data_timeout_error);
 	}
 	else
 	{
-		/* Must never exceed expected data */
-		Error_Handler();
+		PRINT_USER_IT_WARNING("Timeout on Image Transfer\n");
+
+		user_img_transfer_fsm.retry_count++;
+
+		user_img_transfer_mcast_schedule_answer();
+
+		next_state = USER_IMG_TRANSFER_ST_REPAIR;
 	}
 
 	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
 
 	return next_state;
 }
+
+/**
+ * @brief User Image Transfer function that sends the bitmap of the missing blocks to the coordinator, or the final report once the image is complete
+ * @note device FSM Function, multicast only
+ * @param None
+ * @return The next state of the FSM
+ */
+static user_img_transfer_state_t user_img_transfer_fsm_mcast_send_nack(void)
+{
+	uint32_t	  block_num  = TRANSFER_IMAGE_BLOCK_NUM(user_img_transfer_fsm.stream_size);
+	image_nack_t *image_nack = MEMPOOL_MALLOC(sizeof(image_nack_t));
+
+	if (user_img_transfer_fsm.transfer_complete)
+	{
+		image_nack->ack = (user_img_transfer_fsm.error_code == uit_no_error) ? TRANSFER_IMAGE_DONE : TRANSFER_IMAGE_FAILED;
+	}
+	else
+	{
+		image_nack->ack = TRANSFER_IMAGE_NACK;
+	}
+
+	image_nack->pass		= user_img_transfer_fsm.pass;
+	image_nack->missing_num = block_num - user_img_transfer_fsm.blocks_received;
+
+	memset(image_nack->missing_map, 0, sizeof(image_nack->missing_map));
+
+	for (uint32_t i = 0; i < block_num; i++)
+	{
+		if (!TRANSFER_IMAGE_MAP_IS_SET(user_img_transfer_fsm.block_map, i))
+		{
+			TRANSFER_IMAGE_MAP_SET(image_nack->missing_map, i);
+		}
+	}
+
+	if (user_img_transfer_fsm.transfer_complete)
+	{
+		PRINT_USER_IT_INFO("Sending final report for pass %u: image %s\n", image_nack->pass, (image_nack->ack == TRANSFER_IMAGE_DONE) ? "received" : "received with a wrong CRC");
+	}
+	else
+	{
+		PRINT_USER_IT_INFO("Sending NACK for pass %u: %u blocks missing\n", image_nack->pass, image_nack->missing_num);
+	}
+
+	user_img_transfer_fsm.handle = UserG3_SendUdpDataToShortAddress(TRANSFER_CONN_ID, user_img_transfer_fsm.coord_short_addr, image_nack, sizeof(image_nack_t));
+
+	user_img_transfer_set_timeout(TRANSFER_DATA_TIMEOUT); /* Timeout indication */
+
+	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_NONE;
+
+	return USER_IMG_TRANSFER_ST_IN_PROGRESS;
+}
 #endif
 
 /**
@@ -943,6 +2537,9 @@ static void user_img_transfer_handle_udp_data_cnf(const void *payload)
 		if (udp_data_cnf->status == G3_SUCCESS)
 		{
 			user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_UDP_CNF;
+#if IS_COORD
+			user_img_transfer_fsm.airtime += HAL_GetTick() - user_img_transfer_fsm.frame_timestamp;
+#endif
 
 			HANDLE_CNF_ERROR(HIF_UDP_DATA_CNF, udp_data_cnf->status);
 		}
@@ -1034,7 +2631,14 @@ void UserImgTransfer_FsmManager(void)
 {
 	user_img_transfer_fsm.operation_counter++;
 
-	user_img_transfer_fsm.curr_state = user_img_transfer_fsm_func_tbl[user_img_transfer_fsm.curr_state][user_img_transfer_fsm.curr_event]();
+	if (user_img_transfer_fsm.multicast)
+	{
+		user_img_transfer_fsm.curr_state = user_img_transfer_mcast_fsm_func_tbl[user_img_transfer_fsm.curr_state][user_img_transfer_fsm.curr_event]();
+	}
+	else
+	{
+		user_img_transfer_fsm.curr_state = user_img_transfer_fsm_func_tbl[user_img_transfer_fsm.curr_state][user_img_transfer_fsm.curr_event]();
+	}
 }
 
 #if IS_COORD
@@ -1042,16 +2646,19 @@ void UserImgTransfer_FsmManager(void)
  * @brief Function that starts the User Image Transfer FSM.
  * @param image_slot Slot of the image to send
  * @param dest_short_addr Short address of the device that will receive the image
+ * @param window_size Number of blocks to keep in flight (1 - USER_IMG_TRANSFER_WINDOW_MAX), the receiver can reduce it
  * @retval None
  */
-void UserImgTransfer_StartSend(uint8_t image_slot, uint16_t dest_short_addr)
+void UserImgTransfer_StartSend(uint8_t image_slot, uint16_t dest_short_addr, uint8_t window_size)
 {
 	assert(image_slot < IMAGE_SLOTS_NUM);
+	assert((window_size > 0) && (window_size <= USER_IMG_TRANSFER_WINDOW_MAX));
 
 	user_img_transfer_reset_state();
 
 	user_img_transfer_fsm.dest_short_addr = dest_short_addr;
 	user_img_transfer_fsm.image_slot      = image_slot;
+	user_img_transfer_fsm.window_size     = window_size;
 
 	user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_START;
 
@@ -1061,6 +2668,44 @@ void UserImgTransfer_StartSend(uint8_t image_slot, uint16_t dest_short_addr)
 		RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
 	}
 }
+
+/**
+ * @brief Function that starts the User Image Transfer FSM in multicast mode, sending the image to all devices at once.
+ * @param image_slot Slot of the image to send
+ * @retval None
+ * @note The devices acknowledge the image info, then report their missing blocks at the end of each pass, the next pass sends only the blocks missing on at least one device.
+ *       The transfer ends when all devices connected at the start sent their final report, the silent ones are reported as failed.
+ */
+void UserImgTransfer_StartMulticast(uint8_t image_slot)
+{
+	assert(image_slot < IMAGE_SLOTS_NUM);
+
+	user_img_transfer_reset_state();
+
+	user_img_transfer_fsm.dest_short_addr = MAC_BROADCAST_SHORT_ADDR;
+	user_img_transfer_fsm.image_slot      = image_slot;
+	user_img_transfer_fsm.multicast       = true;
+
+	/* The transfer succeeds only if all these devices report the image as received */
+	user_img_transfer_mcast_load_devices();
+
+	if (user_img_transfer_fsm.device_num > 0)
+	{
+		user_img_transfer_fsm.curr_event = USER_IMG_TRANSFER_EV_START;
+
+		if (user_task_operation_couter == user_img_transfer_fsm.operation_counter)
+		{
+			/* If the operation counter of the FSM is equal to the user task operation counter, the user task needs to be executed again */
+			RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+		}
+	}
+	else
+	{
+		PRINT_USER_IT_WARNING("No device connected, nothing to transfer\n");
+
+		user_img_transfer_end(uit_device_error);
+	}
+}
 #else
 /**
  * @brief Function that starts the User Image Transfer FSM.
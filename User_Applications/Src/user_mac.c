@@ -34,6 +34,7 @@
 #include <user_if.h>
 #include <user_modbus.h>
 #include <user_mac.h>
+#include <user_bench.h>
 
 /** @addtogroup User_App
   * @{
@@ -59,9 +60,24 @@
 
 #define MAC_RF_DELAY								(50)	/* In ms */
 
+/* Traffic generator */
+#define GEN_PIPELINE_SIZE							(2)		/* MCPS-DATA requests in flight (the ST8500 handles 2 requests at a time) */
+#define GEN_MEDIA_NUM								(2)		/* Statistics kept for PLC (index 0) and RF (index 1) */
+#define GEN_LQI_BUCKETS								(8)		/* Buckets of the LQI distribution */
+#define GEN_LQI_BUCKET_WIDTH						(256 / GEN_LQI_BUCKETS)
+#define GEN_RX_TIMEOUT								MAC_IND_TIMEOUT	/* In ms, end of the reception if no frame arrives */
+#define GEN_REPORT_TIMEOUT							(2 * MAC_IND_TIMEOUT)	/* In ms, time waiting for the reports of the receivers (longer than GEN_RX_TIMEOUT) */
+
+/* uSD card benchmark */
+#define FS_BENCH_FILE_SIZE							(64 * 1024)	/* Size of the file written and read back, in bytes */
+#define FS_BENCH_CHUNK_SIZE							(1024)		/* Size of each f_write/f_read, in bytes (whole sectors, to be transferred without the window of FatFs) */
+
 /* Macros */
 #define PRINT_CNF_ERROR(cnf_id, status) 	PRINT("ERROR, received negative CNF (%u=%s) for %s\n", status, g3_app_translate_g3_result(status), translateG3cmd(cnf_id))
 
+#define GEN_MEDIA_INDEX(media)				(((media) == MAC_MEDIATYPE_PLC) ? 0 : 1)
+#define GEN_MEDIA_NAME(index)				(((index) == 0) ? "PLC" : "RF")
+
 
 /* Private constants and macros */
 
@@ -73,6 +89,8 @@ typedef enum usermac_state_enum
 	USER_MAC_ST_READY,
 	USER_MAC_ST_RX_ONGOING,
 	USER_MAC_ST_TX_ONGOING,
+	USER_MAC_ST_GEN_TX,
+	USER_MAC_ST_GEN_RX,
 	USER_MAC_ST_CNT
 } usermac_state_t;
 
@@ -84,13 +102,18 @@ typedef enum usermac_event_enum
 	USER_MAC_EV_RECEIVED_NEG_DATA_CNF,
 	USER_MAC_EV_RECEIVED_DATA_IND,
 	USER_MAC_EV_TIMEOUT,
+	USER_MAC_EV_START_GEN,
+	USER_MAC_EV_GEN_DATA_CNF,
+	USER_MAC_EV_GEN_DATA_IND,
 	USER_MAC_EV_CNT
 } usermac_event_t;
 
 typedef enum usermac_msg_type_enum
 {
 	IS_REQUEST = 1,
-	IS_ANSWER  = 2
+	IS_ANSWER  = 2,
+	IS_TRAFFIC = 3,
+	IS_REPORT  = 4
 } usermac_msg_type_t;
 
 /* Private structures */
@@ -107,6 +130,30 @@ typedef struct usermac_ping_msg_str
 	uint8_t		test_payload[TEST_MSG_SIZE]; /* Additional bytes to enlarge the size of the ping message */
 } usermac_ping_msg_t;
 
+/* Header of the frames of the traffic generator, followed by a pattern up to the frame size */
+typedef struct usermac_gen_msg_str
+{
+	uint8_t 	type;		/* Traffic */
+	uint8_t 	media_type; /* Media used for the frame */
+	uint32_t	msg_i;		/* Number ID of the frame */
+	uint32_t	msg_n;		/* Total number of frames of the run */
+} usermac_gen_msg_t;
+
+/* Statistics of a receiver of the traffic generator, sent back to the source at the end of the run */
+typedef struct usermac_gen_report_str
+{
+	uint8_t 	type;										/* Report */
+	uint8_t 	media_type; 								/* Media used for the report */
+	uint32_t	expected;									/* Number of frames of the run */
+	uint32_t	received[GEN_MEDIA_NUM];					/* Frames received (duplicates excluded) */
+	uint32_t	duplicates;									/* Frames received more than once */
+	uint32_t	bytes;										/* MSDU bytes received (duplicates excluded) */
+	uint32_t	duration;									/* Time between the first and the last frame, in ms */
+	uint32_t	lqi_sum[GEN_MEDIA_NUM];						/* Sum of the measured LQI values */
+	uint16_t	lqi_n[GEN_MEDIA_NUM];						/* Number of measured LQI values */
+	uint16_t	lqi_hist[GEN_MEDIA_NUM][GEN_LQI_BUCKETS];	/* LQI distribution */
+} usermac_gen_report_t;
+
 #pragma pack(pop)
 
 typedef struct mac_ind_info_str
@@ -122,6 +169,36 @@ typedef struct mac_ind_info_str
 	mac_mediatype_req_t 	media_type;
 } mac_ind_info_t;
 
+/* Transmitting side of the traffic generator */
+typedef struct usermac_gen_tx_str
+{
+	usermac_gen_params_t	params;							/*!<  Parameters of the run (destination address reversed) */
+	uint32_t				sent;							/*!<  Requests sent */
+	uint32_t				in_flight;						/*!<  Requests waiting for their confirm */
+	uint32_t				confirmed[GEN_MEDIA_NUM];		/*!<  Positive confirms */
+	uint32_t				failed[GEN_MEDIA_NUM];			/*!<  Negative confirms */
+	uint32_t				cnf_timeouts;					/*!<  Confirms not received in time */
+	uint32_t				start_ts;						/*!<  Start of the run, in ms */
+	uint32_t				end_ts;							/*!<  Time of the last confirm, in ms */
+	uint32_t				last_cnf_ts;					/*!<  Time of the last request or confirm, in ms */
+	uint32_t				last_rf_ts;						/*!<  Time of the last RF request, in ms */
+	bool					rf_sent;						/*!<  An RF request was sent (last_rf_ts is valid) */
+	bool					done;							/*!<  All requests confirmed, waiting for the reports */
+} usermac_gen_tx_t;
+
+/* Receiving side of the traffic generator */
+typedef struct usermac_gen_rx_str
+{
+	bool					active;							/*!<  A run is being received */
+	uint32_t				last_seq;						/*!<  Highest frame ID received */
+	uint32_t				first_ts;						/*!<  Time of the first frame, in ms */
+	uint32_t				last_ts;						/*!<  Time of the last frame, in ms */
+	uint8_t					src_addr[MAC_ADDR64_SIZE];		/*!<  Extended address of the source */
+	bool					report_pending;					/*!<  The report was sent, its confirm is expected */
+	uint8_t					report_handle;					/*!<  MSDU handle of the report */
+	usermac_gen_report_t	report;							/*!<  Statistics of the run */
+} usermac_gen_rx_t;
+
 /* User MAC FSM */
 typedef struct usermac_fsm_info_str
 {
@@ -149,6 +226,16 @@ typedef struct usermac_fsm_info_str
 
 	/* Errors */
 	uint32_t				cnf_errors;
+
+#if ENABLE_BENCHMARK
+	/* Benchmark */
+	bool					benchmark;				/*!<  The test is a run of the benchmark */
+	uint32_t				req_ts;					/*!<  Time of the last request, in ms */
+#endif
+
+	/* Traffic generator */
+	usermac_gen_tx_t		gen_tx;
+	usermac_gen_rx_t		gen_rx;
 } usermac_fsm_t;
 
 /* Private variables */
@@ -193,13 +280,18 @@ static usermac_state_t usermac_fsm_default(void);
 static usermac_state_t usermac_fsm_send_frame(void);
 static usermac_state_t usermac_fsm_reply_frame(void);
 static usermac_state_t usermac_fsm_timeout_reached(void);
+static usermac_state_t usermac_fsm_gen_start(void);
+static usermac_state_t usermac_fsm_gen_send(void);
+static usermac_state_t usermac_fsm_gen_receive(void);
 
 /* Private FSM function pointer array */
 static usermac_fsm_func *usermac_fsm_func_tbl[USER_MAC_ST_CNT][USER_MAC_EV_CNT] = {
-/*                 NONE,                START_TX,               RECEIVED_NEG_DATA_CNF,   RECEIVED_DATA_IND,       TIMEOUT                     */
-/* READY      */ { usermac_fsm_default, usermac_fsm_send_frame, usermac_fsm_default,     usermac_fsm_reply_frame, usermac_fsm_default         },
-/* RX_ONGOING */ { usermac_fsm_default, usermac_fsm_default,    usermac_fsm_reply_frame, usermac_fsm_reply_frame, usermac_fsm_timeout_reached },
-/* TX_ONGOING */ { usermac_fsm_default, usermac_fsm_default,    usermac_fsm_send_frame,  usermac_fsm_send_frame,  usermac_fsm_timeout_reached },
+/*                 NONE,                START_TX,               RECEIVED_NEG_DATA_CNF,   RECEIVED_DATA_IND,       TIMEOUT,                     START_GEN,             GEN_DATA_CNF,          GEN_DATA_IND            */
+/* READY      */ { usermac_fsm_default, usermac_fsm_send_frame, usermac_fsm_default,     usermac_fsm_reply_frame, usermac_fsm_default,         usermac_fsm_gen_start, usermac_fsm_default,   usermac_fsm_gen_receive },
+/* RX_ONGOING */ { usermac_fsm_default, usermac_fsm_default,    usermac_fsm_reply_frame, usermac_fsm_reply_frame, usermac_fsm_timeout_reached, usermac_fsm_default,   usermac_fsm_default,   usermac_fsm_default     },
+/* TX_ONGOING */ { usermac_fsm_default, usermac_fsm_default,    usermac_fsm_send_frame,  usermac_fsm_send_frame,  usermac_fsm_timeout_reached, usermac_fsm_default,   usermac_fsm_default,   usermac_fsm_default     },
+/* GEN_TX     */ { usermac_fsm_default, usermac_fsm_default,    usermac_fsm_default,     usermac_fsm_default,     usermac_fsm_gen_send,        usermac_fsm_default,   usermac_fsm_gen_send,  usermac_fsm_gen_send    },
+/* GEN_RX     */ { usermac_fsm_default, usermac_fsm_default,    usermac_fsm_default,     usermac_fsm_default,     usermac_fsm_gen_receive,     usermac_fsm_default,   usermac_fsm_default,   usermac_fsm_gen_receive },
 };
 
 /* Private functions */
@@ -231,6 +323,110 @@ static void usermac_remove_timeout(void)
 /* Test functions */
 
 #if ENABLE_FATFS_TEST
+/**
+  * @brief Computes a transfer rate.
+  * @param size Number of bytes transferred.
+  * @param time Duration of the transfer, in ms.
+  * @retval Transfer rate, in KB/s
+  */
+static uint32_t usermac_fs_rate(const uint32_t size, const uint32_t time)
+{
+	return (time > 0) ? ((size * 1000U) / (time * 1024U)) : 0;
+}
+
+/**
+  * @brief Measures the write and read rates of the uSD card, on a file of FS_BENCH_FILE_SIZE bytes.
+  * @param None
+  * @retval None
+  * @note Must be called with the file system mounted, the file is deleted at the end.
+  */
+static void usermac_bench_fs(void)
+{
+	BYTE    *buffer = MEMPOOL_MALLOC(FS_BENCH_CHUNK_SIZE);
+	FIL     file;
+	FRESULT fres;
+	UINT    bytes_done;
+	uint32_t offset = 0;
+	uint32_t start;
+	uint32_t elapsed;
+
+	char file_name[] = "bench.bin";
+
+	for (uint32_t i = 0; i < FS_BENCH_CHUNK_SIZE; i++)
+	{
+		buffer[i] = (BYTE) i;
+	}
+
+	fres = f_open(&file, file_name, FA_WRITE | FA_CREATE_ALWAYS);
+
+	if (fres == FR_OK)
+	{
+		/* Write, including the final synchronization (the write cache of the driver is flushed) */
+		start = HAL_GetTick();
+
+		while ((fres == FR_OK) && (offset < FS_BENCH_FILE_SIZE))
+		{
+			fres = f_write(&file, buffer, FS_BENCH_CHUNK_SIZE, &bytes_done);
+			offset += bytes_done;
+		}
+
+		if (fres == FR_OK)
+		{
+			fres = f_sync(&file);
+		}
+
+		elapsed = HAL_GetTick() - start;
+
+		if (fres == FR_OK)
+		{
+			PRINT("uSD write: %u KB in %u ms, %u KB/s\n", offset / 1024, elapsed, usermac_fs_rate(offset, elapsed));
+		}
+		else
+		{
+			PRINT("Write error (%u)\r\n", fres);
+		}
+
+		f_close(&file);
+	}
+
+	if (fres == FR_OK)
+	{
+		fres = f_open(&file, file_name, FA_READ | FA_OPEN_EXISTING);
+	}
+
+	if (fres == FR_OK)
+	{
+		offset = 0;
+		start = HAL_GetTick();
+
+		bytes_done = FS_BENCH_CHUNK_SIZE;
+
+		/* Stops at the end of the file (bytes_done is 0) */
+		while ((fres == FR_OK) && (bytes_done > 0) && (offset < FS_BENCH_FILE_SIZE))
+		{
+			fres = f_read(&file, buffer, FS_BENCH_CHUNK_SIZE, &bytes_done);
+			offset += bytes_done;
+		}
+
+		elapsed = HAL_GetTick() - start;
+
+		if ((fres == FR_OK) && (offset == FS_BENCH_FILE_SIZE))
+		{
+			PRINT("uSD read: %u KB in %u ms, %u KB/s\n", offset / 1024, elapsed, usermac_fs_rate(offset, elapsed));
+		}
+		else
+		{
+			PRINT("Read error (%u), %u bytes read\r\n", fres, offset);
+		}
+
+		f_close(&file);
+	}
+
+	f_unlink(file_name);
+
+	MEMPOOL_FREE(buffer);
+}
+
 /**
   * @brief Tests the FAT File System and the SD card reader.
   * @param None
@@ -315,6 +511,9 @@ static void usermac_test_fs(void)
 			/* Close file */
 			f_close(&file);
 
+			/* Measures the transfer rates */
+			usermac_bench_fs();
+
 			/* Unmount drive after */
 			f_mount(NULL, "", 0);
 		}
@@ -452,6 +651,15 @@ static void usermac_reset_fsm(const mac_test_state_t test_state)
 	/* Remove eventual timeout */
 	usermac_remove_timeout();
 
+#if ENABLE_BENCHMARK
+	if (usermac_fsm.benchmark)
+	{
+		/* The results of the benchmark are printed on the test end, successful or not */
+		usermac_fsm.benchmark = false;
+		UserBench_SizeEnd();
+	}
+#endif
+
 	/* Prints the test result code. Ready state omitted. */
 	if (test_state != mac_ready)
 	{
@@ -595,6 +803,12 @@ static usermac_state_t usermac_fsm_send_frame(void)
 
 				usermac_reset_fsm(result_state);
 			}
+#if ENABLE_BENCHMARK
+			else if (usermac_fsm.benchmark)
+			{
+				UserBench_AddSample(HAL_GetTick() - usermac_fsm.req_ts);
+			}
+#endif
 		}
 	}
 
@@ -689,6 +903,13 @@ static usermac_state_t usermac_fsm_send_frame(void)
 
 			g3_send_message(HIF_TX_MSG, HIF_MCPS_DATA_REQ, mac_data_req, len);
 
+#if ENABLE_BENCHMARK
+			if (usermac_fsm.benchmark)
+			{
+				usermac_fsm.req_ts = HAL_GetTick();
+				UserBench_AddSent();
+			}
+#endif
 			usermac_set_timeout(MAC_IND_TIMEOUT);
 
 			next_state = USER_MAC_ST_TX_ONGOING;
@@ -830,6 +1051,523 @@ static usermac_state_t usermac_fsm_timeout_reached(void)
 	return USER_MAC_ST_READY;
 }
 
+/* Traffic generator functions */
+
+/**
+  * @brief Gives the media of the next frame of the traffic generator.
+  * @param None
+  * @return The media of the next frame (PLC and RF alternated if both are used).
+  */
+static mac_mediatype_req_t usermac_gen_next_media(void)
+{
+	mac_mediatype_req_t media;
+
+	if (usermac_fsm.gen_tx.params.media == mac_test_rf)
+	{
+		media = MAC_MEDIATYPE_RF;
+	}
+	else if (usermac_fsm.gen_tx.params.media == mac_test_plc_rf)
+	{
+		media = ((usermac_fsm.gen_tx.sent % 2) == 0) ? MAC_MEDIATYPE_PLC : MAC_MEDIATYPE_RF;
+	}
+	else
+	{
+		media = MAC_MEDIATYPE_PLC;
+	}
+
+	return media;
+}
+
+/**
+  * @brief Gives the time left before the next frame of the traffic generator can be sent.
+  * @param now Current time, in ms.
+  * @return Time left, in ms (0 if the frame can be sent now).
+  * @note The schedule is computed from the start of the run, so that a late frame does not delay the following ones.
+  */
+static uint32_t usermac_gen_next_wait(const uint32_t now)
+{
+	const usermac_gen_tx_t *gen_tx = &usermac_fsm.gen_tx;
+
+	uint32_t wait = 0;
+
+	if (gen_tx->params.rate > 0)
+	{
+		uint32_t due     = (uint32_t) (((uint64_t) gen_tx->sent * gen_tx->params.frame_size * 8U * 1000U) / gen_tx->params.rate);
+		uint32_t elapsed = now - gen_tx->start_ts;
+
+		if (due > elapsed)
+		{
+			wait = due - elapsed;
+		}
+	}
+
+#if (MAC_RF_DELAY > 0)
+	/* Forcefully decrease RF duty cycle, without blocking the User task */
+	if (gen_tx->rf_sent && (usermac_gen_next_media() == MAC_MEDIATYPE_RF) && ((now - gen_tx->last_rf_ts) < MAC_RF_DELAY))
+	{
+		uint32_t rf_wait = MAC_RF_DELAY - (now - gen_tx->last_rf_ts);
+
+		if (rf_wait > wait)
+		{
+			wait = rf_wait;
+		}
+	}
+#endif
+
+	return wait;
+}
+
+/**
+  * @brief Sends the next frame of the traffic generator.
+  * @param now Current time, in ms.
+  * @retval None
+  */
+static void usermac_gen_send_frame(const uint32_t now)
+{
+	usermac_gen_tx_t  *gen_tx  = &usermac_fsm.gen_tx;
+	usermac_gen_msg_t *gen_msg = (usermac_gen_msg_t*) usermac_fsm.last_req.msdu; /* Alias for the request MSDU */
+
+	mac_tx_options_t mac_tx_options;
+	MAC_DataReq_t *mac_data_req = MEMPOOL_MALLOC(sizeof(MAC_DataReq_t)); /* Uses memory pool due to big structure size */
+
+	uint8_t broadcast_addr[] = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
+
+	if (memcmp(gen_tx->params.dst_addr, broadcast_addr, sizeof(gen_tx->params.dst_addr)) == 0)
+	{
+		mac_tx_options = MAC_ACK_REQUEST_OFF;
+	}
+	else
+	{
+		mac_tx_options = MAC_ACK_REQUEST_ON;
+	}
+
+	usermac_fsm.last_req.media_type = usermac_gen_next_media();
+
+	gen_tx->sent++;
+
+	/* The pattern following the header is filled once, at the start of the run */
+	gen_msg->type		= IS_TRAFFIC;
+	gen_msg->media_type	= usermac_fsm.last_req.media_type;
+	gen_msg->msg_i		= gen_tx->sent;
+	gen_msg->msg_n		= gen_tx->params.frame_n;
+
+#if VERBOSE_LOG
+	PRINT("Sending frame %u/%u\n", gen_msg->msg_i, gen_msg->msg_n);
+#endif
+	uint16_t len = hi_mac_data_fill(mac_data_req,
+									MAC_ADDR_MODE_64,
+									PAN_ID,
+									MAC_BROADCAST_SHORT_ADDR,
+									gen_tx->params.dst_addr,
+									gen_tx->params.frame_size,
+									usermac_fsm.last_req.msdu,
+									usermac_fsm.mac_handle++,
+									mac_tx_options,
+									MAC_NO_KEY,
+									usermac_fsm.last_req.media_type);
+
+	g3_send_message(HIF_TX_MSG, HIF_MCPS_DATA_REQ, mac_data_req, len);
+
+	gen_tx->in_flight++;
+	gen_tx->last_cnf_ts = now;
+
+	if (usermac_fsm.last_req.media_type == MAC_MEDIATYPE_RF)
+	{
+		gen_tx->last_rf_ts = now;
+		gen_tx->rf_sent    = true;
+	}
+}
+
+/**
+  * @brief Prints the statistics of the transmitting side of the traffic generator.
+  * @param None
+  * @retval None
+  */
+static void usermac_gen_print_tx_stats(void)
+{
+	const usermac_gen_tx_t *gen_tx = &usermac_fsm.gen_tx;
+
+	uint32_t duration  = gen_tx->end_ts - gen_tx->start_ts;
+	uint32_t confirmed = 0;
+	uint32_t goodput   = 0;
+
+	PRINT("Traffic generator: %u frames of %u bytes sent in %u ms\n", gen_tx->sent, gen_tx->params.frame_size, duration);
+
+	for (uint8_t i = 0; i < GEN_MEDIA_NUM; i++)
+	{
+		uint32_t total = gen_tx->confirmed[i] + gen_tx->failed[i];
+
+		if (total > 0)
+		{
+			PRINT("%s: %u confirmed, %u failed (PER %.2f %%)\n", GEN_MEDIA_NAME(i), gen_tx->confirmed[i], gen_tx->failed[i], (100.0f * gen_tx->failed[i]) / total);
+		}
+
+		confirmed += gen_tx->confirmed[i];
+	}
+
+	if (gen_tx->cnf_timeouts > 0)
+	{
+		PRINT_COLOR("%u confirms not received\n", color_yellow, gen_tx->cnf_timeouts);
+	}
+
+	if (duration > 0)
+	{
+		goodput = (uint32_t) (((uint64_t) confirmed * gen_tx->params.frame_size * 8U * 1000U) / duration);
+	}
+
+	PRINT("Goodput: %u bit/s (confirmed frames)\n", goodput);
+}
+
+/**
+  * @brief Prints the statistics of a receiver of the traffic generator.
+  * @param source Name of the receiver.
+  * @param report Statistics of the receiver.
+  * @retval None
+  */
+static void usermac_gen_print_report(const char *source, const usermac_gen_report_t *report)
+{
+	uint32_t received = report->received[0] + report->received[1];
+	uint32_t lost     = (report->expected > received) ? (report->expected - received) : 0;
+	uint32_t goodput  = 0;
+	float    per      = 0;
+
+	if (report->expected > 0)
+	{
+		per = (100.0f * lost) / report->expected;
+	}
+
+	if (report->duration > 0)
+	{
+		goodput = (uint32_t) (((uint64_t) report->bytes * 8U * 1000U) / report->duration);
+	}
+
+	PRINT("%s: %u/%u frames received (PER %.2f %%), %u duplicates, goodput %u bit/s\n", source, received, report->expected, per, report->duplicates, goodput);
+
+	for (uint8_t i = 0; i < GEN_MEDIA_NUM; i++)
+	{
+		if (report->lqi_n[i] > 0)
+		{
+			float lqi_avg = ((float) report->lqi_sum[i]) / report->lqi_n[i];
+
+			if (i == GEN_MEDIA_INDEX(MAC_MEDIATYPE_PLC))
+			{
+				PRINT("PLC: %u frames, average LQI = %.1f (SNR = %.2f dB)\n", report->received[i], lqi_avg, (lqi_avg * MAC_LQI_TO_SNR_STEP_PLC) - MAC_LQI_TO_SNR_OFFSET_PLC);
+			}
+			else
+			{
+				PRINT("RF: %u frames, average LQI = %.1f (RSSI = %.1f dBm)\n", report->received[i], lqi_avg, lqi_avg - MAC_LQI_TO_RSSI_OFFSET_RF);
+			}
+
+			for (uint8_t bucket = 0; bucket < GEN_LQI_BUCKETS; bucket++)
+			{
+				if (report->lqi_hist[i][bucket] > 0)
+				{
+					PRINT("\tLQI %3u-%3u: %u\n", bucket * GEN_LQI_BUCKET_WIDTH, ((bucket + 1) * GEN_LQI_BUCKET_WIDTH) - 1, report->lqi_hist[i][bucket]);
+				}
+			}
+		}
+	}
+}
+
+/**
+  * @brief Sends the frames of the traffic generator that are due and schedules the next wake-up.
+  * @param None
+  * @retval None
+  */
+static void usermac_gen_transmit(void)
+{
+	usermac_gen_tx_t *gen_tx = &usermac_fsm.gen_tx;
+
+	uint32_t now = HAL_GetTick();
+
+	/* Requests whose confirm was not received in time are no longer waited for */
+	if ((gen_tx->in_flight > 0) && ((now - gen_tx->last_cnf_ts) >= MAC_CNF_TIMEOUT))
+	{
+		gen_tx->cnf_timeouts += gen_tx->in_flight;
+		gen_tx->in_flight = 0;
+	}
+
+	/* Fills the pipeline with the frames that are due */
+	while ((gen_tx->in_flight < GEN_PIPELINE_SIZE) && (gen_tx->sent < gen_tx->params.frame_n) && (usermac_gen_next_wait(now) == 0))
+	{
+		usermac_gen_send_frame(now);
+	}
+
+	if ((gen_tx->sent >= gen_tx->params.frame_n) && (gen_tx->in_flight == 0))
+	{
+		gen_tx->done   = true;
+		gen_tx->end_ts = now;
+
+		usermac_gen_print_tx_stats();
+
+		PRINT("Waiting for the reports of the receivers...\n");
+
+		usermac_set_timeout(GEN_REPORT_TIMEOUT);
+	}
+	else
+	{
+		/* Wakes up on the next confirm, when the next frame is due or when the confirms are late */
+		uint32_t wait = MAC_CNF_TIMEOUT - (now - gen_tx->last_cnf_ts);
+
+		if ((gen_tx->in_flight < GEN_PIPELINE_SIZE) && (gen_tx->sent < gen_tx->params.frame_n))
+		{
+			uint32_t frame_wait = usermac_gen_next_wait(now);
+
+			if ((gen_tx->in_flight == 0) || (frame_wait < wait))
+			{
+				wait = frame_wait;
+			}
+		}
+
+		usermac_set_timeout(wait);
+	}
+}
+
+/**
+  * @brief Ends the reception of a run of the traffic generator, printing its statistics and sending them to the source.
+  * @param None
+  * @retval None
+  */
+static void usermac_gen_rx_end(void)
+{
+	usermac_gen_rx_t     *gen_rx = &usermac_fsm.gen_rx;
+	usermac_gen_report_t *report = &gen_rx->report;
+
+	usermac_remove_timeout();
+
+	report->type		= IS_REPORT;
+	report->media_type	= usermac_fsm.last_ind.media_type;
+	report->duration	= gen_rx->last_ts - gen_rx->first_ts;
+
+	usermac_gen_print_report("Traffic received", report);
+
+	/* The report is sent on the media of the last frame received */
+	MAC_DataReq_t *mac_data_req = MEMPOOL_MALLOC(sizeof(MAC_DataReq_t)); /* Uses memory pool due to big structure size */
+
+	gen_rx->report_handle  = usermac_fsm.mac_handle++;
+	gen_rx->report_pending = true;
+
+	uint16_t len = hi_mac_data_fill(mac_data_req,
+									MAC_ADDR_MODE_64,
+									PAN_ID,
+									MAC_BROADCAST_SHORT_ADDR,
+									gen_rx->src_addr,
+									sizeof(usermac_gen_report_t),
+									(uint8_t*) report,
+									gen_rx->report_handle,
+									MAC_ACK_REQUEST_ON,
+									MAC_NO_KEY,
+									usermac_fsm.last_ind.media_type);
+
+	g3_send_message(HIF_TX_MSG, HIF_MCPS_DATA_REQ, mac_data_req, len);
+
+	gen_rx->active = false;
+}
+
+/**
+  * @brief User MAC FSM function that starts the traffic generator
+  * @param None
+  * @return The next state of the User MAC FSM.
+  */
+static usermac_state_t usermac_fsm_gen_start(void)
+{
+	usermac_state_t next_state = USER_MAC_ST_READY;
+
+	if (!g3_app_conf_ready())
+	{
+		PRINT("G3 configuration not ready, please wait...\n");
+	}
+	else
+	{
+		usermac_fsm.gen_tx.start_ts    = HAL_GetTick();
+		usermac_fsm.gen_tx.last_cnf_ts = usermac_fsm.gen_tx.start_ts;
+
+		if (usermac_fsm.gen_tx.params.rate > 0)
+		{
+			PRINT("Starting traffic generator: %u frames of %u bytes at %u bit/s...\n", usermac_fsm.gen_tx.params.frame_n, usermac_fsm.gen_tx.params.frame_size, usermac_fsm.gen_tx.params.rate);
+		}
+		else
+		{
+			PRINT("Starting traffic generator: %u frames of %u bytes at maximum rate...\n", usermac_fsm.gen_tx.params.frame_n, usermac_fsm.gen_tx.params.frame_size);
+		}
+
+		usermac_gen_transmit();
+
+		next_state = USER_MAC_ST_GEN_TX;
+	}
+
+	usermac_fsm.curr_event = USER_MAC_EV_NONE;
+
+	return next_state;
+}
+
+/**
+  * @brief User MAC FSM function that sends the frames of the traffic generator and waits for the reports of the receivers
+  * @param None
+  * @return The next state of the User MAC FSM.
+  */
+static usermac_state_t usermac_fsm_gen_send(void)
+{
+	usermac_state_t next_state = USER_MAC_ST_GEN_TX;
+
+	if (!usermac_fsm.gen_tx.done)
+	{
+		usermac_gen_transmit();
+	}
+	else if ((usermac_fsm.curr_event == USER_MAC_EV_TIMEOUT) || ((HAL_GetTick() - usermac_fsm.gen_tx.end_ts) >= GEN_REPORT_TIMEOUT))
+	{
+		usermac_remove_timeout();
+
+		PRINT_COLOR("Traffic generator done\a\n", color_green);
+
+		next_state = USER_MAC_ST_READY;
+	}
+
+	usermac_fsm.curr_event = USER_MAC_EV_NONE;
+
+	return next_state;
+}
+
+/**
+  * @brief User MAC FSM function that receives the frames of the traffic generator
+  * @param None
+  * @return The next state of the User MAC FSM.
+  */
+static usermac_state_t usermac_fsm_gen_receive(void)
+{
+	usermac_state_t next_state = USER_MAC_ST_GEN_RX;
+
+	if (usermac_fsm.curr_state == USER_MAC_ST_READY)
+	{
+		PRINT("Receiving traffic, %u frames expected...\n", usermac_fsm.gen_rx.report.expected);
+	}
+
+	if ((usermac_fsm.curr_event == USER_MAC_EV_TIMEOUT) || (usermac_fsm.gen_rx.last_seq >= usermac_fsm.gen_rx.report.expected))
+	{
+		usermac_gen_rx_end();
+
+		next_state = USER_MAC_ST_READY;
+	}
+	else
+	{
+		usermac_set_timeout(GEN_RX_TIMEOUT);
+	}
+
+	usermac_fsm.curr_event = USER_MAC_EV_NONE;
+
+	return next_state;
+}
+
+/**
+  * @brief User MAC function that handles the confirm of a frame of the traffic generator
+  * @param mac_cnf Pointer to the received confirm
+  * @return None
+  */
+static void usermac_gen_handle_cnf(const MAC_DataConfirm_t *mac_cnf)
+{
+	if (usermac_fsm.curr_state == USER_MAC_ST_GEN_TX)
+	{
+		usermac_gen_tx_t *gen_tx = &usermac_fsm.gen_tx;
+
+		uint8_t media = (mac_cnf->media_type == 0) ? GEN_MEDIA_INDEX(MAC_MEDIATYPE_PLC) : GEN_MEDIA_INDEX(MAC_MEDIATYPE_RF);
+
+		if (gen_tx->in_flight > 0)
+		{
+			gen_tx->in_flight--;
+		}
+
+		if (mac_cnf->status == G3_SUCCESS)
+		{
+			gen_tx->confirmed[media]++;
+		}
+		else
+		{
+			gen_tx->failed[media]++;
+#if VERBOSE_LOG
+			PRINT_CNF_ERROR(HIF_MCPS_DATA_CNF, mac_cnf->status);
+#endif
+		}
+
+		gen_tx->last_cnf_ts = HAL_GetTick();
+
+		usermac_fsm.curr_event = USER_MAC_EV_GEN_DATA_CNF;
+	}
+	else
+	{
+		/* Confirm of the report of a receiver */
+		usermac_fsm.gen_rx.report_pending = false;
+
+		if (mac_cnf->status != G3_SUCCESS)
+		{
+			PRINT_CNF_ERROR(HIF_MCPS_DATA_CNF, mac_cnf->status);
+		}
+	}
+}
+
+/**
+  * @brief User MAC function that handles the reception of a frame of the traffic generator
+  * @param None
+  * @return None
+  */
+static void usermac_gen_handle_ind(void)
+{
+	const usermac_gen_msg_t *gen_msg = (const usermac_gen_msg_t*) usermac_fsm.last_ind.msdu; /* Alias for the indication MSDU */
+
+	usermac_gen_rx_t *gen_rx = &usermac_fsm.gen_rx;
+
+	if (gen_msg->type == IS_REPORT)
+	{
+		/* Reports are only expected at the end of a run of this node */
+		if ((usermac_fsm.curr_state == USER_MAC_ST_GEN_TX) && (usermac_fsm.last_ind.msdu_len >= sizeof(usermac_gen_report_t)))
+		{
+			usermac_gen_print_report("Receiver report", (const usermac_gen_report_t*) usermac_fsm.last_ind.msdu);
+		}
+	}
+	else if ((usermac_fsm.last_ind.msdu_len >= sizeof(usermac_gen_msg_t)) &&
+			 ((usermac_fsm.curr_state == USER_MAC_ST_READY) || (usermac_fsm.curr_state == USER_MAC_ST_GEN_RX)))
+	{
+		uint32_t now   = HAL_GetTick();
+		uint8_t  media = GEN_MEDIA_INDEX(usermac_fsm.last_ind.media_type);
+
+		/* First frame of a run (also when the source restarts) */
+		if ((!gen_rx->active) || ((gen_msg->msg_i == 1) && (gen_rx->last_seq > 1)))
+		{
+			memset(&gen_rx->report, 0, sizeof(gen_rx->report));
+
+			gen_rx->active          = true;
+			gen_rx->last_seq        = 0;
+			gen_rx->first_ts        = now;
+			gen_rx->report.expected = gen_msg->msg_n;
+
+			memcpy(gen_rx->src_addr, usermac_fsm.dst_addr, sizeof(gen_rx->src_addr));
+		}
+
+		if (gen_msg->msg_i <= gen_rx->last_seq)
+		{
+			/* Retransmission of a frame whose ACK was lost */
+			gen_rx->report.duplicates++;
+		}
+		else
+		{
+			gen_rx->last_seq = gen_msg->msg_i;
+
+			gen_rx->report.received[media]++;
+			gen_rx->report.bytes += usermac_fsm.last_ind.msdu_len;
+
+			if ((usermac_fsm.last_ind.media_type == MAC_MEDIATYPE_PLC) || (usermac_fsm.last_ind.lqi != MAC_NOTMEASURED_LQI_RF))
+			{
+				gen_rx->report.lqi_sum[media] += usermac_fsm.last_ind.lqi;
+				gen_rx->report.lqi_n[media]++;
+				gen_rx->report.lqi_hist[media][usermac_fsm.last_ind.lqi / GEN_LQI_BUCKET_WIDTH]++;
+			}
+		}
+
+		gen_rx->last_ts = now;
+
+		usermac_fsm.curr_event = USER_MAC_EV_GEN_DATA_IND;
+	}
+}
+
 /**
   * @brief User MAC function that handles the reception of a G3MAC-DATA confirm
   * @param payload Payload of the received message
@@ -839,20 +1577,28 @@ static void usermac_handle_mac_data_cnf(const void *payload)
 {
 	const MAC_DataConfirm_t *mac_cnf = payload;
 
-	usermac_fsm.received_cnf = true;
-
-	if (mac_cnf->status != G3_SUCCESS)
+	if ((usermac_fsm.curr_state == USER_MAC_ST_GEN_TX) ||
+		(usermac_fsm.gen_rx.report_pending && (mac_cnf->msdu_handle == usermac_fsm.gen_rx.report_handle)))
+	{
+		usermac_gen_handle_cnf(mac_cnf);
+	}
+	else
 	{
-		usermac_fsm.cnf_errors++;
-		PRINT_CNF_ERROR(HIF_MCPS_DATA_CNF, mac_cnf->status);
+		usermac_fsm.received_cnf = true;
 
-		if (usermac_fsm.curr_state == USER_MAC_ST_TX_ONGOING)
+		if (mac_cnf->status != G3_SUCCESS)
 		{
-			/* Roll-backs to the previous request count */
-			usermac_fsm.req_counter--;
-		}
+			usermac_fsm.cnf_errors++;
+			PRINT_CNF_ERROR(HIF_MCPS_DATA_CNF, mac_cnf->status);
+
+			if (usermac_fsm.curr_state == USER_MAC_ST_TX_ONGOING)
+			{
+				/* Roll-backs to the previous request count */
+				usermac_fsm.req_counter--;
+			}
 
-		usermac_fsm.curr_event = USER_MAC_EV_RECEIVED_NEG_DATA_CNF;
+			usermac_fsm.curr_event = USER_MAC_EV_RECEIVED_NEG_DATA_CNF;
+		}
 	}
 }
 
@@ -908,134 +1654,143 @@ static void usermac_handle_mac_data_ind(const void *payload)
 
 	offset += sizeof(mac_ind->msdu) - usermac_fsm.last_ind.msdu_len;
 
-	/* Update test message number */
-	usermac_ping_msg_t* ping_recv = (usermac_ping_msg_t*) usermac_fsm.last_ind.msdu;
-	usermac_fsm.test_msg_n	= ping_recv->msg_n;
+	/* Extract security fields */
+	usermac_fsm.last_ind.security_level = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->security_level, offset);
 
-	/* Discards accidental retransmissions */
-	if (ping_recv->msg_i == (usermac_fsm.ind_counter + 1))
+	if (usermac_fsm.last_ind.security_level == MAC_SECURITY_LEVEL_5_ENCMIC32)
 	{
-		usermac_fsm.received_ind = true;
-
-		usermac_fsm.curr_event = USER_MAC_EV_RECEIVED_DATA_IND;
+		usermac_fsm.last_ind.key_index = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->key_index, offset);
 
-		/* Increments indication counter */
-		usermac_fsm.ind_counter++;
+		/* offset does not need to be changed */
+	}
+	else
+	{
+		usermac_fsm.last_ind.key_index = MAC_NO_KEY;
 
-		/* Extract security fields */
-		usermac_fsm.last_ind.security_level = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->security_level, offset);
+		offset += sizeof(mac_ind->key_index); /* No key index field */
+	}
 
-		if (usermac_fsm.last_ind.security_level == MAC_SECURITY_LEVEL_5_ENCMIC32)
-		{
-			usermac_fsm.last_ind.key_index = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->key_index, offset);
+	/* Extract QoS/LQI fields */
+	usermac_fsm.last_ind.qos = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->qos, offset);
+	usermac_fsm.last_ind.lqi = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->phy_params.lqi, offset);
 
-			/* offset does not need to be changed */
-		}
-		else
-		{
-			usermac_fsm.last_ind.key_index = MAC_NO_KEY;
+	/* Extract media type */
+	uint8_t ind_media_type = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->media_type, offset);
 
-			offset += sizeof(mac_ind->key_index); /* No key index field */
-		}
+	if (ind_media_type == MAC_MEDIATYPE_IND_PLC)
+	{
+		usermac_fsm.last_ind.media_type = MAC_MEDIATYPE_PLC;
+	}
+	else
+	{
+		usermac_fsm.last_ind.media_type = MAC_MEDIATYPE_RF;
+	}
 
-		/* Extract QoS/LQI fields */
-		usermac_fsm.last_ind.qos = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->qos, offset);
-		usermac_fsm.last_ind.lqi = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->phy_params.lqi, offset);
+	usermac_ping_msg_t* ping_recv = (usermac_ping_msg_t*) usermac_fsm.last_ind.msdu;
 
-		/* Extract media type */
-		uint8_t ind_media_type = VAR_SIZE_PAYLOAD_OFFSET(mac_ind->media_type, offset);
+	/* Frames of the traffic generator, counted without further processing */
+	if ((usermac_fsm.last_ind.msdu_len > 0) && ((ping_recv->type == IS_TRAFFIC) || (ping_recv->type == IS_REPORT)))
+	{
+		usermac_gen_handle_ind();
+	}
+	else
+	{
+		/* Update test message number */
+		usermac_fsm.test_msg_n	= ping_recv->msg_n;
 
-		if (ind_media_type == MAC_MEDIATYPE_IND_PLC)
-		{
-			usermac_fsm.last_ind.media_type = MAC_MEDIATYPE_PLC;
-		}
-		else
+		/* Discards accidental retransmissions */
+		if (ping_recv->msg_i == (usermac_fsm.ind_counter + 1))
 		{
-			usermac_fsm.last_ind.media_type = MAC_MEDIATYPE_RF;
-		}
+			usermac_fsm.received_ind = true;
 
-		/* Extract and process PHY parameters */
-		if (usermac_fsm.last_ind.media_type == MAC_MEDIATYPE_PLC)
-		{
-			uint32_t carrier_n;
+			usermac_fsm.curr_event = USER_MAC_EV_RECEIVED_DATA_IND;
 
-			float signal_tot_square = 0;
-			float signal_tot  = 0;
-			float signal_v, signal_dbuv;
+			/* Increments indication counter */
+			usermac_fsm.ind_counter++;
 
-			float noise_tot_square = 0;
-			float noise_tot = 0;
-			float noise_v, noise_dbuv;
+			/* Extract and process PHY parameters */
+			if (usermac_fsm.last_ind.media_type == MAC_MEDIATYPE_PLC)
+			{
+				uint32_t carrier_n;
 
-			float snr_db;
+				float signal_tot_square = 0;
+				float signal_tot  = 0;
+				float signal_v, signal_dbuv;
 
-			if (working_plc_band == BOOT_BANDPLAN_CENELEC_A)
-			{
-				carrier_n = PHY_NUM_OF_CARRIERS_CENA;
-			}
-			else if (working_plc_band == BOOT_BANDPLAN_FCC)
-			{
-				carrier_n = PHY_NUM_OF_CARRIERS_FCC;
-			}
-			else
-			{
-				carrier_n = PHY_NUM_OF_CARRIERS_CENB;
-			}
+				float noise_tot_square = 0;
+				float noise_tot = 0;
+				float noise_v, noise_dbuv;
 
-			uint8_t signal[PHY_NUM_OF_CARRIERS];
-			uint8_t noise[PHY_NUM_OF_CARRIERS];
+				float snr_db;
 
-			memset(signal, 0, sizeof(signal));
-			memset(noise, 0, sizeof(noise));
+				if (working_plc_band == BOOT_BANDPLAN_CENELEC_A)
+				{
+					carrier_n = PHY_NUM_OF_CARRIERS_CENA;
+				}
+				else if (working_plc_band == BOOT_BANDPLAN_FCC)
+				{
+					carrier_n = PHY_NUM_OF_CARRIERS_FCC;
+				}
+				else
+				{
+					carrier_n = PHY_NUM_OF_CARRIERS_CENB;
+				}
 
-			memcpy(signal, VAR_SIZE_POINTER_OFFSET(mac_ind->phy_params.signal[0], offset), carrier_n);
-			memcpy(noise, VAR_SIZE_POINTER_OFFSET(mac_ind->phy_params.noise[0], offset), carrier_n);
+				uint8_t signal[PHY_NUM_OF_CARRIERS];
+				uint8_t noise[PHY_NUM_OF_CARRIERS];
 
-			/* Calculate signal in V, then calculate its average */
-			for (uint32_t i = 0; i < carrier_n; i++)
-			{
-				signal_v = MAC_DBUV_TO_V(signal[i]);
+				memset(signal, 0, sizeof(signal));
+				memset(noise, 0, sizeof(noise));
 
-				signal_tot_square += (signal_v * signal_v);
+				memcpy(signal, VAR_SIZE_POINTER_OFFSET(mac_ind->phy_params.signal[0], offset), carrier_n);
+				memcpy(noise, VAR_SIZE_POINTER_OFFSET(mac_ind->phy_params.noise[0], offset), carrier_n);
 
-				noise_v = MAC_DBUV_TO_V(noise[i]);
+				/* Calculate signal in V, then calculate its average */
+				for (uint32_t i = 0; i < carrier_n; i++)
+				{
+					signal_v = MAC_DBUV_TO_V(signal[i]);
 
-				noise_tot_square += (noise_v * noise_v);
-			}
+					signal_tot_square += (signal_v * signal_v);
 
-			signal_tot = sqrt(signal_tot_square);
+					noise_v = MAC_DBUV_TO_V(noise[i]);
 
-			noise_tot = sqrt(noise_tot_square);
+					noise_tot_square += (noise_v * noise_v);
+				}
 
-			/* then re-convert to dBuV */
-			signal_dbuv = MAC_V_TO_DBUV(signal_tot);
-			noise_dbuv  = MAC_V_TO_DBUV(noise_tot);
+				signal_tot = sqrt(signal_tot_square);
 
-			/* Conversion from peak value to average value (takes into account that carriers with different phases can be destructive) */
-			signal_dbuv -= V_PEAK_TO_AVG_POWER_RATION;
-			noise_dbuv -= V_PEAK_TO_AVG_POWER_RATION;
+				noise_tot = sqrt(noise_tot_square);
 
-			snr_db = (((float) usermac_fsm.last_ind.lqi) * MAC_LQI_TO_SNR_STEP_PLC) - MAC_LQI_TO_SNR_OFFSET_PLC;
+				/* then re-convert to dBuV */
+				signal_dbuv = MAC_V_TO_DBUV(signal_tot);
+				noise_dbuv  = MAC_V_TO_DBUV(noise_tot);
 
-			PRINT("Received %u/%u %s (PLC): LQI = %u (SNR = %.2f dB, signal = %.2f dBuV, noise = %.2f dBuV)\n", usermac_fsm.ind_counter, usermac_fsm.test_msg_n, translateG3cmd(HIF_MCPS_DATA_IND), usermac_fsm.last_ind.lqi, snr_db, signal_dbuv, noise_dbuv);
-		}
-		else
-		{
-			if (usermac_fsm.last_ind.lqi != MAC_NOTMEASURED_LQI_RF)
-			{
-				int8_t rssi = usermac_fsm.last_ind.lqi - MAC_LQI_TO_RSSI_OFFSET_RF;
+				/* Conversion from peak value to average value (takes into account that carriers with different phases can be destructive) */
+				signal_dbuv -= V_PEAK_TO_AVG_POWER_RATION;
+				noise_dbuv -= V_PEAK_TO_AVG_POWER_RATION;
 
-				PRINT("Received %u/%u %s (RF): LQI = %u (RSSI = %d dBm)\n", usermac_fsm.ind_counter, usermac_fsm.test_msg_n, translateG3cmd(HIF_MCPS_DATA_IND), usermac_fsm.last_ind.lqi, rssi);
+				snr_db = (((float) usermac_fsm.last_ind.lqi) * MAC_LQI_TO_SNR_STEP_PLC) - MAC_LQI_TO_SNR_OFFSET_PLC;
+
+				PRINT("Received %u/%u %s (PLC): LQI = %u (SNR = %.2f dB, signal = %.2f dBuV, noise = %.2f dBuV)\n", usermac_fsm.ind_counter, usermac_fsm.test_msg_n, translateG3cmd(HIF_MCPS_DATA_IND), usermac_fsm.last_ind.lqi, snr_db, signal_dbuv, noise_dbuv);
 			}
 			else
 			{
-				PRINT_COLOR("Received %u/%u %s (RF): LQI not measured\n", color_yellow, usermac_fsm.ind_counter, usermac_fsm.test_msg_n, translateG3cmd(HIF_MCPS_DATA_IND));
+				if (usermac_fsm.last_ind.lqi != MAC_NOTMEASURED_LQI_RF)
+				{
+					int8_t rssi = usermac_fsm.last_ind.lqi - MAC_LQI_TO_RSSI_OFFSET_RF;
+
+					PRINT("Received %u/%u %s (RF): LQI = %u (RSSI = %d dBm)\n", usermac_fsm.ind_counter, usermac_fsm.test_msg_n, translateG3cmd(HIF_MCPS_DATA_IND), usermac_fsm.last_ind.lqi, rssi);
+				}
+				else
+				{
+					PRINT_COLOR("Received %u/%u %s (RF): LQI not measured\n", color_yellow, usermac_fsm.ind_counter, usermac_fsm.test_msg_n, translateG3cmd(HIF_MCPS_DATA_IND));
+				}
 			}
 		}
-	}
-	else
-	{
-		PRINT_COLOR("Received retransmitted message (ID: %u instead of %u)\n", color_yellow, ping_recv->msg_i, (usermac_fsm.ind_counter + 1));
+		else
+		{
+			PRINT_COLOR("Received retransmitted message (ID: %u instead of %u)\n", color_yellow, ping_recv->msg_i, (usermac_fsm.ind_counter + 1));
+		}
 	}
 }
 
@@ -1174,6 +1929,66 @@ void UserMac_StartTxCallback(uint8_t *dst_addr, usermac_test_type_t test_type, u
 	}
 }
 
+#if ENABLE_BENCHMARK
+/**
+  * @brief Starts a MAC test as a run of the benchmark (PLC only), its round-trip times are given to the User Bench.
+  * @param dst_addr Destination extended address for the test.
+  * @param msg_number Number of messages exchanged
+  * @retval None
+  */
+void UserMac_StartBenchmark(uint8_t *dst_addr, uint32_t msg_number)
+{
+	if (usermac_fsm.curr_state == USER_MAC_ST_READY)
+	{
+		UserMac_StartTxCallback(dst_addr, mac_test_plc, msg_number);
+
+		usermac_fsm.benchmark = true;
+
+		UserBench_SizeStart(sizeof(usermac_ping_msg_t));
+	}
+}
+#endif
+
+/**
+  * @brief Starts the traffic generator, to characterise the link towards one or more devices.
+  * @param params Parameters of the run (destination address MSB first).
+  * @retval True if the run was started, false if the User MAC is busy or the parameters are invalid.
+  */
+bool UserMac_StartGenerator(const usermac_gen_params_t *params)
+{
+	bool started = false;
+
+	if ((usermac_fsm.curr_state == USER_MAC_ST_READY) && (params->frame_n > 0) &&
+		(params->frame_size >= USERMAC_GEN_FRAME_SIZE_MIN) && (params->frame_size <= USERMAC_GEN_FRAME_SIZE_MAX) &&
+		((params->media == mac_test_plc) || (params->media == mac_test_rf) || (params->media == mac_test_plc_rf)))
+	{
+		usermac_gen_tx_t *gen_tx = &usermac_fsm.gen_tx;
+
+		memset(gen_tx, 0, sizeof(usermac_gen_tx_t));
+		memcpy(&gen_tx->params, params, sizeof(gen_tx->params));
+
+		utils_reverse_array(gen_tx->params.dst_addr, MAC_ADDR64_SIZE);
+
+		/* Pattern following the header, the same for all frames */
+		for (uint32_t payload_index = sizeof(usermac_gen_msg_t); payload_index < gen_tx->params.frame_size; payload_index++)
+		{
+			usermac_fsm.last_req.msdu[payload_index] = payload_index;
+		}
+
+		usermac_fsm.curr_event = USER_MAC_EV_START_GEN;
+
+		if (user_task_operation_couter == usermac_fsm.operation_counter)
+		{
+			/* If the operation counter of the FSM is equal to the user task operation counter, the user task needs to be executed again */
+			RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+		}
+
+		started = true;
+	}
+
+	return started;
+}
+
 /**
   * @brief Callback function of the userMacTimeoutTimer FreeRTOStimer. Warns the user about the timeout event and unblocks the User Task.
   * @param argument Unused argument.
@@ -1185,7 +2000,11 @@ void UserMac_TimeoutCallback(void *argument)
 
 	usermac_fsm.curr_event = USER_MAC_EV_TIMEOUT;
 
-	PRINT("MAC test timeout\n\r");
+	/* The traffic generator also uses the timer to pace its frames */
+	if ((usermac_fsm.curr_state != USER_MAC_ST_GEN_TX) && (usermac_fsm.curr_state != USER_MAC_ST_GEN_RX))
+	{
+		PRINT("MAC test timeout\n\r");
+	}
 
 	/* Unblocks the User Task to execute UserG3 and UserIf FSMs */
 	RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
@@ -42,6 +42,7 @@
 #define MODBUS_TEST_MSG_N				10		/* Number of modbus queries for the test */
 
 #define MODBUS_REGISTER_N				16		/* Number of modbus registers (16 bit each) */
+#define MODBUS_READ_RANGE_N				4		/* Number of register ranges read separately in the test (merged by the master) */
 
 /* Timing */
 #define MODBUS_TEST_INTERVAL			10		/* In ms */
@@ -78,6 +79,7 @@ static mb_errot_t modbus_request(uint8_t dest_id, mb_functioncode_t operation, u
 	telegram.u16RegAdd = address;	// start address in slave
 	telegram.u16CoilsNo = size;		// number of elements (coils or registers) to read
 	telegram.u16reg = data; 		// pointer to a memory array in the Arduino
+	telegram.u32Result = NULL;		// result given as notification value
 
 	if (ModbusQuery(&modbus_handler, telegram)) // make a query
 	{
@@ -93,6 +95,60 @@ static mb_errot_t modbus_request(uint8_t dest_id, mb_functioncode_t operation, u
 	return notification;
 }
 
+/**
+  * @brief Queues several read requests at once and waits for all of them.
+  * @param dest_id Slave address.
+  * @param operation Read function code (the same for all requests).
+  * @param address Start address of each request.
+  * @param size Number of elements of each request.
+  * @param data Memory image of each request.
+  * @param request_n Number of requests (up to MAX_TELEGRAMS).
+  * @retval ERR_OK_QUERY if all requests succeeded, the first error otherwise.
+  * @note The requests queued together can be merged by the master into fewer bus transactions.
+  */
+static mb_errot_t modbus_request_multi(uint8_t dest_id, mb_functioncode_t operation, const uint16_t *address, const uint16_t *size, uint16_t **data, uint8_t request_n)
+{
+	mb_errot_t result = ERR_OK_QUERY;
+	uint32_t   request_result[MAX_TELEGRAMS];
+	uint8_t    queued_n = 0;
+	modbus_t   telegram;
+
+	assert(request_n <= MAX_TELEGRAMS);
+
+	for (uint8_t i = 0; i < request_n; i++)
+	{
+		telegram.u8id = dest_id;
+		telegram.u8fct = operation;
+		telegram.u16RegAdd = address[i];
+		telegram.u16CoilsNo = size[i];
+		telegram.u16reg = data[i];
+		telegram.u32Result = &request_result[i];
+
+		if (ModbusQuery(&modbus_handler, telegram))
+		{
+			queued_n++;
+		}
+		else
+		{
+			result = ERR_BUFF_OVERFLOW;
+			break;
+		}
+	}
+
+	/* Each result is notified with an increment of the notification value */
+	for (uint8_t i = 0; i < queued_n; i++)
+	{
+		ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	}
+
+	for (uint8_t i = 0; (i < queued_n) && (result == ERR_OK_QUERY); i++)
+	{
+		result = request_result[i];
+	}
+
+	return result;
+}
+
 
 
 /**
@@ -166,6 +222,16 @@ void UserModbus_deinit(void)
 	ModbusDeinit(&modbus_handler);
 }
 
+/**
+  * @brief Queues a query to the modbus master, the calling task is notified of its result.
+  * @param telegram Query to queue (see "modbus_t").
+  * @retval True if the query was queued, false otherwise (queue full or not master).
+  * @note The queries queued together can be merged by the master into fewer bus transactions.
+  */
+bool UserModbus_query(modbus_t telegram)
+{
+	return ModbusQuery(&modbus_handler, telegram);
+}
 
 /**
   * @brief This is the main modbus routine.
@@ -205,7 +271,25 @@ void UserModbus_exec()
 					modbus_registers[i] = 0;
 				}
 
-				notification = modbus_request(MODBUS_SLAVE_ID, MB_FC_READ_REGISTERS, 0x0, reg_count, modbus_registers);
+				/* Reads the registers by ranges, queued together to be merged by the master */
+				uint16_t  range_address[MODBUS_READ_RANGE_N];
+				uint16_t  range_size[MODBUS_READ_RANGE_N];
+				uint16_t *range_data[MODBUS_READ_RANGE_N];
+				uint16_t  out_count = modbus_handler.u16OutCnt;
+
+				for (uint32_t i = 0; i < MODBUS_READ_RANGE_N; i++)
+				{
+					range_address[i] = i * (reg_count / MODBUS_READ_RANGE_N);
+					range_size[i]    = reg_count / MODBUS_READ_RANGE_N;
+					range_data[i]    = &modbus_registers[range_address[i]];
+				}
+
+				notification = modbus_request_multi(MODBUS_SLAVE_ID, MB_FC_READ_REGISTERS, range_address, range_size, range_data, MODBUS_READ_RANGE_N);
+
+				if (query_count == 0)
+				{
+					PRINT("%u read ranges sent in %u queries\n", MODBUS_READ_RANGE_N, (uint16_t) (modbus_handler.u16OutCnt - out_count));
+				}
 
 				if (notification == ERR_OK_QUERY)
 				{
@@ -0,0 +1,703 @@
+/**
+ ******************************************************************************
+ * @file    user_modbus_gw.c
+ * @author  AMG/IPC Application Team
+ * @brief   Implementation of the gateway between the coordinator (UDP) and the
+ *          Modbus slaves of the devices (RTU).
+ *
+ * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+ * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+ * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+ * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+ * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+ *
+ *******************************************************************************/
+
+/* Inclusions */
+#include <string.h>
+#include <assert.h>
+#include <cmsis_os.h>
+#include <utils.h>
+#include <main.h>
+#include <debug_print.h>
+#include <user_g3_common.h>
+#include <user_modbus_gw.h>
+#if !IS_COORD
+#include <modbus.h>
+#include <user_modbus.h>
+#endif
+
+/** @addtogroup User_App
+ * @{
+ */
+
+/** @addtogroup User_Modbus_Gw
+ * @{
+ */
+
+/** @addtogroup User_Modbus_Gw_Private_Code
+ * @{
+ */
+
+#if ENABLE_MODBUS_GATEWAY
+
+/* Definitions */
+#define USER_MBGW_EXCEPTION_FLAG			(0x80)	/* Set in the function code of an exception response */
+
+#if !IS_COORD
+
+#if USER_MBGW_REQUEST_MAX > MAX_TELEGRAMS
+#error "USER_MBGW_REQUEST_MAX must not exceed MAX_TELEGRAMS, all requests of a datagram are queued to the Modbus master at once"
+#endif
+
+#if (MAX_BUFFER - 3) > USER_MBGW_PDU_MAX_SIZE
+#error "USER_MBGW_PDU_MAX_SIZE must hold the PDUs of the Modbus buffer (MAX_BUFFER without slave address and CRC)"
+#endif
+
+/* Limits of the quantities, from the size of the Modbus buffer (slave address, function code, byte count and CRC take 5 bytes, 9 with address and quantity) */
+#define USER_MBGW_READ_REGS_MAX				((MAX_BUFFER - 5) / 2)
+#define USER_MBGW_READ_BITS_MAX				((MAX_BUFFER - 5) * 8)
+#define USER_MBGW_WRITE_REGS_MAX			((MAX_BUFFER - 9) / 2)
+#define USER_MBGW_WRITE_BITS_MAX			((MAX_BUFFER - 9) * 8)
+#define USER_MBGW_IMAGE_WORDS				((MAX_BUFFER - 4) / 2)	/* Words of the memory image of a request (coils are packed 16 per word) */
+
+#define USER_MBGW_COIL_ON					(0xFF00)	/* Value of FC5 to set a coil */
+#define USER_MBGW_COIL_OFF					(0x0000)	/* Value of FC5 to reset a coil */
+
+/* Custom types */
+typedef enum user_mbgw_job_state_enum
+{
+	USER_MBGW_JOB_IDLE = 0,		/* No batch in progress, a new datagram can be taken */
+	USER_MBGW_JOB_BUSY,			/* Batch handed over to the gateway task */
+	USER_MBGW_JOB_DONE			/* Batch executed, the reply must be sent */
+} user_mbgw_job_state_t;
+
+/* Request of a batch, replaced by its response once executed */
+typedef struct user_mbgw_request_str
+{
+	uint8_t		unit_id;						/*!<  Modbus slave address */
+	uint8_t		function;						/*!<  Function code of the request */
+	uint8_t		exception;						/*!<  Exception code of the response, 0 if the request succeeded */
+	modbus_t	telegram;						/*!<  Query to the Modbus master */
+	uint16_t	image[USER_MBGW_IMAGE_WORDS];	/*!<  Memory image of the query */
+	uint32_t	result;							/*!<  Result of the query (mb_errot_t) */
+} user_mbgw_request_t;
+
+/* Batch received from the coordinator */
+typedef struct user_mbgw_job_str
+{
+	volatile user_mbgw_job_state_t	state;								/*!<  State of the batch, shared with the gateway task */
+	ip6_addr_t						ip_addr;							/*!<  IPv6 address of the coordinator */
+	uint16_t						transaction_id;						/*!<  Transaction ID of the datagram, echoed in the reply */
+	uint8_t							request_n;							/*!<  Number of requests */
+	user_mbgw_request_t				request[USER_MBGW_REQUEST_MAX];		/*!<  Requests of the batch */
+} user_mbgw_job_t;
+
+#endif /* !IS_COORD */
+
+/* External variables */
+extern osMessageQueueId_t	user_queueHandle;
+#if !IS_COORD
+extern osSemaphoreId_t		semModbusGwHandle;
+#endif
+
+/* Private variables */
+static uint8_t				user_mbgw_datagram[USER_MBGW_DATAGRAM_MAX_SIZE];	/* Datagram sent (request on the coordinator, reply on the devices) */
+static bool					user_mbgw_data_received;
+
+#if IS_COORD
+static uint16_t				user_mbgw_transaction_id;
+static user_mbgw_reply_cb_t	*user_mbgw_callback;
+static user_mbgw_pdu_t		user_mbgw_response[USER_MBGW_REQUEST_MAX];			/* Responses of the last reply received */
+#else
+static user_mbgw_job_t		user_mbgw_job;
+#endif /* IS_COORD */
+
+/* Private functions */
+
+#if IS_COORD
+
+/**
+ * @brief Parses a reply of a device into the array of responses.
+ * @param packet Pointer to the UDP packet of the reply.
+ * @param transaction_id Pointer to the variable where the transaction ID is copied.
+ * @retval Number of responses, 0 if the reply is malformed
+ */
+static uint8_t user_mbgw_parse_reply(const udp_packet_t *packet, uint16_t *transaction_id)
+{
+	const uint8_t *data = packet->payload;
+	uint8_t response_n = 0;
+	uint16_t offset = USER_MBGW_HEADER_SIZE;
+	bool valid = (packet->length >= USER_MBGW_HEADER_SIZE) && (data[2] > 0) && (data[2] <= USER_MBGW_REQUEST_MAX);
+
+	if (valid)
+	{
+		*transaction_id = ASSEMBLE_U16(data[0], data[1]);
+
+		for (response_n = 0; (response_n < data[2]) && valid; response_n++)
+		{
+			user_mbgw_pdu_t *response = &user_mbgw_response[response_n];
+
+			valid = ((offset + USER_MBGW_ENTRY_HEADER_SIZE) <= packet->length);
+
+			if (valid)
+			{
+				response->unit_id	= data[offset];
+				response->length	= data[offset + 1];
+				offset += USER_MBGW_ENTRY_HEADER_SIZE;
+
+				valid = (response->length > 0) && (response->length <= USER_MBGW_PDU_MAX_SIZE) && ((offset + response->length) <= packet->length);
+			}
+
+			if (valid)
+			{
+				memcpy(response->pdu, &data[offset], response->length);
+				offset += response->length;
+			}
+		}
+	}
+
+	return valid ? response_n : 0;
+}
+
+/**
+ * @brief Delivers the replies received from the devices.
+ * @param None
+ * @retval None
+ */
+static void user_mbgw_handle_replies(void)
+{
+	udp_packet_t packet;
+
+	while (UserG3_DequeueUdpData(MODBUS_GW_CONN_ID, &packet, 1) > 0)
+	{
+		uint16_t short_addr = ASSEMBLE_U16(packet.ip_addr.u8[14], packet.ip_addr.u8[15]);
+		uint16_t transaction_id = 0;
+		uint8_t  response_n = user_mbgw_parse_reply(&packet, &transaction_id);
+
+		if (response_n == 0)
+		{
+			PRINT_USER_G3_WARNING("Malformed Modbus gateway reply from %u\n", short_addr);
+		}
+		else if (user_mbgw_callback != NULL)
+		{
+			user_mbgw_callback(short_addr, transaction_id, user_mbgw_response, response_n);
+		}
+		else
+		{
+			for (uint8_t i = 0; i < response_n; i++)
+			{
+				PRINT_USER_G3_INFO("Modbus gateway %u, transaction %u: unit %u, function %u, %u bytes\n", short_addr, transaction_id,
+						user_mbgw_response[i].unit_id, user_mbgw_response[i].pdu[0], user_mbgw_response[i].length);
+			}
+		}
+
+		UserG3_ReleaseUdpData(&packet);
+	}
+}
+
+#else
+
+/**
+ * @brief Decodes the PDU of a request into a query to the Modbus master.
+ * @param request Pointer to the request to fill, its unit ID must be already set.
+ * @param pdu Pointer to the PDU of the request.
+ * @param length Length of the PDU, in bytes.
+ * @retval None
+ * @note The request is answered with an exception if its PDU cannot be forwarded.
+ */
+static void user_mbgw_decode_request(user_mbgw_request_t *request, const uint8_t *pdu, const uint8_t length)
+{
+	uint16_t address	= (length >= 3) ? ASSEMBLE_U16(pdu[1], pdu[2]) : 0;
+	uint16_t quantity	= (length >= 5) ? ASSEMBLE_U16(pdu[3], pdu[4]) : 0;	/* Value, for the single writes */
+	uint8_t  byte_count	= (length >= 6) ? pdu[5] : 0;
+
+	request->function	= pdu[0];
+	request->exception	= 0;
+	memset(request->image, 0, sizeof(request->image));
+
+	switch (request->function)
+	{
+	case MB_FC_READ_COILS:
+	case MB_FC_READ_DISCRETE_INPUT:
+		if ((length != 5) || (quantity == 0) || (quantity > USER_MBGW_READ_BITS_MAX))
+		{
+			request->exception = USER_MBGW_EXC_ILLEGAL_VALUE;
+		}
+		break;
+	case MB_FC_READ_REGISTERS:
+	case MB_FC_READ_INPUT_REGISTER:
+		if ((length != 5) || (quantity == 0) || (quantity > USER_MBGW_READ_REGS_MAX))
+		{
+			request->exception = USER_MBGW_EXC_ILLEGAL_VALUE;
+		}
+		break;
+	case MB_FC_WRITE_COIL:
+		if ((length != 5) || ((quantity != USER_MBGW_COIL_ON) && (quantity != USER_MBGW_COIL_OFF)))
+		{
+			request->exception = USER_MBGW_EXC_ILLEGAL_VALUE;
+		}
+		else
+		{
+			request->image[0] = (quantity == USER_MBGW_COIL_ON) ? 1 : 0;
+			quantity = 1;
+		}
+		break;
+	case MB_FC_WRITE_REGISTER:
+		if (length != 5)
+		{
+			request->exception = USER_MBGW_EXC_ILLEGAL_VALUE;
+		}
+		else
+		{
+			request->image[0] = quantity;
+			quantity = 1;
+		}
+		break;
+	case MB_FC_WRITE_MULTIPLE_COILS:
+		if (	(quantity == 0) || (quantity > USER_MBGW_WRITE_BITS_MAX)
+			||	(byte_count != ((quantity + 7) / 8)) || (length != (6 + byte_count)))
+		{
+			request->exception = USER_MBGW_EXC_ILLEGAL_VALUE;
+		}
+		else
+		{
+			/* Packed as sent by the Modbus master: the first byte of each pair in the high byte of the word */
+			for (uint8_t i = 0; i < byte_count; i++)
+			{
+				request->image[i / 2] |= (i % 2) ? pdu[6 + i] : (pdu[6 + i] << 8);
+			}
+		}
+		break;
+	case MB_FC_WRITE_MULTIPLE_REGISTERS:
+		if (	(quantity == 0) || (quantity > USER_MBGW_WRITE_REGS_MAX)
+			||	(byte_count != (2 * quantity)) || (length != (6 + byte_count)))
+		{
+			request->exception = USER_MBGW_EXC_ILLEGAL_VALUE;
+		}
+		else
+		{
+			for (uint8_t i = 0; i < quantity; i++)
+			{
+				request->image[i] = ASSEMBLE_U16(pdu[6 + (2 * i)], pdu[7 + (2 * i)]);
+			}
+		}
+		break;
+	default:
+		request->exception = USER_MBGW_EXC_ILLEGAL_FUNCTION;
+		break;
+	}
+
+	if ((request->exception == 0) && ((request->unit_id == 0) || (request->unit_id > 247)))
+	{
+		/* Broadcasts are not answered by the slaves, they cannot be forwarded */
+		request->exception = USER_MBGW_EXC_PATH_UNAVAILABLE;
+	}
+
+	request->telegram.u8id			= request->unit_id;
+	request->telegram.u8fct			= request->function;
+	request->telegram.u16RegAdd		= address;
+	request->telegram.u16CoilsNo	= quantity;
+	request->telegram.u16reg		= request->image;
+	request->telegram.u32Result		= &request->result;
+}
+
+/**
+ * @brief Decodes a datagram of the coordinator into the batch of the gateway.
+ * @param packet Pointer to the UDP packet of the datagram.
+ * @retval True if the datagram is valid, false otherwise
+ */
+static bool user_mbgw_decode_datagram(const udp_packet_t *packet)
+{
+	const uint8_t *data = packet->payload;
+	uint16_t offset = USER_MBGW_HEADER_SIZE;
+	bool valid = (packet->length >= USER_MBGW_HEADER_SIZE) && (data[2] > 0) && (data[2] <= USER_MBGW_REQUEST_MAX);
+
+	if (valid)
+	{
+		user_mbgw_job.ip_addr			= packet->ip_addr;
+		user_mbgw_job.transaction_id	= ASSEMBLE_U16(data[0], data[1]);
+		user_mbgw_job.request_n			= data[2];
+
+		for (uint8_t i = 0; (i < user_mbgw_job.request_n) && valid; i++)
+		{
+			uint8_t pdu_len = 0;
+
+			valid = ((offset + USER_MBGW_ENTRY_HEADER_SIZE) <= packet->length);
+
+			if (valid)
+			{
+				user_mbgw_job.request[i].unit_id = data[offset];
+				pdu_len = data[offset + 1];
+				offset += USER_MBGW_ENTRY_HEADER_SIZE;
+
+				valid = (pdu_len > 0) && ((offset + pdu_len) <= packet->length);
+			}
+
+			if (valid)
+			{
+				user_mbgw_decode_request(&user_mbgw_job.request[i], &data[offset], pdu_len);
+				offset += pdu_len;
+			}
+		}
+	}
+
+	return valid;
+}
+
+/**
+ * @brief Encodes the response of a request.
+ * @param request Pointer to the executed request.
+ * @param pdu Pointer to the buffer of the response PDU.
+ * @retval Length of the response PDU, in bytes
+ */
+static uint8_t user_mbgw_encode_response(const user_mbgw_request_t *request, uint8_t *pdu)
+{
+	const modbus_t *telegram = &request->telegram;
+	uint8_t length = 0;
+	uint8_t byte_count;
+
+	pdu[length++] = request->function;
+
+	if (request->exception != 0)
+	{
+		pdu[0] |= USER_MBGW_EXCEPTION_FLAG;
+		pdu[length++] = request->exception;
+	}
+	else
+	{
+		switch (request->function)
+		{
+		case MB_FC_READ_COILS:
+		case MB_FC_READ_DISCRETE_INPUT:
+			/* Packed as received by the Modbus master: the first byte of each pair in the low byte of the word */
+			byte_count = (telegram->u16CoilsNo + 7) / 8;
+			pdu[length++] = byte_count;
+			for (uint8_t i = 0; i < byte_count; i++)
+			{
+				pdu[length++] = (i % 2) ? HIGH_BYTE(request->image[i / 2]) : LOW_BYTE(request->image[i / 2]);
+			}
+			break;
+		case MB_FC_READ_REGISTERS:
+		case MB_FC_READ_INPUT_REGISTER:
+			pdu[length++] = (uint8_t) (2 * telegram->u16CoilsNo);
+			for (uint8_t i = 0; i < telegram->u16CoilsNo; i++)
+			{
+				pdu[length++] = HIGH_BYTE(request->image[i]);
+				pdu[length++] = LOW_BYTE( request->image[i]);
+			}
+			break;
+		case MB_FC_WRITE_COIL:
+			pdu[length++] = HIGH_BYTE(telegram->u16RegAdd);
+			pdu[length++] = LOW_BYTE( telegram->u16RegAdd);
+			pdu[length++] = (request->image[0] != 0) ? HIGH_BYTE(USER_MBGW_COIL_ON) : HIGH_BYTE(USER_MBGW_COIL_OFF);
+			pdu[length++] = 0;
+			break;
+		case MB_FC_WRITE_REGISTER:
+			pdu[length++] = HIGH_BYTE(telegram->u16RegAdd);
+			pdu[length++] = LOW_BYTE( telegram->u16RegAdd);
+			pdu[length++] = HIGH_BYTE(request->image[0]);
+			pdu[length++] = LOW_BYTE( request->image[0]);
+			break;
+		default: /* MB_FC_WRITE_MULTIPLE_COILS, MB_FC_WRITE_MULTIPLE_REGISTERS */
+			pdu[length++] = HIGH_BYTE(telegram->u16RegAdd);
+			pdu[length++] = LOW_BYTE( telegram->u16RegAdd);
+			pdu[length++] = HIGH_BYTE(telegram->u16CoilsNo);
+			pdu[length++] = LOW_BYTE( telegram->u16CoilsNo);
+			break;
+		}
+	}
+
+	return length;
+}
+
+/**
+ * @brief Sends the reply of the executed batch to the coordinator.
+ * @param None
+ * @retval None
+ */
+static void user_mbgw_send_reply(void)
+{
+	uint16_t length = 0;
+
+	user_mbgw_datagram[length++] = HIGH_BYTE(user_mbgw_job.transaction_id);
+	user_mbgw_datagram[length++] = LOW_BYTE( user_mbgw_job.transaction_id);
+	user_mbgw_datagram[length++] = user_mbgw_job.request_n;
+
+	for (uint8_t i = 0; i < user_mbgw_job.request_n; i++)
+	{
+		user_mbgw_request_t *request = &user_mbgw_job.request[i];
+
+		if ((request->exception == 0) && (request->result != ERR_OK_QUERY))
+		{
+			request->exception = (request->result == ERR_TIME_OUT) ? USER_MBGW_EXC_TARGET_FAILED : USER_MBGW_EXC_DEVICE_FAILURE;
+		}
+
+		user_mbgw_datagram[length] = request->unit_id;
+		user_mbgw_datagram[length + 1] = user_mbgw_encode_response(request, &user_mbgw_datagram[length + USER_MBGW_ENTRY_HEADER_SIZE]);
+		length += USER_MBGW_ENTRY_HEADER_SIZE + user_mbgw_datagram[length + 1];
+	}
+
+	if (UserG3_SendUdpData(MODBUS_GW_CONN_ID, user_mbgw_job.ip_addr, user_mbgw_datagram, length) == 0)
+	{
+		PRINT_USER_G3_WARNING("Modbus gateway reply not sent\n");
+	}
+}
+
+/**
+ * @brief Takes the next datagram of the coordinator and hands it over to the gateway task.
+ * @param None
+ * @retval None
+ * @note The datagrams received while a batch is in progress stay queued on the connection.
+ */
+static void user_mbgw_take_request(void)
+{
+	udp_packet_t packet;
+	bool taken = false;
+
+	while ((!taken) && (UserG3_DequeueUdpData(MODBUS_GW_CONN_ID, &packet, 1) > 0))
+	{
+		taken = user_mbgw_decode_datagram(&packet);
+
+		if (!taken)
+		{
+			PRINT_USER_G3_WARNING("Malformed Modbus gateway request discarded\n");
+		}
+
+		UserG3_ReleaseUdpData(&packet);
+	}
+
+	if (taken)
+	{
+		user_mbgw_job.state = USER_MBGW_JOB_BUSY;
+
+		osSemaphoreRelease(semModbusGwHandle);
+	}
+	else
+	{
+		user_mbgw_data_received = false;
+	}
+}
+
+#endif /* IS_COORD */
+
+/**
+ * @}
+ */
+
+/** @addtogroup User_Modbus_Gw_Exported_Code
+ * @{
+ */
+
+/**
+ * @brief Function that handles the initialization of the Modbus gateway.
+ * @param None
+ * @retval None
+ * @note On the devices, starts the Modbus master (the gateway task is created with the other tasks).
+ */
+void UserModbusGw_Init(void)
+{
+	user_mbgw_data_received = false;
+
+#if IS_COORD
+	user_mbgw_transaction_id	= 0;
+	user_mbgw_callback			= NULL;
+#else
+	user_mbgw_job.state			= USER_MBGW_JOB_IDLE;
+
+	UserModbus_init(modbus_master);
+	UserModbus_start();
+#endif
+}
+
+/**
+ * @brief Function that checks if a message is needed by the Modbus gateway.
+ * @param g3_msg Pointer to the G3 message structure to evaluate
+ * @return 'true' if the message is needed, 'false' otherwise.
+ */
+bool UserModbusGw_MsgNeeded(const g3_msg_t *g3_msg)
+{
+	switch(g3_msg->command_id)
+	{
+	case HIF_UDP_DATA_IND:
+		return true;
+		break;
+	default:
+		return false;
+		break;
+	}
+}
+
+/**
+ * @brief Function that handles the G3 messages coming from the G3 task.
+ * @param g3_msg Pointer to the received G3 message
+ * @retval None
+ */
+void UserModbusGw_MsgHandler(const g3_msg_t *g3_msg)
+{
+	assert(g3_msg->payload != NULL); /* All expected messages have payload */
+
+	switch (g3_msg->command_id)
+	{
+	case HIF_UDP_DATA_IND:
+		/* The packet is queued by the User G3, it is taken from the gateway connection by the FSM */
+		user_mbgw_data_received = true;
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Function that handles the state of the Modbus gateway.
+ * @param None
+ * @retval None
+ * @note Entry function called from User task infinite execution loop.
+ */
+void UserModbusGw_FsmManager(void)
+{
+#if IS_COORD
+	if (user_mbgw_data_received)
+	{
+		user_mbgw_data_received = false;
+
+		user_mbgw_handle_replies();
+	}
+#else
+	if (user_mbgw_job.state == USER_MBGW_JOB_DONE)
+	{
+		user_mbgw_send_reply();
+
+		user_mbgw_job.state = USER_MBGW_JOB_IDLE;
+	}
+
+	if ((user_mbgw_job.state == USER_MBGW_JOB_IDLE) && user_mbgw_data_received)
+	{
+		user_mbgw_take_request();
+	}
+#endif
+}
+
+#if IS_COORD
+/**
+ * @brief Function that sends a batch of Modbus requests to the gateway of a device.
+ * @param short_addr Short address of the device
+ * @param requests Array of requests (PDU of each one as in Modbus TCP)
+ * @param request_n Number of requests in the array (1 - USER_MBGW_REQUEST_MAX)
+ * @param callback Function called with the responses of the batch (can be NULL, to print them)
+ * @retval Transaction ID of the batch, 0 if it was not sent
+ * @note All requests are executed by the device before it replies, the callback is the same for all batches in progress.
+ */
+uint16_t UserModbusGw_Send(const uint16_t short_addr, const user_mbgw_pdu_t *requests, const uint8_t request_n, user_mbgw_reply_cb_t *callback)
+{
+	uint16_t transaction_id = 0;
+	uint16_t length = 0;
+	bool valid = (request_n > 0) && (request_n <= USER_MBGW_REQUEST_MAX);
+
+	assert(requests != NULL);
+
+	for (uint8_t i = 0; (i < request_n) && valid; i++)
+	{
+		valid = (requests[i].length > 0) && (requests[i].length <= USER_MBGW_PDU_MAX_SIZE);
+	}
+
+	if (valid)
+	{
+		/* Transaction ID 0 is reserved to signal a batch not sent */
+		if (++user_mbgw_transaction_id == 0)
+		{
+			user_mbgw_transaction_id++;
+		}
+
+		user_mbgw_datagram[length++] = HIGH_BYTE(user_mbgw_transaction_id);
+		user_mbgw_datagram[length++] = LOW_BYTE( user_mbgw_transaction_id);
+		user_mbgw_datagram[length++] = request_n;
+
+		for (uint8_t i = 0; i < request_n; i++)
+		{
+			user_mbgw_datagram[length++] = requests[i].unit_id;
+			user_mbgw_datagram[length++] = requests[i].length;
+			memcpy(&user_mbgw_datagram[length], requests[i].pdu, requests[i].length);
+			length += requests[i].length;
+		}
+
+		if (UserG3_SendUdpDataToShortAddress(MODBUS_GW_CONN_ID, short_addr, user_mbgw_datagram, length) != 0)
+		{
+			user_mbgw_callback = callback;
+			transaction_id = user_mbgw_transaction_id;
+		}
+		else
+		{
+			PRINT_USER_G3_WARNING("Modbus gateway request not sent\n");
+		}
+	}
+	else
+	{
+		PRINT_USER_G3_CRITICAL("Invalid Modbus gateway batch (%u requests)\n", request_n);
+	}
+
+	return transaction_id;
+}
+#else
+
+/**
+ * @brief Function that executes the batches of the coordinator, in the modbus_gw_task (the Modbus queries are blocking).
+ * @param None
+ * @retval None
+ * @note All requests of a batch are queued at once, so that the Modbus master can merge them.
+ */
+void UserModbusGw_TaskExec(void)
+{
+	for (;;)
+	{
+		osSemaphoreAcquire(semModbusGwHandle, osWaitForever);
+
+		uint8_t queued_n = 0;
+
+		for (uint8_t i = 0; i < user_mbgw_job.request_n; i++)
+		{
+			user_mbgw_request_t *request = &user_mbgw_job.request[i];
+
+			if (request->exception == 0)
+			{
+				if (UserModbus_query(request->telegram))
+				{
+					queued_n++;
+				}
+				else
+				{
+					request->exception = USER_MBGW_EXC_PATH_UNAVAILABLE;
+				}
+			}
+		}
+
+		/* Each result is notified with an increment of the notification value */
+		for (uint8_t i = 0; i < queued_n; i++)
+		{
+			ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+		}
+
+		user_mbgw_job.state = USER_MBGW_JOB_DONE;
+
+		RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+	}
+}
+
+#endif /* IS_COORD */
+
+#endif /* ENABLE_MODBUS_GATEWAY */
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
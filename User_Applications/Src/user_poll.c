@@ -0,0 +1,1071 @@
+/**
+ ******************************************************************************
+ * @file    user_poll.c
+ * @author  AMG/IPC Application Team
+ * @brief   Implementation of the polling of the devices (data concentrator).
+ *
+ * THE PRESENT SOFTWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+ * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE TIME.
+ * AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY DIRECT,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING FROM THE
+ * CONTENT OF SUCH SOFTWARE AND/OR THE USE MADE BY CUSTOMERS OF THE CODING
+ * INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+ *
+ *******************************************************************************/
+
+/* Inclusions */
+#include <string.h>
+#include <assert.h>
+#include <cmsis_os.h>
+#include <utils.h>
+#include <main.h>
+#include <debug_print.h>
+#include <mem_pool.h>
+#include <hi_adp_pib_attributes.h>
+#include <hi_g3lib_attributes.h>
+#include <hi_g3lib_sap_interface.h>
+#include <g3_app_boot_srv.h>
+#include <user_g3_common.h>
+#include <user_poll.h>
+
+/** @addtogroup User_App
+ * @{
+ */
+
+/** @addtogroup User_Poll
+ * @{
+ */
+
+/** @addtogroup User_Poll_Private_Code
+ * @{
+ */
+
+#if ENABLE_METER_POLLING
+
+/* Definitions */
+#define USER_POLL_MIN(a, b)						(((a) < (b)) ? (a) : (b))
+#define USER_POLL_MAX(a, b)						(((a) > (b)) ? (a) : (b))
+
+#if IS_COORD
+
+/* Timing */
+#define USER_POLL_TIMEOUT_INITIAL				(10000U)	/* In ms, timeout of the requests before the first round-trip is measured */
+#define USER_POLL_TIMEOUT_MIN					(2000U)		/* In ms */
+#define USER_POLL_TIMEOUT_MAX					(60000U)	/* In ms */
+#define USER_POLL_ROUTE_TIMEOUT					(2000U)		/* In ms, time after which a G3LIB-GET.Request of a route is considered lost */
+
+/* Window sizing: the window grows while the round-trip stays close to the lowest one measured, and shrinks when it rises (queuing) */
+#define USER_POLL_RTT_GROW_FACTOR				(2)			/* The window grows if the round-trip time is lower than this factor times the lowest one */
+#define USER_POLL_RTT_SHRINK_FACTOR				(4)			/* The window shrinks if the round-trip time is higher than this factor times the lowest one */
+
+#if USER_POLL_WINDOW_MIN == 0
+#error "USER_POLL_WINDOW_MIN must be > 0"
+#endif
+
+#if USER_POLL_WINDOW_MAX < USER_POLL_WINDOW_MIN
+#error "USER_POLL_WINDOW_MAX must be higher than or equal to USER_POLL_WINDOW_MIN"
+#endif
+
+/* Custom types */
+typedef enum user_poll_event_enum
+{
+	USER_POLL_EV_NONE = 0,
+	USER_POLL_EV_START,
+	USER_POLL_EV_UDP_IND,
+	USER_POLL_EV_ROUTE_CNF,
+	USER_POLL_EV_TIMEOUT,
+	USER_POLL_EV_STOP,
+	USER_POLL_EV_CNT
+} user_poll_event_t;
+
+typedef enum user_poll_state_enum
+{
+	USER_POLL_ST_IDLE = 0,
+	USER_POLL_ST_RUNNING,
+	USER_POLL_ST_CNT
+} user_poll_state_t;
+
+typedef enum user_poll_dev_state_enum
+{
+	USER_POLL_DEV_PENDING = 0,	/* Request to send */
+	USER_POLL_DEV_WAITING,		/* Request sent, waiting for the reply */
+	USER_POLL_DEV_DONE			/* Result delivered */
+} user_poll_dev_state_t;
+
+/* Polling state of a device */
+typedef struct user_poll_device_str
+{
+	uint16_t	short_addr;			/*!<  Short address of the device */
+	uint8_t		state;				/*!<  State of the device in the sweep (user_poll_dev_state_t) */
+	uint8_t		attempts;			/*!<  Number of requests sent */
+	uint8_t		hops;				/*!<  Hop count of the route to the device (0 if unknown) */
+	bool		route_requested;	/*!<  The route to the device was requested */
+	bool		send_failed;		/*!<  The last request got a negative G3UDP-DATA.Confirm */
+	uint8_t		handle;				/*!<  UDP handle of the last request */
+	uint32_t	sent_ts;			/*!<  Time of the last request, in ms */
+	uint32_t	timeout;			/*!<  Timeout of the last request, in ms */
+} user_poll_device_t;
+
+typedef struct user_poll_fsm_str
+{
+	/* FSM */
+	user_poll_state_t		curr_state;								/*!<  Current state of the polling */
+	user_poll_event_t		curr_event;								/*!<  Current event of the polling */
+	uint32_t				operation_counter;						/*!<  Operation counter of the polling FSM */
+
+	/* Sweep */
+	user_poll_device_t		device[USER_POLL_MAX_DEVICES];			/*!<  Devices to poll */
+	uint16_t				device_num;								/*!<  Number of devices to poll */
+	uint16_t				device_done;							/*!<  Number of devices with a result */
+	uint8_t					in_flight;								/*!<  Number of requests waiting for the reply */
+	uint8_t					request[USER_POLL_REQUEST_MAX_SIZE];	/*!<  Request sent to each device */
+	uint16_t				request_len;							/*!<  Length of the request, in bytes */
+	uint32_t				start_ts;								/*!<  Time of the start of the sweep, in ms */
+
+	/* Results */
+	user_poll_batch_cb_t	*callback;								/*!<  Function called with each batch of results */
+	user_poll_result_t		batch[USER_POLL_BATCH_SIZE];			/*!<  Results not delivered yet */
+	uint8_t					batch_count;							/*!<  Number of results in the batch */
+
+	/* Latency */
+	uint32_t				rtt_min;								/*!<  Lowest round-trip time measured, in ms */
+	uint32_t				rttvar;									/*!<  Round-trip time variation, in ms */
+
+	/* Routes */
+	bool					route_busy;								/*!<  A G3LIB-GET.Request of a route is waiting for its confirm */
+	uint32_t				route_ts;								/*!<  Time of the last G3LIB-GET.Request, in ms */
+
+	user_poll_stats_t		stats;									/*!<  Statistics of the sweep */
+} user_poll_fsm_t;
+
+#endif /* IS_COORD */
+
+/* External variables */
+extern osMessageQueueId_t	user_queueHandle;
+
+#if IS_COORD
+extern osTimerId_t 			pollTimerHandle;
+
+extern boot_server_t		boot_server;
+extern userg3_common_t		userg3_common;
+
+/* Private variables */
+static user_poll_fsm_t		user_poll_fsm;
+
+/* Private function pointer type */
+typedef user_poll_state_t user_poll_fsm_func(void);
+
+/* Private FSM function prototypes */
+static user_poll_state_t user_poll_fsm_default(void);
+static user_poll_state_t user_poll_fsm_discard(void);
+static user_poll_state_t user_poll_fsm_start(void);
+static user_poll_state_t user_poll_fsm_run(void);
+static user_poll_state_t user_poll_fsm_stop(void);
+
+/* Private FSM function pointer array */
+static user_poll_fsm_func *user_poll_fsm_func_tbl[USER_POLL_ST_CNT][USER_POLL_EV_CNT] = {
+/*				NONE,                   START,                  UDP_IND,                ROUTE_CNF,              TIMEOUT,                STOP */
+/* IDLE    */ { user_poll_fsm_default, user_poll_fsm_start,    user_poll_fsm_discard,  user_poll_fsm_default,  user_poll_fsm_default,  user_poll_fsm_default	},
+/* RUNNING */ { user_poll_fsm_default, user_poll_fsm_default,  user_poll_fsm_run,      user_poll_fsm_run,      user_poll_fsm_run,      user_poll_fsm_stop		},
+};
+#else
+/* Private variables */
+static uint8_t				user_poll_reply[USER_POLL_REPLY_MAX_SIZE];	/* Reply sent to the coordinator */
+static bool					user_poll_request_received;
+#endif /* IS_COORD */
+
+/* Private functions */
+
+#if IS_COORD
+
+/**
+ * @brief Computes the timeout of the next request sent to a device, from the round-trip times measured.
+ * @param device Pointer to the device, its number of attempts must be already updated.
+ * @retval Timeout of the request, in ms
+ */
+static uint32_t user_poll_device_timeout(const user_poll_device_t *device)
+{
+	uint32_t timeout;
+
+	if (user_poll_fsm.stats.srtt == 0)
+	{
+		timeout = USER_POLL_TIMEOUT_INITIAL;
+	}
+	else
+	{
+		timeout = user_poll_fsm.stats.srtt + (4 * user_poll_fsm.rttvar);
+	}
+
+	/* Devices at the same distance take about the same time to answer */
+	if (device->hops > 0)
+	{
+		const user_poll_hop_stats_t *hop_stats = &user_poll_fsm.stats.hop[USER_POLL_MIN(device->hops, USER_POLL_HOPS_MAX)];
+
+		if (hop_stats->replies > 0)
+		{
+			timeout = USER_POLL_MAX(timeout, 2 * hop_stats->rtt_sum / hop_stats->replies);
+		}
+	}
+
+	/* Doubles the timeout at each retry */
+	if (device->attempts > 1)
+	{
+		timeout <<= (device->attempts - 1);
+	}
+
+	return USER_POLL_MIN(USER_POLL_MAX(timeout, USER_POLL_TIMEOUT_MIN), USER_POLL_TIMEOUT_MAX);
+}
+
+/**
+ * @brief Finds a device of the sweep that waits for a reply.
+ * @param short_addr Short address of the device.
+ * @retval Pointer to the device, NULL if not found
+ */
+static user_poll_device_t* user_poll_find_device(const uint16_t short_addr)
+{
+	user_poll_device_t *found = NULL;
+
+	for (uint16_t i = 0; i < user_poll_fsm.device_num; i++)
+	{
+		user_poll_device_t *device = &user_poll_fsm.device[i];
+
+		/* A pending device can still get the reply of a request that timed out */
+		if ((device->short_addr == short_addr) && (device->state != USER_POLL_DEV_DONE) && (device->attempts > 0))
+		{
+			found = device;
+			break;
+		}
+	}
+
+	return found;
+}
+
+/**
+ * @brief Delivers the current batch of results to the callback.
+ * @param last Indicates that the sweep is over.
+ * @retval None
+ */
+static void user_poll_flush(const bool last)
+{
+	if ((user_poll_fsm.callback != NULL) && ((user_poll_fsm.batch_count > 0) || last))
+	{
+		user_poll_fsm.callback(user_poll_fsm.batch, user_poll_fsm.batch_count, last);
+	}
+
+	user_poll_fsm.batch_count = 0;
+}
+
+/**
+ * @brief Adds the result of a device to the batch, delivering it when full.
+ * @param device Pointer to the device.
+ * @param status Result of the polling.
+ * @param rtt Round-trip time of the request answered, in ms.
+ * @param packet Pointer to the reply of the device (NULL if there is no reply).
+ * @retval None
+ */
+static void user_poll_add_result(user_poll_device_t *device, const user_poll_status_t status, const uint32_t rtt, const udp_packet_t *packet)
+{
+	user_poll_result_t *result = &user_poll_fsm.batch[user_poll_fsm.batch_count++];
+
+	result->short_addr	= device->short_addr;
+	result->status		= status;
+	result->hops		= device->hops;
+	result->attempts	= device->attempts;
+	result->rtt			= rtt;
+	result->read_status	= user_poll_read_error;
+	result->length		= 0;
+
+	if ((packet != NULL) && (packet->length >= USER_POLL_REPLY_HEADER_SIZE))
+	{
+		const uint8_t *reply = packet->payload;
+
+		result->read_status	= reply[0];
+		result->length		= USER_POLL_MIN(packet->length - USER_POLL_REPLY_HEADER_SIZE, USER_POLL_REPLY_MAX_SIZE);
+		memcpy(result->data, &reply[USER_POLL_REPLY_HEADER_SIZE], result->length);
+	}
+
+	/* A reply without the meter data is a failure of the device */
+	if ((status == user_poll_ok) && (result->read_status != user_poll_read_ok))
+	{
+		result->status = user_poll_read_failed;
+	}
+
+	device->state = USER_POLL_DEV_DONE;
+	user_poll_fsm.device_done++;
+
+	if (result->status == user_poll_ok)
+	{
+		user_poll_fsm.stats.replied++;
+	}
+	else
+	{
+		user_poll_fsm.stats.failed++;
+	}
+
+	if (user_poll_fsm.batch_count == USER_POLL_BATCH_SIZE)
+	{
+		user_poll_flush(false);
+	}
+}
+
+/**
+ * @brief Updates the latency estimation and the window with a round-trip time measured.
+ * @param device Pointer to the device that replied.
+ * @param rtt Round-trip time, in ms.
+ * @retval None
+ */
+static void user_poll_update_latency(const user_poll_device_t *device, const uint32_t rtt)
+{
+	user_poll_stats_t		*stats		= &user_poll_fsm.stats;
+	user_poll_hop_stats_t	*hop_stats	= &stats->hop[USER_POLL_MIN(device->hops, USER_POLL_HOPS_MAX)];
+
+	/* Smoothed round-trip time and variation, as for TCP (RFC 6298) */
+	if (stats->srtt == 0)
+	{
+		stats->srtt				= rtt;
+		user_poll_fsm.rttvar	= rtt / 2;
+	}
+	else
+	{
+		uint32_t delta = (rtt > stats->srtt) ? (rtt - stats->srtt) : (stats->srtt - rtt);
+
+		user_poll_fsm.rttvar	= (3 * user_poll_fsm.rttvar + delta) / 4;
+		stats->srtt				= (7 * stats->srtt + rtt) / 8;
+	}
+
+	if ((user_poll_fsm.rtt_min == 0) || (rtt < user_poll_fsm.rtt_min))
+	{
+		user_poll_fsm.rtt_min = USER_POLL_MAX(rtt, 1);
+	}
+
+	/* Window sizing */
+	if ((rtt < USER_POLL_RTT_GROW_FACTOR * user_poll_fsm.rtt_min) && (stats->window < USER_POLL_WINDOW_MAX))
+	{
+		stats->window++;
+	}
+	else if ((rtt > USER_POLL_RTT_SHRINK_FACTOR * user_poll_fsm.rtt_min) && (stats->window > USER_POLL_WINDOW_MIN))
+	{
+		stats->window--;
+	}
+
+	/* Round-trip per hop count */
+	if ((hop_stats->replies == 0) || (rtt < hop_stats->rtt_min))
+	{
+		hop_stats->rtt_min = rtt;
+	}
+	if (rtt > hop_stats->rtt_max)
+	{
+		hop_stats->rtt_max = rtt;
+	}
+	hop_stats->rtt_sum += rtt;
+	hop_stats->replies++;
+}
+
+/**
+ * @brief Parses the replies received on the polling connection.
+ * @param None
+ * @retval None
+ */
+static void user_poll_parse_replies(void)
+{
+	udp_packet_t packet;
+
+	while (UserG3_DequeueUdpData(POLL_CONN_ID, &packet, 1) > 0)
+	{
+		uint16_t short_addr = ASSEMBLE_U16(packet.ip_addr.u8[14], packet.ip_addr.u8[15]);
+		user_poll_device_t *device = user_poll_find_device(short_addr);
+
+		if (device != NULL)
+		{
+			uint32_t rtt = HAL_GetTick() - device->sent_ts;
+
+			if (device->state == USER_POLL_DEV_WAITING)
+			{
+				user_poll_fsm.in_flight--;
+			}
+
+			user_poll_update_latency(device, rtt);
+			user_poll_add_result(device, user_poll_ok, rtt, &packet);
+		}
+		else
+		{
+			PRINT_USER_G3_WARNING("Unexpected poll reply from %u\n", short_addr);
+		}
+
+		UserG3_ReleaseUdpData(&packet);
+	}
+}
+
+/**
+ * @brief Handles the requests not answered in time, scheduling their retry.
+ * @param None
+ * @retval None
+ */
+static void user_poll_expire(void)
+{
+	uint32_t now = HAL_GetTick();
+
+	for (uint16_t i = 0; i < user_poll_fsm.device_num; i++)
+	{
+		user_poll_device_t *device = &user_poll_fsm.device[i];
+
+		if ((device->state == USER_POLL_DEV_WAITING) && ((now - device->sent_ts) >= device->timeout))
+		{
+			user_poll_fsm.in_flight--;
+			user_poll_fsm.stats.timeouts++;
+
+			/* Losses are handled as congestion */
+			user_poll_fsm.stats.window = USER_POLL_MAX(user_poll_fsm.stats.window / 2, USER_POLL_WINDOW_MIN);
+
+			if (device->attempts < USER_POLL_RETRIES_MAX)
+			{
+				PRINT_USER_G3_WARNING("Poll request %u to %u timed out\n", device->attempts, device->short_addr);
+
+				device->state = USER_POLL_DEV_PENDING;
+			}
+			else
+			{
+				PRINT_USER_G3_WARNING("Device %u did not reply to the poll\n", device->short_addr);
+
+				user_poll_add_result(device, (device->send_failed) ? user_poll_send_error : user_poll_timeout, 0, NULL);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Function called by the User G3 when a request is confirmed.
+ * @param connection_id ID of the connection of the request.
+ * @param handle Handle of the request.
+ * @param status Status of the G3UDP-DATA.Confirm.
+ * @retval None
+ */
+static void user_poll_tx_callback(const uint8_t connection_id, const uint8_t handle, const uint8_t status)
+{
+	UNUSED(connection_id);
+
+	user_poll_device_t *device;
+
+	for (uint16_t i = 0; i < user_poll_fsm.device_num; i++)
+	{
+		device = &user_poll_fsm.device[i];
+
+		if ((device->state == USER_POLL_DEV_WAITING) && (device->handle == handle))
+		{
+			device->send_failed = (status != G3_SUCCESS);
+
+			if (device->send_failed)
+			{
+				/* No reply can arrive, the request times out at once */
+				device->timeout = 0;
+
+				user_poll_fsm.curr_event = USER_POLL_EV_TIMEOUT;
+			}
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Sends the request to a device.
+ * @param device Pointer to the device.
+ * @retval True if the request was queued, false if the User G3 rejected it
+ */
+static bool user_poll_send(user_poll_device_t *device)
+{
+	ip6_addr_t	dst_ip_addr;
+	uint8_t		handle;
+
+	hi_ipv6_set_ipaddr(&dst_ip_addr, userg3_common.pan_id, device->short_addr);
+
+	handle = UserG3_SendUdpDataAsync(POLL_CONN_ID, dst_ip_addr, user_poll_fsm.request, user_poll_fsm.request_len, user_poll_tx_callback);
+
+	if (handle != 0)
+	{
+		device->handle		= handle;
+		device->state		= USER_POLL_DEV_WAITING;
+		device->sent_ts		= HAL_GetTick();
+		device->attempts++;
+		device->timeout		= user_poll_device_timeout(device);
+
+		user_poll_fsm.in_flight++;
+		user_poll_fsm.stats.requests++;
+
+		if (user_poll_fsm.in_flight > user_poll_fsm.stats.window_peak)
+		{
+			user_poll_fsm.stats.window_peak = user_poll_fsm.in_flight;
+		}
+	}
+
+	return (handle != 0);
+}
+
+/**
+ * @brief Sends the pending requests while the window has room.
+ * @param None
+ * @retval None
+ */
+static void user_poll_send_pending(void)
+{
+	for (uint16_t i = 0; (i < user_poll_fsm.device_num) && (user_poll_fsm.in_flight < user_poll_fsm.stats.window); i++)
+	{
+		user_poll_device_t *device = &user_poll_fsm.device[i];
+
+		if (device->state == USER_POLL_DEV_PENDING)
+		{
+			/* Back-pressure from the transmit queue of the User G3 */
+			if ((UserG3_GetUdpTxSpace(POLL_CONN_ID) == 0) || (!user_poll_send(device)))
+			{
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Requests the route of the next device with an unknown hop count (one G3LIB-GET.Request at a time).
+ * @param None
+ * @retval None
+ */
+static void user_poll_request_route(void)
+{
+	if ((user_poll_fsm.route_busy) && ((HAL_GetTick() - user_poll_fsm.route_ts) >= USER_POLL_ROUTE_TIMEOUT))
+	{
+		user_poll_fsm.route_busy = false;
+	}
+
+	if (!user_poll_fsm.route_busy)
+	{
+		for (uint16_t i = 0; i < user_poll_fsm.device_num; i++)
+		{
+			user_poll_device_t *device = &user_poll_fsm.device[i];
+
+			if ((device->hops == 0) && (!device->route_requested))
+			{
+				G3_LIB_GetAttributeRequest_t *get_req = MEMPOOL_MALLOC(sizeof(G3_LIB_GetAttributeRequest_t));
+
+				uint16_t len = hi_g3lib_getreq_fill(get_req, ADP_ROUTINGTABLE_BYSHORTADDR_ID, device->short_addr);
+				g3_send_message(HIF_TX_MSG, HIF_G3LIB_GET_REQ, get_req, len);
+
+				device->route_requested		= true;
+				user_poll_fsm.route_busy	= true;
+				user_poll_fsm.route_ts		= HAL_GetTick();
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Starts the timer for the request that times out first, or stops it if no request is in flight.
+ * @param None
+ * @retval None
+ */
+static void user_poll_restart_timer(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t timeout = 0;
+
+	for (uint16_t i = 0; i < user_poll_fsm.device_num; i++)
+	{
+		const user_poll_device_t *device = &user_poll_fsm.device[i];
+
+		if (device->state == USER_POLL_DEV_WAITING)
+		{
+			uint32_t elapsed	= now - device->sent_ts;
+			uint32_t remaining	= (elapsed < device->timeout) ? (device->timeout - elapsed) : 1;
+
+			if ((timeout == 0) || (remaining < timeout))
+			{
+				timeout = remaining;
+			}
+		}
+	}
+
+	if (timeout > 0)
+	{
+		osTimerStart(pollTimerHandle, timeout);
+	}
+	else
+	{
+		osTimerStop(pollTimerHandle);
+	}
+}
+
+/**
+ * @brief Prints the statistics of the sweep.
+ * @param None
+ * @retval None
+ */
+static void user_poll_print_stats(void)
+{
+	const user_poll_stats_t *stats = &user_poll_fsm.stats;
+
+	PRINT_USER_G3_INFO("Poll of %u devices done in %u ms: %u replied, %u failed, %u requests, %u timeouts, window peak %u\n",
+			stats->devices, stats->duration, stats->replied, stats->failed, stats->requests, stats->timeouts, stats->window_peak);
+
+	for (uint8_t i = 0; i <= USER_POLL_HOPS_MAX; i++)
+	{
+		const user_poll_hop_stats_t *hop_stats = &stats->hop[i];
+
+		if (hop_stats->replies > 0)
+		{
+			PRINT_USER_G3_INFO("\tHops %u%s: %u replies, RTT min/avg/max %u/%u/%u ms\n", i, (i == 0) ? " (unknown)" : "",
+					hop_stats->replies, hop_stats->rtt_min, hop_stats->rtt_sum / hop_stats->replies, hop_stats->rtt_max);
+		}
+	}
+}
+
+/**
+ * @brief Polling FSM function that maintains the current state, with no further action.
+ * @param None
+ * @retval The next state of the polling FSM (equal to the current one)
+ */
+static user_poll_state_t user_poll_fsm_default(void)
+{
+	user_poll_fsm.curr_event = USER_POLL_EV_NONE;
+
+	return user_poll_fsm.curr_state;
+}
+
+/**
+ * @brief Polling FSM function that discards the replies received after the end of a sweep.
+ * @param None
+ * @retval The next state of the polling FSM
+ */
+static user_poll_state_t user_poll_fsm_discard(void)
+{
+	udp_packet_t packet;
+
+	while (UserG3_DequeueUdpData(POLL_CONN_ID, &packet, 1) > 0)
+	{
+		UserG3_ReleaseUdpData(&packet);
+	}
+
+	user_poll_fsm.curr_event = USER_POLL_EV_NONE;
+
+	return USER_POLL_ST_IDLE;
+}
+
+/**
+ * @brief Polling FSM function that starts a sweep.
+ * @param None
+ * @retval The next state of the polling FSM
+ */
+static user_poll_state_t user_poll_fsm_start(void)
+{
+	PRINT_USER_G3_INFO("Polling %u devices\n", user_poll_fsm.device_num);
+
+	user_poll_fsm.start_ts = HAL_GetTick();
+
+	return user_poll_fsm_run();
+}
+
+/**
+ * @brief Polling FSM function that parses the replies, handles the timeouts and sends the next requests.
+ * @param None
+ * @retval The next state of the polling FSM
+ */
+static user_poll_state_t user_poll_fsm_run(void)
+{
+	user_poll_state_t next_state = USER_POLL_ST_RUNNING;
+
+	user_poll_parse_replies();
+	user_poll_expire();
+
+	if (user_poll_fsm.device_done < user_poll_fsm.device_num)
+	{
+		user_poll_send_pending();
+		user_poll_request_route();
+		user_poll_restart_timer();
+	}
+	else
+	{
+		osTimerStop(pollTimerHandle);
+
+		user_poll_fsm.stats.duration = HAL_GetTick() - user_poll_fsm.start_ts;
+
+		user_poll_print_stats();
+		user_poll_flush(true);
+
+		next_state = USER_POLL_ST_IDLE;
+	}
+
+	user_poll_fsm.curr_event = USER_POLL_EV_NONE;
+
+	return next_state;
+}
+
+/**
+ * @brief Polling FSM function that aborts a sweep, delivering the results already available.
+ * @param None
+ * @retval The next state of the polling FSM
+ */
+static user_poll_state_t user_poll_fsm_stop(void)
+{
+	osTimerStop(pollTimerHandle);
+
+	user_poll_fsm.stats.duration = HAL_GetTick() - user_poll_fsm.start_ts;
+	user_poll_fsm.in_flight		 = 0;
+
+	PRINT_USER_G3_WARNING("Poll aborted, %u devices out of %u done\n", user_poll_fsm.device_done, user_poll_fsm.device_num);
+
+	user_poll_flush(true);
+
+	return user_poll_fsm_discard();
+}
+
+/**
+ * @brief Handles the reception of a G3LIB-GET.Confirm, which carries the route to a device.
+ * @param payload Pointer to the payload of the received message.
+ * @retval None
+ */
+static void user_poll_handle_get_cnf(const void *payload)
+{
+	const G3_LIB_GetAttributeConfirm_t *get_cnf = payload;
+	assert(get_cnf != NULL);
+
+	if ((user_poll_fsm.curr_state == USER_POLL_ST_RUNNING) && (get_cnf->attribute.attribute_id.id == ADP_ROUTINGTABLE_BYSHORTADDR_ID))
+	{
+		user_poll_fsm.route_busy = false;
+
+		if (get_cnf->status == G3_SUCCESS)
+		{
+			ADP_RoutingTableEntry_t route;
+
+			memcpy(&route, get_cnf->attribute.value, sizeof(route));
+
+			for (uint16_t i = 0; i < user_poll_fsm.device_num; i++)
+			{
+				if (user_poll_fsm.device[i].short_addr == get_cnf->attribute.attribute_id.index)
+				{
+					user_poll_fsm.device[i].hops = route.HopCount;
+					break;
+				}
+			}
+		}
+
+		user_poll_fsm.curr_event = USER_POLL_EV_ROUTE_CNF;
+	}
+}
+
+#else
+
+/**
+ * @brief Builds the reply to a request of the coordinator: the status of the meter reading, followed by the data read.
+ * @param request Pointer to the request.
+ * @param length Length of the request, in bytes.
+ * @param reply Pointer to the buffer of the reply (USER_POLL_REPLY_MAX_SIZE bytes).
+ * @retval Length of the reply, in bytes
+ */
+static uint16_t user_poll_build_reply(const uint8_t *request, const uint16_t length, uint8_t *reply)
+{
+	uint16_t data_len = USER_POLL_REPLY_MAX_SIZE - USER_POLL_REPLY_HEADER_SIZE;
+	user_poll_read_status_t status = UserPoll_ReadMeter(request, length, &reply[USER_POLL_REPLY_HEADER_SIZE], &data_len);
+
+	if (status != user_poll_read_ok)
+	{
+		PRINT_USER_G3_WARNING("Meter not read (status %u)\n", status);
+		data_len = 0;
+	}
+
+	reply[0] = (uint8_t) status;
+
+	return USER_POLL_REPLY_HEADER_SIZE + USER_POLL_MIN(data_len, USER_POLL_REPLY_MAX_SIZE - USER_POLL_REPLY_HEADER_SIZE);
+}
+
+/**
+ * @brief Answers the requests received from the coordinator.
+ * @param None
+ * @retval None
+ */
+static void user_poll_answer(void)
+{
+	udp_packet_t packet;
+
+	while (UserG3_DequeueUdpData(POLL_CONN_ID, &packet, 1) > 0)
+	{
+		uint16_t reply_len = user_poll_build_reply(packet.payload, packet.length, user_poll_reply);
+
+		if (UserG3_SendUdpData(POLL_CONN_ID, packet.ip_addr, user_poll_reply, reply_len) == 0)
+		{
+			PRINT_USER_G3_WARNING("Poll reply not sent\n");
+		}
+
+		UserG3_ReleaseUdpData(&packet);
+	}
+}
+
+#endif /* IS_COORD */
+
+/**
+ * @}
+ */
+
+/** @addtogroup User_Poll_Exported_Code
+ * @{
+ */
+
+/**
+ * @brief Function that handles the initialization of the polling.
+ * @param None
+ * @retval None
+ */
+void UserPoll_Init(void)
+{
+#if IS_COORD
+	memset(&user_poll_fsm, 0, sizeof(user_poll_fsm));
+
+	user_poll_fsm.curr_state	= USER_POLL_ST_IDLE;
+	user_poll_fsm.curr_event	= USER_POLL_EV_NONE;
+	user_poll_fsm.stats.window	= USER_POLL_WINDOW_MIN;
+#else
+	user_poll_request_received	= false;
+#endif
+}
+
+/**
+ * @brief Function that checks if a message is needed by the polling.
+ * @param g3_msg Pointer to the G3 message structure to evaluate
+ * @return 'true' if the message is needed, 'false' otherwise.
+ */
+bool UserPoll_MsgNeeded(const g3_msg_t *g3_msg)
+{
+	switch(g3_msg->command_id)
+	{
+	case HIF_UDP_DATA_IND:
+#if IS_COORD
+	case HIF_G3LIB_GET_CNF:
+#endif
+		return true;
+		break;
+	default:
+		return false;
+		break;
+	}
+}
+
+/**
+ * @brief Function that handles the G3 messages coming from the G3 task.
+ * @param g3_msg Pointer to the received G3 message
+ * @retval None
+ */
+void UserPoll_MsgHandler(const g3_msg_t *g3_msg)
+{
+	assert(g3_msg->payload != NULL); /* All expected messages have payload */
+
+	switch (g3_msg->command_id)
+	{
+	case HIF_UDP_DATA_IND:
+		/* The packet is queued by the User G3, it is taken from the polling connection by the FSM */
+#if IS_COORD
+		user_poll_fsm.curr_event = USER_POLL_EV_UDP_IND;
+#else
+		user_poll_request_received = true;
+#endif
+		break;
+#if IS_COORD
+	case HIF_G3LIB_GET_CNF:
+		user_poll_handle_get_cnf(g3_msg->payload);
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Function that handles the state of the polling FSM.
+ * @param None
+ * @retval None
+ * @note Entry function called from User task infinite execution loop.
+ */
+void UserPoll_FsmManager(void)
+{
+#if IS_COORD
+	user_poll_fsm.operation_counter++;
+
+	user_poll_fsm.curr_state = user_poll_fsm_func_tbl[user_poll_fsm.curr_state][user_poll_fsm.curr_event]();
+#else
+	if (user_poll_request_received)
+	{
+		user_poll_request_received = false;
+
+		user_poll_answer();
+	}
+#endif
+}
+
+#if IS_COORD
+/**
+ * @brief Function that starts the polling of a list of devices.
+ * @param short_addr_list Array with the short addresses of the devices to poll
+ * @param device_num Number of devices in the array (1 - USER_POLL_MAX_DEVICES)
+ * @param request Pointer to the request sent to each device
+ * @param length Length of the request, in bytes (1 - USER_POLL_REQUEST_MAX_SIZE)
+ * @param callback Function called with each batch of results (can be NULL, to get the statistics only)
+ * @retval True if the sweep was started, false otherwise
+ */
+bool UserPoll_Start(const uint16_t *short_addr_list, const uint16_t device_num, const void *request, const uint16_t length, user_poll_batch_cb_t *callback)
+{
+	bool started = false;
+
+	if (user_poll_fsm.curr_state != USER_POLL_ST_IDLE)
+	{
+		PRINT_USER_G3_WARNING("Poll already in progress\n");
+	}
+	else if ((device_num == 0) || (device_num > USER_POLL_MAX_DEVICES) || (length == 0) || (length > USER_POLL_REQUEST_MAX_SIZE))
+	{
+		PRINT_USER_G3_CRITICAL("Invalid poll parameters (%u devices, request of %u bytes)\n", device_num, length);
+	}
+	else
+	{
+		assert(short_addr_list != NULL);
+		assert(request != NULL);
+
+		memset(user_poll_fsm.device, 0, sizeof(user_poll_fsm.device));
+
+		for (uint16_t i = 0; i < device_num; i++)
+		{
+			user_poll_fsm.device[i].short_addr	= short_addr_list[i];
+			user_poll_fsm.device[i].state		= USER_POLL_DEV_PENDING;
+		}
+
+		memcpy(user_poll_fsm.request, request, length);
+
+		user_poll_fsm.request_len	= length;
+		user_poll_fsm.device_num	= device_num;
+		user_poll_fsm.device_done	= 0;
+		user_poll_fsm.in_flight		= 0;
+		user_poll_fsm.callback		= callback;
+		user_poll_fsm.batch_count	= 0;
+		user_poll_fsm.route_busy	= false;
+
+		/* The latency measured in the previous sweeps is kept */
+		user_poll_fsm.stats.devices		= device_num;
+		user_poll_fsm.stats.replied		= 0;
+		user_poll_fsm.stats.failed		= 0;
+		user_poll_fsm.stats.requests	= 0;
+		user_poll_fsm.stats.timeouts	= 0;
+		user_poll_fsm.stats.duration	= 0;
+		user_poll_fsm.stats.window_peak	= 0;
+		memset(user_poll_fsm.stats.hop, 0, sizeof(user_poll_fsm.stats.hop));
+
+		user_poll_fsm.curr_event = USER_POLL_EV_START;
+
+		UserG3_RequestFsmExecution(user_poll_fsm.operation_counter);
+
+		started = true;
+	}
+
+	return started;
+}
+
+/**
+ * @brief Function that starts the polling of all devices connected to the PAN.
+ * @param request Pointer to the request sent to each device
+ * @param length Length of the request, in bytes (1 - USER_POLL_REQUEST_MAX_SIZE)
+ * @param callback Function called with each batch of results (can be NULL, to get the statistics only)
+ * @retval True if the sweep was started, false otherwise
+ */
+bool UserPoll_StartConnected(const void *request, const uint16_t length, user_poll_batch_cb_t *callback)
+{
+	uint16_t short_addr_list[USER_POLL_MAX_DEVICES];
+	uint16_t device_num = 0;
+
+	for (uint16_t i = 0; i < BOOT_MAX_NUM_JOINING_NODES; i++)
+	{
+		if (boot_server.connected_devices[i].conn_state == boot_state_connected)
+		{
+			short_addr_list[device_num++] = boot_server.connected_devices[i].short_addr;
+		}
+	}
+
+	return UserPoll_Start(short_addr_list, device_num, request, length, callback);
+}
+
+/**
+ * @brief Function that aborts the current sweep.
+ * @param None
+ * @retval None
+ */
+void UserPoll_Stop(void)
+{
+	user_poll_fsm.curr_event = USER_POLL_EV_STOP;
+
+	RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+}
+
+/**
+ * @brief Function that checks if a sweep is in progress.
+ * @param None
+ * @retval True if a sweep is in progress, false otherwise
+ */
+bool UserPoll_InProgress(void)
+{
+	return (user_poll_fsm.curr_state != USER_POLL_ST_IDLE);
+}
+
+/**
+ * @brief Function that gets the statistics of the last sweep.
+ * @param stats Pointer to the structure where the statistics are copied
+ * @retval None
+ */
+void UserPoll_GetStats(user_poll_stats_t *stats)
+{
+	assert(stats != NULL);
+
+	*stats = user_poll_fsm.stats;
+}
+
+/**
+ * @brief Callback function of the pollTimer FreeRTOS timer.
+ * @param argument Unused argument.
+ * @retval None
+ */
+void UserPoll_TimeoutCallback(void *argument)
+{
+	UNUSED(argument);
+
+	user_poll_fsm.curr_event = USER_POLL_EV_TIMEOUT;
+
+	RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+}
+#else
+
+/**
+ * @brief Reads the meter attached to the device, to answer a request of the coordinator.
+ * @param request Pointer to the request of the coordinator.
+ * @param length Length of the request, in bytes.
+ * @param data Pointer to the buffer of the data read.
+ * @param data_len Pointer to the size of the buffer, in bytes, set to the length of the data read.
+ * @return Status of the reading, user_poll_read_no_reader if no meter reader is configured.
+ * @note Redefine this function to read the meter (e.g. through the Modbus master).
+ */
+__weak user_poll_read_status_t UserPoll_ReadMeter(const uint8_t *request, const uint16_t length, uint8_t *data, uint16_t *data_len)
+{
+	UNUSED(request);
+	UNUSED(length);
+	UNUSED(data);
+
+	*data_len = 0;
+
+	return user_poll_read_no_reader;
+}
+#endif /* IS_COORD */
+
+#endif /* ENABLE_METER_POLLING */
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/*********************** (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -21,6 +21,7 @@
 #include <debug_print.h>
 #include <pin_management.h>
 #include <utils.h>
+#include <user_bench.h>
 #include <user_g3_common.h>
 #include <user_image_transfer.h>
 #include <user_mac.h>
@@ -70,11 +71,6 @@ static void user_msg_handler(g3_msg_t *g3_msg)
 	if ((working_plc_mode == PLC_MODE_IPV6_BOOT) || (working_plc_mode == PLC_MODE_IPV6_ADP))
 	{
 		/* Forwards the message to the modules that need it */
-		if (UserG3_MsgNeeded(g3_msg))
-		{
-			/* Forwards the message to the User G3 */
-			UserG3_MsgHandler(g3_msg);
-		}
 #if ENABLE_IMAGE_TRANSFER
 		if (UserImgTransfer_MsgNeeded(g3_msg))
 		{
@@ -82,6 +78,15 @@ static void user_msg_handler(g3_msg_t *g3_msg)
 			UserImgTransfer_MsgHandler(g3_msg);
 		}
 #endif
+		/* Forwards the message to the User applications on the UDP connections (User Poll, User Bench, User Modbus Gateway) */
+		UserG3_AppsMsgHandler(g3_msg);
+
+		/* The User G3 must be the last one, it can take the payload of the UDP data indications */
+		if (UserG3_MsgNeeded(g3_msg))
+		{
+			/* Forwards the message to the User G3 */
+			UserG3_MsgHandler(g3_msg);
+		}
 	}
 	else if (working_plc_mode == PLC_MODE_MAC)
 	{
@@ -131,11 +136,18 @@ void user_app_init(void)
 		/* Initialize User Image Transfer */
 		UserImgTransfer_Init();
 #endif
+		/* Initialize the User applications on the UDP connections */
+		UserG3_AppsInit();
 	}
 	else if (working_plc_mode == PLC_MODE_MAC)
 	{
 		/* Initialize User MAC */
 		UserMac_Init();
+
+#if ENABLE_BENCHMARK
+		/* Initialize User Bench (runs the MAC benchmark) */
+		UserBench_Init();
+#endif
 	}
 
 	/* Add here more initializations for the User task */
@@ -185,6 +197,7 @@ void user_app_exec(void)
 #if ENABLE_IMAGE_TRANSFER
     			UserImgTransfer_FsmManager();	/* User Image transfer */
 #endif
+    			UserG3_AppsFsmManager();		/* User applications on the UDP connections */
     		}
     		else if (working_plc_mode == PLC_MODE_MAC)
     		{
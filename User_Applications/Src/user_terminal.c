@@ -27,6 +27,8 @@
 #include <g3_app_config.h>
 #include <g3_app_keep_alive.h>
 #include <g3_app_last_gasp.h>
+#include <g3_boot_access_tbl.h>
+#include <user_bench.h>
 #include <user_g3_common.h>
 #include <user_image_transfer.h>
 #include <user_mac.h>
@@ -56,6 +58,10 @@
 #define STR_PLC_LEN															3
 #define STR_RF_LEN															2
 #define DEFAULT_TEST_MSG_NUMBER												10
+#define STR_GEN_PREFIX														"GEN."
+#define STR_GEN_PREFIX_LEN													4
+#define DEFAULT_GEN_FRAME_SIZE												100
+#define DEFAULT_GEN_FRAME_NUMBER											100
 
 /* UDP tests */
 
@@ -112,6 +118,7 @@ typedef enum user_term_option_enum
 	user_term_opt_fast_restore,
 #else
 	user_term_opt_rekeying,
+	user_term_opt_access_list,
 #endif
 	user_term_opt_reset,
 	user_term_opt_count
@@ -124,6 +131,9 @@ typedef enum user_term_state_enum
 	USER_TERM_ST_MAIN,       		/*!< User Terminal state for test main */
 	USER_TERM_ST_TESTS,       		/*!< User Terminal state for UDP test selection */
 	USER_TERM_ST_TEST_EXEC,			/*!< User Terminal state for UDP test execution */
+#if ENABLE_BENCHMARK
+	USER_TERM_ST_BENCHMARK,			/*!< User Terminal state for the scripted benchmark */
+#endif
 	USER_TERM_ST_DIPLAY_CONNECTION,	/*!< User Terminal state for UDP connection setup */
 	USER_TERM_ST_DIPLAY_DEVICES,	/*!< User Terminal state for connected device */
 #if ENABLE_IMAGE_TRANSFER
@@ -140,6 +150,9 @@ typedef enum user_term_state_enum
 #endif
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_REKEYING
 	USER_TERM_ST_REKEYING,			/*!< User Terminal state for GMK update/Re-keying */
+#endif
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+	USER_TERM_ST_ACCESS_LIST,		/*!< User Terminal state for the access list management */
 #endif
 	USER_TERM_ST_RESET,				/*!< User Terminal state for system reset */
 	USER_TERM_ST_CNT
@@ -175,6 +188,7 @@ typedef enum user_term_transfer_step_enum
 	USER_TERM_TRANSFERSTEP_0,		/* Select TX/RX | Memory check */
 	USER_TERM_TRANSFERSTEP_0bis,	/* Display instruction */
 	USER_TERM_TRANSFERSTEP_1,		/* TX | Select SFLASH slot */
+	USER_TERM_TRANSFERSTEP_1bis,	/* TX | Select window size */
 	USER_TERM_TRANSFERSTEP_2, 		/* RX | Ask for confirmation */
 	USER_TERM_TRANSFERSTEP_3,		/* Get confirmation */
 	USER_TERM_TRANSFERSTEP_4,		/* Send/receive image info REQ */
@@ -186,6 +200,17 @@ typedef enum user_term_transfer_step_enum
 	USER_TERM_TRANSFERSTEP_ack,	/* Sends acknowledge (recipient only) */
 } user_term_transfer_step_t;
 
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+/* For access list management */
+typedef enum user_term_access_step_enum
+{
+	USER_TERM_ACCESSSTEP_SELECT,		/* Select addition/removal */
+	USER_TERM_ACCESSSTEP_EXT_ADDR,		/* Get the extended address */
+	USER_TERM_ACCESSSTEP_SHORT_ADDR,	/* Addition | Get the short address (white list mode) */
+	USER_TERM_ACCESSSTEP_PSK,			/* Addition | Get the PSK (white list mode) */
+} user_term_access_step_t;
+#endif
+
 /* For multiple test */
 typedef enum user_term_test_type_enum
 {
@@ -246,8 +271,20 @@ typedef struct user_term_transfer_str
 	uint32_t	image_validity;
 	uint32_t	image_size;
 	uint16_t	image_crc16;
+
+	/* Transfer parameters */
+	uint8_t		selected_slot;
 } user_term_transfer_t;
 
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+typedef struct user_term_access_str
+{
+	user_term_access_step_t	access_step;
+	bool					remove;
+	g3_boot_data_t			entry;
+} user_term_access_t;
+#endif
+
 /* Private variables ---------------------------------------------------------*/
 static const char *pString_NoSuitableAnswerFound = "Invalid entry! Please retry...\n";
 static const char *pString_Offline               = "You need to connect the device to a PAN to use this feature\n";
@@ -268,6 +305,9 @@ static user_term_fsm_t			user_term_fsm;
 static user_term_test_t			user_term_test;
 static user_term_mult_test_t	user_term_mult_test;
 static user_term_transfer_t		user_term_transfer;
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+static user_term_access_t		user_term_access;
+#endif
 
 static user_term_displayed_event_t user_term_displayed_event[USEREVT_G3_NUMBER] = {
 		/* string,                      color, 			displayed */
@@ -383,6 +423,86 @@ static uint16_t user_term_convert_str_to_hex(uint8_t* dst_buff, uint16_t dst_buf
 	return len;
 }
 
+/**
+  * @brief Parses the command of the MAC traffic generator, "GEN.MAC_ADDRESS.PLC|RF|PLCRF.FRAME_SIZE.FRAME_NUMBER.RATE".
+  * @param command NUL-terminated command string (modified by the parsing).
+  * @param params Pointer to the parameters to fill.
+  * @retval True if the extended address is valid, false otherwise (the other fields have defaults).
+  */
+static bool user_term_parse_generator(char *command, usermac_gen_params_t *params)
+{
+	bool     valid = false;
+	uint32_t len   = 0;
+
+	params->media		= mac_test_plc;
+	params->frame_size	= DEFAULT_GEN_FRAME_SIZE;
+	params->frame_n		= DEFAULT_GEN_FRAME_NUMBER;
+	params->rate		= 0;
+
+	/* Skips the prefix */
+	char *token = strtok(command + STR_GEN_PREFIX_LEN, ASCII_DELIMITER);
+
+	if ((token != NULL) && (strlen(token) == (2 * MAC_ADDR64_SIZE)))
+	{
+		for (len = 0; len < MAC_ADDR64_SIZE; len++)
+		{
+			uint8_t hbyte = token[2*len];
+			uint8_t lbyte = token[2*len+1];
+
+			if (IS_HEX_DIGIT(hbyte) && IS_HEX_DIGIT(lbyte))
+			{
+				params->dst_addr[len] = ASSEMBLE_U8(CONVERT_ASCII_TO_HEX(hbyte), CONVERT_ASCII_TO_HEX(lbyte));
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		valid = (len == MAC_ADDR64_SIZE);
+	}
+
+	if (valid)
+	{
+		token = strtok(NULL, ASCII_DELIMITER);
+
+		if (token != NULL)
+		{
+			if (strncmp(token, "PLCRF", STR_PLCRF_LEN) == 0)
+			{
+				params->media = mac_test_plc_rf;
+			}
+			else if (strncmp(token, "RF", STR_RF_LEN) == 0)
+			{
+				params->media = mac_test_rf;
+			}
+
+			token = strtok(NULL, ASCII_DELIMITER);
+		}
+
+		if (token != NULL)
+		{
+			params->frame_size = atoi(token);
+
+			token = strtok(NULL, ASCII_DELIMITER);
+		}
+
+		if (token != NULL)
+		{
+			params->frame_n = atoi(token);
+
+			token = strtok(NULL, ASCII_DELIMITER);
+		}
+
+		if (token != NULL)
+		{
+			params->rate = atoi(token);
+		}
+	}
+
+	return valid;
+}
+
 /**
  * @brief Starts counting for the timeout of a transfer operation.
  * @param timeout The timeout value for the operation.
@@ -460,6 +580,10 @@ static void user_term_reset_to_state(user_term_state_t new_state)
 
 	UserG3_AbortUdpDataLoopback();
 
+#if ENABLE_BENCHMARK
+	UserBench_Stop();
+#endif
+
 	if (osTimerIsRunning(userTimeoutTimerHandle))
 	{
 		user_term_remove_timeout();
@@ -1217,6 +1341,7 @@ static void user_term_udp_test_multicast_tx(void)
 static void user_term_udp_transfer_tx(void)
 {
 	uint8_t selected_slot;
+	uint32_t window_size;
 	user_input_t * user_input = NULL;
 
 	switch (user_term_transfer.transfer_sub_step)
@@ -1261,19 +1386,55 @@ static void user_term_udp_transfer_tx(void)
 			if (selection_valid)
 			{
 				PRINT_BLANK_LINE();
-				PRINT("Selected slot %u, starting image transfer...\n", selected_slot + 1);
+				PRINT("Selected slot %u.\n", selected_slot + 1);
+
+				user_term_transfer.selected_slot = selected_slot;
+
+				if (user_term_fsm.dest_short_addr == MAC_BROADCAST_SHORT_ADDR)
+				{
+					PRINT("Starting multicast image transfer...\n");
+
+					/* Silences event display */
+					user_term_displayed_event[USEREVT_G3_UDP_DATA_CNF].displayed = 0;
+					user_term_displayed_event[USEREVT_G3_UDP_DATA_IND].displayed = 0;
+
+					user_term_transfer.transfer_sub_step = USER_TERM_TRANSFERSTEP_2;
+					UserImgTransfer_StartMulticast(selected_slot);
+				}
+				else
+				{
+					PRINT("Type the window size (1 - %u), then ENTER (press only ENTER for default: %u)\n", USER_IMG_TRANSFER_WINDOW_MAX, USER_IMG_TRANSFER_WINDOW_DEFAULT);
+
+					user_term_transfer.transfer_sub_step = USER_TERM_TRANSFERSTEP_1bis;
+				}
+			}
+			else
+			{
+				user_term_transfer.transfer_sub_step = USER_TERM_TRANSFERSTEP_0bis;
+				RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+			}
+		}
+		break;
+	case USER_TERM_TRANSFERSTEP_1bis:
+		user_input = user_if_get_input();
+		if (PARSE_CMD_ANY_CHAR)
+		{
+			window_size = user_term_assign_user_value(user_input, USER_IMG_TRANSFER_WINDOW_DEFAULT, "window size", false);
+
+			if ((window_size > 0) && (window_size <= USER_IMG_TRANSFER_WINDOW_MAX))
+			{
+				PRINT("Starting image transfer...\n");
 
 				/* Silences event display */
 				user_term_displayed_event[USEREVT_G3_UDP_DATA_CNF].displayed = 0;
 				user_term_displayed_event[USEREVT_G3_UDP_DATA_IND].displayed = 0;
 
 				user_term_transfer.transfer_sub_step = USER_TERM_TRANSFERSTEP_2;
-				UserImgTransfer_StartSend(selected_slot, user_term_fsm.dest_short_addr);
+				UserImgTransfer_StartSend(user_term_transfer.selected_slot, user_term_fsm.dest_short_addr, (uint8_t) window_size);
 			}
 			else
 			{
-				user_term_transfer.transfer_sub_step = USER_TERM_TRANSFERSTEP_0bis;
-				RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+				PRINT("Invalid window size, type a value between 1 and %u\n", USER_IMG_TRANSFER_WINDOW_MAX);
 			}
 		}
 		break;
@@ -1519,6 +1680,9 @@ static void user_term_state_main_menu(user_term_action_t action)
 #endif
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_REKEYING
 		PRINT("%u) Update GMK\n",            		user_term_opt_rekeying);
+#endif
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+		PRINT("%u) Access list\n",            		user_term_opt_access_list);
 #endif
 		PRINT("%u) Reset\n",						user_term_opt_reset);
 		/* Append other tests to the related menu here... */
@@ -1570,6 +1734,11 @@ static void user_term_state_main_menu(user_term_action_t action)
 			case user_term_opt_rekeying:
 				user_term_set_state(USER_TERM_ST_REKEYING);
 				break;
+#endif
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+			case user_term_opt_access_list:
+				user_term_set_state(USER_TERM_ST_ACCESS_LIST);
+				break;
 #endif
 			case user_term_opt_reset:
 				user_term_set_state(USER_TERM_ST_RESET);
@@ -1602,6 +1771,9 @@ static void user_term_state_test(user_term_action_t action)
 			PRINT("2) Multiple basic UDP tests\n");
 			PRINT("3) Loopback UDP test\n");
 			PRINT("4) Multicast UDP test\n");
+#if ENABLE_BENCHMARK
+			PRINT("5) Scripted benchmark (UDP loopback/ICMP echo, CSV results)\n");
+#endif
 
 			user_term_test.test_type = test_type_none;
 		}
@@ -1626,6 +1798,12 @@ static void user_term_state_test(user_term_action_t action)
 			{
 				user_term_test.test_type = test_type_multicast;
 			}
+#if ENABLE_BENCHMARK
+			else if (PARSE_CMD_CHAR('5'))
+			{
+				user_term_set_state(USER_TERM_ST_BENCHMARK);
+			}
+#endif
 			else if (PARSE_CMD_ANY_CHAR)
 			{
 				PRINT(pString_NoSuitableAnswerFound);
@@ -1806,6 +1984,44 @@ static void user_term_state_test_exec(user_term_action_t action)
 	}
 }
 
+#if ENABLE_BENCHMARK
+/**
+ * @brief User Terminal implementation for the scripted benchmark, driven by a single command line.
+ * @param action Type of action to run.
+ * @retval None
+ */
+static void user_term_state_benchmark(user_term_action_t action)
+{
+	user_input_t * user_input = NULL;
+
+	if (action == USER_TERM_ACT_DISPMENU)
+	{
+		PRINT_BLANK_LINE();
+		PRINT("<<< Scripted benchmark >>>\n\n");
+
+		UserBench_PrintUsage();
+		PRINT("Type the command line, then ENTER\n");
+	}
+	else if (!UserBench_InProgress()) /* if (action == USER_TERM_ACT_PROCSEL) */
+	{
+		user_input = user_if_get_input();
+
+		if (PARSE_CMD_ANY_CHAR)
+		{
+			char command[USERIF_INPUT_MAX_SIZE + 1];
+			user_bench_params_t params;
+
+			memcpy(command, user_input->payload, user_input->length);
+			command[user_input->length] = '\0';
+
+			if (UserBench_ParseCommand(command, &params) && UserBench_Start(&params))
+			{
+				PRINT("Benchmark started, the next command line can be typed at its end\n");
+			}
+		}
+	}
+}
+#endif
 
 /**
  * @brief User Terminal implementation for printing the UDP connection information.
@@ -1870,6 +2086,12 @@ static void user_term_state_print_device_list(user_term_action_t action)
 #if IS_COORD
 		PRINT("Coordinator - PAN ID: %X, short address: 0\n\n", userg3_common.pan_id);
 		user_term_print_device_list();
+#if ENABLE_ICMP_KEEP_ALIVE
+		ka_stats_t ka_stats;
+
+		g3_app_ka_get_stats(&ka_stats);
+		PRINT("Keep-Alive: %u pings sent, %u pings avoided (%u refreshes by inbound traffic)\n\n", ka_stats.pings_sent, ka_stats.pings_avoided, ka_stats.traffic_refreshes);
+#endif /* ENABLE_ICMP_KEEP_ALIVE */
 #else /* IS_COORD */
 		PRINT("This device - PAN ID: %X, short address: %u.\n", userg3_common.pan_id, userg3_common.device_addr);
 #endif /* IS_COORD */
@@ -1911,6 +2133,7 @@ static void user_term_state_transfer(user_term_action_t action)
 
 				if (device_count > 0)
 				{
+					PRINT("Type %u to send the image to all devices (multicast).\n", MAC_BROADCAST_SHORT_ADDR);
 					PRINT(pString_TypeDestinationAddr, default_value);
 				}
 				else
@@ -1941,7 +2164,14 @@ static void user_term_state_transfer(user_term_action_t action)
 					/* Acquires destination */
 					user_term_fsm.dest_short_addr = user_term_assign_user_value(user_input, default_value, "destination short address", false);
 
-					if ((user_term_fsm.dest_short_addr != COORD_ADDRESS) && (user_term_fsm.dest_short_addr < MAC_BROADCAST_SHORT_ADDR))
+					if (user_term_fsm.dest_short_addr == MAC_BROADCAST_SHORT_ADDR)
+					{
+						/* Multicast to all devices */
+						user_term_fsm.req_step = USER_TERM_EXECUTE;
+
+						RTOS_PUT_MSG(user_queueHandle, USER_MSG, NULL);
+					}
+					else if ((user_term_fsm.dest_short_addr != COORD_ADDRESS) && (user_term_fsm.dest_short_addr < MAC_BROADCAST_SHORT_ADDR))
 					{
 						/* Kick device */
 						boot_device_t* recipient_device = g3_app_boot_find_device(NULL, user_term_fsm.dest_short_addr, boot_state_connected);
@@ -2001,8 +2231,11 @@ static void user_term_state_erase_sflash(user_term_action_t action)
 		PRINT("<< SFLASH management >>");
 		PRINT_BLANK_LINE();
 		checkMemoryContent(user_term_transfer.slot);
-		PRINT("Press 'y' then ENTER to erase all slots (1 - 4)\n");
+		PRINT("Press 'y' then ENTER to erase all slots (1 - 4), with their progress records, staging area and load record\n");
 		PRINT("Press '1', '2', '3', '4', then ENTER to erase a single slot\n");
+#if IS_COORD
+		PRINT("Press 'b' then ENTER to erase the Boot Server data (re-keying record, device log and access list)\n");
+#endif
 		PRINT("Press 'm' then ENTER to erase the NVM\n");
 		PRINT("Press 'n' then ENTER to abort\n");
 	}
@@ -2013,7 +2246,7 @@ static void user_term_state_erase_sflash(user_term_action_t action)
 		/* Parse received command: */
 		if (PARSE_CMD_CHAR('y'))
 		{
-			PRINT("Erasing all flash memory slots...\n");
+			PRINT("Erasing all image slots, progress records, staging area and load record...\n");
 
 			if (eraseMemory() == true)
 			{
@@ -2043,6 +2276,23 @@ static void user_term_state_erase_sflash(user_term_action_t action)
 
 			user_term_reset_to_state(USER_TERM_ST_MAIN);
 		}
+#if IS_COORD
+		else if (PARSE_CMD_CHAR('b'))
+		{
+			PRINT("Erasing the Boot Server data...\n");
+			utils_delay_ms(10); /* Gives time slice to the print task */
+			if (g3_app_boot_erase_sflash() == true)
+			{
+				PRINT("Erasure complete\n");
+			}
+			else
+			{
+				PRINT("Erasure failed\n");
+			}
+
+			user_term_reset_to_state(USER_TERM_ST_MAIN);
+		}
+#endif
 		else if (PARSE_CMD_CHAR('m'))
 		{
 			hif_nvm_req_t *hif_nvm_req = MEMPOOL_MALLOC(sizeof(hif_nvm_req_t)); /* Uses memory pool due to big structure size */
@@ -2385,6 +2635,158 @@ static void user_term_state_rekeying(user_term_action_t action)
 }
 #endif /* IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_REKEYING */
 
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+/**
+ * @brief Adds the acquired entry to the access list, then goes back to the main menu.
+ * @param None
+ * @retval None
+ */
+static void user_term_access_list_add(void)
+{
+	ALLOC_STATIC_HEX_STRING(ext_addr_str, user_term_access.entry.ext_addr, sizeof(user_term_access.entry.ext_addr));
+
+	if (g3_boot_access_table_add(&user_term_access.entry))
+	{
+		PRINT("Entry %s added (%u entries)\n", ext_addr_str, g3_boot_access_table_count());
+	}
+	else
+	{
+		PRINT("Could not add entry %s\n", ext_addr_str);
+	}
+
+	user_term_set_state(USER_TERM_ST_MAIN);
+}
+
+/**
+ * @brief User Terminal implementation for the access list management.
+ * @param action Type of action to run
+ * @retval None
+ */
+static void user_term_state_access_list(user_term_action_t action)
+{
+	user_input_t * user_input = NULL;
+
+	if (action == USER_TERM_ACT_DISPMENU)
+	{
+		PRINT_BLANK_LINE();
+		PRINT("<< Access list >>\n\n");
+
+#if (SELECTED_LIST_MODE == BLACK_LIST_MODE)
+		PRINT("Black list mode, %u entries in the SFLASH\n", g3_boot_access_table_count());
+#else
+		PRINT("White list mode, %u entries in the SFLASH\n", g3_boot_access_table_count());
+#endif
+		PRINT("1) Add/update entry\n");
+		PRINT("2) Remove entry\n");
+
+		user_term_access.access_step = USER_TERM_ACCESSSTEP_SELECT;
+	}
+	else /* if (action == USER_TERM_ACT_PROCSEL) */
+	{
+		user_input = user_if_get_input();
+
+		if (PARSE_CMD_ANY_CHAR)
+		{
+			switch (user_term_access.access_step)
+			{
+			case USER_TERM_ACCESSSTEP_SELECT:
+				if (PARSE_CMD_CHAR('1') || PARSE_CMD_CHAR('2'))
+				{
+					user_term_access.remove = PARSE_CMD_CHAR('2');
+
+					PRINT("Insert an 8 bytes hexadecimal extended address without spaces or '0x', then press ENTER\n");
+					user_term_access.access_step = USER_TERM_ACCESSSTEP_EXT_ADDR;
+				}
+				else
+				{
+					PRINT(pString_NoSuitableAnswerFound);
+				}
+				break;
+			case USER_TERM_ACCESSSTEP_EXT_ADDR:
+				if (user_term_convert_str_to_hex(user_term_access.entry.ext_addr, sizeof(user_term_access.entry.ext_addr), user_input) != sizeof(user_term_access.entry.ext_addr))
+				{
+					PRINT("Invalid extended address\n");
+					user_term_reset_to_state(USER_TERM_ST_MAIN);
+				}
+				else if (user_term_access.remove)
+				{
+					if (g3_boot_access_table_remove(user_term_access.entry.ext_addr))
+					{
+						PRINT("Entry removed (%u entries)\n", g3_boot_access_table_count());
+					}
+					else
+					{
+						PRINT(pString_DeviceNotFound);
+					}
+
+					user_term_set_state(USER_TERM_ST_MAIN);
+				}
+				else
+				{
+#if (SELECTED_LIST_MODE == BLACK_LIST_MODE)
+					/* Short address and PSK are not used in black list mode */
+					const uint8_t default_psk[ADP_EAP_PSK_KEY_LEN] = DEFAULT_PSK;
+
+					user_term_access.entry.short_addr = 0;
+					memcpy(user_term_access.entry.psk, default_psk, sizeof(user_term_access.entry.psk));
+
+					user_term_access_list_add();
+#else
+					PRINT("Type the short address to assign (default: %u), then ENTER\n", g3_boot_access_table_count() + 1);
+					user_term_access.access_step = USER_TERM_ACCESSSTEP_SHORT_ADDR;
+#endif
+				}
+				break;
+#if (SELECTED_LIST_MODE == WHITE_LIST_MODE)
+			case USER_TERM_ACCESSSTEP_SHORT_ADDR:
+				user_term_access.entry.short_addr = (uint16_t) user_term_assign_user_value(user_input, g3_boot_access_table_count() + 1, "short address", false);
+
+				if ((user_term_access.entry.short_addr != COORD_ADDRESS) && (user_term_access.entry.short_addr < MAC_BROADCAST_SHORT_ADDR))
+				{
+					const uint8_t default_psk[ADP_EAP_PSK_KEY_LEN] = DEFAULT_PSK;
+					ALLOC_STATIC_HEX_STRING(default_psk_str, default_psk, sizeof(default_psk));
+
+					PRINT("Insert a 16 bytes hexadecimal PSK without spaces or '0x', then press ENTER\n");
+					PRINT("Default: %s\n", default_psk_str);
+					user_term_access.access_step = USER_TERM_ACCESSSTEP_PSK;
+				}
+				else
+				{
+					/* Re-acquires the short address */
+					PRINT(pString_DestinationAddrOOR);
+				}
+				break;
+			case USER_TERM_ACCESSSTEP_PSK:
+			{
+				const uint8_t default_psk[ADP_EAP_PSK_KEY_LEN] = DEFAULT_PSK;
+				uint16_t len = user_term_convert_str_to_hex(user_term_access.entry.psk, sizeof(user_term_access.entry.psk), user_input);
+
+				if (len == 0)
+				{
+					len = sizeof(user_term_access.entry.psk);
+					memcpy(user_term_access.entry.psk, default_psk, sizeof(user_term_access.entry.psk));
+				}
+
+				if (len == sizeof(user_term_access.entry.psk))
+				{
+					user_term_access_list_add();
+				}
+				else
+				{
+					PRINT("Invalid hex string (%u/%u digits)\n", len, ADP_EAP_PSK_KEY_LEN);
+					user_term_reset_to_state(USER_TERM_ST_MAIN);
+				}
+				break;
+			}
+#endif /* SELECTED_LIST_MODE == WHITE_LIST_MODE */
+			default:
+				break;
+			}
+		}
+	}
+}
+#endif /* IS_COORD && ENABLE_ACCESS_LIST_STORAGE */
+
 /**
  * @brief User Terminal implementation for the system reset.
  * @param action Type of action to run
@@ -2432,6 +2834,9 @@ static user_term_func* const user_term_func_tbl[USER_TERM_ST_CNT] =
 		/* MAIN 				*/ user_term_state_main_menu,
 		/* TESTS 				*/ user_term_state_test,
 		/* TEST_EXEC 			*/ user_term_state_test_exec,
+#if ENABLE_BENCHMARK
+		/* BENCHMARK 			*/ user_term_state_benchmark,
+#endif
 		/* DIPLAY_CONNECTION	*/ user_term_state_print_connection,
 		/* DIPLAY_DEVICES		*/ user_term_state_print_device_list,
 #if ENABLE_IMAGE_TRANSFER
@@ -2448,6 +2853,9 @@ static user_term_func* const user_term_func_tbl[USER_TERM_ST_CNT] =
 #endif
 #if IS_COORD && ENABLE_BOOT_SERVER_ON_HOST && ENABLE_REKEYING
 		/* REKEYING				*/ user_term_state_rekeying,
+#endif
+#if IS_COORD && ENABLE_ACCESS_LIST_STORAGE
+		/* ACCESS_LIST			*/ user_term_state_access_list,
 #endif
 		/* RESET				*/ user_term_state_reset,
 };
@@ -2507,6 +2915,46 @@ void UserTerminal_FsmManager_MAC(void)
 {
 	user_input_t* user_input = user_if_get_input();
 
+#if ENABLE_BENCHMARK
+	/* Benchmark command line, "mac <ext_addr> ..." */
+	if ((user_input != NULL) && (user_input->length > 4) && (strncmp((char*) user_input->payload, "mac ", 4) == 0))
+	{
+		char command[USERIF_INPUT_MAX_SIZE + 1];
+		user_bench_params_t params;
+
+		memcpy(command, user_input->payload, user_input->length);
+		command[user_input->length] = '\0';
+
+		if (UserBench_ParseCommand(command, &params))
+		{
+			UserBench_Start(&params);
+		}
+
+		user_input = NULL; /* Already parsed */
+	}
+#endif
+
+	/* Traffic generator command line, "GEN.MAC_ADDRESS.PLC|RF|PLCRF.FRAME_SIZE.FRAME_NUMBER.RATE" */
+	if ((user_input != NULL) && (user_input->length > STR_GEN_PREFIX_LEN) && (strncmp((char*) user_input->payload, STR_GEN_PREFIX, STR_GEN_PREFIX_LEN) == 0))
+	{
+		char command[USERIF_INPUT_MAX_SIZE + 1];
+		usermac_gen_params_t params;
+
+		memcpy(command, user_input->payload, user_input->length);
+		command[user_input->length] = '\0';
+
+		if (!user_term_parse_generator(command, &params))
+		{
+			PRINT("Usage: GEN.MAC_ADDRESS.PLC|RF|PLCRF.FRAME_SIZE.FRAME_NUMBER.RATE (rate in bit/s, 0 for maximum)\n");
+		}
+		else if (!UserMac_StartGenerator(&params))
+		{
+			PRINT("Traffic generator not started (busy, or frame size out of %u-%u bytes)\n", USERMAC_GEN_FRAME_SIZE_MIN, USERMAC_GEN_FRAME_SIZE_MAX);
+		}
+
+		user_input = NULL; /* Already parsed */
+	}
+
 	if ((user_input != NULL) &&  UserMac_IsReady())
 	{
 		uint8_t dest_addr[MAC_ADDR64_SIZE];
@@ -2577,6 +3025,10 @@ void UserTerminal_FsmManager_MAC(void)
 		else
 		{
 			PRINT("Insert MAC address in HEX format (e.g. '0102030405060708'):\n");
+			PRINT("Traffic generator: GEN.MAC_ADDRESS.PLC|RF|PLCRF.FRAME_SIZE.FRAME_NUMBER.RATE\n");
+#if ENABLE_BENCHMARK
+			UserBench_PrintUsage();
+#endif
 		}
 	}
 }